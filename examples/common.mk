@@ -73,6 +73,10 @@ $(SRC).mlbpar.c:  $(SRC).c
 $(SRC).pipepar.c:  $(SRC).c
 	$(PLC) $(SRC).c --nodiamond-tile $(TILEFLAGS) $(PLCFLAGS) -o $@
 
+# Version with split tiling: concurrent start without diamond tiling
+$(SRC).splitpar.c:  $(SRC).c
+	$(PLC) $(SRC).c --split-tile $(TILEFLAGS) $(PLCFLAGS) -o $@
+
 orig: $(SRC).c
 	$(CC) $(OPT_FLAGS) $(CFLAGS) $(SRC).c -o $@ $(LDFLAGS)
 
@@ -98,6 +102,10 @@ mlbpar: $(SRC).mlbpar.c
 pipepar: $(SRC).pipepar.c
 	$(CC) $(OPT_FLAGS) $(CFLAGS) $(OMP_FLAGS) $(SRC).pipepar.c -o $@  $(LDFLAGS)
 
+# Version with split tiling
+splitpar: $(SRC).splitpar.c
+	$(CC) $(OPT_FLAGS) $(CFLAGS) $(OMP_FLAGS) $(SRC).splitpar.c -o $@  $(LDFLAGS)
+
 perf: orig tiled par orig_par
 	rm -f .test
 	./orig
@@ -130,6 +138,14 @@ lbtest: par pipepar
 	diff -q out_par4 out_fulldiamondtile4
 	@echo Success!
 
+splittest: orig splitpar
+	touch .test
+	./orig 2> out_orig
+	OMP_NUM_THREADS=$(NTHREADS) ./splitpar 2> out_splitpar4
+	rm -f .test
+	diff -q out_orig out_splitpar4
+	@echo Success!
+
 opt-test: orig opt
 	touch .test
 	./orig > out_orig
@@ -140,11 +156,11 @@ opt-test: orig opt
 	rm -f .test
 
 clean:
-	rm -f out_* *.pipepar.c *.tiled.c *.opt.c *.par.c orig opt tiled par sched orig_par \
+	rm -f out_* *.pipepar.c *.splitpar.c *.tiled.c *.opt.c *.par.c orig opt tiled par sched orig_par \
 		hopt hopt *.par2d.c *.out.* \
 		*.kernel.* a.out $(EXTRA_CLEAN) tags tmp* gmon.out *~ .unroll \
 	   	.vectorize par2d parsetab.py *.body.c *.pluto.c *.par.cloog *.tiled.cloog *.pluto.cloog
 
 exec-clean:
-	rm -f out_* opt orig tiled sched sched hopt hopt par pipepar orig_par *.out.* *.kernel.* a.out \
+	rm -f out_* opt orig tiled sched sched hopt hopt par pipepar splitpar orig_par *.out.* *.kernel.* a.out \
 		$(EXTRA_CLEAN) tags tmp* gmon.out *~ par2d
@@ -0,0 +1,348 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE
+ * in the top-level directory for details.
+ *
+ * Runtime for the dynamic scheduling of tiles (--dynschedule), included by
+ * the code Pluto generates. It is header-only and needs C11 atomics and
+ * OpenMP (for the threads only). It is C only: <stdatomic.h> isn't usable
+ * from C++ before C++23, so code generated with --dynschedule has to be
+ * compiled as C11 or later.
+ *
+ * The generated code first runs the tile space loops of a band with the
+ * tiles registered in order (pluto_dyn_add_tile) instead of run. The graph
+ * of tiles is then built (pluto_dyn_schedule): a tile depends on the tiles
+ * at the distances the dependences between tiles have along its first
+ * `nkey_dims' coordinates, and on the previous tile with the same first
+ * coordinates. Each tile has an atomic count of its predecessors that
+ * haven't run, and those without any are put in the ready queues: one
+ * lock-free deque per thread, from which the other threads steal when their
+ * own is empty. The threads of a parallel region then run tiles as they get
+ * them (pluto_dyn_next), and running a tile (pluto_dyn_done) decrements the
+ * counts of its successors, which become ready when theirs drops to zero.
+ */
+#ifndef PLUTO_DYNSCHEDULE_H
+#define PLUTO_DYNSCHEDULE_H
+
+#ifdef __cplusplus
+#error "pluto/dynschedule.h is C only; compile the code using it as C11"
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <omp.h>
+
+/* Maximum number of coordinates that identify a tile in dependences */
+#define PLUTO_DYN_MAX_KEY_DIMS 3
+
+/// Chase-Lev deque of the ready tiles of a thread: the thread pushes and
+/// takes tiles at the bottom, and other threads steal them at the top. A tile
+/// is pushed once, so a buffer with room for all the tiles never overflows.
+typedef struct plutoDynDeque {
+  atomic_long top;
+  atomic_long bottom;
+  atomic_long *buf;
+  /* Keeps deques of different threads on different cache lines */
+  char pad[64 - 2 * sizeof(atomic_long) - sizeof(atomic_long *)];
+} PlutoDynDeque;
+
+/// Graph of the tiles of a band.
+typedef struct plutoDynGraph {
+  /* Number of coordinates of a tile */
+  unsigned ndims;
+  /* Number of first coordinates that identify a tile in dependences */
+  unsigned nkey_dims;
+  /* Maximum distances of the dependences between tiles along them */
+  unsigned max_dists[PLUTO_DYN_MAX_KEY_DIMS];
+
+  /* Tiles in the order they were added: their coordinates, and which loop
+   * body runs them */
+  long ntiles;
+  long capacity;
+  int *coords;
+  unsigned *copies;
+
+  /* The successors of tile i are succs[succ_start[i]..succ_start[i+1]-1] */
+  long *succ_start;
+  long *succs;
+  /* Number of predecessors of each tile that haven't run */
+  atomic_long *npreds;
+  /* Number of tiles that haven't run */
+  atomic_long remaining;
+
+  /* Ready tiles: one deque per thread */
+  int nthreads;
+  PlutoDynDeque *deques;
+} PlutoDynGraph;
+
+static inline void *pluto_dyn_malloc(size_t size) {
+  void *ptr = malloc(size > 0 ? size : 1);
+  if (!ptr) {
+    fprintf(stderr, "[pluto] dynschedule: out of memory\n");
+    exit(1);
+  }
+  return ptr;
+}
+
+/// Returns a graph for tiles with `ndims' coordinates, whose dependences
+/// have at most the distances `max_dists' along the first `nkey_dims'.
+static inline PlutoDynGraph *pluto_dyn_alloc(unsigned ndims,
+                                             unsigned nkey_dims,
+                                             const unsigned *max_dists) {
+  PlutoDynGraph *g = (PlutoDynGraph *)pluto_dyn_malloc(sizeof(PlutoDynGraph));
+  memset(g, 0, sizeof(PlutoDynGraph));
+  g->ndims = ndims;
+  g->nkey_dims = nkey_dims;
+  memcpy(g->max_dists, max_dists, nkey_dims * sizeof(unsigned));
+  return g;
+}
+
+/// Adds the tile at `coords' run by the loop body `copy'. Tiles are added in
+/// their sequential order.
+static inline void pluto_dyn_add_tile(PlutoDynGraph *g, unsigned copy,
+                                      const int *coords) {
+  if (g->ntiles == g->capacity) {
+    g->capacity = g->capacity > 0 ? 2 * g->capacity : 64;
+    g->coords = (int *)realloc(g->coords, g->capacity * g->ndims * sizeof(int));
+    g->copies =
+        (unsigned *)realloc(g->copies, g->capacity * sizeof(unsigned));
+    if (!g->coords || !g->copies) {
+      fprintf(stderr, "[pluto] dynschedule: out of memory\n");
+      exit(1);
+    }
+  }
+  memcpy(&g->coords[g->ntiles * g->ndims], coords, g->ndims * sizeof(int));
+  g->copies[g->ntiles++] = copy;
+}
+
+/// Returns the slot of `table' (with `tsize' slots, a power of two) of the
+/// last tile whose first coordinates are `key', or the empty slot where it
+/// goes.
+static inline long pluto_dyn_lookup(const PlutoDynGraph *g, const long *table,
+                                    long tsize, const int *key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned k = 0; k < g->nkey_dims; k++) {
+    hash = (hash ^ (uint32_t)key[k]) * 1099511628211ULL;
+  }
+  long slot = (long)(hash & (uint64_t)(tsize - 1));
+  while (table[slot] >= 0 &&
+         memcmp(&g->coords[table[slot] * g->ndims], key,
+                g->nkey_dims * sizeof(int)) != 0) {
+    slot = (slot + 1) & (tsize - 1);
+  }
+  return slot;
+}
+
+static inline void pluto_dyn_push(PlutoDynDeque *q, long cap, long tile) {
+  long b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+  atomic_store_explicit(&q->buf[b % cap], tile, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+}
+
+/// Takes the last tile pushed to the deque of the calling thread; returns -1
+/// if it is empty.
+static inline long pluto_dyn_take(PlutoDynDeque *q, long cap) {
+  long b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long t = atomic_load_explicit(&q->top, memory_order_relaxed);
+  long tile = -1;
+  if (t <= b) {
+    tile = atomic_load_explicit(&q->buf[b % cap], memory_order_relaxed);
+    if (t == b) {
+      /* Last tile: thieves may take it first */
+      if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+                                                   memory_order_seq_cst,
+                                                   memory_order_relaxed))
+        tile = -1;
+      atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    }
+  } else {
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+  }
+  return tile;
+}
+
+/// Steals the first tile pushed to the deque of another thread; returns -1
+/// if it is empty or another thread took it first.
+static inline long pluto_dyn_steal(PlutoDynDeque *q, long cap) {
+  long t = atomic_load_explicit(&q->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+  if (t >= b)
+    return -1;
+  long tile = atomic_load_explicit(&q->buf[t % cap], memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(
+          &q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    return -1;
+  return tile;
+}
+
+/// Builds the graph of the tiles added and puts those without predecessors
+/// in the ready queues of the threads of the next parallel region.
+static inline void pluto_dyn_schedule(PlutoDynGraph *g) {
+  long n = g->ntiles;
+  unsigned h = g->nkey_dims;
+
+  /* Last tile with each key, and previous tile with the key of each tile */
+  long tsize = 1;
+  while (tsize < 2 * n) {
+    tsize <<= 1;
+  }
+  long *table = (long *)pluto_dyn_malloc(tsize * sizeof(long));
+  for (long s = 0; s < tsize; s++) {
+    table[s] = -1;
+  }
+  long *prev = (long *)pluto_dyn_malloc(n * sizeof(long));
+  for (long i = 0; i < n; i++) {
+    long slot = pluto_dyn_lookup(g, table, tsize, &g->coords[i * g->ndims]);
+    prev[i] = table[slot];
+    table[slot] = i;
+  }
+
+  /* Predecessors of each tile: the previous tile with its key, and the last
+   * tile of each key at the offsets, which runs after the other tiles of
+   * that key. Edges only go to larger keys or to later tiles of a key, so
+   * the graph has no cycles. */
+  long noffsets = 1;
+  for (unsigned k = 0; k < h; k++) {
+    noffsets *= g->max_dists[k] + 1;
+  }
+  long *preds = (long *)pluto_dyn_malloc(n * noffsets * sizeof(long));
+  long *npreds = (long *)pluto_dyn_malloc(n * sizeof(long));
+  long *nsuccs = (long *)calloc(n + 1, sizeof(long));
+  if (!nsuccs) {
+    fprintf(stderr, "[pluto] dynschedule: out of memory\n");
+    exit(1);
+  }
+  for (long i = 0; i < n; i++) {
+    long *tpreds = &preds[i * noffsets];
+    long np = 0;
+    if (prev[i] >= 0)
+      tpreds[np++] = prev[i];
+    for (long o = 1; o < noffsets; o++) {
+      int key[PLUTO_DYN_MAX_KEY_DIMS];
+      long rem = o;
+      for (int k = h - 1; k >= 0; k--) {
+        key[k] = g->coords[i * g->ndims + k] - rem % (g->max_dists[k] + 1);
+        rem /= g->max_dists[k] + 1;
+      }
+      long pred = table[pluto_dyn_lookup(g, table, tsize, key)];
+      if (pred < 0)
+        continue;
+      long p;
+      for (p = 0; p < np && tpreds[p] != pred; p++)
+        ;
+      if (p == np)
+        tpreds[np++] = pred;
+    }
+    npreds[i] = np;
+    for (long p = 0; p < np; p++) {
+      nsuccs[tpreds[p]]++;
+    }
+  }
+
+  /* Successors */
+  g->succ_start = (long *)pluto_dyn_malloc((n + 1) * sizeof(long));
+  g->succ_start[0] = 0;
+  for (long i = 0; i < n; i++) {
+    g->succ_start[i + 1] = g->succ_start[i] + nsuccs[i];
+    nsuccs[i] = g->succ_start[i];
+  }
+  g->succs = (long *)pluto_dyn_malloc(g->succ_start[n] * sizeof(long));
+  for (long i = 0; i < n; i++) {
+    for (long p = 0; p < npreds[i]; p++) {
+      g->succs[nsuccs[preds[i * noffsets + p]]++] = i;
+    }
+  }
+
+  g->npreds = (atomic_long *)pluto_dyn_malloc(n * sizeof(atomic_long));
+  for (long i = 0; i < n; i++) {
+    atomic_init(&g->npreds[i], npreds[i]);
+  }
+  atomic_init(&g->remaining, n);
+
+  /* Ready queues, with the tiles without predecessors dealt out */
+  g->nthreads = omp_get_max_threads();
+  g->deques = (PlutoDynDeque *)pluto_dyn_malloc(g->nthreads *
+                                                sizeof(PlutoDynDeque));
+  for (int t = 0; t < g->nthreads; t++) {
+    atomic_init(&g->deques[t].top, 0);
+    atomic_init(&g->deques[t].bottom, 0);
+    g->deques[t].buf =
+        (atomic_long *)pluto_dyn_malloc(n * sizeof(atomic_long));
+  }
+  long nready = 0;
+  for (long i = 0; i < n; i++) {
+    if (npreds[i] == 0)
+      pluto_dyn_push(&g->deques[nready++ % g->nthreads], n, i);
+  }
+
+  free(table);
+  free(prev);
+  free(preds);
+  free(npreds);
+  free(nsuccs);
+}
+
+/// Returns a tile ready to run for the calling thread, or -1 once all the
+/// tiles have run. Must be called from a parallel region with at most as
+/// many threads as omp_get_max_threads() returned for pluto_dyn_schedule.
+static inline long pluto_dyn_next(PlutoDynGraph *g) {
+  int tid = omp_get_thread_num();
+  long cap = g->ntiles;
+  for (;;) {
+    long tile = pluto_dyn_take(&g->deques[tid], cap);
+    if (tile >= 0)
+      return tile;
+    if (atomic_load(&g->remaining) == 0)
+      return -1;
+    for (int k = 1; k < g->nthreads; k++) {
+      tile = pluto_dyn_steal(&g->deques[(tid + k) % g->nthreads], cap);
+      if (tile >= 0)
+        return tile;
+    }
+  }
+}
+
+/// Marks `tile' as run by the calling thread, which gets the successors that
+/// become ready.
+static inline void pluto_dyn_done(PlutoDynGraph *g, long tile) {
+  PlutoDynDeque *q = &g->deques[omp_get_thread_num()];
+  for (long s = g->succ_start[tile]; s < g->succ_start[tile + 1]; s++) {
+    long succ = g->succs[s];
+    if (atomic_fetch_sub(&g->npreds[succ], 1) == 1)
+      pluto_dyn_push(q, g->ntiles, succ);
+  }
+  atomic_fetch_sub(&g->remaining, 1);
+}
+
+static inline const int *pluto_dyn_get_coords(const PlutoDynGraph *g,
+                                              long tile) {
+  return &g->coords[tile * g->ndims];
+}
+
+static inline unsigned pluto_dyn_get_copy(const PlutoDynGraph *g, long tile) {
+  return g->copies[tile];
+}
+
+static inline void pluto_dyn_free(PlutoDynGraph *g) {
+  for (int t = 0; t < g->nthreads; t++) {
+    free(g->deques[t].buf);
+  }
+  free(g->deques);
+  free(g->npreds);
+  free(g->succs);
+  free(g->succ_start);
+  free(g->copies);
+  free(g->coords);
+  free(g);
+}
+
+#endif // PLUTO_DYNSCHEDULE_H
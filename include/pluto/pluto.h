@@ -45,6 +45,51 @@ enum fusionType {
 };
 typedef enum fusionType FusionType;
 
+/* Target instruction sets for options->target */
+enum targetType {
+  /* 32 registers; no particular vector unit assumed */
+  kTargetGeneric,
+
+  /* The instruction set of the machine Pluto runs on (cpuid) */
+  kTargetNative,
+
+  kTargetSSE,
+  kTargetAVX2,
+  kTargetAVX512,
+  kTargetNEON
+};
+typedef enum targetType TargetType;
+
+/* Code generators for options->codegen */
+enum codegenType {
+  /* CLooG, with loops marked and transformed on its clast (default) */
+  kCodegenCloog,
+
+  /* isl's AST generator, with full tiles separated from partial ones */
+  kCodegenIsl
+};
+typedef enum codegenType CodegenType;
+
+/* Maximum number of cache levels that can be described to the tile size
+ * selection model */
+#define PLUTO_MAX_CACHE_LEVELS 4
+
+/* One level of the cache hierarchy as seen by the tile size selection model */
+struct plutoCacheLevel {
+  /* Total size in bytes */
+  uint64_t size;
+
+  /* Cache line size in bytes */
+  unsigned line_size;
+
+  /* Ways of associativity; 0 for fully associative */
+  unsigned associativity;
+
+  /* Number of cores sharing this cache */
+  unsigned shared_by;
+};
+typedef struct plutoCacheLevel PlutoCacheLevel;
+
 struct plutoOptions {
 
   /* To tile or not? */
@@ -95,10 +140,59 @@ struct plutoOptions {
   /* unroll/jam factor */
   int ufactor;
 
+  /// Instruction set whose vector register count and width the unroll-jam
+  /// model uses to pick unroll-jam factors (at most ufactor) that do not
+  /// spill registers.
+  TargetType target;
+
   /* Enable or disable post-transformations to make code amenable to
    * vectorization (default - enabled) */
   int prevector;
 
+  /// Mark vectorizable loops with OpenMP SIMD pragmas (with simdlen, safelen
+  /// and aligned clauses) instead of ivdep/vector always; loops carrying
+  /// dependences of distance at least two are then vectorized too.
+  int omp_simd;
+
+  /// Alignment in bytes of the arrays (and of the rows of multi-dimensional
+  /// ones) asserted by the user; 0 if unknown. Used for the aligned clauses
+  /// of SIMD loops.
+  unsigned array_alignment;
+
+  /// Detect reductions (updates of a location with + or *), relax the
+  /// dependences between their updates and parallelize or vectorize the
+  /// loops carrying them with OpenMP reduction clauses. Floating-point
+  /// updates are then reassociated.
+  int reductions;
+
+  /// Run the tiles of bands with pipelined parallelism as OpenMP tasks
+  /// ordered by depend clauses instead of skewing the tile space into a
+  /// wavefront.
+  int omp_tasks;
+
+  /// Run the outer two tile space loops of bands with pipelined parallelism
+  /// as doacross loops (omp for ordered(2)) that wait for the tiles they
+  /// depend on with ordered depend(sink) instead of skewing the tile space
+  /// into a wavefront.
+  int doacross;
+
+  /// Collapse parallel loops with the rectangular parallel loops nested in
+  /// them (OpenMP collapse clause).
+  int omp_collapse;
+
+  /// Pick the OpenMP schedule of parallel loops from how the trip counts of
+  /// the loops inside them vary (dynamic or guided for triangular ones).
+  int omp_schedule;
+
+  /// Emit two versions of the code: the optimized one and one generated with
+  /// --notile --noparallel, selected at run time by comparing an estimate of
+  /// the total iteration count against multiversion_threshold.
+  int multiversion;
+
+  /// Estimated iteration count at and above which the multiversioned code
+  /// runs the optimized version.
+  double multiversion_threshold;
+
   /* consider RAR dependences */
   int rar;
 
@@ -130,16 +224,73 @@ struct plutoOptions {
   /// execution.
   int second_level_tile;
 
+  /// Number of levels of tiling; each level tiles the tile space loops of the
+  /// previous one, e.g., for the next level of the memory hierarchy or for a
+  /// NUMA node or socket. --second-level-tile implies at least two.
+  int tile_levels;
+
+  /// Level of tiling (1 for the first, innermost, level of tiles) whose tile
+  /// space loops are parallelized, by creating a wavefront of tiles if needed;
+  /// the loops of the outer levels are run sequentially. 0 for the outermost
+  /// level.
+  int parallel_tile_level;
+
+  /// Split-tile permutable bands: the outer two dimensions of a band (time
+  /// and space for an iterative stencil) are tiled with tiles that shrink in
+  /// time followed by tiles that fill the gaps between them, so that all
+  /// tiles of each phase start concurrently without a wavefront and without
+  /// redundant computation. Bands for which that isn't legal get rectangular
+  /// tiles. Turns off diamond tiling.
+  int split_tile;
+
+  /// Keep tile sizes symbolic in the generated code: each tiled loop tK gets
+  /// its tile size from a variable tsK (initialized with the tile size that
+  /// would otherwise have been used, and settable at run time through
+  /// PLUTO_TILE_SIZES) instead of a constant.
+  int parametric_tiles;
+
+  /// Separate full tiles from partial ones in the code generated with CLooG:
+  /// the point loops of full tiles get the tile bounds as constant-trip
+  /// bounds, those of partial tiles get their bounds computed once per tile,
+  /// and divisions by power-of-two tile sizes become shifts.
+  int full_tiles;
+
   /// Automatically find tile sizes for each permutable band using a tile size
   /// selection model.
   bool find_tile_sizes;
 
+  /// Have the tile size selection model count the exact footprint of tiles
+  /// (the distinct data elements accessed by a tile) instead of estimating it
+  /// from dimensional reuse.
+  int exact_tile_footprint;
+
+  /// Tile configuration file giving tile sizes, unroll-jam factors and vector
+  /// lengths per band (see lib/tile_config.h); NULL to fall back to
+  /// tile.sizes in the current directory.
+  char *tile_config;
+
+  /// File the tile sizes found by the tile size selection model are written
+  /// to, as a tile configuration; NULL for none.
+  char *tile_config_out;
+
   /// Cache size in bytes.
   uint64_t cache_size;
 
-  /// Size in bytes of each data element.
+  /// Size in bytes of each data element; 0 to use the size of the array
+  /// elements found in the input (sizeof(double) if unknown).
   unsigned data_element_size;
 
+  /// Cache hierarchy, innermost (L1) first, used by the tile size selection
+  /// model. When empty, a single level of cache_size bytes is assumed.
+  PlutoCacheLevel cache_levels[PLUTO_MAX_CACHE_LEVELS];
+  unsigned num_cache_levels;
+
+  /// Number of threads the generated code will run with (0 if not known, in
+  /// which case OMP_NUM_THREADS is looked at). The tile size selection model
+  /// keeps at least parallel_slack tiles per thread along parallel dimensions.
+  unsigned num_threads;
+  unsigned parallel_slack;
+
   /* NOTE: --ft and --lt are to manually force tiling depths */
   /* First depth to tile (starting from 0) */
   int ft;
@@ -173,6 +324,14 @@ struct plutoOptions {
   /* Enable cloog's -backtrack */
   int cloogbacktrack;
 
+  /// Code generator to use (--codegen).
+  CodegenType codegen;
+
+  /// Comma-separated AST generation options (atomic, separate or unroll, or
+  /// nothing for isl's default) of the schedule dimensions t1, t2, ... with
+  /// --codegen=isl; NULL if not given.
+  char *isl_ast_options;
+
   /* Use isl to compute dependences (default) */
   int isldep;
 
@@ -234,6 +393,19 @@ struct plutoOptions {
   /* Index set splitting */
   int iss;
 
+  /* Maintain the SCCs and connected components of the DDG incrementally as
+   * dependences get satisfied instead of recomputing them from scratch. */
+  int incremental_scc;
+
+  /* Hierarchical scheduling: cluster SCCs into groups of at most
+   * hier_cluster_size statements and solve one small ILP per cluster */
+  int hierarchical;
+  int hier_cluster_size;
+
+  /* Compile time budget in seconds (0 for none); once the scheduling ILPs
+   * run out of it, cheaper strategies are used for the remaining bands */
+  double time_budget;
+
   /* Output file name supplied from -o */
   char *out_file;
 
@@ -250,6 +422,18 @@ void pluto_options_free(PlutoOptions *);
 
 typedef struct plutoContext {
   PlutoOptions *options;
+  /* Time (in seconds since the epoch) at which the context was allocated;
+   * options->time_budget is counted from here */
+  double start_time;
+  /* Time (as start_time) by which all the scheduling ILPs/LPs have to be
+   * solved (0 for none): start_time + options->time_budget */
+  double budget_end;
+  /* Time (as start_time) by which the ILPs/LPs of the current scheduling
+   * strategy have to be solved (0 for none); its share of the time left
+   * before budget_end */
+  double solver_deadline;
+  /* Set when a solve has run into solver_deadline */
+  int solver_timed_out;
 } PlutoContext;
 
 PlutoContext *pluto_context_alloc();
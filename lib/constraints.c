@@ -1082,6 +1082,26 @@ int64_t *pluto_constraints_lexmin_pip(const PlutoConstraints *cst, int negvar) {
   return sol;
 }
 
+/// Seconds left before context->solver_deadline, the deadline that the
+/// compile time budget (options->time_budget) sets for the ILPs/LPs of the
+/// current scheduling strategy, or a negative value if there is none. Once the
+/// deadline has passed, flags the timeout in context->solver_timed_out and
+/// returns 0.
+double pluto_solver_time_left(PlutoContext *context) {
+  if (context->solver_deadline <= 0.0) {
+    return -1.0;
+  }
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  double time_left =
+      context->solver_deadline - (tv.tv_sec + tv.tv_usec * 1.0e-6);
+  if (time_left <= 0.0) {
+    context->solver_timed_out = 1;
+    return 0.0;
+  }
+  return time_left;
+}
+
 /// Solve these constraints for lexmin. solution.
 //  TODO: GLPK-based path doesn't exist here.
 int64_t *pluto_constraints_lexmin(const PlutoConstraints *cst, int negvar) {
@@ -1169,9 +1189,20 @@ int64_t *get_ilp_solution_from_glpk_problem(glp_prob *lp,
   return sol;
 }
 
+/// Time limit in milliseconds for a GLPK solve subject to
+/// context->solver_deadline (GLPK's default of INT_MAX if there is none).
+static int glpk_time_limit(PlutoContext *context) {
+  double time_left = pluto_solver_time_left(context);
+  if (time_left < 0.0 || time_left * 1000.0 >= INT_MAX) {
+    return INT_MAX;
+  }
+  return PLMAX(1, (int)(time_left * 1000.0));
+}
+
 /* Set glpk problem parameters.
- * Checks feasibility of the LP problem using simplex */
-void set_glpk_problem_params(glp_prob *lp, PlutoContext *context) {
+ * Checks feasibility of the LP problem using simplex; tm_lim is the time
+ * limit in milliseconds. Returns the exit code of glp_simplex. */
+int set_glpk_problem_params(glp_prob *lp, int tm_lim, PlutoContext *context) {
   PlutoOptions *options = context->options;
   if (!options->moredebug) {
     glp_term_out(GLP_OFF);
@@ -1184,16 +1215,20 @@ void set_glpk_problem_params(glp_prob *lp, PlutoContext *context) {
   parm.msg_lev = GLP_MSG_OFF;
   IF_MORE_DEBUG(parm.msg_lev = GLP_MSG_ON;);
   IF_MORE_DEBUG(parm.msg_lev = GLP_MSG_ALL;);
+  parm.tm_lim = tm_lim;
 
   glp_scale_prob(lp, GLP_SF_AUTO);
   glp_adv_basis(lp, 0);
-  glp_simplex(lp, &parm);
+  return glp_simplex(lp, &parm);
 }
 
-void find_optimal_solution_glpk(glp_prob *lp, double tol,
-                                PlutoContext *context) {
+/* Returns the exit code of glp_intopt; tm_lim is the time limit in
+ * milliseconds. */
+int find_optimal_solution_glpk(glp_prob *lp, double tol, int tm_lim,
+                               PlutoContext *context) {
   glp_iocp iocp;
   glp_init_iocp(&iocp);
+  iocp.tm_lim = tm_lim;
   /* The default is 1e-5; one may need to reduce it even further
    * depending on how large a coefficient we might see */
   iocp.tol_int = tol;
@@ -1204,12 +1239,24 @@ void find_optimal_solution_glpk(glp_prob *lp, double tol,
   IF_MORE_DEBUG(iocp.msg_lev = GLP_MSG_ALL;);
 
   /* Find optimal solution */
-  glp_intopt(lp, &iocp);
+  return glp_intopt(lp, &iocp);
 }
 
-/* Returns 0 if a solution was found else returns 1 */
+/* Returns 0 if a solution was found else returns 1. The solve is subject to
+ * context->solver_deadline; if it runs into it, context->solver_timed_out is
+ * set, and the best integer solution found so far (if any) is returned. */
 int pluto_constraints_solve_glpk(glp_prob *lp, PlutoContext *context) {
-  set_glpk_problem_params(lp, context);
+  if (pluto_solver_time_left(context) == 0.0) {
+    glp_delete_prob(lp);
+    return 1;
+  }
+  if (set_glpk_problem_params(lp, glpk_time_limit(context), context) ==
+      GLP_ETMLIM) {
+    IF_DEBUG(printf("[pluto] GLPK: time limit reached\n"););
+    context->solver_timed_out = 1;
+    glp_delete_prob(lp);
+    return 1;
+  }
   int lp_status = glp_get_status(lp);
 
   if (lp_status == GLP_INFEAS || lp_status == GLP_UNDEF) {
@@ -1217,7 +1264,11 @@ int pluto_constraints_solve_glpk(glp_prob *lp, PlutoContext *context) {
     return 1;
   }
 
-  find_optimal_solution_glpk(lp, 1e-7, context);
+  if (find_optimal_solution_glpk(lp, 1e-7, glpk_time_limit(context),
+                                 context) == GLP_ETMLIM) {
+    IF_DEBUG(printf("[pluto] GLPK: time limit reached\n"););
+    context->solver_timed_out = 1;
+  }
 
   int ilp_status = glp_mip_status(lp);
 
@@ -1241,7 +1292,7 @@ int pluto_constraints_solve_glpk(glp_prob *lp, PlutoContext *context) {
 double *pluto_mip_scale_solutions_glpk(glp_prob *ilp, PlutoContext *context) {
   double *scale_sols;
 
-  set_glpk_problem_params(ilp, context);
+  set_glpk_problem_params(ilp, INT_MAX, context);
 
   int lp_status = glp_get_status(ilp);
 
@@ -1250,7 +1301,7 @@ double *pluto_mip_scale_solutions_glpk(glp_prob *ilp, PlutoContext *context) {
     return NULL;
   }
 
-  find_optimal_solution_glpk(ilp, 1e-2, context);
+  find_optimal_solution_glpk(ilp, 1e-2, INT_MAX, context);
 
   int ilp_status = glp_mip_status(ilp);
 
@@ -179,6 +179,9 @@ void print_polylib_visual_sets_new(char *name, PlutoConstraints *cst);
 
 __isl_give isl_set *isl_set_from_pluto_constraints(const PlutoConstraints *cst,
                                                    isl_ctx *ctx);
+__isl_give isl_set *
+isl_set_from_pluto_constraints_params(const PlutoConstraints *cst, int n_par,
+                                      isl_ctx *ctx);
 PlutoConstraints *isl_set_to_pluto_constraints(__isl_keep isl_set *set,
                                                PlutoContext *context);
 __isl_give isl_basic_set *
@@ -221,6 +224,7 @@ PlutoConstraints *farkas_lemma_affine(const PlutoConstraints *dom,
 void pluto_constraints_gaussian_eliminate(PlutoConstraints *cst, int pos);
 
 int pluto_constraints_get_num_non_zero_coeffs(const PlutoConstraints *cst);
+double pluto_solver_time_left(PlutoContext *context);
 #ifdef GLPK
 int64_t *pluto_prog_constraints_lexmin_glpk(const PlutoConstraints *cst,
                                             PlutoMatrix *obj, double **val,
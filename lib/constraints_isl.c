@@ -146,6 +146,25 @@ __isl_give isl_set *isl_set_from_pluto_constraints(const PlutoConstraints *cst,
   return set;
 }
 
+/*
+ * Construct a set from the constraints in cst whose last n_par dimensions
+ * (before the constant) are parameters
+ */
+__isl_give isl_set *
+isl_set_from_pluto_constraints_params(const PlutoConstraints *cst, int n_par,
+                                      isl_ctx *ctx) {
+  int n_dim = cst->ncols - 1 - n_par;
+  isl_set *set = isl_set_empty(isl_space_set_alloc(ctx, n_par, n_dim));
+
+  for (; cst != NULL; cst = cst->next) {
+    isl_basic_map *bmap =
+        isl_basic_map_from_pluto_constraints(ctx, cst, 0, n_dim, n_par);
+    set = isl_set_union(set, isl_map_range(isl_map_from_basic_map(bmap)));
+  }
+
+  return set;
+}
+
 struct pluto_cst_context_info {
   PlutoConstraints **cst;
   PlutoContext *context;
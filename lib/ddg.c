@@ -51,6 +51,16 @@ Graph *graph_alloc(int nVertices, PlutoContext *context) {
 
   /* Not computed yet */
   g->num_ccs = -1;
+
+  /* Not maintained incrementally unless set up by the client */
+  g->dep_edges = NULL;
+  g->ndeps = 0;
+  g->sccs_valid = false;
+  g->ccs_valid = false;
+  g->scc_dirty = NULL;
+  g->cc_dirty = NULL;
+  g->full_scc_time = 0.0;
+  g->full_cc_time = 0.0;
   return g;
 }
 
@@ -257,7 +267,239 @@ void free_scc_vertices(Graph *ddg) {
     }
   }
 }
+
+/// Returns the SCC ids of the graph in a topological order of its condensation.
+/// SCC ids are always assigned in topological order, both by the full
+/// (Kosaraju) computation and when SCCs are split incrementally, i.e., there is
+/// never an edge from SCC i to SCC j with i > j. The returned array is owned by
+/// the caller.
+int *get_ssc_topological_order(Graph *ddg) {
+  /* SCCs should have been computed */
+  assert(ddg->num_sccs != -1);
+
+  int *order = (int *)malloc(ddg->num_sccs * sizeof(int));
+  for (int i = 0; i < ddg->num_sccs; i++) {
+    order[i] = ddg->sccs[i].id;
+    assert(order[i] == i);
+  }
+  return order;
+}
+
+/// Tarjan's SCC algorithm restricted to the vertices (members) of a single
+/// SCC. Sub-SCCs are numbered in the order in which they are found, i.e., in
+/// reverse topological order.
+static void scc_split_visit(Graph *g, int v, const int *members, int nmembers,
+                            int *index, int *lowlink, bool *on_stack,
+                            int *stack, int *sp, int *counter, int *piece,
+                            int *npieces) {
+  index[v] = *counter;
+  lowlink[v] = *counter;
+  (*counter)++;
+  stack[(*sp)++] = v;
+  on_stack[v] = true;
+
+  for (int k = 0; k < nmembers; k++) {
+    int w = members[k];
+    if (!g->adj->val[v][w])
+      continue;
+    if (index[w] == -1) {
+      scc_split_visit(g, w, members, nmembers, index, lowlink, on_stack, stack,
+                      sp, counter, piece, npieces);
+      lowlink[v] = PLMIN(lowlink[v], lowlink[w]);
+    } else if (on_stack[w]) {
+      lowlink[v] = PLMIN(lowlink[v], index[w]);
+    }
+  }
+
+  if (lowlink[v] == index[v]) {
+    int w;
+    do {
+      w = stack[--(*sp)];
+      on_stack[w] = false;
+      piece[w] = *npieces;
+    } while (w != v);
+    (*npieces)++;
+  }
+}
+
+/// Split the SCCs marked dirty (those that have lost internal edges) into the
+/// SCCs of the current graph without recomputing the SCCs of the whole graph.
+/// Only edges are assumed to have been removed since the SCCs were last
+/// computed (other than forward edges between SCCs). The sub-SCCs of a split
+/// SCC take its place in the topological order and the remaining SCCs are
+/// renumbered preserving their relative order. Properties of a split SCC are
+/// inherited by its sub-SCCs; the vertices list, if any, is left with the
+/// first sub-SCC and has to be recomputed by the caller. Returns the number of
+/// new SCCs created.
+int graph_split_dirty_sccs(Graph *g) {
+  int n = g->nVertices;
+  int num_sccs = g->num_sccs;
+
+  assert(g->sccs_valid && g->scc_dirty != NULL);
+
+  /* Group vertices by their SCC (counting sort on SCC id) */
+  int *start = (int *)malloc((num_sccs + 1) * sizeof(int));
+  int *members = (int *)malloc(n * sizeof(int));
+  for (int i = 0; i <= num_sccs; i++) {
+    start[i] = 0;
+  }
+  for (int v = 0; v < n; v++) {
+    start[g->vertices[v].scc_id + 1]++;
+  }
+  for (int i = 0; i < num_sccs; i++) {
+    start[i + 1] += start[i];
+  }
+  int *pos = (int *)malloc(num_sccs * sizeof(int));
+  memcpy(pos, start, num_sccs * sizeof(int));
+  for (int v = 0; v < n; v++) {
+    members[pos[g->vertices[v].scc_id]++] = v;
+  }
+  free(pos);
+
+  int *index = (int *)malloc(n * sizeof(int));
+  int *lowlink = (int *)malloc(n * sizeof(int));
+  int *stack = (int *)malloc(n * sizeof(int));
+  int *piece = (int *)malloc(n * sizeof(int));
+  bool *on_stack = (bool *)malloc(n * sizeof(bool));
+  Scc *new_sccs = (Scc *)malloc(n * sizeof(Scc));
+
+  int num_new = 0;
+  for (int i = 0; i < num_sccs; i++) {
+    int *scc_members = members + start[i];
+    int size = start[i + 1] - start[i];
+
+    if (!g->scc_dirty[i] || size == 1) {
+      new_sccs[num_new] = g->sccs[i];
+      new_sccs[num_new].id = num_new;
+      new_sccs[num_new].size = size;
+      for (int k = 0; k < size; k++) {
+        g->vertices[scc_members[k]].scc_id = num_new;
+      }
+      num_new++;
+      continue;
+    }
+
+    for (int k = 0; k < size; k++) {
+      index[scc_members[k]] = -1;
+      on_stack[scc_members[k]] = false;
+    }
+    int counter = 0, sp = 0, npieces = 0;
+    for (int k = 0; k < size; k++) {
+      if (index[scc_members[k]] == -1) {
+        scc_split_visit(g, scc_members[k], scc_members, size, index, lowlink,
+                        on_stack, stack, &sp, &counter, piece, &npieces);
+      }
+    }
+
+    for (int p = 0; p < npieces; p++) {
+      new_sccs[num_new + p] = g->sccs[i];
+      new_sccs[num_new + p].id = num_new + p;
+      new_sccs[num_new + p].size = 0;
+      if (p > 0) {
+        new_sccs[num_new + p].vertices = NULL;
+      }
+    }
+    /* Tarjan finds sub-SCCs in reverse topological order */
+    for (int k = 0; k < size; k++) {
+      int v = scc_members[k];
+      int id = num_new + npieces - 1 - piece[v];
+      g->vertices[v].scc_id = id;
+      new_sccs[id].size++;
+    }
+    num_new += npieces;
+  }
+
+  int num_split = num_new - num_sccs;
+  memcpy(g->sccs, new_sccs, num_new * sizeof(Scc));
+  g->num_sccs = num_new;
+  for (int i = 0; i < n; i++) {
+    g->scc_dirty[i] = false;
+  }
+
+  free(new_sccs);
+  free(on_stack);
+  free(piece);
+  free(stack);
+  free(lowlink);
+  free(index);
+  free(members);
+  free(start);
+
+  return num_split;
+}
+
+/// Split the connected components marked dirty (those that have lost an
+/// undirected edge) without recomputing the components of the whole graph.
+/// Component ids are reassigned in the order of the smallest vertex id in each
+/// component, which is the numbering a full computation yields. Returns the
+/// number of new components created.
+int graph_split_dirty_ccs(Graph *g) {
+  int n = g->nVertices;
+  int num_ccs = g->num_ccs;
+
+  assert(g->ccs_valid && g->cc_dirty != NULL);
+
+  int *label = (int *)malloc(n * sizeof(int));
+  int *map = (int *)malloc(num_ccs * sizeof(int));
+  int *stack = (int *)malloc(n * sizeof(int));
+  for (int v = 0; v < n; v++) {
+    label[v] = -1;
+  }
+  for (int c = 0; c < num_ccs; c++) {
+    map[c] = -1;
+  }
+
+  int num_new = 0;
+  for (int v = 0; v < n; v++) {
+    int c = g->vertices[v].cc_id;
+    if (!g->cc_dirty[c]) {
+      if (map[c] == -1) {
+        map[c] = num_new++;
+      }
+      label[v] = map[c];
+      continue;
+    }
+    if (label[v] != -1) {
+      continue;
+    }
+    /* Traverse the undirected graph within the old component */
+    int sp = 0;
+    label[v] = num_new;
+    stack[sp++] = v;
+    while (sp > 0) {
+      int u = stack[--sp];
+      for (int w = 0; w < n; w++) {
+        if (label[w] != -1 || g->vertices[w].cc_id != c)
+          continue;
+        if (g->adj->val[u][w] || g->adj->val[w][u]) {
+          label[w] = num_new;
+          stack[sp++] = w;
+        }
+      }
+    }
+    num_new++;
+  }
+
+  int num_split = num_new - num_ccs;
+  for (int v = 0; v < n; v++) {
+    g->vertices[v].cc_id = label[v];
+  }
+  g->num_ccs = num_new;
+  for (int i = 0; i < n; i++) {
+    g->cc_dirty[i] = false;
+  }
+
+  free(stack);
+  free(map);
+  free(label);
+
+  return num_split;
+}
+
 void graph_free(Graph *g) {
+  free(g->dep_edges);
+  free(g->scc_dirty);
+  free(g->cc_dirty);
   pluto_matrix_free(g->adj);
   free(g->vertices);
   free(g->sccs);
@@ -93,6 +93,24 @@ struct graph {
    * rebuild only when necessary */
   bool to_be_rebuilt;
 
+  /* Incremental SCC/CC maintenance (used with --incremental-scc). For each
+   * dependence, true if it currently contributes an edge to adj; NULL if the
+   * graph is not maintained incrementally. */
+  bool *dep_edges;
+  int ndeps;
+
+  /* True if sccs (resp. cc ids) are consistent with adj except for the SCCs
+   * (CCs) marked dirty, i.e., those that have lost an internal edge since they
+   * were last computed and may have to be split. */
+  bool sccs_valid;
+  bool ccs_valid;
+  bool *scc_dirty;
+  bool *cc_dirty;
+
+  /* Time taken by the last full (from scratch) SCC and CC computation */
+  double full_scc_time;
+  double full_cc_time;
+
   PlutoContext *context;
 };
 typedef struct graph Graph;
@@ -115,6 +133,8 @@ Vertex *ddg_get_vertex_by_id(Graph *g, int id);
 
 bool is_adjacent(Graph *, int, int);
 int *get_ssc_topological_order(Graph *ddg);
+int graph_split_dirty_sccs(Graph *g);
+int graph_split_dirty_ccs(Graph *g);
 void compute_scc_vertices(Graph *ddg);
 void print_scc_vertices(int scc_id, Graph *g);
 void free_scc_vertices(Graph *ddg);
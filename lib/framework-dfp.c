@@ -225,6 +225,186 @@ double *pluto_fusion_constraints_feasibility_solve(PlutoConstraints *cst,
   return sol;
 }
 
+/// Outcome of the LP that checks whether a pair of FCG vertices can be fused.
+typedef struct fcgLpResult {
+  /* The LP has been solved for the key of the cache entry it belongs to */
+  bool known;
+  bool feasible;
+  /* The solution found has u and w set to zero */
+  bool parallel;
+  /* Dependence distance of the solution found; used with lpcolour */
+  int64_t dep_dist;
+} FcgLpResult;
+
+/// Memoized outcomes of the fusion LPs between all dimensions of two clusters
+/// of statements (two statements, or two SCCs in the clustered approach). The
+/// key is made of the sorted statement ids on either side followed by the ids
+/// of the unsatisfied dependences between them. These determine the LP
+/// completely, so an entry stays valid across FCG rebuilds until one of those
+/// dependences is satisfied (or the SCCs change), which yields a new key.
+typedef struct fcgLpCacheEntry {
+  int *key;
+  int key_len;
+  int ndims1, ndims2;
+  FcgLpResult *results;
+  struct fcgLpCacheEntry *next;
+} FcgLpCacheEntry;
+
+struct fcgLpCache {
+  FcgLpCacheEntry **buckets;
+  unsigned nbuckets;
+};
+
+static int int_compar(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+/// Builds the cache key for the fusion LPs between the statements in stmts1
+/// and those in stmts2.
+static int *fcg_lp_cache_key(const int *stmts1, int n1, const int *stmts2,
+                             int n2, PlutoProg *prog, int *key_len) {
+  int nstmts = prog->nstmts;
+  int ndeps = prog->ndeps;
+  Dep **deps = prog->deps;
+
+  int *key = (int *)malloc((n1 + n2 + 2 + ndeps) * sizeof(int));
+  bool *in_pair = (bool *)calloc(nstmts, sizeof(bool));
+  int len = 0;
+
+  memcpy(key, stmts1, n1 * sizeof(int));
+  qsort(key, n1, sizeof(int), int_compar);
+  len += n1;
+  key[len++] = -1;
+  memcpy(key + len, stmts2, n2 * sizeof(int));
+  qsort(key + len, n2, sizeof(int), int_compar);
+  len += n2;
+  key[len++] = -1;
+
+  for (int i = 0; i < n1; i++) {
+    in_pair[stmts1[i]] = true;
+  }
+  for (int i = 0; i < n2; i++) {
+    in_pair[stmts2[i]] = true;
+  }
+  /* RAR dependences are included even if they are not considered; this can
+   * only cause extra misses, not stale hits. */
+  for (int i = 0; i < ndeps; i++) {
+    if (!dep_is_satisfied(deps[i]) && in_pair[deps[i]->src] &&
+        in_pair[deps[i]->dest]) {
+      key[len++] = i;
+    }
+  }
+  free(in_pair);
+  *key_len = len;
+  return key;
+}
+
+/// Returns the cache entry for the given key, creating an empty one if there
+/// is none. Takes ownership of key.
+static FcgLpCacheEntry *fcg_lp_cache_lookup(PlutoProg *prog, int *key,
+                                            int key_len, int ndims1,
+                                            int ndims2) {
+  if (prog->fcg_lp_cache == NULL) {
+    struct fcgLpCache *cache =
+        (struct fcgLpCache *)malloc(sizeof(struct fcgLpCache));
+    cache->nbuckets = PLMAX(64, prog->nstmts * prog->nstmts);
+    cache->buckets = (FcgLpCacheEntry **)calloc(cache->nbuckets,
+                                                sizeof(FcgLpCacheEntry *));
+    prog->fcg_lp_cache = cache;
+  }
+  struct fcgLpCache *cache = prog->fcg_lp_cache;
+
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < key_len; i++) {
+    hash = (hash ^ (uint32_t)key[i]) * 16777619u;
+  }
+  FcgLpCacheEntry **bucket = &cache->buckets[hash % cache->nbuckets];
+
+  for (FcgLpCacheEntry *e = *bucket; e != NULL; e = e->next) {
+    if (e->key_len == key_len && !memcmp(e->key, key, key_len * sizeof(int))) {
+      assert(e->ndims1 == ndims1 && e->ndims2 == ndims2);
+      free(key);
+      return e;
+    }
+  }
+
+  FcgLpCacheEntry *e = (FcgLpCacheEntry *)malloc(sizeof(FcgLpCacheEntry));
+  e->key = key;
+  e->key_len = key_len;
+  e->ndims1 = ndims1;
+  e->ndims2 = ndims2;
+  e->results = (FcgLpResult *)calloc(PLMAX(1, ndims1 * ndims2),
+                                     sizeof(FcgLpResult));
+  e->next = *bucket;
+  *bucket = e;
+  return e;
+}
+
+/// Frees the memoized fusion LP outcomes of prog.
+void fcg_lp_cache_free(PlutoProg *prog) {
+  struct fcgLpCache *cache = prog->fcg_lp_cache;
+  if (cache == NULL) {
+    return;
+  }
+  for (unsigned i = 0; i < cache->nbuckets; i++) {
+    FcgLpCacheEntry *e = cache->buckets[i];
+    while (e != NULL) {
+      FcgLpCacheEntry *next = e->next;
+      free(e->key);
+      free(e->results);
+      free(e);
+      e = next;
+    }
+  }
+  free(cache->buckets);
+  free(cache);
+  prog->fcg_lp_cache = NULL;
+}
+
+/// Solves the fusion LPs of ntasks dimension pairs. The LP for task t is cst
+/// with the lower bounds of rows[offsets[t]] ... rows[offsets[t+1]-1] set to 1.
+/// The LPs are independent of each other; each one works on its own copy of
+/// cst, and they are solved in parallel when OpenMP is available. The solvers
+/// write their problems to fixed file names with --debug, so the LPs are
+/// solved serially then. Outcomes of LPs that ran into the compile time
+/// budget's deadline are left unknown.
+static void fcg_solve_pair_lps(PlutoConstraints *cst, PlutoMatrix *obj,
+                               int ntasks, const int *rows, const int *offsets,
+                               FcgLpResult **results, PlutoProg *prog) {
+  PlutoOptions *options = cst->context->options;
+  int npar = prog->npar;
+
+  if (ntasks == 0) {
+    return;
+  }
+
+  prog->num_lp_calls += ntasks;
+  double tstart = rtclock();
+#pragma omp parallel for schedule(dynamic) if (ntasks > 1 && !options->debug)
+  for (int t = 0; t < ntasks; t++) {
+    PlutoConstraints *lpcst = pluto_constraints_dup(cst);
+    for (int r = offsets[t]; r < offsets[t + 1]; r++) {
+      lpcst->val[rows[r]][lpcst->ncols - 1] = -1;
+      lpcst->is_eq[rows[r]] = 0;
+    }
+    double *sol = pluto_fusion_constraints_feasibility_solve(lpcst, obj);
+    FcgLpResult *res = results[t];
+    /* An LP cut short by the compile time budget's deadline is taken as
+     * infeasible for now, but not memoized: it is solved again when the FCG
+     * is rebuilt, possibly with the time of a fallback strategy. */
+    res->known = (sol != NULL || !cst->context->solver_timed_out);
+    res->feasible = (sol != NULL);
+    if (sol != NULL) {
+      res->parallel = is_lp_solution_parallel(sol, npar);
+      res->dep_dist = get_dep_dist_from_pluto_sol(sol, npar);
+      free(sol);
+    }
+    pluto_constraints_free(lpcst);
+  }
+  prog->mipTime += rtclock() - tstart;
+}
+
 /// Adds edges in FCG corresponding to the statements represented by the nodes
 /// v1 and v2 in DDG.
 void fcg_add_pairwise_edges(Graph *fcg, int v1, int v2, PlutoProg *prog,
@@ -292,8 +472,25 @@ void fcg_add_pairwise_edges(Graph *fcg, int v1, int v2, PlutoProg *prog,
   }
 
   /* Solve Pluto LP by setting corresponding coeffs to 0 without any objective.
-   * This is the check for fusability of two dimensions */
-  for (int i = 0; i < stmts[v1]->dim_orig; i++) {
+   * This is the check for fusability of two dimensions. Outcomes already known
+   * from an earlier construction of the FCG are reused; the remaining LPs are
+   * collected first and solved together. */
+  int ndims1 = stmts[v1]->dim_orig;
+  int ndims2 = stmts[v2]->dim_orig;
+  int key_len;
+  int *key = fcg_lp_cache_key(&v1, 1, &v2, 1, prog, &key_len);
+  FcgLpCacheEntry *entry =
+      fcg_lp_cache_lookup(prog, key, key_len, ndims1, ndims2);
+
+  int npairs = 0, ntasks = 0;
+  int *pairs = (int *)malloc(PLMAX(1, ndims1 * ndims2) * sizeof(int));
+  int *rows = (int *)malloc(PLMAX(1, 2 * ndims1 * ndims2) * sizeof(int));
+  int *offsets = (int *)malloc((ndims1 * ndims2 + 1) * sizeof(int));
+  FcgLpResult **results = (FcgLpResult **)malloc(
+      PLMAX(1, ndims1 * ndims2) * sizeof(FcgLpResult *));
+  offsets[0] = 0;
+
+  for (int i = 0; i < ndims1; i++) {
     /* note that the vertex should not be coloured. Even if the vertex has a
      * self edge, it must be considered during construction of the FCG. This
      * is because,even after satisfying the permute preventing dep, it might
@@ -306,64 +503,56 @@ void fcg_add_pairwise_edges(Graph *fcg, int v1, int v2, PlutoProg *prog,
     if (fcg->adj->val[fcg_offset1 + i][fcg_offset1 + i] == 1) {
       /* Do not solve LPs if a dimenion of a
        * statement is not permutable */
-      for (int j = 0; j < stmts[v2]->dim_orig; j++) {
+      for (int j = 0; j < ndims2; j++) {
         fcg->adj->val[fcg_offset1 + i][fcg_offset2 + j] = 1;
       }
       continue;
     }
 
-    /* Set the lower bound of i^th dimension of v1 to 1 */
-    conflictcst->val[row_offset + src_offset + i][CST_WIDTH - 1] = -1;
-    conflictcst->is_eq[row_offset + src_offset + i] = 0;
-
-    for (int j = 0; j < stmts[v2]->dim_orig; j++) {
+    for (int j = 0; j < ndims2; j++) {
       if (colour[fcg_offset2 + j] != 0 &&
           colour[fcg_offset2 + j] != current_colour) {
         continue;
       }
-      if (fcg->adj->val[fcg_offset1 + i][fcg_offset1 + i] == 1) {
-        fcg->adj->val[fcg_offset1 + i][fcg_offset2 + j] = 1;
+      FcgLpResult *res = &entry->results[i * ndims2 + j];
+      pairs[npairs++] = i * ndims2 + j;
+      if (res->known) {
+        prog->num_fcg_lp_reused++;
         continue;
       }
+      /* Set the lower bounds of the i^th dimension of v1 and the j^th
+       * dimension of v2 to 1 */
+      rows[offsets[ntasks]] = row_offset + src_offset + i;
+      rows[offsets[ntasks] + 1] = row_offset + dest_offset + j;
+      offsets[ntasks + 1] = offsets[ntasks] + 2;
+      results[ntasks++] = res;
+    }
+  }
 
-      /* Set the lower bound of i^th dimension of v1 to 1 */
-      conflictcst->val[row_offset + dest_offset + j][CST_WIDTH - 1] = -1;
-      conflictcst->is_eq[row_offset + dest_offset + j] = 0;
+  fcg_solve_pair_lps(conflictcst, obj, ntasks, rows, offsets, results, prog);
 
-      /* Check if fusing ith dimesion of the source with ith dimension
-       * of the target is valid */
-      prog->num_lp_calls++;
-      double tstart = rtclock();
-      double *sol =
-          pluto_fusion_constraints_feasibility_solve(conflictcst, obj);
-      prog->mipTime += rtclock() - tstart;
-
-      /* If no solutions, then dimensions are not fusable.
-       * Add an edge in the conflict graph. */
-      if (sol == NULL) {
-        IF_DEBUG(printf("Unable to fuse dimension %d of statement %d", i, v1););
-        IF_DEBUG(printf("with dimension %d of statement %d \n", j, v2););
-        IF_DEBUG(printf(" Adding edge %d to %d in fcg\n", fcg_offset1 + i,
-                        fcg_offset2 + j););
-        fcg->adj->val[fcg_offset1 + i][fcg_offset2 + j] = 1;
-      } else {
-        if (check_parallel && !is_lp_solution_parallel(sol, npar)) {
-          /* Add parallelism preventing edge */
-          fcg->adj->val[fcg_offset1 + i][fcg_offset2 + j] = 1;
-        }
-        free(sol);
-      }
-      /* Unset the lowerbound for the coefficient of c_j.
-       * The same constraint matrix is reused for all coeffs. */
-      conflictcst->val[row_offset + dest_offset + j][CST_WIDTH - 1] = 0;
-      conflictcst->is_eq[row_offset + dest_offset + j] = 1;
+  for (int k = 0; k < npairs; k++) {
+    int i = pairs[k] / ndims2;
+    int j = pairs[k] % ndims2;
+    FcgLpResult *res = &entry->results[pairs[k]];
+    /* If no solutions, then dimensions are not fusable.
+     * Add an edge in the conflict graph. */
+    if (!res->feasible) {
+      IF_DEBUG(printf("Unable to fuse dimension %d of statement %d", i, v1););
+      IF_DEBUG(printf("with dimension %d of statement %d \n", j, v2););
+      IF_DEBUG(printf(" Adding edge %d to %d in fcg\n", fcg_offset1 + i,
+                      fcg_offset2 + j););
+      fcg->adj->val[fcg_offset1 + i][fcg_offset2 + j] = 1;
+    } else if (check_parallel && !res->parallel) {
+      /* Add parallelism preventing edge */
+      fcg->adj->val[fcg_offset1 + i][fcg_offset2 + j] = 1;
     }
-
-    /* Unset the lowerbound for the coefficient of c_i.
-     * The same constraint matrix is reused for all coeffs. */
-    conflictcst->val[row_offset + src_offset + i][CST_WIDTH - 1] = 0;
-    conflictcst->is_eq[row_offset + src_offset + i] = 1;
   }
+
+  free(pairs);
+  free(rows);
+  free(offsets);
+  free(results);
   conflictcst->nrows = row_offset + CST_WIDTH - 1;
   return;
 }
@@ -477,8 +666,29 @@ void fcg_scc_cluster_add_inter_scc_edges(Graph *fcg, int *colour,
         int stmt2_offset = npar + 1 + (nvar + 1) * stmt2;
         inter_scc_cst->is_eq[row_offset + stmt2_offset + nvar] = 0;
       }
-      /* Check for pairwise permutability of dimensions between scc1 and scc2 */
-      for (int dim1 = 0; dim1 < sccs[scc1].max_dim; dim1++) {
+      /* Check for pairwise permutability of dimensions between scc1 and scc2.
+       * Outcomes known from an earlier construction of the FCG are reused;
+       * the remaining LPs are collected first and solved together. */
+      int ndims1 = sccs[scc1].max_dim;
+      int ndims2 = sccs[scc2].max_dim;
+      int key_len;
+      int *key = fcg_lp_cache_key(sccs[scc1].vertices, sccs[scc1].size,
+                                  sccs[scc2].vertices, sccs[scc2].size, prog,
+                                  &key_len);
+      FcgLpCacheEntry *entry =
+          fcg_lp_cache_lookup(prog, key, key_len, ndims1, ndims2);
+
+      int npairs = 0, ntasks = 0;
+      int max_pairs = PLMAX(1, ndims1 * ndims2);
+      int *pairs = (int *)malloc(max_pairs * sizeof(int));
+      int *rows = (int *)malloc(
+          max_pairs * (sccs[scc1].size + sccs[scc2].size) * sizeof(int));
+      int *offsets = (int *)malloc((max_pairs + 1) * sizeof(int));
+      FcgLpResult **results =
+          (FcgLpResult **)malloc(max_pairs * sizeof(FcgLpResult *));
+      offsets[0] = 0;
+
+      for (int dim1 = 0; dim1 < ndims1; dim1++) {
 
         if (colour[scc1_fcg_offset + dim1] != 0 &&
             colour[scc1_fcg_offset + dim1] != current_colour) {
@@ -488,24 +698,12 @@ void fcg_scc_cluster_add_inter_scc_edges(Graph *fcg, int *colour,
          * solve LP's. Just add edges to all dimensions of SCC2. */
         if (fcg->adj->val[scc1_fcg_offset + dim1][scc1_fcg_offset + dim1] ==
             1) {
-          for (int dim2 = 0; dim2 < sccs[scc2].max_dim; dim2++) {
+          for (int dim2 = 0; dim2 < ndims2; dim2++) {
             fcg->adj->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] = 1;
           }
           continue;
         }
-        /* Set lb of dim1 of each statement in Scc 1 */
-        for (int i = 0; i < sccs[scc1].size; i++) {
-          int stmt1 = sccs[scc1].vertices[i];
-          if (dim1 > stmts[stmt1]->dim_orig) {
-            continue;
-          }
-          int stmt1_offset = npar + 1 + (nvar + 1) * stmt1;
-          inter_scc_cst->val[row_offset + stmt1_offset + dim1][CST_WIDTH - 1] =
-              -1;
-          inter_scc_cst->is_eq[row_offset + stmt1_offset + dim1] = 0;
-        }
-        for (int dim2 = 0; dim2 < sccs[scc2].max_dim; dim2++) {
-          /* Set the lower bounds of dimensions of each statement in SCC2 */
+        for (int dim2 = 0; dim2 < ndims2; dim2++) {
           if (colour[scc2_fcg_offset + dim2] != 0 &&
               colour[scc2_fcg_offset + dim2] != current_colour) {
             continue;
@@ -515,77 +713,75 @@ void fcg_scc_cluster_add_inter_scc_edges(Graph *fcg, int *colour,
             fcg->adj->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] = 1;
             continue;
           }
-          for (int j = 0; j < sccs[scc2].size; j++) {
-            int stmt2 = sccs[scc2].vertices[j];
-            if (dim2 <= stmts[stmt2]->dim_orig) {
-              int stmt2_offset = npar + 1 + (nvar + 1) * stmt2;
-              inter_scc_cst
-                  ->val[row_offset + stmt2_offset + dim2][CST_WIDTH - 1] = -1;
-              inter_scc_cst->is_eq[row_offset + stmt2_offset + dim2] = 0;
-            }
+          FcgLpResult *res = &entry->results[dim1 * ndims2 + dim2];
+          pairs[npairs++] = dim1 * ndims2 + dim2;
+          if (res->known) {
+            prog->num_fcg_lp_reused++;
+            continue;
           }
-
-          /* Check if fusing ith dimesion of the source with i^th
-           * dimension of the target is valid */
-          prog->num_lp_calls++;
-          double tstart = rtclock();
-          double *sol =
-              pluto_fusion_constraints_feasibility_solve(inter_scc_cst, obj);
-          prog->mipTime += rtclock() - tstart;
-
-          /* If no solutions, then dimensions are not fusable.
-           * Hence add an edge in the conflict graph. */
-          if (sol == NULL) {
-            IF_DEBUG(printf("Unable to fuse dim %d of scc %d", dim1, scc1););
-            IF_DEBUG(printf(" with dim %d of scc %d \n", dim2, scc2););
-            IF_DEBUG(printf(" Adding edge %d to %d in fcg\n",
-                            scc1_fcg_offset + dim1, scc2_fcg_offset + dim2););
-            fcg->adj->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] = 1;
-          } else {
-            if (options->lpcolour) {
-              dep_dist_mat
-                  ->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] =
-                  get_dep_dist_from_pluto_sol(sol, npar);
-              IF_DEBUG(
-                  printf(
-                      "Dependence distance between dims %d and %d\n of SCCs %d "
-                      "and %d: %ld\n",
-                      dim1, dim2, scc1, scc2,
-                      dep_dist_mat->val[scc1_fcg_offset + dim1]
-                                       [scc2_fcg_offset + dim2]););
-            }
-            if (check_parallel && !is_lp_solution_parallel(sol, npar)) {
-              IF_DEBUG(printf("Adding Parallelism preventing edge"););
-              IF_DEBUG(printf("%d to %d in fcg \n", scc1_fcg_offset + dim1,
-                              scc2_fcg_offset + dim2););
-              par_preventing_adj_mat
-                  ->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] = 1;
+          /* Set the lower bounds of dim1 of each statement in SCC1 and of
+           * dim2 of each statement in SCC2 */
+          int nrows = offsets[ntasks];
+          for (int i = 0; i < sccs[scc1].size; i++) {
+            int stmt1 = sccs[scc1].vertices[i];
+            if (dim1 <= stmts[stmt1]->dim_orig) {
+              int stmt1_offset = npar + 1 + (nvar + 1) * stmt1;
+              rows[nrows++] = row_offset + stmt1_offset + dim1;
             }
-            free(sol);
           }
-          /* Reset the lower bounds of dimensions of
-           * each statement in SCC2 */
           for (int j = 0; j < sccs[scc2].size; j++) {
             int stmt2 = sccs[scc2].vertices[j];
             if (dim2 <= stmts[stmt2]->dim_orig) {
               int stmt2_offset = npar + 1 + (nvar + 1) * stmt2;
-              inter_scc_cst
-                  ->val[row_offset + stmt2_offset + dim2][CST_WIDTH - 1] = 0;
-              inter_scc_cst->is_eq[row_offset + stmt2_offset + dim2] = 1;
+              rows[nrows++] = row_offset + stmt2_offset + dim2;
             }
           }
+          offsets[ntasks + 1] = nrows;
+          results[ntasks++] = res;
         }
-        /* Reset lb of dim1 of each statement in Scc 1 */
-        for (int i = 0; i < sccs[scc1].size; i++) {
-          int stmt1 = sccs[scc1].vertices[i];
-          if (dim1 <= stmts[stmt1]->dim_orig) {
-            int stmt1_offset = npar + 1 + (nvar + 1) * stmt1;
-            inter_scc_cst
-                ->val[row_offset + stmt1_offset + dim1][CST_WIDTH - 1] = 0;
-            inter_scc_cst->is_eq[row_offset + stmt1_offset + dim1] = -1;
-          }
+      }
+
+      /* Check if fusing dim1 of scc1 with dim2 of scc2 is valid */
+      fcg_solve_pair_lps(inter_scc_cst, obj, ntasks, rows, offsets, results,
+                         prog);
+
+      for (int k = 0; k < npairs; k++) {
+        int dim1 = pairs[k] / ndims2;
+        int dim2 = pairs[k] % ndims2;
+        FcgLpResult *res = &entry->results[pairs[k]];
+
+        /* If no solutions, then dimensions are not fusable.
+         * Hence add an edge in the conflict graph. */
+        if (!res->feasible) {
+          IF_DEBUG(printf("Unable to fuse dim %d of scc %d", dim1, scc1););
+          IF_DEBUG(printf(" with dim %d of scc %d \n", dim2, scc2););
+          IF_DEBUG(printf(" Adding edge %d to %d in fcg\n",
+                          scc1_fcg_offset + dim1, scc2_fcg_offset + dim2););
+          fcg->adj->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] = 1;
+          continue;
+        }
+        if (options->lpcolour) {
+          dep_dist_mat->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] =
+              res->dep_dist;
+          IF_DEBUG(printf("Dependence distance between dims %d and %d\n of "
+                          "SCCs %d and %d: %ld\n",
+                          dim1, dim2, scc1, scc2,
+                          dep_dist_mat->val[scc1_fcg_offset + dim1]
+                                           [scc2_fcg_offset + dim2]););
+        }
+        if (check_parallel && !res->parallel) {
+          IF_DEBUG(printf("Adding Parallelism preventing edge"););
+          IF_DEBUG(printf("%d to %d in fcg \n", scc1_fcg_offset + dim1,
+                          scc2_fcg_offset + dim2););
+          par_preventing_adj_mat
+              ->val[scc1_fcg_offset + dim1][scc2_fcg_offset + dim2] = 1;
         }
       }
+
+      free(pairs);
+      free(rows);
+      free(offsets);
+      free(results);
     }
   }
   pluto_constraints_free(inter_scc_cst);
@@ -1287,38 +1483,6 @@ bool is_discarded(int v, int *list, int num) {
   return false;
 }
 
-/// Routine that returns the next vertex to be coloured. Currently returns the
-/// next vertex in the which is given by the ordering of the input loops. If lp
-/// colour flag is turned on, then it returns the vertex which had a non zero
-/// value in the solution of pluto-lp for the SCC to which the given vertex
-/// belongs.
-int get_next_min_vertex(int fcg_stmt_offset, int stmt_id, int *list, int num,
-                        int pv, PlutoProg *prog) {
-  PlutoContext *context = prog->context;
-  PlutoOptions *options = context->options;
-  int nvar = prog->nvar;
-  int npar = prog->npar;
-  Stmt **stmts = prog->stmts;
-  int min = 0;
-
-  for (int i = 0; i < stmts[stmt_id]->dim_orig; i++) {
-    if (!is_discarded(fcg_stmt_offset + i, list, num)) {
-      if (options->lpcolour) {
-        int scc_id = stmts[stmt_id]->scc_id;
-        double *sol = prog->ddg->sccs[scc_id].sol;
-        assert(sol != NULL);
-        int stmt_offset = npar + 1 + (nvar + 1) * stmt_id + i;
-        if (sol[stmt_offset] == 0.0f) {
-          continue;
-        }
-      }
-      min = i;
-      break;
-    }
-  }
-  return min;
-}
-
 /* Fix: Modify this routine to handle single SCC case.
  * Routine is called with unclustered approach with typed fuse. Currently not
  * supported.
@@ -1441,17 +1605,267 @@ void cut_around_scc(int scc_id, PlutoProg *prog) {
   }
 }
 
-/// Colours the input SCC recursively. The statement pos refers to the position
-/// of the statement in the list of vertices in the scc and pv refers to the
-/// previous vertex. Returns true if the colouring is successful; else returns
-/// false.
+/// State of the search that colours one dimension of each statement of an SCC
+/// with colour c (see colour_scc). Local vertex k stands for the FCG vertex
+/// vertex[k] of the statement at position pos[k] of the SCC. sat[k] is the
+/// number of FCG neighbours of vertex[k] coloured c, i.e., the saturation of k
+/// w.r.t c, and k can be coloured c only if it is zero. nbrs[k] lists the
+/// local vertices adjacent to k, so that saturations are updated in time
+/// proportional to the degree within the SCC instead of rescanning the FCG.
+/// viable[p] is the number of candidate dimensions of the statement at
+/// position p that can still be coloured c; a partial colouring is abandoned
+/// as soon as a statement yet to be coloured has none left.
+typedef struct sccColouringState {
+  int c;
+  /* Number of statements in the SCC */
+  int nstmts;
+  int nvertices;
+  int *vertex;
+  int *pos;
+  /* Candidate dimensions of the statement at position p in the order they are
+   * tried: order[pos_start[p]] ... order[pos_start[p+1] - 1] */
+  int *pos_start;
+  int *order;
+  /* Coloured with a different colour or has a self edge in the FCG */
+  bool *is_blocked;
+  bool *is_candidate;
+  int *sat;
+  int **nbrs;
+  int *num_nbrs;
+  int *viable;
+  /* Pruning on viable is exact only when saturations never decrease during
+   * the search, i.e., when no vertex of the SCC is coloured c to start with */
+  bool prune;
+} SccColouringState;
+
+/// Sets up the colouring state of SCC scc_id for colour c. The candidate
+/// dimensions of a statement are tried in the order of the input loops; with
+/// lpcolour, only the dimensions with a non-zero component in the LP solution
+/// of the SCC are tried, followed by the first dimension (same order as the
+/// earlier linear scan in colour_scc).
+static SccColouringState *scc_colouring_state_alloc(int scc_id, int *colour,
+                                                    int c, PlutoProg *prog) {
+  PlutoOptions *options = prog->context->options;
+  int nvar = prog->nvar;
+  int npar = prog->npar;
+  Graph *ddg = prog->ddg;
+  Graph *fcg = prog->fcg;
+  Stmt **stmts = prog->stmts;
+  Scc *scc = &ddg->sccs[scc_id];
+  int64_t **adj = fcg->adj->val;
+
+  SccColouringState *state =
+      (SccColouringState *)malloc(sizeof(SccColouringState));
+  state->c = c;
+  state->nstmts = scc->size;
+
+  int n = 0;
+  for (int p = 0; p < scc->size; p++) {
+    n += stmts[scc->vertices[p]]->dim_orig;
+  }
+  state->nvertices = n;
+  state->vertex = (int *)malloc(n * sizeof(int));
+  state->pos = (int *)malloc(n * sizeof(int));
+  state->order = (int *)malloc(n * sizeof(int));
+  state->pos_start = (int *)malloc((scc->size + 1) * sizeof(int));
+  state->is_blocked = (bool *)malloc(n * sizeof(bool));
+  state->is_candidate = (bool *)malloc(n * sizeof(bool));
+  state->sat = (int *)malloc(n * sizeof(int));
+  state->nbrs = (int **)malloc(n * sizeof(int *));
+  state->num_nbrs = (int *)malloc(n * sizeof(int));
+  state->viable = (int *)malloc(scc->size * sizeof(int));
+  state->prune = true;
+
+  int k = 0, num_ordered = 0;
+  for (int p = 0; p < scc->size; p++) {
+    int stmt_id = scc->vertices[p];
+    int fcg_offset = ddg->vertices[stmt_id].fcg_stmt_offset;
+    /* Scalar statements are never coloured: they are in SCCs of their own
+     * whose dimensionality is zero. */
+    assert(stmts[stmt_id]->dim_orig > 0);
+    state->pos_start[p] = num_ordered;
+    int first = k;
+    for (int j = 0; j < stmts[stmt_id]->dim_orig; j++, k++) {
+      int v = fcg_offset + j;
+      state->vertex[k] = v;
+      state->pos[k] = p;
+      state->is_blocked[k] = (colour[v] > 0 && colour[v] != c) || adj[v][v];
+      state->is_candidate[k] = true;
+      if (options->lpcolour) {
+        double *sol = scc->sol;
+        assert(sol != NULL);
+        state->is_candidate[k] =
+            (sol[npar + 1 + (nvar + 1) * stmt_id + j] != 0.0f);
+      }
+      if (state->is_candidate[k]) {
+        state->order[num_ordered++] = k;
+      }
+      if (colour[v] == c) {
+        state->prune = false;
+      }
+    }
+    if (!state->is_candidate[first]) {
+      state->is_candidate[first] = true;
+      state->order[num_ordered++] = first;
+    }
+  }
+  state->pos_start[scc->size] = num_ordered;
+
+  /* Saturation w.r.t vertices outside the SCC does not change during the
+   * search; compute it once. */
+  for (k = 0; k < n; k++) {
+    int v = state->vertex[k];
+    state->sat[k] = 0;
+    for (int i = 0; i < fcg->nVertices; i++) {
+      if (i != v && colour[i] == c && (adj[i][v] == 1 || adj[v][i] == 1)) {
+        state->sat[k]++;
+      }
+    }
+  }
+
+  int *nbrs = (int *)malloc(n * sizeof(int));
+  for (k = 0; k < n; k++) {
+    int v = state->vertex[k];
+    int num = 0;
+    for (int l = 0; l < n; l++) {
+      int u = state->vertex[l];
+      if (l != k && (adj[u][v] == 1 || adj[v][u] == 1)) {
+        nbrs[num++] = l;
+      }
+    }
+    state->num_nbrs[k] = num;
+    state->nbrs[k] = (int *)malloc(num * sizeof(int));
+    memcpy(state->nbrs[k], nbrs, num * sizeof(int));
+  }
+  free(nbrs);
+
+  for (int p = 0; p < scc->size; p++) {
+    state->viable[p] = 0;
+  }
+  for (k = 0; k < n; k++) {
+    if (state->is_candidate[k] && !state->is_blocked[k] && state->sat[k] == 0) {
+      state->viable[state->pos[k]]++;
+    }
+  }
+  return state;
+}
+
+static void scc_colouring_state_free(SccColouringState *state) {
+  for (int k = 0; k < state->nvertices; k++) {
+    free(state->nbrs[k]);
+  }
+  free(state->nbrs);
+  free(state->num_nbrs);
+  free(state->viable);
+  free(state->sat);
+  free(state->is_candidate);
+  free(state->is_blocked);
+  free(state->pos_start);
+  free(state->order);
+  free(state->pos);
+  free(state->vertex);
+  free(state);
+}
+
+/// Sets the colour of local vertex k to new_colour (either the current colour
+/// or zero) and updates the saturation of its neighbours.
+static void scc_colouring_set_colour(SccColouringState *state, int *colour,
+                                     int k, int new_colour) {
+  int v = state->vertex[k];
+  bool was_c = colour[v] == state->c;
+  colour[v] = new_colour;
+  if (was_c == (new_colour == state->c))
+    return;
+
+  for (int i = 0; i < state->num_nbrs[k]; i++) {
+    int l = state->nbrs[k][i];
+    bool counts = state->is_candidate[l] && !state->is_blocked[l];
+    if (was_c) {
+      state->sat[l]--;
+      if (counts && state->sat[l] == 0)
+        state->viable[state->pos[l]]++;
+    } else {
+      if (counts && state->sat[l] == 0)
+        state->viable[state->pos[l]]--;
+      state->sat[l]++;
+    }
+  }
+}
+
+/// Colours one dimension each of the statements at positions stmt_pos onwards
+/// in the SCC with the current colour; pv is the FCG vertex coloured last.
+/// Dimensions are tried in the same order as before and the first colouring
+/// found is the same as that of an exhaustive search; statements that cannot
+/// be coloured any more only cut the search short.
+static bool colour_scc_dims(SccColouringState *state, int *colour,
+                            int stmt_pos, int pv, PlutoProg *prog) {
+  PlutoContext *context = prog->context;
+  Graph *fcg = prog->fcg;
+  int nstmts_scc = state->nstmts;
+  int c = state->c;
+
+  if (stmt_pos >= nstmts_scc) {
+    return true;
+  }
+
+  for (int i = state->pos_start[stmt_pos]; i < state->pos_start[stmt_pos + 1];
+       i++) {
+    int k = state->order[i];
+    int v = state->vertex[k];
+
+    /* Already coloured with a different colour, or not permutable (self
+     * edge). */
+    if (state->is_blocked[k]) {
+      continue;
+    }
+
+    if (state->sat[k] > 0) {
+      /* An adjacent vertex has colour c. */
+      if (pv < 0 || !is_adjacent(fcg, v, pv)) {
+        scc_colouring_set_colour(state, colour, k, 0);
+      }
+      continue;
+    }
+
+    IF_DEBUG(printf("[Colour SCC] Trying Colouring FCG vertex %d with colour "
+                    "%d\n",
+                    v, c););
+    scc_colouring_set_colour(state, colour, k, c);
+
+    bool is_dead_end = false;
+    if (state->prune) {
+      for (int p = stmt_pos + 1; p < nstmts_scc; p++) {
+        if (state->viable[p] == 0) {
+          is_dead_end = true;
+          break;
+        }
+      }
+    }
+
+    if (!is_dead_end && colour_scc_dims(state, colour, stmt_pos + 1, v, prog)) {
+      IF_DEBUG(printf("[Colour SCC] Coloured FCG vertex %d with colour %d\n",
+                      v, c););
+      return true;
+    }
+    IF_DEBUG(printf("[Colour SCC] Unable to colour FCG vertex %d with colour "
+                    "%d\n",
+                    v, c););
+    /* Undo the colouring. Try the next vertex. */
+    scc_colouring_set_colour(state, colour, k, 0);
+  }
+  return false;
+}
+
+/// Colours the input SCC starting from the statement at position stmt_pos in
+/// the list of vertices in the scc; pv refers to the previous vertex coloured.
+/// The search is done on a colouring state that tracks the saturation of the
+/// vertices of the SCC (see SccColouringState). Returns true if the colouring
+/// is successful; else returns false.
 bool colour_scc(int scc_id, int *colour, int c, int stmt_pos, int pv,
                 PlutoProg *prog) {
   PlutoContext *context = prog->context;
   PlutoOptions *options = context->options;
-  int nvar = prog->nvar;
   Graph *ddg = prog->ddg;
-  Graph *fcg = prog->fcg;
   Scc *sccs = ddg->sccs;
 
   /* ToDo: Check if this condition can really happen.  */
@@ -1510,79 +1924,10 @@ bool colour_scc(int scc_id, int *colour, int c, int stmt_pos, int pv,
     return true;
   }
 
-  int stmt_id = sccs[scc_id].vertices[stmt_pos];
-  int fcg_offset = ddg->vertices[stmt_id].fcg_stmt_offset;
-  int list[nvar];
-  int num_discarded = 0;
-  bool is_parallel = false;
-
-  while (num_discarded != nvar) {
-    int j =
-        get_next_min_vertex(fcg_offset, stmt_id, list, num_discarded, pv, prog);
-    if (options->scc_cluster) {
-      IF_DEBUG(printf("[Colour SCC] Trying Colouring dimension %d of scc %d "
-                      "with colour %d\n",
-                      j, scc_id, c););
-    } else {
-      IF_DEBUG(printf("[Colour SCC] Trying Colouring dimension %d of statement "
-                      "%d with colour %d\n",
-                      j, stmt_id, c););
-    }
-
-    int v = fcg_offset + j;
-
-    /* If the dimension is already coloured with a different colour.
-     * Else it tries to check if the existing colour is fine. This is done
-     * as opposed to undoing the existing colour and then redoing it in
-     * the next step once FCG is rebuilt */
-    if (colour[v] > 0 && colour[v] != c) {
-      IF_DEBUG(printf("[Colour SCC]Dimension %d of statement %d already "
-                      "coloured with colour %d\n",
-                      j, stmt_id, colour[v]););
-      list[num_discarded] = v;
-      num_discarded++;
-      continue;
-    }
-
-    /* Can not colour a vertex with a self edge.
-     * This dimension is not permutable */
-    if (fcg->adj->val[v][v] != 0) {
-      list[num_discarded] = v;
-      num_discarded++;
-      continue;
-    }
-
-    /* FIXME: This check is redundant and is covered in the next condition. */
-    if (pv >= 0 && is_adjacent(fcg, v, pv)) {
-      list[num_discarded] = v;
-      num_discarded++;
-      continue;
-    }
-
-    /* Check if this is a valid colour */
-    if (is_valid_colour(v, c, fcg, colour, is_parallel)) {
-      colour[v] = c;
-      /* If this is a valid colour, then try colouring the next vertex in the
-       * SCC */
-      if (colour_scc(scc_id, colour, c, stmt_pos + 1, v, prog)) {
-        IF_DEBUG(printf("[Colour SCC] Colouring dimension %d", j););
-        IF_DEBUG(printf("of statement %d with colour %d\n", stmt_id, c););
-        return true;
-      } else {
-        list[num_discarded] = v;
-        num_discarded++;
-        IF_DEBUG(printf("[Colour SCC] Unable to colour dimension %d of", j););
-        IF_DEBUG(printf("statement %d with colour %d\n", stmt_id, c););
-        /* Undo the colouring. Try the next vertex. */
-        colour[v] = 0;
-      }
-    } else {
-      colour[v] = 0;
-      list[num_discarded] = v;
-      num_discarded++;
-    }
-  }
-  return false;
+  SccColouringState *state = scc_colouring_state_alloc(scc_id, colour, c, prog);
+  bool is_coloured = colour_scc_dims(state, colour, stmt_pos, pv, prog);
+  scc_colouring_state_free(state);
+  return is_coloured;
 }
 
 /// Checks if the input SCC (given by scc_id) is connected by must distribute
@@ -2765,6 +3110,17 @@ void find_permutable_dimensions_scc_based(int *colour, PlutoProg *prog) {
   }
 
   for (int i = 1; i <= max_colours; i++) {
+    /* Out of compile time budget: stop colouring; pluto_auto_transform falls
+     * back to the original schedule. */
+    if (pluto_time_budget_fallback(prog) != kBudgetNoFallback) {
+      PLUTO_MESSAGE(printf("[pluto] Compile time budget of %0.2lfs exhausted "
+                           "at colour %d; falling back to %s\n",
+                           options->time_budget, i,
+                           pluto_budget_fallback_str(
+                               kBudgetOriginalFallback)););
+      prog->budget_fallback = kBudgetOriginalFallback;
+      break;
+    }
     IF_DEBUG(printf("Colouring FCG with colour %d\n", i););
     for (int j = 0; j < prog->ddg->num_sccs; j++) {
       prog->ddg->sccs[j].is_scc_coloured = false;
@@ -136,10 +136,21 @@ static inline void find_optimal_solution_gurobi(GRBmodel *lp, double tol) {
   GRBoptimize(lp);
 }
 
+/// Makes the solve of lp subject to context->solver_deadline, the deadline
+/// that the compile time budget sets for scheduling ILPs/LPs.
+static void set_gurobi_time_limit(GRBmodel *lp, PlutoContext *context) {
+  double time_left = pluto_solver_time_left(context);
+  if (time_left >= 0.0) {
+    GRBsetdblparam(GRBgetenv(lp), "TimeLimit", time_left);
+  }
+}
+
 /// Solve the gurobi problem lp. If optimal solution is found, then it returns
 /// 0. The caller can retrive the funtion from the gurobi model object lp. If
 /// the problem is infeasible then the routine returns 1. If the problem is
-/// unbounded, program terminates with the corresponding error message.
+/// unbounded, program terminates with the corresponding error message. If the
+/// solve hits its time limit, context->solver_timed_out is set and the best
+/// integer solution found so far (if any) is returned.
 bool pluto_constraints_solve_gurobi(GRBmodel *lp, double tol,
                                     PlutoContext *context) {
   GRBenv *env = NULL;
@@ -149,6 +160,16 @@ bool pluto_constraints_solve_gurobi(GRBmodel *lp, double tol,
   int optim_status;
   GRBgetintattr(lp, GRB_INT_ATTR_STATUS, &optim_status);
 
+  if (optim_status == GRB_TIME_LIMIT) {
+    IF_DEBUG(printf("[pluto] Gurobi: time limit reached\n"););
+    context->solver_timed_out = 1;
+    int sol_count = 0;
+    GRBgetintattr(lp, GRB_INT_ATTR_SOLCOUNT, &sol_count);
+    if (sol_count == 0) {
+      return 1;
+    }
+  }
+
   if (optim_status == GRB_INFEASIBLE) {
     return 1;
   }
@@ -326,6 +347,7 @@ int64_t *pluto_prog_constraints_lexmin_gurobi(const PlutoConstraints *cst,
   GRBsetdblattr(lp, GRB_INT_ATTR_MODELSENSE, GRB_MINIMIZE);
 
   set_gurobi_constraints_from_pluto_constraints(lp, cst);
+  set_gurobi_time_limit(lp, context);
 
   if (options->debug) {
     GRBwrite(lp, "pluto.lp");
@@ -415,6 +437,7 @@ double *pluto_fcg_constraints_lexmin_gurobi(const PlutoConstraints *cst,
   GRBnewmodel(env, &lp, NULL, num_vars, grb_obj, NULL, NULL, vtype, NULL);
 
   set_gurobi_constraints_from_pluto_constraints(lp, cst);
+  set_gurobi_time_limit(lp, context);
 
   if (options->debug) {
     GRBwrite(lp, "pluto-pairwise-constraints-gurobi.lp");
@@ -0,0 +1,651 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE in the
+ * top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ * Hierarchical scheduling for large SCoPs. SCCs of the DDG are grouped into
+ * clusters of bounded size, consecutive in the topological order of the SCCs,
+ * and clusters into fusion groups. Groups are ordered among themselves by an
+ * outermost scalar dimension, which satisfies all inter-group dependences.
+ * Each permutable band is then found by solving one small ILP per cluster
+ * instead of one ILP over all statements, followed by a reduced problem over
+ * one shift per cluster that fuses the clusters of a group.
+ *
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/time.h>
+
+#include "constraints.h"
+#include "ddg.h"
+#include "math_support.h"
+#include "pluto.h"
+#include "pluto/matrix.h"
+#include "pluto/pluto.h"
+#include "program.h"
+
+static double rtclock() {
+  struct timeval Tp;
+  int stat = gettimeofday(&Tp, NULL);
+  if (stat != 0)
+    printf("Error return from gettimeofday: %d", stat);
+  return (Tp.tv_sec + Tp.tv_usec * 1.0e-6);
+}
+
+/// Returns the constraints of cst that involve the statements marked in
+/// in_set, with the columns of all other statements removed. Rows of cst that
+/// couple in_set with other statements are of two kinds. Dependence rows are
+/// homogeneous: if all the other statements they involve are marked in solved,
+/// the solution of those in fsol is substituted into the constant term, and
+/// otherwise (or if solved is NULL) the row is left out. The "at least one
+/// statement" rows of the LAZY mode are not homogeneous: they are restricted
+/// to in_set unless drop_coupling is set, in which case they are left out.
+/// num_coupling is set to the number of LAZY rows kept and num_substituted to
+/// the number of dependence rows kept.
+static PlutoConstraints *
+hier_restrict_constraints(const PlutoConstraints *cst, const bool *in_set,
+                          const bool *solved, const int64_t *fsol,
+                          const PlutoProg *prog, bool drop_coupling,
+                          int *num_coupling, int *num_substituted) {
+  int nstmts = prog->nstmts;
+  int nvar = prog->nvar;
+  int npar = prog->npar;
+
+  int nsub = 0;
+  for (int i = 0; i < nstmts; i++) {
+    nsub += in_set[i];
+  }
+
+  int ncols = npar + 1 + nsub * (nvar + 1) + 1;
+  PlutoConstraints *sub =
+      pluto_constraints_alloc(cst->nrows, ncols, prog->context);
+  sub->ncols = ncols;
+  *num_coupling = 0;
+  *num_substituted = 0;
+
+  for (int r = 0; r < cst->nrows; r++) {
+    bool inside = false, outside = false, unsolved = false;
+    for (int s = 0; s < nstmts; s++) {
+      int offset = npar + 1 + s * (nvar + 1);
+      for (int j = 0; j < nvar + 1; j++) {
+        if (cst->val[r][offset + j] != 0) {
+          if (in_set[s]) {
+            inside = true;
+          } else {
+            outside = true;
+            unsolved = unsolved || solved == NULL || !solved[s];
+          }
+          break;
+        }
+      }
+    }
+    if (!inside && outside) {
+      continue;
+    }
+    int64_t cst_term = cst->val[r][cst->ncols - 1];
+    if (outside) {
+      if (cst_term != 0) {
+        if (drop_coupling)
+          continue;
+        (*num_coupling)++;
+      } else {
+        if (unsolved)
+          continue;
+        for (int s = 0; s < nstmts; s++) {
+          if (in_set[s])
+            continue;
+          int offset = npar + 1 + s * (nvar + 1);
+          for (int j = 0; j < nvar + 1; j++) {
+            cst_term += cst->val[r][offset + j] * fsol[offset + j];
+          }
+        }
+        (*num_substituted)++;
+      }
+    }
+
+    int64_t *row = sub->val[sub->nrows];
+    for (int j = 0; j < npar + 1; j++) {
+      row[j] = cst->val[r][j];
+    }
+    int col = npar + 1;
+    for (int s = 0; s < nstmts; s++) {
+      if (!in_set[s])
+        continue;
+      int offset = npar + 1 + s * (nvar + 1);
+      for (int j = 0; j < nvar + 1; j++) {
+        row[col++] = cst->val[r][offset + j];
+      }
+    }
+    row[col] = cst_term;
+    sub->is_eq[sub->nrows] = cst->is_eq[r];
+    sub->nrows++;
+  }
+
+  return sub;
+}
+
+/// Solves the Pluto ILP sub (as produced by hier_restrict_constraints) for the
+/// statements marked in in_set.
+static int64_t *hier_lexmin(PlutoConstraints *sub, const bool *in_set,
+                            PlutoProg *prog) {
+  int nstmts = prog->nstmts;
+
+  Stmt **sub_stmts = (Stmt **)malloc(nstmts * sizeof(Stmt *));
+  int nsub = 0;
+  for (int i = 0; i < nstmts; i++) {
+    if (in_set[i]) {
+      sub_stmts[nsub++] = prog->stmts[i];
+    }
+  }
+
+  int64_t *sol = pluto_stmts_constraints_lexmin(sub, sub_stmts, nsub, prog);
+
+  free(sub_stmts);
+  return sol;
+}
+
+/// Can the statements in in_set share an outermost permutable hyperplane?
+/// basecst holds the permutability, bounding, and non-trivial solution
+/// constraints of the whole program.
+static bool hier_is_fusable(const PlutoConstraints *basecst,
+                            const bool *in_set, PlutoProg *prog) {
+  int num_coupling, num_substituted;
+  PlutoConstraints *sub =
+      hier_restrict_constraints(basecst, in_set, NULL, NULL, prog, true,
+                                &num_coupling, &num_substituted);
+  int64_t *sol = hier_lexmin(sub, in_set, prog);
+  pluto_constraints_free(sub);
+
+  bool fusable = (sol != NULL);
+  free(sol);
+  return fusable;
+}
+
+/// Is there an unsatisfied dependence between a statement in set1 and one in
+/// set2 (in either direction)?
+static bool hier_sets_connected(const bool *set1, const bool *set2,
+                                const PlutoProg *prog) {
+  PlutoOptions *options = prog->context->options;
+
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (dep_is_satisfied(dep))
+      continue;
+    if (options->rar == 0 && IS_RAR(dep->type))
+      continue;
+    if ((set1[dep->src] && set2[dep->dest]) ||
+        (set2[dep->src] && set1[dep->dest])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Marks in reps the statements of set1 that have an unsatisfied dependence
+/// with a statement of set2 (in either direction), and returns their number.
+static int hier_connected_stmts(const bool *set1, const bool *set2, bool *reps,
+                                const PlutoProg *prog) {
+  PlutoOptions *options = prog->context->options;
+
+  for (int i = 0; i < prog->nstmts; i++) {
+    reps[i] = false;
+  }
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (dep_is_satisfied(dep))
+      continue;
+    if (options->rar == 0 && IS_RAR(dep->type))
+      continue;
+    if (set1[dep->src] && set2[dep->dest]) {
+      reps[dep->src] = true;
+    } else if (set2[dep->src] && set1[dep->dest]) {
+      reps[dep->dest] = true;
+    }
+  }
+
+  int nreps = 0;
+  for (int i = 0; i < prog->nstmts; i++) {
+    nreps += reps[i];
+  }
+  return nreps;
+}
+
+/// Clusters the SCCs of the DDG and groups the clusters into fusion groups.
+/// SCCs are visited in topological order. An SCC joins the current cluster if
+/// the cluster stays within options->hier_cluster_size statements and either
+/// it is not connected to the cluster or the cluster and the SCC can share an
+/// outermost permutable hyperplane (one small ILP); if they can't, the SCC
+/// starts a new cluster in a new fusion group. An SCC that doesn't fit starts
+/// a new cluster, which stays in the current fusion group if the SCC can share
+/// an outermost permutable hyperplane with the statements of the group it
+/// depends on (or that depend on it): the flat ILP restricted to these
+/// representatives decides whether the two clusters can fuse. Clusters of a
+/// group are scheduled together, one after another, by
+/// pluto_hierarchical_constraints_lexmin; fusion groups are ordered by an
+/// outermost scalar hyperplane, which satisfies every dependence between them
+/// since they are contiguous in the topological order. Sets the hier_* fields
+/// of prog; a single cluster means the flat ILP is used.
+void pluto_hierarchical_cluster(PlutoProg *prog) {
+  int nstmts = prog->nstmts;
+  int nvar = prog->nvar;
+  int npar = prog->npar;
+  Stmt **stmts = prog->stmts;
+  Graph *ddg = prog->ddg;
+  int num_sccs = ddg->num_sccs;
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+  int max_size = options->hier_cluster_size;
+
+  double t_start = rtclock();
+
+  free(prog->hier_cluster);
+  free(prog->hier_group);
+  prog->hier_cluster = (int *)malloc(nstmts * sizeof(int));
+  prog->hier_group = (int *)malloc(PLMAX(num_sccs, 1) * sizeof(int));
+  prog->hier_num_clusters = 1;
+  prog->hier_num_groups = 1;
+  prog->hier_max_cluster_size = nstmts;
+  prog->hier_group[0] = 0;
+  for (int i = 0; i < nstmts; i++) {
+    prog->hier_cluster[i] = 0;
+  }
+
+  if (nstmts <= max_size || num_sccs <= 1) {
+    prog->hier_time += rtclock() - t_start;
+    return;
+  }
+
+  PlutoConstraints *basecst =
+      pluto_constraints_dup(get_permutability_constraints(prog));
+  PlutoConstraints *boundcst = get_coeff_bounding_constraints(prog);
+  pluto_constraints_add(basecst, boundcst);
+  pluto_constraints_free(boundcst);
+  PlutoConstraints *nzcst = get_non_trivial_sol_constraints(prog, EAGER);
+  pluto_constraints_add(basecst, nzcst);
+  pluto_constraints_free(nzcst);
+
+  bool *in_cluster = (bool *)calloc(nstmts, sizeof(bool));
+  bool *in_group = (bool *)calloc(nstmts, sizeof(bool));
+  bool *in_scc = (bool *)malloc(nstmts * sizeof(bool));
+  bool *in_union = (bool *)malloc(nstmts * sizeof(bool));
+  int *scc_cluster = (int *)malloc(num_sccs * sizeof(int));
+
+  int cluster = 0, group = 0, cluster_size = 0, max_cluster_size = 0;
+  for (int k = 0; k < num_sccs; k++) {
+    int scc_size = 0;
+    for (int i = 0; i < nstmts; i++) {
+      in_scc[i] = (stmts[i]->scc_id == k);
+      scc_size += in_scc[i];
+    }
+
+    if (k > 0) {
+      bool new_cluster = false, new_group = false;
+      if (cluster_size + scc_size <= max_size) {
+        if (hier_sets_connected(in_cluster, in_scc, prog)) {
+          for (int i = 0; i < nstmts; i++) {
+            in_union[i] = in_cluster[i] || in_scc[i];
+          }
+          new_cluster = new_group = !hier_is_fusable(basecst, in_union, prog);
+        }
+      } else {
+        new_cluster = true;
+        int nreps = hier_connected_stmts(in_group, in_scc, in_union, prog);
+        if (nreps >= 1) {
+          if (nreps + scc_size <= 2 * max_size) {
+            for (int i = 0; i < nstmts; i++) {
+              in_union[i] = in_union[i] || in_scc[i];
+            }
+            new_group = !hier_is_fusable(basecst, in_union, prog);
+          } else {
+            /* Too large to check: the flat ILP might have fused them */
+            new_group = true;
+            prog->hier_size_cuts++;
+          }
+        }
+      }
+      if (new_cluster) {
+        IF_DEBUG(printf("[pluto] hierarchical: cluster %d ends before SCC %d "
+                        "(%s)\n",
+                        cluster, k,
+                        new_group ? "new fusion group" : "size limit"););
+        prog->hier_group[cluster] = group;
+        cluster++;
+        cluster_size = 0;
+        for (int i = 0; i < nstmts; i++) {
+          in_cluster[i] = false;
+        }
+      }
+      if (new_group) {
+        group++;
+        for (int i = 0; i < nstmts; i++) {
+          in_group[i] = false;
+        }
+      }
+    }
+
+    scc_cluster[k] = cluster;
+    cluster_size += scc_size;
+    max_cluster_size = PLMAX(max_cluster_size, cluster_size);
+    for (int i = 0; i < nstmts; i++) {
+      in_cluster[i] = in_cluster[i] || in_scc[i];
+      in_group[i] = in_group[i] || in_scc[i];
+    }
+  }
+  prog->hier_group[cluster] = group;
+
+  prog->hier_num_clusters = cluster + 1;
+  prog->hier_num_groups = group + 1;
+  prog->hier_max_cluster_size = max_cluster_size;
+  for (int i = 0; i < nstmts; i++) {
+    prog->hier_cluster[i] = scc_cluster[stmts[i]->scc_id];
+  }
+
+  free(scc_cluster);
+  free(in_union);
+  free(in_scc);
+  free(in_group);
+  free(in_cluster);
+  pluto_constraints_free(basecst);
+
+  if (prog->hier_num_groups >= 2) {
+    /* Order the fusion groups by their ids at the outermost level */
+    pluto_prog_add_hyperplane(prog, prog->num_hyperplanes, H_SCALAR);
+    for (int i = 0; i < nstmts; i++) {
+      pluto_stmt_add_hyperplane(stmts[i], H_SCALAR, stmts[i]->trans->nrows);
+      for (int j = 0; j < nvar + npar; j++) {
+        stmts[i]->trans->val[stmts[i]->trans->nrows - 1][j] = 0;
+      }
+      stmts[i]->trans->val[stmts[i]->trans->nrows - 1][nvar + npar] =
+          prog->hier_group[prog->hier_cluster[i]];
+    }
+    IF_DEBUG(
+        pluto_transformation_print_level(prog, prog->num_hyperplanes - 1););
+    prog->hier_deps_distributed =
+        dep_satisfaction_update(prog, stmts[0]->trans->nrows - 1);
+    if (prog->hier_deps_distributed >= 1) {
+      ddg_update(ddg, prog);
+    } else {
+      for (int i = 0; i < nstmts; i++) {
+        stmts[i]->trans->nrows--;
+      }
+      prog->num_hyperplanes--;
+    }
+  }
+
+  prog->hier_time += rtclock() - t_start;
+
+  PLUTO_MESSAGE(printf("[pluto] Hierarchical scheduling: %d cluster(s) of at "
+                       "most %d statement(s) in %d fusion group(s) (flat ILP: "
+                       "%d statements)\n",
+                       prog->hier_num_clusters, prog->hier_max_cluster_size,
+                       prog->hier_num_groups, nstmts););
+}
+
+/// Prints what hierarchical scheduling lost with respect to the flat ILP: the
+/// dependences distributed across fusion groups, the group boundaries that
+/// were too large to check for fusability, the total gap between the
+/// dependence distance bounds (sum of u and w) of the hyperplanes found
+/// cluster by cluster and a lower bound on those of the flat ILP, and the
+/// hyperplanes for which the clusters of a fusion group could not be fused.
+void pluto_hierarchical_report(const PlutoProg *prog) {
+  PlutoContext *context = prog->context;
+
+  if (prog->hier_num_clusters <= 1) {
+    return;
+  }
+  PLUTO_MESSAGE(printf("[pluto] Hierarchical scheduling: %d dependence(s) "
+                       "distributed across fusion groups; loss vs. flat ILP: "
+                       "%d unchecked group boundar%s, dependence distance "
+                       "bound +%lld at most, %d failed fusion(s)\n",
+                       prog->hier_deps_distributed, prog->hier_size_cuts,
+                       prog->hier_size_cuts == 1 ? "y" : "ies",
+                       (long long)prog->hier_bound_loss,
+                       prog->hier_fusion_failures););
+}
+
+/// Sum of u and w in the solution sol of a Pluto ILP: the dependence distance
+/// bound that the objective minimizes first.
+static int64_t hier_bound(const int64_t *sol, const PlutoProg *prog) {
+  int64_t bound = 0;
+  for (int j = 0; j < prog->npar + 1; j++) {
+    bound += sol[j];
+  }
+  return bound;
+}
+
+/// Is the (u, w) of sol1 lexicographically greater than that of sol2?
+static bool hier_bound_lexgt(const int64_t *sol1, const int64_t *sol2,
+                             const PlutoProg *prog) {
+  for (int j = 0; j < prog->npar + 1; j++) {
+    if (sol1[j] != sol2[j])
+      return sol1[j] > sol2[j];
+  }
+  return false;
+}
+
+/// Solves the reduced inter-cluster problem of a hyperplane. The solution of
+/// each cluster in fsol is kept up to a shift of the whole cluster (added to
+/// the translation coefficients of its statements), while u and w are free:
+/// every row of cst is rewritten over u, w, and one shift per cluster, which
+/// gives a problem with npar + 1 + hier_num_clusters variables. Its lexmin
+/// minimizes the dependence distance bound over the coupled clusters and then
+/// the shifts; fsol is updated with it. fsol itself (with no shift) is
+/// feasible, so it is left as is if the problem can't be solved.
+static void hier_solve_inter_cluster(const PlutoConstraints *cst,
+                                     int64_t *fsol, const PlutoProg *prog) {
+  int nstmts = prog->nstmts;
+  int npar = prog->npar;
+  int nvar = prog->nvar;
+  int num_clusters = prog->hier_num_clusters;
+  int *cluster = prog->hier_cluster;
+  PlutoContext *context = prog->context;
+
+  int ncols = npar + 1 + num_clusters + 1;
+  PlutoConstraints *rcst = pluto_constraints_alloc(cst->nrows, ncols, context);
+  rcst->ncols = ncols;
+
+  for (int r = 0; r < cst->nrows; r++) {
+    int64_t *row = rcst->val[rcst->nrows];
+    for (int j = 0; j < ncols; j++) {
+      row[j] = 0;
+    }
+    bool has_var = false;
+    for (int j = 0; j < npar + 1; j++) {
+      row[j] = cst->val[r][j];
+      has_var = has_var || row[j] != 0;
+    }
+    int64_t cst_term = cst->val[r][cst->ncols - 1];
+    for (int s = 0; s < nstmts; s++) {
+      int offset = npar + 1 + s * (nvar + 1);
+      for (int j = 0; j < nvar + 1; j++) {
+        cst_term += cst->val[r][offset + j] * fsol[offset + j];
+      }
+      row[npar + 1 + cluster[s]] += cst->val[r][offset + nvar];
+    }
+    for (int c = 0; c < num_clusters; c++) {
+      has_var = has_var || row[npar + 1 + c] != 0;
+    }
+    if (!has_var) {
+      /* Doesn't depend on u, w, or the shifts; fsol meets it */
+      continue;
+    }
+    row[ncols - 1] = cst_term;
+    rcst->is_eq[rcst->nrows] = cst->is_eq[r];
+    rcst->nrows++;
+  }
+
+  int64_t *sol = pluto_constraints_lexmin(rcst, DO_NOT_ALLOW_NEGATIVE_COEFF);
+  pluto_constraints_free(rcst);
+  if (sol == NULL) {
+    return;
+  }
+
+  for (int j = 0; j < npar + 1; j++) {
+    fsol[j] = sol[j];
+  }
+  for (int s = 0; s < nstmts; s++) {
+    fsol[npar + 1 + s * (nvar + 1) + nvar] += sol[npar + 1 + cluster[s]];
+  }
+  IF_DEBUG(for (int c = 0; c < num_clusters; c++) {
+    if (sol[npar + 1 + c] != 0) {
+      printf("[pluto] hierarchical: cluster %d shifted by %lld\n", c,
+             (long long)sol[npar + 1 + c]);
+    }
+  });
+  free(sol);
+}
+
+/// Solves the Pluto ILP cst (with the column layout of the whole program) one
+/// cluster at a time. Dependences between fusion groups have been satisfied
+/// by the outermost ordering of the groups; within a group, the clusters are
+/// solved in topological order, each one with the solutions of the earlier
+/// ones substituted into the dependence rows that couple them. The "at least
+/// one statement" rows of the LAZY mode are imposed per cluster, and dropped
+/// for clusters that cannot meet them as long as some cluster does. Clusters
+/// with no statement that needs more hyperplanes and no coupling with earlier
+/// clusters get the trivial (zero) solution without solving. The clusters are
+/// then shifted with respect to each other by the reduced inter-cluster
+/// problem. Falls back to the flat ILP if a dependence between groups is
+/// unsatisfied, and returns NULL (so that the band ends here) if a cluster
+/// can't be fused with the earlier ones of its group.
+int64_t *pluto_hierarchical_constraints_lexmin(PlutoConstraints *cst,
+                                               PlutoProg *prog) {
+  int nstmts = prog->nstmts;
+  int npar = prog->npar;
+  int nvar = prog->nvar;
+  int num_clusters = prog->hier_num_clusters;
+  int *cluster = prog->hier_cluster;
+  int *group = prog->hier_group;
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (options->rar == 0 && IS_RAR(dep->type))
+      continue;
+    if (!dep_is_satisfied(dep) &&
+        group[cluster[dep->src]] != group[cluster[dep->dest]]) {
+      IF_DEBUG(printf("[pluto] hierarchical: unsatisfied inter-group "
+                      "dependence %d; solving the flat ILP\n",
+                      i + 1););
+      return pluto_prog_constraints_lexmin(cst, prog);
+    }
+  }
+
+  double t_start = rtclock();
+
+  int64_t *fsol = (int64_t *)calloc(cst->ncols - 1, sizeof(int64_t));
+  /* Lower bound on the (u, w) of the flat ILP: the largest (u, w) over the
+   * clusters solved on their own, each of which is a relaxation of it */
+  int64_t *lower = (int64_t *)calloc(npar + 1, sizeof(int64_t));
+  bool *in_cluster = (bool *)malloc(nstmts * sizeof(bool));
+  bool *solved = (bool *)calloc(nstmts, sizeof(bool));
+  bool has_coupling = false, progress = false;
+
+  for (int c = 0; c < num_clusters; c++) {
+    bool needs_hyps = false;
+    for (int i = 0; i < nstmts; i++) {
+      in_cluster[i] = (cluster[i] == c);
+      if (in_cluster[i] && pluto_stmt_get_num_ind_hyps(prog->stmts[i]) <
+                               prog->stmts[i]->dim_orig) {
+        needs_hyps = true;
+      }
+    }
+
+    int num_coupling, num_substituted;
+    PlutoConstraints *sub =
+        hier_restrict_constraints(cst, in_cluster, solved, fsol, prog, false,
+                                  &num_coupling, &num_substituted);
+    if (!needs_hyps && num_substituted == 0) {
+      pluto_constraints_free(sub);
+      for (int i = 0; i < nstmts; i++) {
+        solved[i] = solved[i] || in_cluster[i];
+      }
+      continue;
+    }
+    int64_t *sol = hier_lexmin(sub, in_cluster, prog);
+    pluto_constraints_free(sub);
+
+    bool drop_coupling = false;
+    if (num_coupling >= 1) {
+      has_coupling = true;
+      if (sol != NULL) {
+        progress = true;
+      } else {
+        drop_coupling = true;
+        sub = hier_restrict_constraints(cst, in_cluster, solved, fsol, prog,
+                                        true, &num_coupling, &num_substituted);
+        sol = hier_lexmin(sub, in_cluster, prog);
+        pluto_constraints_free(sub);
+      }
+    }
+
+    if (sol == NULL) {
+      if (num_substituted >= 1 && !context->solver_timed_out) {
+        IF_DEBUG(printf("[pluto] hierarchical: cluster %d can't be fused "
+                        "with the earlier clusters of its group\n",
+                        c););
+        prog->hier_fusion_failures++;
+      }
+      free(fsol);
+      fsol = NULL;
+      break;
+    }
+
+    if (num_substituted == 0 && (num_coupling == 0 || drop_coupling)) {
+      if (hier_bound_lexgt(sol, lower, prog)) {
+        memcpy(lower, sol, (npar + 1) * sizeof(int64_t));
+      }
+    } else if (hier_bound_lexgt(sol, lower, prog)) {
+      /* The coupling rows may have raised (u, w); solve the cluster without
+       * them */
+      sub = hier_restrict_constraints(cst, in_cluster, NULL, NULL, prog, true,
+                                      &num_coupling, &num_substituted);
+      int64_t *relaxed = hier_lexmin(sub, in_cluster, prog);
+      pluto_constraints_free(sub);
+      if (relaxed != NULL && hier_bound_lexgt(relaxed, lower, prog)) {
+        memcpy(lower, relaxed, (npar + 1) * sizeof(int64_t));
+      }
+      free(relaxed);
+    }
+
+    /* u and w are only used for the objective; keep the largest */
+    for (int j = 0; j < npar + 1; j++) {
+      fsol[j] = PLMAX(fsol[j], sol[j]);
+    }
+    int col = npar + 1;
+    for (int i = 0; i < nstmts; i++) {
+      if (!in_cluster[i])
+        continue;
+      for (int j = 0; j < nvar + 1; j++) {
+        fsol[npar + 1 + i * (nvar + 1) + j] = sol[col++];
+      }
+      solved[i] = true;
+    }
+    free(sol);
+  }
+
+  if (fsol != NULL && has_coupling && !progress) {
+    free(fsol);
+    fsol = NULL;
+  }
+
+  if (fsol != NULL) {
+    hier_solve_inter_cluster(cst, fsol, prog);
+    prog->hier_bound_loss +=
+        PLMAX(0, hier_bound(fsol, prog) - hier_bound(lower, prog));
+  }
+
+  free(solved);
+  free(in_cluster);
+  free(lower);
+  prog->hier_time += rtclock() - t_start;
+  return fsol;
+}
@@ -240,8 +240,11 @@ get_coeff_bounding_constraints_for_cone_complement(PlutoProg *prog) {
   return cst;
 }
 
-PlutoMatrix *construct_cplex_objective(const PlutoConstraints *cst,
-                                       const PlutoProg *prog) {
+/// Objective of the Pluto ILP cst over the statements stmts[0..nstmts-1],
+/// whose coefficient columns follow u and w in that order.
+static PlutoMatrix *construct_stmts_objective(const PlutoConstraints *cst,
+                                              Stmt *const *stmts, int nstmts,
+                                              const PlutoProg *prog) {
   int npar = prog->npar;
   int nvar = prog->nvar;
   PlutoMatrix *obj = pluto_matrix_alloc(1, cst->ncols - 1, prog->context);
@@ -249,23 +252,28 @@ PlutoMatrix *construct_cplex_objective(const PlutoConstraints *cst,
 
   /* u */
   for (int j = 0; j < npar; j++) {
-    obj->val[0][j] = 5 * 5 * nvar * prog->nstmts;
+    obj->val[0][j] = 5 * 5 * nvar * nstmts;
   }
   /* w */
-  obj->val[0][npar] = 5 * nvar * prog->nstmts;
+  obj->val[0][npar] = 5 * nvar * nstmts;
 
-  for (int i = 0, j = npar + 1; i < prog->nstmts; i++) {
+  for (int i = 0, j = npar + 1; i < nstmts; i++) {
     unsigned k;
-    for (k = j; k < j + prog->stmts[i]->dim_orig; k++) {
-      obj->val[0][k] = (nvar + 2) * (prog->stmts[i]->dim_orig - (k - j));
+    for (k = j; k < j + stmts[i]->dim_orig; k++) {
+      obj->val[0][k] = (nvar + 2) * (stmts[i]->dim_orig - (k - j));
     }
     /* constant shift */
     obj->val[0][k] = 1;
-    j += prog->stmts[i]->dim_orig + 1;
+    j += stmts[i]->dim_orig + 1;
   }
   return obj;
 }
 
+PlutoMatrix *construct_cplex_objective(const PlutoConstraints *cst,
+                                       const PlutoProg *prog) {
+  return construct_stmts_objective(cst, prog->stmts, prog->nstmts, prog);
+}
+
 /*
  * This calls pluto_constraints_lexmin, but before doing that does some
  * preprocessing
@@ -273,14 +281,32 @@ PlutoMatrix *construct_cplex_objective(const PlutoConstraints *cst,
  *   permutation/substitution of variables
  */
 int64_t *pluto_prog_constraints_lexmin(PlutoConstraints *cst, PlutoProg *prog) {
-  Stmt **stmts = prog->stmts;
-  int nstmts = prog->nstmts;
+  return pluto_stmts_constraints_lexmin(cst, prog->stmts, prog->nstmts, prog);
+}
+
+/// Same as pluto_prog_constraints_lexmin for a Pluto ILP over the statements
+/// stmts[0..nstmts-1] only, whose coefficient columns follow u and w in that
+/// order. Hierarchical scheduling uses it to solve the ILP of a cluster of
+/// statements.
+int64_t *pluto_stmts_constraints_lexmin(PlutoConstraints *cst,
+                                        Stmt *const *stmts, int nstmts,
+                                        PlutoProg *prog) {
   int nvar = prog->nvar;
   int npar = prog->npar;
   int num_ccs = prog->ddg->num_ccs;
   PlutoContext *context = prog->context;
   PlutoOptions *options = context->options;
 
+  /* The per-CC objective and the LP scaling matrices are built for all the
+   * statements of prog */
+  assert(nstmts == prog->nstmts || (!options->per_cc_obj && !options->lp));
+
+  /* Don't start a solve once the compile time budget's deadline has passed */
+  if (pluto_solver_time_left(context) == 0.0) {
+    IF_DEBUG(printf("[pluto] pluto_stmts_constraints_lexmin: out of time\n"););
+    return NULL;
+  }
+
   int ncols = CST_WIDTH;
   if (options->per_cc_obj) {
     ncols += (npar + 1) * num_ccs;
@@ -342,6 +368,8 @@ int64_t *pluto_prog_constraints_lexmin(PlutoConstraints *cst, PlutoProg *prog) {
     double t_start = rtclock();
     sol = pluto_constraints_lexmin_isl(newcst, DO_NOT_ALLOW_NEGATIVE_COEFF);
     prog->mipTime += rtclock() - t_start;
+    /* isl can't be given a time limit; flag a solve that overran it */
+    pluto_solver_time_left(context);
   } else if (options->glpk || options->lp || options->dfp || options->gurobi) {
     double **val = NULL;
     int **index = NULL;
@@ -349,7 +377,7 @@ int64_t *pluto_prog_constraints_lexmin(PlutoConstraints *cst, PlutoProg *prog) {
 
     nrows = 0;
 
-    PlutoMatrix *obj = construct_cplex_objective(newcst, prog);
+    PlutoMatrix *obj = construct_stmts_objective(newcst, stmts, nstmts, prog);
 
 #if defined(GLPK) || defined(GUROBI)
     int num_ccs;
@@ -394,6 +422,8 @@ int64_t *pluto_prog_constraints_lexmin(PlutoConstraints *cst, PlutoProg *prog) {
     double t_start = rtclock();
     sol = pluto_constraints_lexmin_pip(newcst, DO_NOT_ALLOW_NEGATIVE_COEFF);
     prog->mipTime += rtclock() - t_start;
+    /* Neither can PIP */
+    pluto_solver_time_left(context);
   }
 
   int64_t *fsol = NULL;
@@ -829,7 +859,11 @@ int find_permutable_hyperplanes(PlutoProg *prog, bool hyp_search_mode,
       IF_DEBUG(printf("[pluto] (Band %d) Solving for hyperplane #%d\n",
                       band_depth + 1, num_sols_found + 1));
       // IF_DEBUG2(pluto_constraints_pretty_print(stdout, currcst));
-      bestsol = pluto_prog_constraints_lexmin(currcst, prog);
+      if (prog->hier_num_clusters >= 2) {
+        bestsol = pluto_hierarchical_constraints_lexmin(currcst, prog);
+      } else {
+        bestsol = pluto_prog_constraints_lexmin(currcst, prog);
+      }
     }
     pluto_constraints_free(indcst);
 
@@ -1474,6 +1508,123 @@ int get_first_non_scalar_hyperplane(PlutoProg *prog, int start, int end) {
   return -1;
 }
 
+/// Returns the fallback strategy that the compile time budget calls for at
+/// this point. The budget (options->time_budget, counted from the allocation
+/// of the context so that dependence analysis is included) is shared by the
+/// strategies: each one has an equal share of the time left when it takes
+/// over for the strategies that might still follow (see
+/// set_budget_deadline) to solve its ILPs/LPs, which are given that deadline
+/// as a time limit (context->solver_deadline). Once a solve has run into it,
+/// or it has passed between solves, the next cheaper strategy is returned:
+/// the LP relaxation, then per-SCC scheduling, then the original schedule.
+BudgetFallback pluto_time_budget_fallback(const PlutoProg *prog) {
+  const PlutoContext *context = prog->context;
+  BudgetFallback fallback = prog->budget_fallback;
+
+  if (context->options->time_budget <= 0.0 ||
+      fallback == kBudgetOriginalFallback) {
+    return fallback;
+  }
+  if (!context->solver_timed_out && rtclock() < context->solver_deadline) {
+    return fallback;
+  }
+
+  if (fallback == kBudgetNoFallback) {
+#if defined GLPK || defined GUROBI
+    return kBudgetLpFallback;
+#else
+    /* No LP solver to fall back to */
+    return kBudgetPerSccFallback;
+#endif
+  }
+  return (BudgetFallback)(fallback + 1);
+}
+
+const char *pluto_budget_fallback_str(BudgetFallback fallback) {
+  switch (fallback) {
+  case kBudgetLpFallback:
+    return "LP relaxation";
+  case kBudgetPerSccFallback:
+    return "per-SCC scheduling";
+  case kBudgetOriginalFallback:
+    return "original schedule";
+  default:
+    return "none";
+  }
+}
+
+/// Sets the deadline of the ILPs/LPs of the scheduling strategy 'fallback',
+/// which takes over now: an equal share, among it and the cheaper strategies
+/// that can follow it and still solve ILPs/LPs, of the time left before the
+/// end of the compile time budget. The whole budget thus bounds the time
+/// spent solving, up to a solve that can't be interrupted (isl/PIP).
+static void set_budget_deadline(PlutoContext *context,
+                                BudgetFallback fallback) {
+  int num_strategies = kBudgetOriginalFallback - fallback;
+#if !defined GLPK && !defined GUROBI
+  if (fallback == kBudgetNoFallback) {
+    /* No LP relaxation to fall back to */
+    num_strategies--;
+  }
+#endif
+  double now = rtclock();
+  double left = context->budget_end - now;
+  context->solver_deadline =
+      now + (left > 0.0 ? left / num_strategies : 0.0);
+  context->solver_timed_out = 0;
+}
+
+/// Switches the remaining bands over to the cheaper scheduling strategy
+/// 'fallback'. For kBudgetOriginalFallback, pluto_auto_transform itself stops
+/// and restores the original schedule.
+static void pluto_apply_budget_fallback(PlutoProg *prog,
+                                        BudgetFallback fallback) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+
+  PLUTO_MESSAGE(printf("[pluto] Compile time budget of %0.2lfs exhausted; "
+                       "falling back to %s\n",
+                       options->time_budget,
+                       pluto_budget_fallback_str(fallback)););
+  prog->budget_fallback = fallback;
+  set_budget_deadline(context, fallback);
+
+  if (fallback == kBudgetLpFallback) {
+    options->lp = 1;
+#ifdef GLPK
+    if (!options->gurobi) {
+      options->glpk = 1;
+    }
+#else
+    options->gurobi = 1;
+#endif
+    options->islsolve = 0;
+    options->pipsolve = 0;
+  } else if (fallback == kBudgetPerSccFallback) {
+    /* Distribute the SCCs and schedule each one with its own ILP through the
+     * per-cluster solver of hierarchical scheduling; the ILPs are small
+     * enough not to need the LP relaxation. */
+    options->lp = 0;
+    ddg_compute_scc(prog);
+    cut_all_sccs(prog, prog->ddg);
+    if (!options->per_cc_obj) {
+      free(prog->hier_cluster);
+      prog->hier_cluster = (int *)malloc(prog->nstmts * sizeof(int));
+      for (unsigned i = 0; i < prog->nstmts; i++) {
+        prog->hier_cluster[i] = prog->stmts[i]->scc_id;
+      }
+      prog->hier_num_clusters = prog->ddg->num_sccs;
+      /* The SCCs are all cut: each cluster is a fusion group of its own */
+      free(prog->hier_group);
+      prog->hier_group = (int *)malloc(prog->ddg->num_sccs * sizeof(int));
+      for (int c = 0; c < prog->ddg->num_sccs; c++) {
+        prog->hier_group[c] = c;
+      }
+      prog->hier_num_groups = prog->ddg->num_sccs;
+    }
+  }
+}
+
 /* Copy h2 into h1 */
 static void copy_hyperplane(int64_t *h1, int64_t *h2, int ncols) {
   int j;
@@ -1512,6 +1663,18 @@ int pluto_auto_transform(PlutoProg *prog) {
   Stmt **stmts = prog->stmts;
   int nstmts = prog->nstmts;
 
+  /* Solver choices that the compile time budget fallbacks may override */
+  int orig_lp = options->lp, orig_glpk = options->glpk,
+      orig_gurobi = options->gurobi, orig_islsolve = options->islsolve,
+      orig_pipsolve = options->pipsolve;
+
+  /* The ILPs/LPs of the full strategy get their share of the compile time
+   * budget */
+  if (options->time_budget > 0.0) {
+    context->budget_end = context->start_time + options->time_budget;
+    set_budget_deadline(context, kBudgetNoFallback);
+  }
+
   for (i = 0; i < prog->ndeps; i++) {
     prog->deps[i]->satisfied = false;
   }
@@ -1579,6 +1742,10 @@ int pluto_auto_transform(PlutoProg *prog) {
     if (options->fuse == kSmartFuse && !options->dfp) {
       cut_scc_dim_based(prog, ddg);
     }
+    if (options->hierarchical && !options->dfp && !options->per_cc_obj &&
+        !options->lp) {
+      pluto_hierarchical_cluster(prog);
+    }
   }
 
   if (options->fuse == kTypedFuse) {
@@ -1666,31 +1833,36 @@ int pluto_auto_transform(PlutoProg *prog) {
     /* This routine frees colour internally */
     find_permutable_dimensions_scc_based(colour, prog);
 
-    if (!options->silent && options->debug) {
-      printf("[pluto] Transformations before skewing \n");
-      pluto_transformations_pretty_print(prog);
-    }
+    /* pluto-lp-dfp is already the LP path; when it runs out of the compile
+     * time budget, the original schedule is used. */
+    if (prog->budget_fallback == kBudgetNoFallback) {
+      if (!options->silent && options->debug) {
+        printf("[pluto] Transformations before skewing \n");
+        pluto_transformations_pretty_print(prog);
+      }
 
-    is_skewed = introduce_skew(prog);
+      is_skewed = introduce_skew(prog);
 
-    pluto_dep_satisfaction_reset(prog);
-    if (is_skewed && options->diamondtile) {
-      conc_start_found = pluto_diamond_tile(prog);
-    }
-    /* If there are any unsatisfied deps, they have to be
-     * distributed at the inner most level. */
-    pluto_dep_satisfaction_reset(prog);
-    for (int i = 0; i < prog->num_hyperplanes; i++) {
-      dep_satisfaction_update(prog, i);
-    }
-    if (!deps_satisfaction_check(prog)) {
-      ddg_update(prog->ddg, prog);
-      ddg_compute_scc(prog);
-      cut_all_sccs(prog, prog->ddg);
+      pluto_dep_satisfaction_reset(prog);
+      if (is_skewed && options->diamondtile) {
+        conc_start_found = pluto_diamond_tile(prog);
+      }
+      /* If there are any unsatisfied deps, they have to be
+       * distributed at the inner most level. */
+      pluto_dep_satisfaction_reset(prog);
+      for (int i = 0; i < prog->num_hyperplanes; i++) {
+        dep_satisfaction_update(prog, i);
+      }
+      if (!deps_satisfaction_check(prog)) {
+        ddg_update(prog->ddg, prog);
+        ddg_compute_scc(prog);
+        cut_all_sccs(prog, prog->ddg);
+      }
     }
 
     free(prog->total_coloured_stmts);
     free(prog->scaled_dims);
+    fcg_lp_cache_free(prog);
 #endif
   } else {
 
@@ -1699,6 +1871,20 @@ int pluto_auto_transform(PlutoProg *prog) {
        * (maximum across all statements) */
       int num_sols_left;
 
+      /* Switch to a cheaper strategy for this and the remaining bands if the
+       * compile time budget has run out */
+      BudgetFallback fallback = pluto_time_budget_fallback(prog);
+      if (fallback == kBudgetLpFallback && prog->hier_num_clusters >= 2) {
+        /* Already scheduling cluster by cluster */
+        fallback = kBudgetPerSccFallback;
+      }
+      if (fallback > prog->budget_fallback) {
+        pluto_apply_budget_fallback(prog, fallback);
+      }
+      if (prog->budget_fallback == kBudgetOriginalFallback) {
+        break;
+      }
+
       if (options->fuse == kNoFuse) {
         ddg_compute_scc(prog);
         cut_all_sccs(prog, ddg);
@@ -1736,6 +1922,12 @@ int pluto_auto_transform(PlutoProg *prog) {
                        depth, nsols));
       IF_DEBUG2(pluto_transformations_pretty_print(prog));
 
+      if (nsols == 0 && context->solver_timed_out) {
+        /* The band's ILP ran out of time rather than out of solutions; retry
+         * the band with the next cheaper strategy */
+        continue;
+      }
+
       num_ind_sols_found = pluto_get_max_ind_hyps(prog);
 
       if (nsols >= 1) {
@@ -1810,6 +2002,14 @@ int pluto_auto_transform(PlutoProg *prog) {
               prog->num_hyperplanes = orig_num_hyperplanes;
               prog->hProps = orig_hProps;
             }
+            options->lp = orig_lp;
+            options->glpk = orig_glpk;
+            options->gurobi = orig_gurobi;
+            options->islsolve = orig_islsolve;
+            options->pipsolve = orig_pipsolve;
+            context->budget_end = 0.0;
+            context->solver_deadline = 0.0;
+            context->solver_timed_out = 0;
             return 1;
           }
         }
@@ -1834,15 +2034,43 @@ int pluto_auto_transform(PlutoProg *prog) {
     PLUTO_MESSAGE(printf("[pluto] Diamond tiling not possible/useful\n"););
   }
 
+  if (options->hierarchical) {
+    pluto_hierarchical_report(prog);
+  }
+
   denormalize_domains(prog);
 
-  for (i = 0; i < nstmts; i++) {
-    pluto_matrix_free(orig_trans[i]);
-    free(orig_hyp_types[i]);
+  options->lp = orig_lp;
+  options->glpk = orig_glpk;
+  options->gurobi = orig_gurobi;
+  options->islsolve = orig_islsolve;
+  options->pipsolve = orig_pipsolve;
+  context->budget_end = 0.0;
+  context->solver_deadline = 0.0;
+  context->solver_timed_out = 0;
+
+  if (prog->budget_fallback == kBudgetOriginalFallback) {
+    /* Out of compile time budget: discard the partial transformation and
+     * restore the original one; it is legal and still gets tiled. */
+    for (i = 0; i < nstmts; i++) {
+      pluto_matrix_free(stmts[i]->trans);
+      free(stmts[i]->hyp_types);
+      stmts[i]->trans = orig_trans[i];
+      stmts[i]->hyp_types = orig_hyp_types[i];
+    }
+    free(prog->hProps);
+    prog->num_hyperplanes = orig_num_hyperplanes;
+    prog->hProps = orig_hProps;
+    prog->is_diamond_tiled = false;
+  } else {
+    for (i = 0; i < nstmts; i++) {
+      pluto_matrix_free(orig_trans[i]);
+      free(orig_hyp_types[i]);
+    }
+    free(orig_hProps);
   }
   free(orig_trans);
   free(orig_hyp_types);
-  free(orig_hProps);
 
   IF_DEBUG(printf("[pluto] pluto_auto_transform: successful, done\n"););
 
@@ -1901,6 +2129,75 @@ int get_num_unsatisfied_inter_scc_deps(PlutoProg *prog) {
 
 void ddg_print(Graph *g) { pluto_matrix_print(stdout, g->adj); }
 
+/*
+ * Record, for each dependence, whether it contributes an edge to the DDG, and
+ * set up the state needed to maintain SCCs and CCs incrementally
+ */
+static void ddg_track_dep_edges(Graph *g, PlutoProg *prog) {
+  free(g->dep_edges);
+  g->dep_edges = (bool *)malloc(prog->ndeps * sizeof(bool));
+  g->ndeps = prog->ndeps;
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    g->dep_edges[i] = !IS_RAR(dep->type) && !dep_is_satisfied(dep);
+  }
+  if (g->scc_dirty == NULL) {
+    g->scc_dirty = (bool *)malloc(g->nVertices * sizeof(bool));
+    g->cc_dirty = (bool *)malloc(g->nVertices * sizeof(bool));
+  }
+  for (int i = 0; i < g->nVertices; i++) {
+    g->scc_dirty[i] = false;
+    g->cc_dirty[i] = false;
+  }
+}
+
+/*
+ * Update the DDG incrementally: only the edges of dependences whose
+ * satisfaction changed since the last update are touched. An edge that
+ * vanishes from within an SCC (CC) marks it dirty; it is split at the next
+ * ddg_compute_scc (ddg_compute_cc). An edge that appears is harmless as long
+ * as it goes forward in the topological order of the SCCs (lies within a CC);
+ * otherwise, the SCCs (CCs) have to be recomputed from scratch.
+ */
+static void ddg_update_incremental(Graph *g, PlutoProg *prog) {
+  Vertex *vertices = g->vertices;
+  int64_t **adj = g->adj->val;
+
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (IS_RAR(dep->type))
+      continue;
+    bool has_edge = !dep_is_satisfied(dep);
+    if (has_edge == g->dep_edges[i])
+      continue;
+    g->dep_edges[i] = has_edge;
+
+    int src = dep->src;
+    int dest = dep->dest;
+    if (!has_edge) {
+      adj[src][dest]--;
+      if (adj[src][dest] != 0 || src == dest)
+        continue;
+      if (g->sccs_valid && vertices[src].scc_id == vertices[dest].scc_id) {
+        g->scc_dirty[vertices[src].scc_id] = true;
+      }
+      if (g->ccs_valid && adj[dest][src] == 0) {
+        g->cc_dirty[vertices[src].cc_id] = true;
+      }
+    } else {
+      adj[src][dest]++;
+      if (adj[src][dest] != 1 || src == dest)
+        continue;
+      if (g->sccs_valid && vertices[src].scc_id > vertices[dest].scc_id) {
+        g->sccs_valid = false;
+      }
+      if (g->ccs_valid && vertices[src].cc_id != vertices[dest].cc_id) {
+        g->ccs_valid = false;
+      }
+    }
+  }
+}
+
 /*
  * Update the DDG - should be called when some dependences
  * are satisfied
@@ -1912,6 +2209,11 @@ void ddg_update(Graph *g, PlutoProg *prog) {
 
   IF_DEBUG(printf("[pluto] updating DDG\n"););
 
+  if (g->dep_edges != NULL && g->ndeps == prog->ndeps) {
+    ddg_update_incremental(g, prog);
+    return;
+  }
+
   for (i = 0; i < g->nVertices; i++)
     for (j = 0; j < g->nVertices; j++)
       g->adj->val[i][j] = 0;
@@ -1924,6 +2226,13 @@ void ddg_update(Graph *g, PlutoProg *prog) {
      * adjacency matrix */
     g->adj->val[dep->src][dep->dest] += !dep_is_satisfied(dep);
   }
+
+  /* The set of dependences changed; start afresh */
+  if (g->dep_edges != NULL) {
+    ddg_track_dep_edges(g, prog);
+    g->sccs_valid = false;
+    g->ccs_valid = false;
+  }
 }
 
 /*
@@ -1943,6 +2252,10 @@ Graph *ddg_create(PlutoProg *prog) {
     g->adj->val[dep->src][dep->dest] += !dep_is_satisfied(dep);
   }
 
+  if (prog->context->options->incremental_scc) {
+    ddg_track_dep_edges(g, prog);
+  }
+
   return g;
 }
 
@@ -1979,6 +2292,18 @@ static int get_scc_size(PlutoProg *prog, int scc_id) {
   return num;
 }
 
+/*
+ * Record the time taken by an incremental SCC/CC update along with the time
+ * it saved w.r.t the last full computation on the same graph
+ */
+static void ddg_account_incremental(PlutoProg *prog, double full_time,
+                                    double tstart) {
+  double t = rtclock() - tstart;
+  prog->ddg_scc_incr_time += t;
+  prog->ddg_scc_time_saved += full_time - t;
+  prog->num_ddg_scc_incr++;
+}
+
 /* Compute the connected components of the graph */
 void ddg_compute_cc(PlutoProg *prog) {
   int i;
@@ -1987,9 +2312,23 @@ void ddg_compute_cc(PlutoProg *prog) {
   int stmt_id;
   int time = 0;
   PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
 
   IF_DEBUG(printf("[pluto] ddg_compute_cc\n"););
   Graph *g = prog->ddg;
+  double tstart = rtclock();
+
+  if (options->incremental_scc && g->ccs_valid) {
+    int num_split = graph_split_dirty_ccs(g);
+    IF_DEBUG(printf("[pluto] ddg_compute_cc: %d CC(s) split incrementally\n",
+                    num_split););
+    for (i = 0; i < g->nVertices; i++) {
+      prog->stmts[i]->cc_id = g->vertices[i].cc_id;
+    }
+    ddg_account_incremental(prog, g->full_cc_time, tstart);
+    return;
+  }
+
   /* Make the graph undirected. */
   Graph *gU = get_undirected_graph(g);
   for (i = 0; i < gU->nVertices; i++) {
@@ -2001,17 +2340,28 @@ void ddg_compute_cc(PlutoProg *prog) {
       num_cc++;
       gU->vertices[i].cc_id = cc_id;
       dfs_vertex(gU, &gU->vertices[i], &time);
-      gU->vertices[i].cc_id = cc_id;
     }
-    gU->vertices[i].cc_id = cc_id;
+    /* A vertex visited earlier already has the id of its CC */
     g->vertices[i].cc_id = gU->vertices[i].cc_id;
     stmt_id = g->vertices[i].id;
     assert(stmt_id == i);
 
     prog->stmts[i]->cc_id = g->vertices[i].cc_id;
+    IF_DEBUG(printf("[pluto] ddg_compute_cc: S%d in CC %d\n", i + 1,
+                    g->vertices[i].cc_id););
   }
   g->num_ccs = num_cc;
   graph_free(gU);
+
+  if (g->cc_dirty != NULL) {
+    for (i = 0; i < g->nVertices; i++) {
+      g->cc_dirty[i] = false;
+    }
+    g->ccs_valid = true;
+  }
+  g->full_cc_time = rtclock() - tstart;
+  prog->ddg_scc_full_time += g->full_cc_time;
+  prog->num_ddg_scc_full++;
 }
 
 /* Compute the SCCs of a graph (using Kosaraju's algorithm) */
@@ -2019,10 +2369,41 @@ void ddg_compute_scc(PlutoProg *prog) {
   int i;
 
   PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
 
   IF_DEBUG(printf("[pluto] ddg_compute_scc\n"););
 
   Graph *g = prog->ddg;
+  double tstart = rtclock();
+
+  if (options->incremental_scc && g->sccs_valid) {
+    int num_split = graph_split_dirty_sccs(g);
+    IF_DEBUG(printf("[pluto] ddg_compute_scc: %d SCC(s) split incrementally\n",
+                    num_split););
+    for (i = 0; i < g->num_sccs; i++) {
+      g->sccs[i].max_dim = 0;
+      g->sccs[i].sol = NULL;
+      g->sccs[i].is_parallel = 0;
+    }
+    for (i = 0; i < g->nVertices; i++) {
+      Stmt *stmt = prog->stmts[i];
+      Scc *scc = &g->sccs[g->vertices[i].scc_id];
+      stmt->scc_id = g->vertices[i].scc_id;
+      scc->max_dim = PLMAX(scc->max_dim, stmt->dim_orig);
+    }
+    ddg_account_incremental(prog, g->full_scc_time, tstart);
+    graph_print_sccs(g);
+    return;
+  }
+
+  /* The DFS below overwrites the CC ids of the vertices */
+  int *cc_ids = NULL;
+  if (g->ccs_valid) {
+    cc_ids = (int *)malloc(g->nVertices * sizeof(int));
+    for (i = 0; i < g->nVertices; i++) {
+      cc_ids[i] = g->vertices[i].cc_id;
+    }
+  }
 
   dfs(g);
 
@@ -2049,6 +2430,22 @@ void ddg_compute_scc(PlutoProg *prog) {
 
   graph_free(gT);
 
+  if (cc_ids != NULL) {
+    for (i = 0; i < g->nVertices; i++) {
+      g->vertices[i].cc_id = cc_ids[i];
+    }
+    free(cc_ids);
+  }
+  if (g->scc_dirty != NULL) {
+    for (i = 0; i < g->nVertices; i++) {
+      g->scc_dirty[i] = false;
+    }
+    g->sccs_valid = true;
+  }
+  g->full_scc_time = rtclock() - tstart;
+  prog->ddg_scc_full_time += g->full_scc_time;
+  prog->num_ddg_scc_full++;
+
   graph_print_sccs(g);
 }
 
@@ -2126,6 +2523,23 @@ void pluto_update_deps(Stmt *stmt, PlutoConstraints *cst, PlutoProg *prog) {
       pluto_constraints_free(cst_l);
     }
   }
+
+  /* Relaxed reduction dependences are self dependences */
+  for (int i = 0; i < prog->nreduction_deps; i++) {
+    Dep *dep = prog->reduction_deps[i];
+    if (stmts[dep->src] != stmt)
+      continue;
+    PlutoConstraints *src_cst = pluto_constraints_dup(cst);
+    PlutoConstraints *dest_cst = pluto_constraints_dup(cst);
+    for (unsigned c = 0; c < stmt->dim; c++) {
+      pluto_constraints_add_dim(src_cst, stmt->dim, NULL);
+      pluto_constraints_add_dim(dest_cst, 0, NULL);
+    }
+    pluto_constraints_add(dep->dpolytope, src_cst);
+    pluto_constraints_add(dep->dpolytope, dest_cst);
+    pluto_constraints_free(src_cst);
+    pluto_constraints_free(dest_cst);
+  }
 }
 
 /// Returns true if these statements completely fused until the innermost level.
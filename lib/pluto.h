@@ -58,14 +58,34 @@ typedef struct pluto_matrix PlutoMatrix;
     }                                                                          \
   }
 
-#define MAX_TILING_LEVELS 2
+/// Maximum number of levels of tiling (--tile-levels), e.g., L1, L2, L3 and a
+/// NUMA node or socket; tiling for registers is left to unroll-jam.
+#define MAX_TILING_LEVELS 6
 
 /// The default tile size to use for the first level of tiling.
 #define DEFAULT_FIRST_LEVEL_TILE_SIZE 32
 
-/// The ratio / multiplying factor to use for the second level of tile size.
+/// The ratio / multiplying factor to use for the tile sizes of the second and
+/// further levels of tiling.
 #define DEFAULT_SECOND_LEVEL_TILE_SIZE_RATIO 8
 
+/// The largest slope (dependence distance along space per unit of distance
+/// along time) that a band can have to be split-tiled.
+#define MAX_SPLIT_TILE_SLOPE 8
+
+/// The largest safelen given to an OpenMP SIMD loop (see
+/// pluto_loop_get_safelen).
+#define MAX_SIMD_SAFELEN 64
+
+/// The largest distance in tiles, along a dimension of a band, of the
+/// dependences between the tiles of a band run as OpenMP tasks (see
+/// pluto_create_task_band).
+#define MAX_TASK_DEP_DISTANCE 2
+
+/// The log2 of the number of elements of the array whose addresses stand for
+/// tiles in the depend clauses of OpenMP tasks; tile indices wrap around it.
+#define TASK_DEP_SLOT_BITS 12
+
 #define PI_TABLE_SIZE 256
 
 #define CST_WIDTH (npar + 1 + nstmts * (nvar + 1) + 1)
@@ -117,6 +137,15 @@ typedef enum stmttype {
   STMT_UNKNOWN
 } PlutoStmtType;
 
+/* Operator of a reduction statement: one that only updates a single location
+ * with an associative and commutative operator, like s += e (see
+ * reduction.h) */
+typedef enum reductionOp {
+  kReductionNone = 0,
+  kReductionAdd,
+  kReductionMul
+} PlutoReductionOp;
+
 typedef struct pluto_access {
   int sym_id;
   char *name;
@@ -194,6 +223,15 @@ struct statement {
   int first_tile_dim;
   int last_tile_dim;
 
+  /* Unroll-jam factor and vector length given by the tile configuration of
+   * the statement's band; 0 if not given */
+  unsigned ufactor;
+  unsigned vector_length;
+
+  /* Operator of the update if the statement is a reduction (on its only
+   * write access); kReductionNone otherwise */
+  PlutoReductionOp reduction_op;
+
   PlutoStmtType type;
 
   /* ID of the domain parallel loop that the statement belongs to */
@@ -301,6 +339,18 @@ typedef struct dependence Dep;
 
 typedef enum unrollType { NO_UNROLL, UNROLL, UNROLLJAM } UnrollType;
 
+/* Cheaper scheduling strategies switched to, in this order, once the compile
+ * time budget (options->time_budget) runs out */
+typedef enum budgetFallback {
+  kBudgetNoFallback = 0,
+  /* Solve the remaining bands' ILPs as LPs */
+  kBudgetLpFallback,
+  /* Distribute all SCCs and solve one small ILP per SCC */
+  kBudgetPerSccFallback,
+  /* Keep the original schedule */
+  kBudgetOriginalFallback
+} BudgetFallback;
+
 /* Properties of the new hyperplanes found. These are common across all
  * statements or apply at a level across all statements
  */
@@ -342,6 +392,12 @@ struct plutoProg {
   Dep **transdeps;
   int ntransdeps;
 
+  /* Dependences between instances of reduction statements on the reduced
+   * location; removed from deps with --reductions since the order of the
+   * updates doesn't matter (see reduction.h) */
+  Dep **reduction_deps;
+  int nreduction_deps;
+
   /* Array of data variable names */
   /* used by distmem to set different tags for different data */
   char **data_names;
@@ -391,6 +447,11 @@ struct plutoProg {
   // If concurrent start is found.
   bool is_diamond_tiled;
 
+  /// Tile bands run with one OpenMP task per tile instead of a wavefront of
+  /// tiles (--omp-tasks; see pluto_create_task_band).
+  struct taskBand **task_bands;
+  unsigned ntask_bands;
+
   /* number of outermost parallel dimensions to be parameterized */
   /* used by dynschedule */
   int num_parameterized_loops;
@@ -415,8 +476,50 @@ struct plutoProg {
   // Time taken by tile size selection model
   double tss_time;
 
+  /* Time spent computing SCCs/CCs of the DDG from scratch and incrementally,
+   * and the time saved (estimated) by the incremental updates */
+  double ddg_scc_full_time, ddg_scc_incr_time, ddg_scc_time_saved;
+  long int num_ddg_scc_full, num_ddg_scc_incr;
+
   long int num_lp_calls;
 
+  /* Outcomes of the pairwise fusion LPs solved while building the FCG, reused
+   * across rebuilds of the FCG (dfp only) */
+  struct fcgLpCache *fcg_lp_cache;
+  /* Number of pairwise fusion LPs answered from fcg_lp_cache */
+  long int num_fcg_lp_reused;
+
+  /* Hierarchical scheduling: cluster id of each statement, number of
+   * clusters, and statistics on the clustering */
+  int *hier_cluster;
+  int hier_num_clusters;
+  int hier_max_cluster_size;
+  /* Fusion group of each cluster; the clusters of a group share their
+   * permutable bands, and groups are ordered by an outermost scalar
+   * hyperplane */
+  int *hier_group;
+  int hier_num_groups;
+  /* Boundaries between fusion groups that were too large to check whether
+   * the flat ILP could fuse across them */
+  int hier_size_cuts;
+  /* Dependences satisfied by the outermost ordering of fusion groups */
+  int hier_deps_distributed;
+  /* Sum over the hyperplanes found cluster by cluster of the gap between
+   * their dependence distance bound (u and w) and a lower bound on that of
+   * the flat ILP */
+  int64_t hier_bound_loss;
+  /* Hyperplanes for which a cluster could not be fused with the earlier
+   * clusters of its group */
+  int hier_fusion_failures;
+  double hier_time;
+
+  /* Cheapest fallback strategy that the compile time budget forced */
+  BudgetFallback budget_fallback;
+
+  /* Size in bytes of the largest array element accessed, as reported by the
+   * polyhedral extractor; 0 if unknown */
+  unsigned data_element_size;
+
   PlutoContext *context;
 };
 typedef struct plutoProg PlutoProg;
@@ -486,6 +589,18 @@ typedef struct band {
   struct band **children;
 } Band;
 
+/// A band of tile space loops that is run with one OpenMP task per tile, the
+/// tasks being ordered by depend clauses on their predecessor tiles.
+typedef struct taskBand {
+  Band *band;
+  /// Number of band dimensions identifying a tile in the depend clauses (at
+  /// most three; the tiles of the inner ones are ordered as a whole).
+  unsigned ndep_dims;
+  /// Maximum distance in tiles of the dependences between the band's tiles
+  /// along each of these dimensions.
+  unsigned *max_dists;
+} PlutoTaskBand;
+
 void dep_alloc_members(Dep *);
 void dep_free(Dep *);
 
@@ -516,14 +631,22 @@ PlutoConstraints *get_non_trivial_sol_constraints(const PlutoProg *, bool);
 PlutoConstraints *get_coeff_bounding_constraints(const PlutoProg *);
 
 int64_t *pluto_prog_constraints_lexmin(PlutoConstraints *cst, PlutoProg *prog);
+int64_t *pluto_stmts_constraints_lexmin(PlutoConstraints *cst,
+                                        Stmt *const *stmts, int nstmts,
+                                        PlutoProg *prog);
+void pluto_hierarchical_cluster(PlutoProg *prog);
+int64_t *pluto_hierarchical_constraints_lexmin(PlutoConstraints *cst,
+                                               PlutoProg *prog);
+void pluto_hierarchical_report(const PlutoProg *prog);
 void pluto_add_hyperplane_from_ilp_solution(int64_t *sol, PlutoProg *prog);
 
 int pluto_auto_transform(PlutoProg *prog);
+BudgetFallback pluto_time_budget_fallback(const PlutoProg *prog);
+const char *pluto_budget_fallback_str(BudgetFallback fallback);
 int pluto_multicore_codegen(FILE *fp, FILE *outfp, const PlutoProg *prog);
-int pluto_dynschedule_graph_codegen(PlutoProg *prog, FILE *sigmafp, FILE *outfp,
-                                    FILE *headerfp);
-int pluto_dynschedule_codegen(PlutoProg *prog, FILE *sigmafp, FILE *outfp,
-                              FILE *headerfp);
+int pluto_multiversion_codegen(FILE *cloogfp, FILE *outfp,
+                               const PlutoProg *prog,
+                               const PlutoProg *simple_prog);
 int pluto_distmem_codegen(PlutoProg *prog, FILE *cloogfp, FILE *sigmafp,
                           FILE *outfp, FILE *headerfp);
 
@@ -539,14 +662,14 @@ void getOutermostTilableBand(PlutoProg *prog, int *bandStart, int *bandEnd);
 
 void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog);
 void cut_lightest_edge(Stmt *stmts, int nstmts, Dep *deps, int ndeps, int);
-void pluto_tile(PlutoProg *);
+int pluto_tile(PlutoProg *);
 bool pluto_create_tile_schedule(PlutoProg *prog, Band **bands, int nbands);
+bool pluto_create_task_band(PlutoProg *prog, const Band *band);
+const PlutoTaskBand *pluto_loop_get_task_band(const Ploop *loop,
+                                              const PlutoProg *prog);
+void pluto_task_band_free(PlutoTaskBand *tband);
 
 int pluto_omp_parallelize(PlutoProg *prog);
-int pluto_dynschedule_graph_parallelize(PlutoProg *prog, FILE *sigmafp,
-                                        FILE *headerfp);
-int pluto_dynschedule_parallelize(PlutoProg *prog, FILE *sigmafp,
-                                  FILE *headerfp, FILE *pifp);
 int pluto_distmem_parallelize(PlutoProg *prog, FILE *sigmafp, FILE *headerfp,
                               FILE *pifp);
 
@@ -634,15 +757,15 @@ PlutoConstraints *get_receiver_tiles(struct stmt_access_pair **wacc_stmt,
                                      int dest_copy_level, PlutoProg *prog,
                                      int dep_loop_num, int *pi_mappings);
 
-void print_dynsched_file(char *srcFileName, FILE *cloogfp, FILE *outfp,
-                         PlutoProg *prog);
 int get_outermost_parallel_loop(const PlutoProg *prog);
 
 int is_loop_dominated(Ploop *loop1, Ploop *loop2, const PlutoProg *prog);
 Ploop **pluto_get_parallel_loops(const PlutoProg *prog, unsigned *nploops);
+Ploop **pluto_get_vector_loops(const PlutoProg *prog, unsigned *nvloops);
 Ploop **pluto_get_all_loops(const PlutoProg *prog, unsigned *num);
 Ploop **pluto_get_unroll_jam_loops(const PlutoProg *prog,
                                    unsigned *num_ujloops);
+unsigned pluto_get_unroll_jam_factor(Ploop *loop, const PlutoProg *prog);
 Ploop **pluto_get_dom_parallel_loops(const PlutoProg *prog, unsigned *nploops);
 Band **pluto_get_dom_parallel_bands(PlutoProg *prog, unsigned *nbands,
                                     int **comm_placement_levels);
@@ -662,10 +785,16 @@ Ploop *pluto_loop_dup(Ploop *l);
 Ploop *pluto_loop_alloc();
 void pluto_loop_free(Ploop *l);
 int pluto_loop_is_parallel(const PlutoProg *prog, Ploop *loop);
+unsigned pluto_loop_get_safelen(const Ploop *loop, const PlutoProg *prog);
+char *pluto_loop_get_omp_schedule(const Ploop *loop, const PlutoProg *prog);
+void pluto_dep_add_distance_row(PlutoConstraints *cst, const Dep *dep,
+                                unsigned level, bool is_eq,
+                                const PlutoProg *prog);
 int pluto_loop_is_parallel_for_stmt(const PlutoProg *prog, const Ploop *loop,
                                     const Stmt *stmt);
 int pluto_loop_has_satisfied_dep_with_component(const PlutoProg *prog,
                                                 const Ploop *loop);
+void pluto_band_free(Band *band);
 void pluto_bands_free(Band **bands, unsigned nbands);
 int pluto_is_hyperplane_loop(const Stmt *stmt, int level);
 void pluto_detect_hyperplane_types(PlutoProg *prog);
@@ -715,6 +844,7 @@ PlutoMatrix *construct_cplex_objective(const PlutoConstraints *cst,
 Graph *build_fusion_conflict_graph(PlutoProg *prog, int *colour, int num_nodes,
                                    int current_colour);
 void find_permutable_dimensions_scc_based(int *colour, PlutoProg *prog);
+void fcg_lp_cache_free(PlutoProg *prog);
 bool introduce_skew(PlutoProg *prog);
 #endif
 
@@ -61,7 +61,8 @@ static int pluto_schedule_prog(PlutoProg *prog) {
   }
 
   if (options->tile) {
-    pluto_tile(prog);
+    if (pluto_tile(prog))
+      return 1;
   } else {
     if (options->intratileopt) {
       pluto_intra_tile_optimize(prog, 0);
@@ -14,17 +14,18 @@
  */
 #include <assert.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
+#include "constraints.h"
 #include "math_support.h"
 #include "pluto.h"
 #include "pluto/matrix.h"
 #include "pluto/pluto.h"
 #include "program.h"
+#include "reduction.h"
+#include "target.h"
 
-/// Number of registers defined in the ISA. This is used in heuristics that
-/// determine whether the unroll jam of a loop is profitable.
-#define NUM_TOTAL_REGISTERS 32
 Ploop *pluto_loop_alloc() {
   Ploop *loop = (Ploop *)malloc(sizeof(Ploop));
   loop->nstmts = 0;
@@ -288,6 +289,11 @@ int pluto_loop_is_parallel(const PlutoProg *prog, Ploop *loop) {
     return 0;
   }
 
+  /* Reductions it carries must be parallelizable with reduction clauses */
+  if (!pluto_loop_get_reduction_clause(loop, prog, NULL)) {
+    return 0;
+  }
+
   if (prog->hProps[loop->depth].dep_prop == PARALLEL) {
     return 1;
   }
@@ -313,6 +319,186 @@ int pluto_loop_is_parallel(const PlutoProg *prog, Ploop *loop) {
   return parallel;
 }
 
+/// Adds to `cst' (over the source iterators, the destination iterators, the
+/// parameters and the constant) the row of the distance of `dep' along the
+/// hyperplane at `level': phi_dest - phi_src, as an equality or an
+/// inequality.
+void pluto_dep_add_distance_row(PlutoConstraints *cst, const Dep *dep,
+                                unsigned level, bool is_eq,
+                                const PlutoProg *prog) {
+  const Stmt *src = prog->stmts[dep->src];
+  const Stmt *dest = prog->stmts[dep->dest];
+  unsigned src_dim = src->dim, dest_dim = dest->dim, npar = prog->npar;
+
+  if (is_eq)
+    pluto_constraints_add_equality(cst);
+  else
+    pluto_constraints_add_inequality(cst);
+  int64_t *row = cst->val[cst->nrows - 1];
+  for (unsigned j = 0; j < src_dim; j++)
+    row[j] = -src->trans->val[level][j];
+  for (unsigned j = 0; j < dest_dim; j++)
+    row[src_dim + j] = dest->trans->val[level][j];
+  for (unsigned j = 0; j < npar + 1; j++) {
+    row[src_dim + dest_dim + j] = dest->trans->val[level][dest_dim + j] -
+                                  src->trans->val[level][src_dim + j];
+  }
+}
+
+/// Returns the largest number of consecutive iterations of `loop' that can be
+/// run as a SIMD chunk (OpenMP's safelen): 0 if `loop' carries no dependence
+/// between its statements, and otherwise the minimum positive distance along
+/// it of such dependences between iterations of the outer loops that are the
+/// same. Distances larger than MAX_SIMD_SAFELEN count as MAX_SIMD_SAFELEN.
+/// Returns 1 if the loop isn't vectorizable at all.
+unsigned pluto_loop_get_safelen(const Ploop *loop, const PlutoProg *prog) {
+  for (unsigned i = 0; i < loop->nstmts; i++) {
+    if (loop->stmts[i]->type != ORIG)
+      return 1;
+  }
+  if (!pluto_loop_get_reduction_clause(loop, prog, NULL))
+    return 1;
+  if (pluto_loop_is_parallel(prog, (Ploop *)loop))
+    return 0;
+
+  unsigned safelen = 0;
+  for (int i = 0; i < prog->ndeps && safelen != 1; i++) {
+    Dep *dep = prog->deps[i];
+    if (IS_RAR(dep->type))
+      continue;
+    if (!pluto_stmt_is_member_of(prog->stmts[dep->src]->id, loop->stmts,
+                                 loop->nstmts) ||
+        !pluto_stmt_is_member_of(prog->stmts[dep->dest]->id, loop->stmts,
+                                 loop->nstmts))
+      continue;
+
+    /* Instances at the same outer iterations with a distance of at least one
+     * along the loop */
+    PlutoConstraints *cst = pluto_constraints_dup(dep->dpolytope);
+    for (unsigned l = 0; l < loop->depth; l++) {
+      pluto_dep_add_distance_row(cst, dep, l, true, prog);
+    }
+    pluto_dep_add_distance_row(cst, dep, loop->depth, false, prog);
+    cst->val[cst->nrows - 1][cst->ncols - 1] -= 1;
+    if (pluto_constraints_is_empty(cst)) {
+      pluto_constraints_free(cst);
+      continue;
+    }
+
+    /* Binary search for the minimum distance; distance <= k is the negation
+     * of the distance row plus k */
+    pluto_dep_add_distance_row(cst, dep, loop->depth, false, prog);
+    int64_t *row = cst->val[cst->nrows - 1];
+    for (unsigned j = 0; j < cst->ncols; j++)
+      row[j] = -row[j];
+    unsigned lo = 1, hi = MAX_SIMD_SAFELEN + 1;
+    int64_t c = row[cst->ncols - 1];
+    while (lo < hi) {
+      unsigned mid = (lo + hi) / 2;
+      row[cst->ncols - 1] = c + mid;
+      if (pluto_constraints_is_empty(cst))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    pluto_constraints_free(cst);
+    unsigned dist = lo > MAX_SIMD_SAFELEN ? MAX_SIMD_SAFELEN : lo;
+    if (safelen == 0 || dist < safelen)
+      safelen = dist;
+  }
+
+  /* The loop isn't parallel, yet no dependence instance between the same
+   * outer iterations was found: stay conservative */
+  return safelen == 0 ? 1 : safelen;
+}
+
+/// Returns how the number of iterations of the loop at `inner' of `stmt'
+/// changes with the iterator of the loop at `depth' (< inner), from the
+/// slopes along the latter of its lower and upper bounds in the transformed
+/// domain projected on the two: 0 if it doesn't (a lower and an upper bound
+/// have the same slope, as the bounds of a point loop with those of its tile,
+/// or all have the same), 1 if it grows, -1 if it shrinks, and 2 if it does
+/// either (with different pairs of bounds).
+static int get_trip_count_trend(const Stmt *stmt, unsigned depth,
+                                unsigned inner) {
+  PlutoConstraints *dom = pluto_get_new_domain(stmt);
+  unsigned nrows = stmt->trans->nrows;
+  pluto_constraints_project_out(dom, inner + 1, nrows - inner - 1);
+  pluto_constraints_project_out(dom, depth + 1, inner - depth - 1);
+  pluto_constraints_project_out(dom, 0, depth);
+
+  /* Columns: outer iterator, inner iterator, parameters, constant */
+  int trend = 0;
+  for (const PlutoConstraints *cst = dom; cst && trend != 2; cst = cst->next) {
+    double *lbs = (double *)malloc(cst->nrows * sizeof(double));
+    double *ubs = (double *)malloc(cst->nrows * sizeof(double));
+    unsigned nlbs = 0, nubs = 0;
+    for (unsigned r = 0; r < cst->nrows; r++) {
+      int64_t c = cst->val[r][1];
+      if (c == 0)
+        continue;
+      /* The bound is -val[r][0] / c times the outer iterator + ... */
+      double slope = -(double)cst->val[r][0] / c;
+      if (c > 0 || cst->is_eq[r])
+        lbs[nlbs++] = slope;
+      if (c < 0 || cst->is_eq[r])
+        ubs[nubs++] = slope;
+    }
+    bool same = false, grows = false, shrinks = false;
+    for (unsigned l = 0; l < nlbs; l++) {
+      for (unsigned u = 0; u < nubs; u++) {
+        if (ubs[u] == lbs[l] && lbs[l] != 0)
+          same = true;
+        else if (ubs[u] > lbs[l])
+          grows = true;
+        else if (ubs[u] < lbs[l])
+          shrinks = true;
+      }
+    }
+    free(lbs);
+    free(ubs);
+    if (same || (!grows && !shrinks))
+      continue;
+    int cst_trend = grows && shrinks ? 2 : (grows ? 1 : -1);
+    trend = (trend == 0 || trend == cst_trend) ? cst_trend : 2;
+  }
+  pluto_constraints_free(dom);
+  return trend;
+}
+
+/// Returns the OpenMP schedule clause for `loop' run in parallel, chosen
+/// from how the work of its iterations varies: NULL (the static default) if
+/// the trip counts of the loops inside don't change with its iterator (see
+/// get_trip_count_trend), "schedule(dynamic,1)" if they do and `loop' is a
+/// tile space loop (whose iterations are coarse) or they shrink, and
+/// "schedule(guided)" if they grow, which starts with large chunks of light
+/// iterations. Triangular and trapezoidal loop nests thus don't leave
+/// threads idle at the end of a static schedule.
+char *pluto_loop_get_omp_schedule(const Ploop *loop, const PlutoProg *prog) {
+  int trend = 0;
+  bool tile_space = false;
+  for (unsigned i = 0; i < loop->nstmts && trend != 2; i++) {
+    const Stmt *stmt = loop->stmts[i];
+    if (loop->depth >= stmt->trans->nrows)
+      continue;
+    if (stmt->hyp_types[loop->depth] == H_TILE_SPACE_LOOP)
+      tile_space = true;
+    for (unsigned d = loop->depth + 1; d < stmt->trans->nrows && trend != 2;
+         d++) {
+      if (pluto_is_hyperplane_scalar(stmt, d))
+        continue;
+      int stmt_trend = get_trip_count_trend(stmt, loop->depth, d);
+      if (stmt_trend != 0)
+        trend = (trend == 0 || trend == stmt_trend) ? stmt_trend : 2;
+    }
+  }
+  if (trend == 0)
+    return NULL;
+  if (trend == 1 && !tile_space)
+    return strdup("schedule(guided)");
+  return strdup("schedule(dynamic,1)");
+}
+
 /*
  * Whether all statements instances of 'stmt' across different iterations of
  * loop can be run in parallel; only used in a special context; it doesn't
@@ -546,30 +732,53 @@ static unsigned get_max_num_innermost_accesses(Ploop *loop,
   return max_unique_accesses;
 }
 
-/// Cost function returns true if unrolling jamming the loop will utilize less
-/// number of registers than the total number of registers specified in the ISA
-/// of the processor. We assume that the total number of registers that is
-/// available is 32. This heuristic has to be tuned further.
-bool is_unroll_jam_profitable(Ploop *loop, const PlutoProg *prog) {
+/// Returns the unroll-jam factor for `loop': the largest power of two, at
+/// most --ufactor, for which the jammed body fits in the registers of the
+/// target (--target). After jamming by a factor u, each of the `a' distinct
+/// accesses at the innermost level that varies with `loop' needs u registers
+/// while each of the `t' that is invariant in it is shared by the u copies;
+/// a*u - t*(u - 1) registers are therefore needed. The largest such factor
+/// gives the most independent operations to keep the FMA units busy without
+/// spilling. Returns 0 if unroll-jamming `loop' isn't profitable: there is no
+/// temporal reuse along it, or even a factor of two would spill.
+unsigned pluto_get_unroll_jam_factor(Ploop *loop, const PlutoProg *prog) {
   PlutoContext *context = prog->context;
   PlutoOptions *options = context->options;
   unsigned t = get_max_num_innermost_invariant_accesses(loop, prog);
   IF_DEBUG(printf("Number of accesses with temporal reuse: %d\n", t););
   // If there is no temporal reuse, then unroll jam isnt profitable.
   if (t == 0)
-    return false;
+    return 0;
   unsigned a = get_max_num_innermost_accesses(loop, prog);
   IF_DEBUG(pluto_loop_print(loop););
   IF_DEBUG(
       printf("Total number of unique accesses at innermost level %d\n", a););
-  unsigned unroll_factor = options->ufactor;
-  int num_reg_required = a * unroll_factor - (t * (unroll_factor - 1));
-  int cost = NUM_TOTAL_REGISTERS - num_reg_required;
-  IF_DEBUG(pluto_loop_print(loop););
-  IF_DEBUG(printf("Cost for loop: %d\n", cost););
-  if (cost >= 0)
-    return true;
-  return false;
+  const PlutoTarget *target = pluto_get_target(options->target);
+  unsigned best = 0;
+  for (unsigned uf = 2; uf <= (unsigned)options->ufactor; uf *= 2) {
+    unsigned num_reg_required = a * uf - t * (uf - 1);
+    if (num_reg_required > target->num_registers)
+      break;
+    best = uf;
+  }
+  /* A factor that is not a power of two is used as given if it fits. */
+  if ((unsigned)options->ufactor > best && best > 0) {
+    unsigned uf = options->ufactor;
+    if (a * uf - t * (uf - 1) <= target->num_registers)
+      best = uf;
+  }
+  IF_DEBUG(printf("Unroll-jam factor for loop with %s registers (%u, %u "
+                  "bytes wide): %u\n",
+                  target->name, target->num_registers, target->vector_width,
+                  best););
+  return best;
+}
+
+/// Returns true if unroll-jamming the loop by some factor makes the jammed
+/// body use no more registers than the target has (see
+/// pluto_get_unroll_jam_factor).
+bool is_unroll_jam_profitable(Ploop *loop, const PlutoProg *prog) {
+  return pluto_get_unroll_jam_factor(loop, prog) > 0;
 }
 
 /// Returns a list of intra tile loops that are candidates for unroll jam.
@@ -629,6 +838,41 @@ Ploop **pluto_get_parallel_loops(const PlutoProg *prog, unsigned *nploops) {
   return ploops;
 }
 
+/// Returns the loops to vectorize: the innermost parallel loops and, with
+/// --omp-simd, the innermost loops whose dependences still allow SIMD chunks
+/// of at least two iterations (see pluto_loop_get_safelen). Without
+/// --omp-simd, loops that carry reductions are left out since their
+/// pragmas can't express them.
+Ploop **pluto_get_vector_loops(const PlutoProg *prog, unsigned *nvloops) {
+  unsigned num;
+  Ploop **loops = pluto_get_all_loops(prog, &num);
+  Ploop **vloops = NULL;
+
+  *nvloops = 0;
+  for (unsigned i = 0; i < num; i++) {
+    if (!pluto_loop_is_innermost(loops[i], prog))
+      continue;
+    if (prog->context->options->omp_simd) {
+      if (!pluto_loop_is_parallel(prog, loops[i]) &&
+          pluto_loop_get_safelen(loops[i], prog) < 2)
+        continue;
+    } else {
+      char *clause;
+      pluto_loop_get_reduction_clause(loops[i], prog, &clause);
+      bool has_reduction = (clause != NULL);
+      free(clause);
+      if (!pluto_loop_is_parallel(prog, loops[i]) || has_reduction)
+        continue;
+    }
+    vloops = (Ploop **)realloc(vloops, (*nvloops + 1) * sizeof(Ploop *));
+    vloops[(*nvloops)++] = pluto_loop_dup(loops[i]);
+  }
+
+  pluto_loops_free(loops, num);
+
+  return vloops;
+}
+
 /* List of parallel loops such that no loop dominates another in the list */
 Ploop **pluto_get_dom_parallel_loops(const PlutoProg *prog,
                                      unsigned *ndploops) {
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <vector>
 
 #include "constraints.h"
@@ -745,6 +746,8 @@ PlutoProg *pluto_prog_alloc(PlutoContext *context) {
   prog->ndeps = 0;
   prog->transdeps = NULL;
   prog->ntransdeps = 0;
+  prog->reduction_deps = NULL;
+  prog->nreduction_deps = 0;
   prog->ddg = NULL;
   prog->fcg = NULL;
   prog->hProps = NULL;
@@ -753,6 +756,8 @@ PlutoProg *pluto_prog_alloc(PlutoContext *context) {
   prog->data_names = NULL;
   prog->num_data = 0;
   prog->is_diamond_tiled = false;
+  prog->task_bands = NULL;
+  prog->ntask_bands = 0;
 
   strcpy(prog->decls, "");
 
@@ -776,6 +781,29 @@ PlutoProg *pluto_prog_alloc(PlutoContext *context) {
 
   prog->tss_time = 0.0;
   prog->num_lp_calls = 0;
+  prog->fcg_lp_cache = NULL;
+  prog->num_fcg_lp_reused = 0;
+
+  prog->hier_cluster = NULL;
+  prog->hier_num_clusters = 1;
+  prog->hier_max_cluster_size = 0;
+  prog->hier_group = NULL;
+  prog->hier_num_groups = 1;
+  prog->hier_size_cuts = 0;
+  prog->hier_deps_distributed = 0;
+  prog->hier_bound_loss = 0;
+  prog->hier_fusion_failures = 0;
+  prog->hier_time = 0.0;
+
+  prog->budget_fallback = kBudgetNoFallback;
+
+  prog->data_element_size = 0;
+
+  prog->ddg_scc_full_time = 0.0;
+  prog->ddg_scc_incr_time = 0.0;
+  prog->ddg_scc_time_saved = 0.0;
+  prog->num_ddg_scc_full = 0;
+  prog->num_ddg_scc_incr = 0;
 
   return prog;
 }
@@ -792,6 +820,16 @@ void pluto_prog_free(PlutoProg *prog) {
   }
   free(prog->transdeps);
 
+  for (int i = 0; i < prog->nreduction_deps; i++) {
+    pluto_dep_free(prog->reduction_deps[i]);
+  }
+  free(prog->reduction_deps);
+
+  for (unsigned i = 0; i < prog->ntask_bands; i++) {
+    pluto_task_band_free(prog->task_bands[i]);
+  }
+  free(prog->task_bands);
+
   /* Free DDG */
   if (prog->ddg != NULL) {
     graph_free(prog->ddg);
@@ -821,6 +859,9 @@ void pluto_prog_free(PlutoProg *prog) {
 
   pluto_constraints_free(prog->globcst);
 
+  free(prog->hier_cluster);
+  free(prog->hier_group);
+
   free(prog->decls);
 
   for (int i = 0; i < prog->num_data; i++) {
@@ -860,11 +901,22 @@ PlutoOptions *pluto_options_alloc() {
   options->per_cc_obj = 0;
 
   options->iss = 0;
+
+  options->incremental_scc = 0;
+
+  options->hierarchical = 0;
+  options->hier_cluster_size = 16;
+
+  /* No compile time budget */
+  options->time_budget = 0.0;
+
   options->unrolljam = 1;
 
   /* Unroll/jam factor */
   options->ufactor = 8;
 
+  options->target = kTargetGeneric;
+
   /* Ignore input deps */
   options->rar = 0;
 
@@ -880,12 +932,33 @@ PlutoOptions *pluto_options_alloc() {
 
   options->cloogbacktrack = 1;
 
+  options->codegen = kCodegenCloog;
+  options->isl_ast_options = NULL;
+
   options->multipar = 0;
   options->second_level_tile = 0;
+  options->tile_levels = 1;
+  options->parallel_tile_level = 0;
+  options->split_tile = 0;
+  options->parametric_tiles = 0;
+  options->full_tiles = 0;
   options->find_tile_sizes = 0;
+  options->exact_tile_footprint = 0;
   options->cache_size = 1048576; // L2 cache size by default
-  options->data_element_size = sizeof(double);
+  options->data_element_size = 0;
+  options->num_cache_levels = 0;
+  options->num_threads = 0;
+  options->parallel_slack = 2;
   options->prevector = 1;
+  options->omp_simd = 1;
+  options->array_alignment = 0;
+  options->reductions = 0;
+  options->omp_tasks = 0;
+  options->doacross = 0;
+  options->omp_collapse = 1;
+  options->omp_schedule = 1;
+  options->multiversion = 0;
+  options->multiversion_threshold = 100000.0;
   options->fuse = kSmartFuse;
 
   /* Experimental */
@@ -933,6 +1006,8 @@ PlutoOptions *pluto_options_alloc() {
   options->silent = 0;
 
   options->out_file = NULL;
+  options->tile_config = NULL;
+  options->tile_config_out = NULL;
 
   options->time = 1;
 
@@ -942,6 +1017,12 @@ PlutoOptions *pluto_options_alloc() {
 PlutoContext *pluto_context_alloc() {
   PlutoContext *context = (PlutoContext *)malloc(sizeof(PlutoContext));
   context->options = pluto_options_alloc();
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  context->start_time = tv.tv_sec + tv.tv_usec * 1.0e-6;
+  context->budget_end = 0.0;
+  context->solver_deadline = 0.0;
+  context->solver_timed_out = 0;
   return context;
 }
 
@@ -971,6 +1052,11 @@ void pluto_prog_add_param(PlutoProg *prog, const char *param, int pos) {
         prog->deps[i]->dpolytope,
         prog->deps[i]->dpolytope->ncols - 1 - prog->npar + pos, NULL);
   }
+  for (int i = 0; i < prog->nreduction_deps; i++) {
+    pluto_constraints_add_dim(
+        prog->reduction_deps[i]->dpolytope,
+        prog->reduction_deps[i]->dpolytope->ncols - 1 - prog->npar + pos, NULL);
+  }
   pluto_constraints_add_dim(prog->param_context,
                             prog->param_context->ncols - 1 - prog->npar + pos,
                             param);
@@ -993,6 +1079,9 @@ void pluto_options_free(PlutoOptions *options) {
   if (options->out_file != NULL) {
     free(options->out_file);
   }
+  free(options->tile_config);
+  free(options->tile_config_out);
+  free(options->isl_ast_options);
   free(options);
 }
 
@@ -1081,6 +1170,17 @@ void pluto_stmt_add_dim(Stmt *stmt, unsigned pos, int time_pos,
                                 NULL);
     }
   }
+
+  /* Relaxed reduction dependences are self dependences */
+  for (i = 0; i < prog->nreduction_deps; i++) {
+    Dep *dep = prog->reduction_deps[i];
+    if (dep->src == stmt->id) {
+      pluto_constraints_add_dim(dep->dpolytope, stmt->dim - 1 + pos, NULL);
+      pluto_constraints_add_dim(dep->dpolytope, pos, NULL);
+      pluto_constraints_add_dim(dep->bounding_poly, stmt->dim - 1 + pos, NULL);
+      pluto_constraints_add_dim(dep->bounding_poly, pos, NULL);
+    }
+  }
 }
 
 /* Warning: use it only to knock off a dummy dimension (unrelated to
@@ -1142,6 +1242,15 @@ void pluto_stmt_remove_dim(Stmt *stmt, unsigned pos, PlutoProg *prog) {
                                        pos);
     }
   }
+
+  /* Relaxed reduction dependences are self dependences */
+  for (int i = 0; i < prog->nreduction_deps; i++) {
+    Dep *dep = prog->reduction_deps[i];
+    if (dep->src == stmt->id) {
+      pluto_constraints_remove_dim(dep->dpolytope, stmt->dim + 1 + pos);
+      pluto_constraints_remove_dim(dep->dpolytope, pos);
+    }
+  }
 }
 
 void pluto_stmt_add_hyperplane(Stmt *stmt, PlutoHypType type, unsigned pos) {
@@ -1385,6 +1494,9 @@ Stmt *pluto_stmt_alloc(unsigned dim, const PlutoConstraints *domain,
 
   stmt->first_tile_dim = 0;
   stmt->last_tile_dim = -1;
+  stmt->ufactor = 0;
+  stmt->vector_length = 0;
+  stmt->reduction_op = kReductionNone;
 
   stmt->type = STMT_UNKNOWN;
   stmt->ploop_id = -1;
@@ -2199,6 +2311,9 @@ Stmt *pluto_stmt_dup(const Stmt *stmt) {
 
   nstmt->dim_orig = stmt->dim_orig;
   nstmt->type = stmt->type;
+  nstmt->ufactor = stmt->ufactor;
+  nstmt->vector_length = stmt->vector_length;
+  nstmt->reduction_op = stmt->reduction_op;
 
   for (unsigned i = 0; i < stmt->dim; i++) {
     nstmt->iterators[i] = strdup(stmt->iterators[i]);
@@ -0,0 +1,356 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE in the
+ * top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ * Reductions: detection of statements that update a single location with an
+ * associative and commutative operator, relaxation of the dependences
+ * between their updates, and the OpenMP clauses of the loops that carry
+ * them.
+ *
+ */
+#include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "math_support.h"
+#include "pluto.h"
+#include "pluto/matrix.h"
+#include "pluto/pluto.h"
+#include "program.h"
+#include "reduction.h"
+
+/// Returns the position of the assignment operator at the top level of
+/// `text' (the '=' of =, +=, ...), or -1 if there is none.
+static int find_assignment(const char *text) {
+  int depth = 0;
+  for (int i = 0; text[i]; i++) {
+    char c = text[i];
+    if (c == '(' || c == '[') {
+      depth++;
+    } else if (c == ')' || c == ']') {
+      depth--;
+    } else if (c == '=' && depth == 0) {
+      if (text[i + 1] == '=') {
+        i++;
+        continue;
+      }
+      if (i > 0 && strchr("!<>", text[i - 1]) &&
+          !(i > 1 && text[i - 2] == text[i - 1])) {
+        /* Comparison; <<= and >>= are assignments */
+        continue;
+      }
+      return i;
+    }
+  }
+  return -1;
+}
+
+/// Returns true if `expr' has one of `ops' outside parentheses and brackets.
+static bool has_top_level_op(const char *expr, const char *ops) {
+  int depth = 0;
+  for (const char *p = expr; *p; p++) {
+    if (*p == '(' || *p == '[') {
+      depth++;
+    } else if (*p == ')' || *p == ']') {
+      depth--;
+    } else if (depth == 0 && strchr(ops, *p)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+PlutoReductionOp pluto_get_reduction_op_from_text(const char *text) {
+  int pos = find_assignment(text);
+  if (pos <= 0)
+    return kReductionNone;
+
+  /* Compound assignment */
+  if (strchr("+-*/%&|^<>", text[pos - 1])) {
+    if (text[pos - 1] == '+' || text[pos - 1] == '-')
+      return kReductionAdd;
+    if (text[pos - 1] == '*')
+      return kReductionMul;
+    return kReductionNone;
+  }
+
+  /* x = x op e: the right-hand side starts with the left-hand side */
+  int lhs_len = pos;
+  while (lhs_len > 0 && isspace(text[lhs_len - 1]))
+    lhs_len--;
+  const char *rhs = text + pos + 1;
+  while (isspace(*rhs))
+    rhs++;
+  if (lhs_len == 0 || strncmp(rhs, text, lhs_len))
+    return kReductionNone;
+  const char *rest = rhs + lhs_len;
+  while (isspace(*rest))
+    rest++;
+  char op = *rest;
+  if ((op != '+' && op != '-' && op != '*') || rest[1] == op ||
+      rest[1] == '=')
+    return kReductionNone;
+
+  /* The remaining operand must bind tighter than op */
+  if (op == '*') {
+    return has_top_level_op(rest + 1, "+-/%?<>=&|^,") ? kReductionNone
+                                                      : kReductionMul;
+  }
+  return has_top_level_op(rest + 1, "?<>=&|^,") ? kReductionNone
+                                                : kReductionAdd;
+}
+
+/// Returns true if `stmt' is a valid reduction on its only write access.
+static bool is_reduction_stmt(const Stmt *stmt) {
+  if (stmt->reduction_op == kReductionNone || stmt->nwrites != 1 ||
+      stmt->writes[0]->name == NULL)
+    return false;
+  PlutoAccess *wacc = stmt->writes[0];
+  int num_reads = 0;
+  for (int i = 0; i < stmt->nreads; i++) {
+    PlutoAccess *racc = stmt->reads[i];
+    if (racc->name == NULL || strcmp(racc->name, wacc->name))
+      continue;
+    if (!are_pluto_matrices_equal(racc->mat, wacc->mat))
+      return false;
+    num_reads++;
+  }
+  return num_reads == 1;
+}
+
+/// Returns true if `dep' is between instances of a reduction statement on
+/// its reduced location.
+static bool is_reduction_dep(const Dep *dep, const PlutoProg *prog) {
+  if (IS_RAR(dep->type) || dep->src != dep->dest)
+    return false;
+  const Stmt *stmt = prog->stmts[dep->src];
+  if (stmt->reduction_op == kReductionNone || !dep->src_acc ||
+      !dep->dest_acc || !dep->src_acc->name || !dep->dest_acc->name)
+    return false;
+  const char *name = stmt->writes[0]->name;
+  return !strcmp(dep->src_acc->name, name) &&
+         !strcmp(dep->dest_acc->name, name);
+}
+
+unsigned pluto_relax_reduction_deps(PlutoProg *prog) {
+  PlutoContext *context = prog->context;
+
+  for (unsigned i = 0; i < prog->nstmts; i++) {
+    Stmt *stmt = prog->stmts[i];
+    if (!is_reduction_stmt(stmt)) {
+      stmt->reduction_op = kReductionNone;
+      continue;
+    }
+    IF_DEBUG(printf("[pluto] S%d is a reduction on %s\n", stmt->id + 1,
+                    stmt->writes[0]->name););
+  }
+
+  unsigned num_relaxed = 0;
+  int ndeps = 0;
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (is_reduction_dep(dep, prog)) {
+      prog->reduction_deps = (Dep **)realloc(
+          prog->reduction_deps, (prog->nreduction_deps + 1) * sizeof(Dep *));
+      prog->reduction_deps[prog->nreduction_deps++] = dep;
+      num_relaxed++;
+    } else {
+      dep->id = ndeps;
+      prog->deps[ndeps++] = dep;
+    }
+  }
+  prog->ndeps = ndeps;
+
+  return num_relaxed;
+}
+
+/// Returns the location `stmt' reduces, in terms of the iterators of the
+/// loops outside `depth' (t1, t2, ...) and the parameters, as an OpenMP list
+/// item: the scalar, or a one-element array section. Returns NULL if the
+/// location varies with the loop at `depth' or an inner one.
+static char *get_reduction_location(const Stmt *stmt, unsigned depth,
+                                    const PlutoProg *prog) {
+  const PlutoAccess *acc = stmt->writes[0];
+  if (acc->mat->nrows == 0)
+    return strdup(acc->name);
+
+  int *divs;
+  PlutoMatrix *newacc = pluto_get_new_access_func(acc->mat, stmt, &divs);
+  unsigned nhyps = stmt->trans->nrows;
+  assert(newacc->ncols == nhyps + prog->npar + 1);
+
+  /* Each term: "+<coeff>*<name>" */
+  size_t len = strlen(acc->name) + 1;
+  for (int i = 0; i < prog->npar; i++) {
+    len += newacc->nrows * (strlen(prog->params[i]) + 24);
+  }
+  len += newacc->nrows * (nhyps * 40 + 64);
+  char *location = (char *)malloc(len);
+  strcpy(location, acc->name);
+
+  bool invariant = true;
+  for (unsigned r = 0; r < newacc->nrows && invariant; r++) {
+    int64_t *row = newacc->val[r];
+    int64_t cst = row[newacc->ncols - 1];
+    for (unsigned c = depth; c < nhyps; c++) {
+      if (row[c] != 0 && stmt->hyp_types[c] != H_SCALAR)
+        invariant = false;
+    }
+    /* Scalar dimensions are constants */
+    for (unsigned c = 0; c < nhyps; c++) {
+      if (stmt->hyp_types[c] == H_SCALAR)
+        cst += row[c] * stmt->trans->val[c][stmt->trans->ncols - 1];
+    }
+    if (!invariant)
+      break;
+
+    bool exact = cst % divs[r] == 0;
+    for (unsigned c = 0; c < newacc->ncols - 1; c++) {
+      if (row[c] % divs[r] != 0)
+        exact = false;
+    }
+    int64_t div = exact ? divs[r] : 1;
+
+    char *p = location + strlen(location);
+    p += sprintf(p, "[%s", exact || divs[r] == 1 ? "" : "(");
+    bool first = true;
+    for (unsigned c = 0; c < newacc->ncols - 1; c++) {
+      if (row[c] == 0 || (c < nhyps && stmt->hyp_types[c] == H_SCALAR))
+        continue;
+      int64_t coeff = row[c] / div;
+      if (!first || coeff < 0)
+        p += sprintf(p, "%s", coeff < 0 ? "-" : "+");
+      if (coeff != 1 && coeff != -1)
+        p += sprintf(p, "%lld*", (long long)(coeff < 0 ? -coeff : coeff));
+      if (c < nhyps)
+        p += sprintf(p, "t%u", c + 1);
+      else
+        p += sprintf(p, "%s", prog->params[c - nhyps]);
+      first = false;
+    }
+    if (cst != 0 || first)
+      p += sprintf(p, first ? "%lld" : "%+lld", (long long)(cst / div));
+    if (!exact && divs[r] != 1)
+      p += sprintf(p, ")/%d", divs[r]);
+    sprintf(p, "%s]", r == newacc->nrows - 1 ? ":1" : "");
+  }
+
+  pluto_matrix_free(newacc);
+  free(divs);
+  if (!invariant) {
+    free(location);
+    return NULL;
+  }
+  return location;
+}
+
+/// A reduction carried by a loop: the array, its location and operator
+typedef struct loopReduction {
+  const char *name;
+  char *location;
+  PlutoReductionOp op;
+} LoopReduction;
+
+bool pluto_loop_get_reduction_clause(const Ploop *loop, const PlutoProg *prog,
+                                     char **clause) {
+  if (clause)
+    *clause = NULL;
+  if (prog->nreduction_deps == 0)
+    return true;
+
+  /* The reductions the loop carries */
+  LoopReduction *reds = NULL;
+  unsigned nreds = 0;
+  bool expressible = true;
+  for (int i = 0; i < prog->nreduction_deps && expressible; i++) {
+    const Dep *dep = prog->reduction_deps[i];
+    const Stmt *stmt = prog->stmts[dep->src];
+    if (!pluto_stmt_is_member_of(stmt->id, loop->stmts, loop->nstmts) ||
+        loop->depth >= stmt->trans->nrows ||
+        get_dep_direction(dep, prog, loop->depth) == DEP_ZERO)
+      continue;
+    const char *name = stmt->writes[0]->name;
+    unsigned k;
+    for (k = 0; k < nreds; k++) {
+      if (!strcmp(reds[k].name, name))
+        break;
+    }
+    if (k < nreds)
+      continue;
+    reds = (LoopReduction *)realloc(reds, (nreds + 1) * sizeof(LoopReduction));
+    reds[nreds].name = name;
+    reds[nreds].location = get_reduction_location(stmt, loop->depth, prog);
+    reds[nreds].op = stmt->reduction_op;
+    if (reds[nreds].location == NULL)
+      expressible = false;
+    nreds++;
+  }
+
+  /* Private copies of the reduced locations are made for the loop: the other
+   * accesses to their arrays in the loop must be the same reduction */
+  for (unsigned k = 0; k < nreds && expressible; k++) {
+    for (unsigned i = 0; i < loop->nstmts && expressible; i++) {
+      const Stmt *stmt = loop->stmts[i];
+      bool accesses = false;
+      for (int j = 0; j < stmt->nreads + stmt->nwrites; j++) {
+        const PlutoAccess *acc = j < stmt->nreads
+                                     ? stmt->reads[j]
+                                     : stmt->writes[j - stmt->nreads];
+        if (acc->name && !strcmp(acc->name, reds[k].name))
+          accesses = true;
+      }
+      if (!accesses)
+        continue;
+      if (stmt->reduction_op != reds[k].op ||
+          strcmp(stmt->writes[0]->name, reds[k].name)) {
+        expressible = false;
+        break;
+      }
+      char *location = get_reduction_location(stmt, loop->depth, prog);
+      if (location == NULL || strcmp(location, reds[k].location))
+        expressible = false;
+      free(location);
+    }
+  }
+
+  if (expressible && clause && nreds > 0) {
+    size_t len = 1;
+    for (unsigned k = 0; k < nreds; k++) {
+      len += strlen(reds[k].location) + 16;
+    }
+    *clause = (char *)malloc(len);
+    (*clause)[0] = '\0';
+    PlutoReductionOp ops[] = {kReductionAdd, kReductionMul};
+    for (unsigned o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+      bool first = true;
+      for (unsigned k = 0; k < nreds; k++) {
+        if (reds[k].op != ops[o])
+          continue;
+        if (first) {
+          sprintf(*clause + strlen(*clause), "%sreduction(%c:",
+                  strlen(*clause) > 0 ? ") " : "",
+                  ops[o] == kReductionAdd ? '+' : '*');
+        } else {
+          strcat(*clause, ",");
+        }
+        strcat(*clause, reds[k].location);
+        first = false;
+      }
+    }
+    strcat(*clause, ")");
+  }
+
+  for (unsigned k = 0; k < nreds; k++) {
+    free(reds[k].location);
+  }
+  free(reds);
+
+  return expressible;
+}
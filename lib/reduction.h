@@ -0,0 +1,51 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE
+ * in the top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ */
+#ifndef _REDUCTION_H
+#define _REDUCTION_H
+
+#include <stdbool.h>
+
+#include "pluto.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/// Returns the reduction operator of the expression statement `text' if it
+/// is an update of its left-hand side of the form x += e, x -= e, x *= e,
+/// x = x + e, x = x - e or x = x * e; kReductionNone otherwise. Whether e
+/// reads x is checked on the accesses (see pluto_relax_reduction_deps).
+PlutoReductionOp pluto_get_reduction_op_from_text(const char *text);
+
+/// Relaxes the dependences of reductions (--reductions): statements whose
+/// reduction_op was set by the frontend are kept as reductions if they write
+/// a single location, read it once with the same access function and read
+/// no other element of its array. The dependences between instances of such
+/// a statement on that location are moved from prog->deps to
+/// prog->reduction_deps so that the scheduler may reorder the updates, which
+/// are then parallelized with OpenMP reduction clauses. Returns the number
+/// of dependences moved.
+unsigned pluto_relax_reduction_deps(PlutoProg *prog);
+
+/// Finds the reductions carried by `loop' (whose dependences were relaxed)
+/// and sets `clause', if not NULL, to the OpenMP reduction clauses they need
+/// when the loop is run in parallel or in SIMD chunks, e.g.
+/// "reduction(+:s,C[t1][t2:1])", or to NULL if there are none. Returns false
+/// if a carried reduction can't be expressed with a clause: the reduced
+/// location varies within the loop, or other statements in the loop access
+/// its array; the loop must then run sequentially.
+bool pluto_loop_get_reduction_clause(const Ploop *loop, const PlutoProg *prog,
+                                     char **clause);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _REDUCTION_H
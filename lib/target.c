@@ -0,0 +1,58 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE in the
+ * top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ * Register files of the instruction sets known to the unroll-jam model
+ * (--target), and detection of the one of the host.
+ *
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "target.h"
+
+static const PlutoTarget targets[] = {
+    [kTargetGeneric] = {"generic", 32, 8},
+    [kTargetNative] = {"native", 32, 8},
+    [kTargetSSE] = {"sse", 16, 16},
+    [kTargetAVX2] = {"avx2", 16, 32},
+    [kTargetAVX512] = {"avx512", 32, 64},
+    [kTargetNEON] = {"neon", 32, 16},
+};
+
+/// Returns the instruction set of the host; kTargetGeneric if it isn't known.
+static TargetType get_native_target() {
+#if defined(__x86_64__) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return kTargetAVX512;
+  /* AVX has the register file of AVX2. */
+  if (__builtin_cpu_supports("avx2") || __builtin_cpu_supports("avx"))
+    return kTargetAVX2;
+  return kTargetSSE;
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+  return kTargetNEON;
+#else
+  return kTargetGeneric;
+#endif
+}
+
+const PlutoTarget *pluto_get_target(TargetType type) {
+  if (type == kTargetNative)
+    type = get_native_target();
+  return &targets[type];
+}
+
+bool pluto_parse_target(const char *name, TargetType *type) {
+  for (unsigned i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+    if (!strcmp(name, targets[i].name)) {
+      *type = (TargetType)i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,48 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE
+ * in the top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ */
+#ifndef _TARGET_H
+#define _TARGET_H
+
+#include <stdbool.h>
+
+#include "pluto/pluto.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Register file of a target instruction set, as seen by the unroll-jam
+ * model. */
+struct plutoTarget {
+  const char *name;
+
+  /* Number of architectural vector (or, for the generic target, scalar
+   * floating-point) registers */
+  unsigned num_registers;
+
+  /* Width of a vector register in bytes */
+  unsigned vector_width;
+};
+typedef struct plutoTarget PlutoTarget;
+
+/// Returns the description of `type'. kTargetNative is resolved to the
+/// instruction set of the machine Pluto runs on (through cpuid on x86), and to
+/// the generic target if it can't be identified.
+const PlutoTarget *pluto_get_target(TargetType type);
+
+/// Parses an instruction set name as given to --target (generic, native, sse,
+/// avx2, avx512 or neon). Returns false if `name' isn't one of them.
+bool pluto_parse_target(const char *name, TargetType *type);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _TARGET_H
@@ -19,13 +19,17 @@
 #include "pluto/pluto.h"
 #include "post_transform.h"
 #include "program.h"
+#include "tile_config.h"
 #include "tile_size_selection_model.h"
 #include "transforms.h"
 
-/* Read tile sizes from file tile.sizes */
-static int read_tile_sizes(int *tile_sizes, int *second_level_tile_size_ratios,
-                           int num_tile_dims, Stmt **stmts, int nstmts,
-                           int firstLoop, PlutoContext *context) {
+/* Read the tile sizes of `level' (1 for the first level) from file tile.sizes
+ * (when no tile configuration is given): first level tile sizes come first,
+ * one per loop of the band, followed by the ratios of the tile sizes of each
+ * further level to those of the previous one, one per band dimension */
+static int read_tile_sizes(int *tile_sizes, unsigned level, int num_tile_dims,
+                           Stmt **stmts, int nstmts, int firstLoop,
+                           PlutoContext *context) {
   int i, j;
 
   FILE *tsfile = fopen("tile.sizes", "r");
@@ -41,6 +45,8 @@ static int read_tile_sizes(int *tile_sizes, int *second_level_tile_size_ratios,
     num_tile_dims = options->lt - options->ft + 1;
   }
 
+  int first_level_tile_sizes[num_tile_dims];
+  int *sizes = (level == 1) ? tile_sizes : first_level_tile_sizes;
   for (i = 0; i < num_tile_dims && !feof(tsfile); i++) {
     for (j = 0; j < nstmts; j++) {
       if (pluto_is_hyperplane_loop(stmts[j], firstLoop + i))
@@ -48,10 +54,10 @@ static int read_tile_sizes(int *tile_sizes, int *second_level_tile_size_ratios,
     }
     int loop = (j < nstmts);
     if (loop) {
-      fscanf(tsfile, "%d", &tile_sizes[i]);
+      fscanf(tsfile, "%d", &sizes[i]);
     } else {
       /* Size set for scalar dimension doesn't matter */
-      tile_sizes[i] = 42;
+      sizes[i] = 42;
     }
   }
 
@@ -61,17 +67,27 @@ static int read_tile_sizes(int *tile_sizes, int *second_level_tile_size_ratios,
     return 0;
   }
 
-  i = 0;
-  while (i < num_tile_dims && !feof(tsfile)) {
-    fscanf(tsfile, "%d", &second_level_tile_size_ratios[i++]);
+  if (level == 1) {
+    fclose(tsfile);
+    return 1;
   }
 
-  if (i < num_tile_dims) {
-    if (options->second_level_tile)
-      printf("WARNING: not enough second level tile sizes provided; using "
-             "default\n");
+  /* Skip the ratios of the levels in between */
+  int nskip = (level - 2) * num_tile_dims;
+  for (i = 0; i < nskip + num_tile_dims; i++) {
+    int ratio;
+    if (fscanf(tsfile, "%d", &ratio) != 1)
+      break;
+    if (i >= nskip)
+      tile_sizes[i - nskip] = ratio;
+  }
+
+  if (i < nskip + num_tile_dims) {
+    printf("WARNING: not enough level %u tile sizes provided; using "
+           "default\n",
+           level);
     for (i = 0; i < num_tile_dims; i++) {
-      second_level_tile_size_ratios[i] = 8;
+      tile_sizes[i] = DEFAULT_SECOND_LEVEL_TILE_SIZE_RATIO;
     }
   }
 
@@ -79,6 +95,86 @@ static int read_tile_sizes(int *tile_sizes, int *second_level_tile_size_ratios,
   return 1;
 }
 
+/// Returns the number of dimensions of `band' that are loops for at least one
+/// of its statements; their positions in the band are stored in `loop_dims'.
+static unsigned get_band_loop_dims(const Band *band, unsigned *loop_dims) {
+  unsigned nloop_dims = 0;
+  for (unsigned i = 0; i < band->width; i++) {
+    for (unsigned j = 0; j < band->loop->nstmts; j++) {
+      if (pluto_is_hyperplane_loop(band->loop->stmts[j],
+                                   band->loop->depth + i)) {
+        loop_dims[nloop_dims++] = i;
+        break;
+      }
+    }
+  }
+  return nloop_dims;
+}
+
+/// Sets the tile sizes of `level' for `band' from its tile configuration,
+/// which has one size per loop of the band. Returns false if the
+/// configuration has no sizes for that level.
+static bool get_config_tile_sizes(int *tile_sizes, const Band *band,
+                                  const PlutoTileBandConfig *band_config,
+                                  unsigned level, PlutoContext *context) {
+  if (!band_config || band_config->nlevels < level ||
+      band_config->nsizes[level - 1] == 0)
+    return false;
+
+  const int *sizes = band_config->sizes[level - 1];
+  unsigned nsizes = band_config->nsizes[level - 1];
+  unsigned loop_dims[band->width];
+  unsigned nloop_dims = get_band_loop_dims(band, loop_dims);
+
+  if (nsizes < nloop_dims) {
+    printf("[pluto] WARNING: %u level %u tile sizes given for a band with %u "
+           "loops; using the default for the rest\n",
+           nsizes, level, nloop_dims);
+  }
+  for (unsigned i = 0; i < nloop_dims && i < nsizes; i++) {
+    tile_sizes[loop_dims[i]] = sizes[i];
+  }
+
+  IF_DEBUG(printf("[pluto] Level %u tile sizes from the tile configuration "
+                  "for band at depth %d\n",
+                  level, band->loop->depth););
+  return true;
+}
+
+/// Rounds the first level tile size of the innermost loop of `band' up to a
+/// multiple of `vector_length' (if not 0), whichever way the tile sizes were
+/// chosen.
+static void round_tile_sizes_to_vector_length(int *tile_sizes,
+                                              const Band *band,
+                                              unsigned vector_length) {
+  unsigned loop_dims[band->width];
+  unsigned nloop_dims = get_band_loop_dims(band, loop_dims);
+  if (vector_length == 0 || nloop_dims == 0)
+    return;
+
+  int *size = &tile_sizes[loop_dims[nloop_dims - 1]];
+  *size = ((*size + vector_length - 1) / vector_length) * vector_length;
+}
+
+/// Records the tile sizes of `level' used for `band' into `found'.
+static void record_tile_sizes(PlutoTileConfig *found, const Band *band,
+                              unsigned level, const int *tile_sizes,
+                              const PlutoOptions *options) {
+  unsigned loop_dims[band->width];
+  unsigned nloop_dims = get_band_loop_dims(band, loop_dims);
+  if (nloop_dims == 0)
+    return;
+
+  int sizes[nloop_dims];
+  for (unsigned i = 0; i < nloop_dims; i++) {
+    sizes[i] = tile_sizes[loop_dims[i]];
+  }
+  PlutoTileBandConfig *band_config = pluto_tile_config_get_band(found, band);
+  pluto_tile_band_config_set_sizes(band_config, level, sizes, nloop_dims);
+  if (options->unrolljam)
+    band_config->ufactor = options->ufactor;
+}
+
 /*
  * Reschedule a diamond tile
  */
@@ -114,8 +210,18 @@ void pluto_tile_band(PlutoProg *prog, Band *band, int *tile_sizes) {
 
   unsigned num_domain_supernodes[band->loop->nstmts];
 
+  /* Last tile space dimension once this level is added: the tile space
+   * dimensions of all the levels this band has been tiled for so far are
+   * followed by those of this level */
+  int last_tile_dim[band->loop->nstmts];
+
   for (unsigned s = 0; s < band->loop->nstmts; s++) {
+    Stmt *stmt = band->loop->stmts[s];
     num_domain_supernodes[s] = 0;
+    bool tiled =
+        stmt->num_tiled_loops > 0 && stmt->first_tile_dim == (int)firstD;
+    last_tile_dim[s] =
+        (tiled ? stmt->last_tile_dim : (int)firstD - 1) + band->width;
   }
 
   for (unsigned depth = firstD; depth <= lastD; depth++) {
@@ -201,25 +307,378 @@ void pluto_tile_band(PlutoProg *prog, Band *band, int *tile_sizes) {
       }
       stmt->num_tiled_loops++;
       stmt->first_tile_dim = firstD;
-      stmt->last_tile_dim = lastD;
+      stmt->last_tile_dim = last_tile_dim[s];
     } /* all statements */
   }   /* all scats to be tiled */
 }
 
+/// Returns true if, for every dependence between statements of `band' that is
+/// not satisfied outside the band, sign * dx <= slope * dt, where dt and dx are
+/// the dependence distances along the first two dimensions of the band.
+static bool are_deps_within_slope(const Band *band, int sign, int slope,
+                                  const PlutoProg *prog) {
+  PlutoContext *context = prog->context;
+  unsigned r0 = band->loop->depth, r1 = band->loop->depth + 1;
+  int npar = prog->npar;
+
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (IS_RAR(dep->type))
+      continue;
+    if (dep->satisfaction_level < (int)band->loop->depth)
+      continue;
+    if (!pluto_stmt_is_member_of(prog->stmts[dep->src]->id, band->loop->stmts,
+                                 band->loop->nstmts) ||
+        !pluto_stmt_is_member_of(prog->stmts[dep->dest]->id,
+                                 band->loop->stmts, band->loop->nstmts))
+      continue;
+    const Stmt *src = prog->stmts[dep->src];
+    const Stmt *dest = prog->stmts[dep->dest];
+    int src_dim = src->dim, dest_dim = dest->dim;
+    PlutoMatrix *st = src->trans, *dt = dest->trans;
+
+    /* Look for a violation: sign * dx - slope * dt >= 1 */
+    PlutoConstraints *cst =
+        pluto_constraints_alloc(1 + dep->dpolytope->nrows,
+                                src_dim + dest_dim + npar + 1, context);
+    cst->is_eq[0] = 0;
+    for (int j = 0; j < src_dim; j++) {
+      cst->val[0][j] = -(sign * st->val[r1][j] - slope * st->val[r0][j]);
+    }
+    for (int j = 0; j < dest_dim; j++) {
+      cst->val[0][src_dim + j] =
+          sign * dt->val[r1][j] - slope * dt->val[r0][j];
+    }
+    for (int j = 0; j < npar + 1; j++) {
+      cst->val[0][src_dim + dest_dim + j] =
+          (sign * dt->val[r1][dest_dim + j] -
+           slope * dt->val[r0][dest_dim + j]) -
+          (sign * st->val[r1][src_dim + j] - slope * st->val[r0][src_dim + j]);
+    }
+    cst->val[0][src_dim + dest_dim + npar] -= 1;
+    cst->nrows = 1;
+    pluto_constraints_add(cst, dep->dpolytope);
+    bool is_empty = pluto_constraints_is_empty(cst);
+    pluto_constraints_free(cst);
+    if (!is_empty)
+      return false;
+  }
+  return true;
+}
+
+/// Returns the smallest slope (at most MAX_SPLIT_TILE_SLOPE) that bounds the
+/// dependence distances of `band' as in are_deps_within_slope; -1 if there is
+/// none.
+static int get_split_tile_slope(const Band *band, int sign,
+                                const PlutoProg *prog) {
+  for (int slope = 0; slope <= MAX_SPLIT_TILE_SLOPE; slope++) {
+    if (are_deps_within_slope(band, sign, slope, prog))
+      return slope;
+  }
+  return -1;
+}
+
+/// Returns true if `band' is to be split-tiled: the tile configuration says
+/// so for the band, or it says nothing and --split-tile is on.
+static bool is_split_tiling_requested(const Band *band,
+                                      const PlutoTileConfig *config,
+                                      const PlutoOptions *options) {
+  const PlutoTileBandConfig *band_config =
+      pluto_tile_config_lookup(config, band);
+  if (band_config && band_config->split >= 0)
+    return band_config->split;
+  return options->split_tile;
+}
+
+/// Finds the bands to be split-tiled and the slopes of their tiles: for band
+/// b, slopes[2b] and slopes[2b + 1] bound the dependence distances along the
+/// second dimension of the band to the right and to the left per unit of
+/// distance along the first one (the time dimension). They are -1 for bands
+/// tiled with rectangular tiles. Returns false if no band is split-tiled.
+static bool get_split_tile_slopes(PlutoProg *prog, Band **bands,
+                                  unsigned nbands, unsigned num_levels,
+                                  const PlutoTileConfig *config, int *slopes) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+  bool found = false;
+
+  for (unsigned b = 0; b < nbands; b++) {
+    Band *band = bands[b];
+    slopes[2 * b] = slopes[2 * b + 1] = -1;
+    if (!is_split_tiling_requested(band, config, options))
+      continue;
+
+    const char *reason = NULL;
+    if (options->parametric_tiles) {
+      reason = "with parametric tile sizes";
+    } else if (num_levels > 1) {
+      reason = "with more than one level of tiling";
+    } else if (band->width < 2) {
+      reason = "with less than two dimensions";
+    } else {
+      for (unsigned i = 0; i < band->loop->nstmts && !reason; i++) {
+        if (!pluto_is_hyperplane_loop(band->loop->stmts[i],
+                                      band->loop->depth) ||
+            !pluto_is_hyperplane_loop(band->loop->stmts[i],
+                                      band->loop->depth + 1))
+          reason = "whose outer two dimensions are not loops";
+      }
+    }
+    int right = -1, left = -1;
+    if (!reason) {
+      right = get_split_tile_slope(band, 1, prog);
+      left = get_split_tile_slope(band, -1, prog);
+      if (right < 0 || left < 0)
+        reason = "whose dependences do not all move forward in time";
+    }
+    if (reason) {
+      PLUTO_MESSAGE(printf("[pluto] WARNING: band at depth %d can't be "
+                           "split-tiled %s; using rectangular tiles\n",
+                           band->loop->depth, reason););
+      continue;
+    }
+    slopes[2 * b] = right;
+    slopes[2 * b + 1] = left;
+    found = true;
+  }
+  return found;
+}
+
+/// Adds to the domain of `stmt' the constraint
+///   sum_r coeffs[r] * phi_r + sum_k sn_coeffs[k] * zT_k + c >= 0,
+/// where phi_r is the r-th hyperplane of the band (now at row first_row + r
+/// of the transformation) and zT_k the k-th supernode of the statement.
+static void add_split_tile_constraint(Stmt *stmt, unsigned first_row,
+                                      const int *coeffs, unsigned ncoeffs,
+                                      const int *sn_coeffs, unsigned nsn,
+                                      int c, PlutoProg *prog) {
+  PlutoConstraints *dom = stmt->domain;
+  pluto_constraints_add_inequality(dom);
+  int64_t *row = dom->val[dom->nrows - 1];
+  for (unsigned j = 0; j < dom->ncols; j++) {
+    row[j] = 0;
+    for (unsigned r = 0; r < ncoeffs; r++) {
+      row[j] += coeffs[r] * stmt->trans->val[first_row + r][j];
+    }
+  }
+  for (unsigned k = 0; k < nsn; k++) {
+    row[k] += sn_coeffs[k];
+  }
+  row[dom->ncols - 1] += c;
+
+  PlutoConstraints *cst = pluto_constraints_select_row(dom, dom->nrows - 1);
+  pluto_update_deps(stmt, cst, prog);
+  pluto_constraints_free(cst);
+}
+
+/// Split-tiles `band' (see --split-tile). With t and x the first two
+/// dimensions of the band, h and w their tile sizes, and a and b the slopes
+/// of the dependences along x per unit of t to the right and to the left,
+/// three tile space dimensions T, P and S replace those of t and x:
+///
+///   h*T <= t <= h*T + h - 1,  u = t - h*T
+///   w*S + a*u <= x <= w*S + w - 1 + a*u
+///   w*P <= x - w*S + b*u <= w*P + w - 1
+///
+/// For a time tile T, the tiles of phase P = 0 shrink with u while those of
+/// phase P = 1 fill the gaps between them; the tiles of a phase only depend on
+/// those of earlier phases and time tiles, so that all tiles S of a phase can
+/// run concurrently. Requires (a + b) * (h - 1) <= w. The other dimensions of
+/// the band get rectangular tiles inside.
+static void pluto_split_tile_band(PlutoProg *prog, Band *band, int *tile_sizes,
+                                  int right, int left) {
+  unsigned firstD = band->loop->depth;
+  int h = tile_sizes[0], w = tile_sizes[1];
+
+  for (unsigned s = 0; s < band->loop->nstmts; s++) {
+    Stmt *stmt = band->loop->stmts[s];
+    char iter[6];
+
+    /* 1. Add the tile space dimensions: T, P, S, and one per loop of the
+     * other dimensions of the band */
+    unsigned nsn = 0;
+    for (unsigned i = 0; i < band->width + 1; i++) {
+      unsigned depth = firstD + i;
+      /* Dimensions beyond S tile the band hyperplane i - 1, at row depth +
+       * i - 1 until this dimension is added; scalar ones are tiled
+       * trivially */
+      if (i >= 3 && pluto_is_hyperplane_scalar(stmt, depth + i - 1)) {
+        pluto_stmt_add_hyperplane(stmt, H_SCALAR, depth);
+        for (unsigned j = 0; j < stmt->dim + prog->npar + 1; j++) {
+          stmt->trans->val[depth][j] = stmt->trans->val[depth + i][j];
+        }
+        continue;
+      }
+      sprintf(iter, "zT%d", stmt->dim);
+      pluto_stmt_add_dim(stmt, nsn++, depth, iter, H_TILE_SPACE_LOOP, prog);
+    }
+
+    /* 2. Specify the tiles in the original domain. The band hyperplanes now
+     * start at row firstD + width + 1. */
+    unsigned first_row = firstD + band->width + 1;
+    int coeffs[band->width];
+    int sn[nsn];
+    int a = right, b = left;
+
+    /* h*T <= t <= h*T + h - 1 */
+    memset(sn, 0, sizeof(sn));
+    coeffs[0] = 1;
+    sn[0] = -h;
+    add_split_tile_constraint(stmt, first_row, coeffs, 1, sn, nsn, 0, prog);
+    coeffs[0] = -1;
+    sn[0] = h;
+    add_split_tile_constraint(stmt, first_row, coeffs, 1, sn, nsn, h - 1,
+                              prog);
+
+    /* w*S + a*(t - h*T) <= x <= w*S + w - 1 + a*(t - h*T) */
+    coeffs[0] = -a;
+    coeffs[1] = 1;
+    sn[0] = a * h;
+    sn[2] = -w;
+    add_split_tile_constraint(stmt, first_row, coeffs, 2, sn, nsn, 0, prog);
+    coeffs[0] = a;
+    coeffs[1] = -1;
+    sn[0] = -a * h;
+    sn[2] = w;
+    add_split_tile_constraint(stmt, first_row, coeffs, 2, sn, nsn, w - 1,
+                              prog);
+
+    /* w*P <= x - w*S + b*(t - h*T) <= w*P + w - 1 */
+    coeffs[0] = b;
+    coeffs[1] = 1;
+    sn[0] = -b * h;
+    sn[1] = -w;
+    sn[2] = -w;
+    add_split_tile_constraint(stmt, first_row, coeffs, 2, sn, nsn, 0, prog);
+    coeffs[0] = -b;
+    coeffs[1] = -1;
+    sn[0] = b * h;
+    sn[1] = w;
+    sn[2] = w;
+    add_split_tile_constraint(stmt, first_row, coeffs, 2, sn, nsn, w - 1,
+                              prog);
+
+    /* Rectangular tiles for the other dimensions of the band */
+    unsigned k = 3;
+    for (unsigned r = 2; r < band->width; r++) {
+      if (pluto_is_hyperplane_scalar(stmt, first_row + r))
+        continue;
+      memset(sn, 0, sizeof(sn));
+      memset(coeffs, 0, sizeof(coeffs));
+      coeffs[r] = 1;
+      sn[k] = -tile_sizes[r];
+      add_split_tile_constraint(stmt, first_row, coeffs, band->width, sn, nsn,
+                                0, prog);
+      coeffs[r] = -1;
+      sn[k] = tile_sizes[r];
+      add_split_tile_constraint(stmt, first_row, coeffs, band->width, sn, nsn,
+                                tile_sizes[r] - 1, prog);
+      k++;
+    }
+    assert(k == nsn);
+
+    stmt->num_tiled_loops += band->width + 1;
+    stmt->first_tile_dim = firstD;
+    stmt->last_tile_dim = firstD + band->width;
+  }
+}
+
+/// Returns the number of levels of tiling: options->tile_levels, and at least
+/// two with --second-level-tile.
+static unsigned get_num_tiling_levels(const PlutoOptions *options) {
+  int num_levels = PLMAX(options->tile_levels, 1);
+  if (options->second_level_tile)
+    num_levels = PLMAX(num_levels, 2);
+  return PLMIN(num_levels, MAX_TILING_LEVELS);
+}
+
+/// Returns the level (1 for the first level of tiles) whose tile space loops
+/// are parallelized for `band', tiled for `num_levels' levels: the one given
+/// for the band in the tile configuration, else the one given with
+/// --parallel-tile-level, else the outermost one.
+static unsigned get_parallel_tile_level(const Band *band, unsigned num_levels,
+                                        const PlutoTileConfig *config,
+                                        const PlutoOptions *options) {
+  const PlutoTileBandConfig *band_config =
+      pluto_tile_config_lookup(config, band);
+  unsigned level = num_levels;
+  if (band_config && band_config->parallel_level > 0)
+    level = band_config->parallel_level;
+  else if (options->parallel_tile_level > 0)
+    level = options->parallel_tile_level;
+  return PLMIN(level, num_levels);
+}
+
+/// Creates a wavefront of tiles (where there is no parallel loop) among the
+/// tile space loops of the level chosen for each band by
+/// get_parallel_tile_level. Loops of the outer levels are left sequential.
+/// Split-tiled bands (those with non-negative `split_slopes') need no
+/// wavefront: their tiles of a phase are all concurrent. With --omp-tasks,
+/// the tiles of bands that allow it are run as OpenMP tasks instead (see
+/// pluto_create_task_band), scheduled dynamically with --dynschedule, or run
+/// as doacross loops with --doacross. Returns true if something was done.
+static bool create_tile_schedule_at_levels(PlutoProg *prog, Band **bands,
+                                           unsigned nbands,
+                                           unsigned num_levels,
+                                           const PlutoTileConfig *config,
+                                           const int *split_slopes) {
+  PlutoOptions *options = prog->context->options;
+  Band **level_bands = (Band **)malloc(nbands * sizeof(Band *));
+  unsigned nlevel_bands = 0;
+  for (unsigned b = 0; b < nbands; b++) {
+    if (split_slopes && split_slopes[2 * b] >= 0)
+      continue;
+    unsigned level =
+        get_parallel_tile_level(bands[b], num_levels, config, options);
+    Ploop *loop = pluto_loop_dup(bands[b]->loop);
+    loop->depth += (num_levels - level) * bands[b]->width;
+    Band *level_band = pluto_band_alloc(loop, bands[b]->width);
+    pluto_loop_free(loop);
+    if ((options->omp_tasks || options->dynschedule || options->doacross) &&
+        pluto_create_task_band(prog, level_band)) {
+      if (!options->silent) {
+        printf("[pluto] Tiles of t%u to t%u %s\n", level_band->loop->depth + 1,
+               level_band->loop->depth + level_band->width,
+               options->dynschedule ? "scheduled dynamically"
+               : options->doacross  ? "run as doacross loops"
+                                    : "run as OpenMP tasks");
+      }
+      pluto_band_free(level_band);
+      continue;
+    }
+    level_bands[nlevel_bands++] = level_band;
+  }
+  bool retval = pluto_create_tile_schedule(prog, level_bands, nlevel_bands);
+  pluto_bands_free(level_bands, nlevel_bands);
+  return retval;
+}
+
 /*
  * Updates statement domains and transformations to represent the new
  * tiled code. A schedule of tiles is created for parallel execution if
  * --parallel is on. Intra-tile optimization is done as part of this as well.
+ * Returns 1 (without tiling anything) if the tile configuration given with
+ * --tile-config can't be read, else 0.
  */
-void pluto_tile(PlutoProg *prog) {
+int pluto_tile(PlutoProg *prog) {
   unsigned nbands, i, j, n_ibands, num_tiled_levels, nloops;
   Band **bands, **ibands;
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+
+  /* Tile sizes given per band; sizes the user asked for are never silently
+   * replaced with default ones */
+  PlutoTileConfig *config = NULL;
+  if (options->tile_config) {
+    config = pluto_tile_config_read(options->tile_config, context);
+    if (!config)
+      return 1;
+  }
+
   bands = pluto_get_outermost_permutable_bands(prog, &nbands);
   /* Tiling has not been done yet. Hence num_tiled_levels argument to
    * pluto_get_innermost_permutable_bands is 0. */
   ibands = pluto_get_innermost_permutable_bands(prog, 0, &n_ibands);
-  PlutoContext *context = prog->context;
-  PlutoOptions *options = context->options;
 
   IF_DEBUG(printf("[pluto_tile] Outermost tilable bands\n"););
   IF_DEBUG(pluto_bands_print(bands, nbands););
@@ -247,6 +706,40 @@ void pluto_tile(PlutoProg *prog) {
   }
   pluto_loops_free(loops, nloops);
 
+  unsigned num_levels = get_num_tiling_levels(options);
+
+  /* Tile size ratios of the levels beyond the first found by the tile size
+   * selection model while tiling for the first level: tile_size_ratios[b][l]
+   * for level l + 2 of band b */
+  int ***tile_size_ratios = NULL;
+  if (num_levels > 1 && options->find_tile_sizes) {
+    tile_size_ratios = (int ***)malloc(nbands * sizeof(int **));
+    for (i = 0; i < nbands; i++) {
+      tile_size_ratios[i] = (int **)malloc((num_levels - 1) * sizeof(int *));
+      for (unsigned l = 0; l < num_levels - 1; l++) {
+        tile_size_ratios[i][l] = (int *)malloc(bands[i]->width * sizeof(int));
+        for (j = 0; j < bands[i]->width; j++) {
+          tile_size_ratios[i][l][j] = DEFAULT_SECOND_LEVEL_TILE_SIZE_RATIO;
+        }
+      }
+    }
+  }
+
+  /* The tile sizes found by the tile size selection model to be written
+   * out */
+  PlutoTileConfig *found = NULL;
+  if (options->find_tile_sizes && options->tile_config_out) {
+    found = pluto_tile_config_alloc();
+  }
+
+  /* Slopes of the tiles of the bands to be split-tiled */
+  int *split_slopes = (int *)malloc(2 * nbands * sizeof(int));
+  if (!get_split_tile_slopes(prog, bands, nbands, num_levels, config,
+                             split_slopes)) {
+    free(split_slopes);
+    split_slopes = NULL;
+  }
+
   /* Now, we are ready to tile */
   if (options->lt >= 0 && options->ft >= 0) {
     /* User option specified tiling */
@@ -254,24 +747,49 @@ void pluto_tile(PlutoProg *prog) {
     assert(options->ft <= prog->num_hyperplanes - 1);
     assert(options->lt <= prog->num_hyperplanes - 1);
     assert(options->ft <= options->lt);
+  }
 
-    // Tiling for the first level.
-    pluto_tile_scattering_dims(prog, bands, nbands, false);
+  /* Tile for the first level, then tile the tile space loops of each level
+   * for the next one. */
+  for (unsigned level = 1; level <= num_levels; level++) {
+    pluto_tile_scattering_dims(prog, bands, nbands, level, num_levels,
+                               tile_size_ratios, config, found, split_slopes);
     num_tiled_levels++;
+  }
 
-    if (options->second_level_tile) {
-      pluto_tile_scattering_dims(prog, bands, nbands, true);
-      num_tiled_levels++;
+  /* A split-tiled band has one more tile space dimension than it has
+   * dimensions; it is described from P on for what follows, so that its
+   * intra-tile dimensions are found `width' dimensions below. */
+  for (i = 0; split_slopes && i < nbands; i++) {
+    if (split_slopes[2 * i] >= 0)
+      bands[i]->loop->depth++;
+  }
+
+  if (tile_size_ratios) {
+    for (i = 0; i < nbands; i++) {
+      for (unsigned l = 0; l < num_levels - 1; l++) {
+        free(tile_size_ratios[i][l]);
+      }
+      free(tile_size_ratios[i]);
     }
-  } else {
-    // Tiling for the first level.
-    pluto_tile_scattering_dims(prog, bands, nbands, false);
-    num_tiled_levels++;
-    if (options->second_level_tile) {
-      // Tile for another level.
-      pluto_tile_scattering_dims(prog, bands, nbands, true);
-      num_tiled_levels++;
+    free(tile_size_ratios);
+  }
+
+  if (found) {
+    FILE *fp = fopen(options->tile_config_out, "w");
+    if (fp) {
+      fprintf(fp, "# Tile sizes found by the tile size selection model; "
+                  "replay with --tile-config\n");
+      pluto_tile_config_print(fp, found);
+      fclose(fp);
+      if (!options->silent) {
+        printf("[pluto] Tile sizes written to %s\n", options->tile_config_out);
+      }
+    } else {
+      printf("[pluto] WARNING: can't write tile sizes to %s\n",
+             options->tile_config_out);
     }
+    pluto_tile_config_free(found);
   }
 
   /* Detect properties after tiling */
@@ -314,45 +832,118 @@ void pluto_tile(PlutoProg *prog) {
     }
   }
 
-  if (options->parallel) {
-    int retval = pluto_create_tile_schedule(prog, bands, nbands);
+  if (options->parallel && options->parametric_tiles) {
+    /* A wavefront of tiles combines tile space dimensions, which can't be
+     * expressed with tile sizes that are only known at run time. Only the
+     * outer parallel tile loops get parallelized. */
+    for (i = 0; i < nbands; i++) {
+      if (!pluto_loop_is_parallel(prog, bands[i]->loop)) {
+        PLUTO_MESSAGE(printf("[pluto] WARNING: pipelined parallelism not "
+                             "exploited with parametric tile sizes\n"););
+        break;
+      }
+    }
+  } else if (options->parallel) {
+    int retval = create_tile_schedule_at_levels(prog, bands, nbands, num_levels,
+                                                config, split_slopes);
     if (retval && !options->silent) {
       printf("[Pluto] After tile scheduling:\n");
       pluto_transformations_pretty_print(prog);
     }
   }
+  free(split_slopes);
+  pluto_tile_config_free(config);
   pluto_bands_free(bands, nbands);
   pluto_bands_free(ibands, n_ibands);
+  return 0;
 }
 
-/// Tiles scattering functions for all bands; if tile_second_level is true,
-/// perform another level of tiling.
+/// Tiles scattering functions for all bands for `level' (1 for the first
+/// level; each further level tiles the tile space loops of the previous one)
+/// of `num_levels' levels of tiling. For levels beyond the first, the tile
+/// sizes are ratios to those of the previous level. With automatic tile size
+/// selection, the ratios of all levels are determined along with the first
+/// level tile sizes; they are stored into tile_size_ratios[b][l - 2] for level
+/// l of band b (if tile_size_ratios is not NULL) and read back from there.
+/// Bands b for which split_slopes[2b] is not negative (if split_slopes is not
+/// NULL) are split-tiled with the slopes split_slopes[2b] and
+/// split_slopes[2b + 1] (see get_split_tile_slopes).
 void pluto_tile_scattering_dims(PlutoProg *prog, Band **bands, int nbands,
-                                bool tile_second_level) {
+                                unsigned level, unsigned num_levels,
+                                int ***tile_size_ratios,
+                                const PlutoTileConfig *config,
+                                PlutoTileConfig *found,
+                                const int *split_slopes) {
   int tile_sizes[prog->num_hyperplanes];
-  int second_level_tile_size_ratios[prog->num_hyperplanes];
 
   Stmt **stmts = prog->stmts;
 
-  for (unsigned j = 0; j < prog->num_hyperplanes; j++) {
-    tile_sizes[j] = DEFAULT_FIRST_LEVEL_TILE_SIZE;
-    second_level_tile_size_ratios[j] = DEFAULT_SECOND_LEVEL_TILE_SIZE_RATIO;
-  }
-
   PlutoContext *context = prog->context;
   PlutoOptions *options = context->options;
 
   for (unsigned b = 0; b < nbands; b++) {
-    if (options->find_tile_sizes)
-      find_tile_sizes(bands[b], prog, tile_sizes);
-    else
-      read_tile_sizes(tile_sizes, second_level_tile_size_ratios,
-                      bands[b]->width, bands[b]->loop->stmts,
-                      bands[b]->loop->nstmts, bands[b]->loop->depth,
-                      prog->context);
-
-    if (tile_second_level) {
-      pluto_tile_band(prog, bands[b], second_level_tile_size_ratios);
+    for (unsigned j = 0; j < prog->num_hyperplanes; j++) {
+      tile_sizes[j] = (level == 1) ? DEFAULT_FIRST_LEVEL_TILE_SIZE
+                                   : DEFAULT_SECOND_LEVEL_TILE_SIZE_RATIO;
+    }
+
+    const PlutoTileBandConfig *band_config =
+        pluto_tile_config_lookup(config, bands[b]);
+    if (band_config && level == 1) {
+      for (unsigned j = 0; j < bands[b]->loop->nstmts; j++) {
+        bands[b]->loop->stmts[j]->ufactor = band_config->ufactor;
+        bands[b]->loop->stmts[j]->vector_length = band_config->vector_length;
+      }
+    }
+
+    if (get_config_tile_sizes(tile_sizes, bands[b], band_config, level,
+                              context)) {
+      /* Sizes given for this band and level */
+    } else if (options->find_tile_sizes) {
+      if (level > 1) {
+        assert(tile_size_ratios != NULL);
+        for (unsigned j = 0; j < bands[b]->width; j++) {
+          tile_sizes[j] = tile_size_ratios[b][level - 2][j];
+        }
+      } else {
+        find_tile_sizes(bands[b], prog, tile_sizes,
+                        tile_size_ratios ? tile_size_ratios[b] : NULL,
+                        num_levels);
+      }
+    } else if (!options->tile_config) {
+      read_tile_sizes(tile_sizes, level, bands[b]->width,
+                      bands[b]->loop->stmts, bands[b]->loop->nstmts,
+                      bands[b]->loop->depth, prog->context);
+    }
+    if (band_config && level == 1) {
+      round_tile_sizes_to_vector_length(tile_sizes, bands[b],
+                                        band_config->vector_length);
+    }
+
+    bool split = split_slopes && split_slopes[2 * b] >= 0;
+    if (split) {
+      /* Tiles of a phase must not shrink to nothing before the end of a time
+       * tile */
+      int slope = split_slopes[2 * b] + split_slopes[2 * b + 1];
+      if (slope > 0 && slope * (tile_sizes[0] - 1) > tile_sizes[1]) {
+        tile_sizes[0] = tile_sizes[1] / slope + 1;
+        PLUTO_MESSAGE(printf("[pluto] Time tile size of split-tiled band at "
+                             "depth %d reduced to %d\n",
+                             bands[b]->loop->depth, tile_sizes[0]););
+      }
+    }
+
+    if (found) {
+      record_tile_sizes(found, bands[b], level, tile_sizes, options);
+    }
+
+    if (split) {
+      PLUTO_MESSAGE(printf("[pluto] Split tiling band at depth %d (slopes %d, "
+                           "%d)\n",
+                           bands[b]->loop->depth, split_slopes[2 * b],
+                           split_slopes[2 * b + 1]););
+      pluto_split_tile_band(prog, bands[b], tile_sizes, split_slopes[2 * b],
+                            split_slopes[2 * b + 1]);
     } else {
       pluto_tile_band(prog, bands[b], tile_sizes);
     }
@@ -482,6 +1073,128 @@ bool pluto_create_tile_schedule(PlutoProg *prog, Band **bands, int nbands) {
   return retval;
 }
 
+/// Returns the maximum distance of `dep' along the hyperplane at `level'
+/// between instances at the same iterations of the loops outside `depth',
+/// or -1 if it may be negative or exceed MAX_TASK_DEP_DISTANCE.
+static int get_max_dep_distance(const Dep *dep, unsigned depth, unsigned level,
+                                const PlutoProg *prog) {
+  PlutoConstraints *cst = pluto_constraints_dup(dep->dpolytope);
+  for (unsigned l = 0; l < depth; l++) {
+    pluto_dep_add_distance_row(cst, dep, l, true, prog);
+  }
+  /* distance <= -1 */
+  pluto_dep_add_distance_row(cst, dep, level, false, prog);
+  int64_t *row = cst->val[cst->nrows - 1];
+  for (unsigned j = 0; j < cst->ncols; j++)
+    row[j] = -row[j];
+  row[cst->ncols - 1] -= 1;
+  if (!pluto_constraints_is_empty(cst)) {
+    pluto_constraints_free(cst);
+    return -1;
+  }
+
+  /* distance >= d + 1 */
+  int64_t c = row[cst->ncols - 1];
+  for (unsigned j = 0; j < cst->ncols; j++)
+    row[j] = -row[j];
+  int d;
+  for (d = 0; d <= MAX_TASK_DEP_DISTANCE; d++) {
+    row[cst->ncols - 1] = -c - 2 - d;
+    if (pluto_constraints_is_empty(cst))
+      break;
+  }
+  pluto_constraints_free(cst);
+  return d <= MAX_TASK_DEP_DISTANCE ? d : -1;
+}
+
+/// Makes `band', a band of tile space loops with pipelined parallelism, run
+/// with one OpenMP task per tile instead of a wavefront of tiles (--omp-tasks),
+/// with its tiles scheduled by the runtime of --dynschedule, or as doacross
+/// loops (--doacross): the tiles are identified in dependences by their
+/// first (up to three) band dimensions, and each tile depends on the tiles
+/// at the distances the dependences between tiles have along them. Returns
+/// false if the band isn't suitable: it is parallel, has dimensions that are
+/// scalar for some of its statements, carries relaxed reductions, or has
+/// dependences whose distances in tiles are unbounded or larger than
+/// MAX_TASK_DEP_DISTANCE.
+bool pluto_create_task_band(PlutoProg *prog, const Band *band) {
+  const Ploop *loop = band->loop;
+  if (band->width < 2 || pluto_loop_is_parallel(prog, (Ploop *)loop))
+    return false;
+
+  for (unsigned depth = loop->depth; depth < loop->depth + band->width;
+       depth++) {
+    for (unsigned i = 0; i < loop->nstmts; i++) {
+      if (pluto_is_hyperplane_scalar(loop->stmts[i], depth))
+        return false;
+    }
+  }
+
+  /* Tasks of a wavefront would update reduced locations concurrently */
+  for (int i = 0; i < prog->nreduction_deps; i++) {
+    const Dep *dep = prog->reduction_deps[i];
+    if (pluto_stmt_is_member_of(prog->stmts[dep->src]->id, loop->stmts,
+                                loop->nstmts))
+      return false;
+  }
+
+  unsigned ndep_dims = PLMIN(band->width, 3);
+  unsigned *max_dists = (unsigned *)calloc(ndep_dims, sizeof(unsigned));
+  for (int i = 0; i < prog->ndeps; i++) {
+    Dep *dep = prog->deps[i];
+    if (IS_RAR(dep->type) ||
+        !pluto_stmt_is_member_of(prog->stmts[dep->src]->id, loop->stmts,
+                                 loop->nstmts) ||
+        !pluto_stmt_is_member_of(prog->stmts[dep->dest]->id, loop->stmts,
+                                 loop->nstmts))
+      continue;
+    for (unsigned k = 0; k < ndep_dims; k++) {
+      int dist = get_max_dep_distance(dep, loop->depth, loop->depth + k, prog);
+      if (dist < 0) {
+        free(max_dists);
+        return false;
+      }
+      max_dists[k] = PLMAX(max_dists[k], (unsigned)dist);
+    }
+  }
+
+  PlutoTaskBand *tband = (PlutoTaskBand *)malloc(sizeof(PlutoTaskBand));
+  tband->band = pluto_band_alloc(band->loop, band->width);
+  tband->ndep_dims = ndep_dims;
+  tband->max_dists = max_dists;
+  prog->task_bands = (PlutoTaskBand **)realloc(
+      prog->task_bands, (prog->ntask_bands + 1) * sizeof(PlutoTaskBand *));
+  prog->task_bands[prog->ntask_bands++] = tband;
+
+  return true;
+}
+
+/// Returns the task band `loop' is in (the loop of the band or one inside it
+/// that only runs statements of the band), or NULL if there is none.
+const PlutoTaskBand *pluto_loop_get_task_band(const Ploop *loop,
+                                              const PlutoProg *prog) {
+  for (unsigned i = 0; i < prog->ntask_bands; i++) {
+    const Ploop *bloop = prog->task_bands[i]->band->loop;
+    if (loop->depth < bloop->depth)
+      continue;
+    unsigned j;
+    for (j = 0; j < loop->nstmts; j++) {
+      if (!pluto_stmt_is_member_of(loop->stmts[j]->id, bloop->stmts,
+                                   bloop->nstmts))
+        break;
+    }
+    if (j == loop->nstmts)
+      return prog->task_bands[i];
+  }
+  return NULL;
+}
+
+void pluto_task_band_free(PlutoTaskBand *tband) {
+  pluto_band_free(tband->band);
+  free(tband->max_dists);
+  free(tband);
+}
+
 // Find the innermost permutable nest (at least two tilable hyperplanes).
 // FIXME(bondhugula): this method does not appear to work any more (due to
 // hProps being obsolete?); on examples/example/matmul.c, a single loop is being
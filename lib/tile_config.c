@@ -0,0 +1,336 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE in the
+ * top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ * Reading and writing of tile configuration files (--tile-config), which give
+ * tile sizes, unroll-jam factors and vector lengths per permutable band.
+ *
+ */
+#include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pluto.h"
+#include "pluto/pluto.h"
+#include "tile_config.h"
+
+PlutoTileConfig *pluto_tile_config_alloc() {
+  PlutoTileConfig *config = (PlutoTileConfig *)malloc(sizeof(PlutoTileConfig));
+  config->bands = NULL;
+  config->nbands = 0;
+  return config;
+}
+
+void pluto_tile_config_free(PlutoTileConfig *config) {
+  if (config == NULL)
+    return;
+  for (unsigned b = 0; b < config->nbands; b++) {
+    PlutoTileBandConfig *band_config = &config->bands[b];
+    for (unsigned l = 0; l < band_config->nlevels; l++) {
+      free(band_config->sizes[l]);
+    }
+    free(band_config->sizes);
+    free(band_config->nsizes);
+    free(band_config->stmts);
+  }
+  free(config->bands);
+  free(config);
+}
+
+PlutoTileBandConfig *pluto_tile_config_add_band(PlutoTileConfig *config) {
+  config->bands = (PlutoTileBandConfig *)realloc(
+      config->bands, (config->nbands + 1) * sizeof(PlutoTileBandConfig));
+  PlutoTileBandConfig *band_config = &config->bands[config->nbands++];
+  band_config->stmts = NULL;
+  band_config->nstmts = 0;
+  band_config->depth = -1;
+  band_config->sizes = NULL;
+  band_config->nsizes = NULL;
+  band_config->nlevels = 0;
+  band_config->ufactor = 0;
+  band_config->vector_length = 0;
+  band_config->parallel_level = 0;
+  band_config->split = -1;
+  return band_config;
+}
+
+void pluto_tile_band_config_set_sizes(PlutoTileBandConfig *band_config,
+                                      unsigned level, const int *sizes,
+                                      unsigned nsizes) {
+  assert(level >= 1);
+  if (level > band_config->nlevels) {
+    band_config->sizes =
+        (int **)realloc(band_config->sizes, level * sizeof(int *));
+    band_config->nsizes =
+        (unsigned *)realloc(band_config->nsizes, level * sizeof(unsigned));
+    for (unsigned l = band_config->nlevels; l < level; l++) {
+      band_config->sizes[l] = NULL;
+      band_config->nsizes[l] = 0;
+    }
+    band_config->nlevels = level;
+  }
+  free(band_config->sizes[level - 1]);
+  band_config->sizes[level - 1] = (int *)malloc(nsizes * sizeof(int));
+  memcpy(band_config->sizes[level - 1], sizes, nsizes * sizeof(int));
+  band_config->nsizes[level - 1] = nsizes;
+}
+
+static int compare_ints(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+/// Ids of the statements of `band', sorted, in `ids' (of size at least
+/// band->loop->nstmts).
+static void get_band_stmt_ids(const Band *band, int *ids) {
+  for (unsigned i = 0; i < band->loop->nstmts; i++) {
+    ids[i] = band->loop->stmts[i]->id;
+  }
+  qsort(ids, band->loop->nstmts, sizeof(int), compare_ints);
+}
+
+static bool band_config_has_stmts(const PlutoTileBandConfig *band_config,
+                                  const int *ids, unsigned nids) {
+  return band_config->nstmts == nids &&
+         !memcmp(band_config->stmts, ids, nids * sizeof(int));
+}
+
+const PlutoTileBandConfig *
+pluto_tile_config_lookup(const PlutoTileConfig *config, const Band *band) {
+  if (config == NULL)
+    return NULL;
+
+  int ids[band->loop->nstmts];
+  get_band_stmt_ids(band, ids);
+
+  const PlutoTileBandConfig *best = NULL;
+  int best_score = -1;
+  for (unsigned b = 0; b < config->nbands; b++) {
+    const PlutoTileBandConfig *band_config = &config->bands[b];
+    if (band_config->stmts &&
+        !band_config_has_stmts(band_config, ids, band->loop->nstmts))
+      continue;
+    if (band_config->depth >= 0 && band_config->depth != band->loop->depth)
+      continue;
+    int score = 2 * (band_config->stmts != NULL) + (band_config->depth >= 0);
+    if (score > best_score) {
+      best = band_config;
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+PlutoTileBandConfig *pluto_tile_config_get_band(PlutoTileConfig *config,
+                                                const Band *band) {
+  int ids[band->loop->nstmts];
+  get_band_stmt_ids(band, ids);
+
+  for (unsigned b = 0; b < config->nbands; b++) {
+    PlutoTileBandConfig *band_config = &config->bands[b];
+    if (band_config->stmts &&
+        band_config_has_stmts(band_config, ids, band->loop->nstmts) &&
+        band_config->depth == band->loop->depth)
+      return band_config;
+  }
+
+  PlutoTileBandConfig *band_config = pluto_tile_config_add_band(config);
+  band_config->nstmts = band->loop->nstmts;
+  band_config->stmts = (int *)malloc(band->loop->nstmts * sizeof(int));
+  memcpy(band_config->stmts, ids, band->loop->nstmts * sizeof(int));
+  band_config->depth = band->loop->depth;
+  return band_config;
+}
+
+static char *trim(char *str) {
+  while (isspace((unsigned char)*str))
+    str++;
+  char *end = str + strlen(str);
+  while (end > str && isspace((unsigned char)end[-1]))
+    end--;
+  *end = '\0';
+  return str;
+}
+
+/// Parses a comma-separated list of positive integers. Returns false on a
+/// syntax error.
+static bool parse_sizes(char *value, int **sizes, unsigned *nsizes) {
+  *sizes = NULL;
+  *nsizes = 0;
+  for (char *tok = strtok(value, ","); tok; tok = strtok(NULL, ",")) {
+    char *end;
+    tok = trim(tok);
+    long size = strtol(tok, &end, 10);
+    if (end == tok || *end != '\0' || size < 1) {
+      free(*sizes);
+      return false;
+    }
+    *sizes = (int *)realloc(*sizes, (*nsizes + 1) * sizeof(int));
+    (*sizes)[(*nsizes)++] = size;
+  }
+  return *nsizes > 0;
+}
+
+/// Parses a comma-separated list of statements S1, S2, ... (or '*' for any)
+/// into sorted statement ids. Returns false on a syntax error.
+static bool parse_stmts(char *value, PlutoTileBandConfig *band_config) {
+  free(band_config->stmts);
+  band_config->stmts = NULL;
+  band_config->nstmts = 0;
+  if (!strcmp(value, "*"))
+    return true;
+  for (char *tok = strtok(value, ","); tok; tok = strtok(NULL, ",")) {
+    char *end;
+    tok = trim(tok);
+    if (tok[0] != 'S')
+      return false;
+    long id = strtol(tok + 1, &end, 10);
+    if (end == tok + 1 || *end != '\0' || id < 1)
+      return false;
+    band_config->stmts = (int *)realloc(
+        band_config->stmts, (band_config->nstmts + 1) * sizeof(int));
+    band_config->stmts[band_config->nstmts++] = id - 1;
+  }
+  qsort(band_config->stmts, band_config->nstmts, sizeof(int), compare_ints);
+  return band_config->nstmts > 0;
+}
+
+static bool parse_unsigned(const char *value, unsigned *res) {
+  char *end;
+  long val = strtol(value, &end, 10);
+  if (end == value || *end != '\0' || val < 0)
+    return false;
+  *res = val;
+  return true;
+}
+
+PlutoTileConfig *pluto_tile_config_read(const char *path,
+                                        PlutoContext *context) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    fprintf(stderr, "[pluto] ERROR: can't open tile configuration %s\n",
+            path);
+    return NULL;
+  }
+
+  PlutoTileConfig *config = pluto_tile_config_alloc();
+  PlutoTileBandConfig *band_config = NULL;
+  char line[1024];
+  unsigned lineno = 0;
+  bool error = false;
+  while (!error && fgets(line, sizeof(line), fp)) {
+    lineno++;
+    char *comment = strchr(line, '#');
+    if (comment)
+      *comment = '\0';
+    char *str = trim(line);
+    if (*str == '\0')
+      continue;
+    if (!strcmp(str, "[band]")) {
+      band_config = pluto_tile_config_add_band(config);
+      continue;
+    }
+    char *eq = strchr(str, '=');
+    if (!band_config || !eq) {
+      error = true;
+      break;
+    }
+    *eq = '\0';
+    char *key = trim(str);
+    char *value = trim(eq + 1);
+    unsigned level;
+    int nchars;
+    if (!strcmp(key, "statements")) {
+      error = !parse_stmts(value, band_config);
+    } else if (!strcmp(key, "depth")) {
+      unsigned depth;
+      error = !parse_unsigned(value, &depth);
+      band_config->depth = depth;
+    } else if (sscanf(key, "level%u%n", &level, &nchars) == 1 &&
+               key[nchars] == '\0' && level >= 1) {
+      int *sizes;
+      unsigned nsizes;
+      error = !parse_sizes(value, &sizes, &nsizes);
+      if (!error) {
+        pluto_tile_band_config_set_sizes(band_config, level, sizes, nsizes);
+        free(sizes);
+      }
+    } else if (!strcmp(key, "unroll-jam")) {
+      error = !parse_unsigned(value, &band_config->ufactor);
+    } else if (!strcmp(key, "vector-length")) {
+      error = !parse_unsigned(value, &band_config->vector_length);
+    } else if (!strcmp(key, "parallel-level")) {
+      error = !parse_unsigned(value, &band_config->parallel_level);
+    } else if (!strcmp(key, "shape")) {
+      if (!strcmp(value, "split"))
+        band_config->split = 1;
+      else if (!strcmp(value, "rectangular"))
+        band_config->split = 0;
+      else
+        error = true;
+    } else {
+      error = true;
+    }
+  }
+  fclose(fp);
+
+  if (error) {
+    fprintf(stderr, "[pluto] ERROR: %s:%u: invalid tile configuration\n",
+            path, lineno);
+    pluto_tile_config_free(config);
+    return NULL;
+  }
+
+  IF_DEBUG(printf("[pluto] Read tile configuration for %u band(s) from %s\n",
+                  config->nbands, path););
+  IF_DEBUG(pluto_tile_config_print(stdout, config););
+
+  return config;
+}
+
+static void print_ints(FILE *fp, const char *prefix, const int *vals,
+                       unsigned n) {
+  for (unsigned i = 0; i < n; i++) {
+    fprintf(fp, "%s%s%d", i == 0 ? "" : ", ", prefix, vals[i]);
+  }
+}
+
+void pluto_tile_config_print(FILE *fp, const PlutoTileConfig *config) {
+  for (unsigned b = 0; b < config->nbands; b++) {
+    const PlutoTileBandConfig *band_config = &config->bands[b];
+    fprintf(fp, "%s[band]\n", b == 0 ? "" : "\n");
+    if (band_config->stmts) {
+      int ids[band_config->nstmts];
+      for (unsigned i = 0; i < band_config->nstmts; i++) {
+        ids[i] = band_config->stmts[i] + 1;
+      }
+      fprintf(fp, "statements = ");
+      print_ints(fp, "S", ids, band_config->nstmts);
+      fprintf(fp, "\n");
+    }
+    if (band_config->depth >= 0)
+      fprintf(fp, "depth = %d\n", band_config->depth);
+    for (unsigned l = 0; l < band_config->nlevels; l++) {
+      if (band_config->nsizes[l] == 0)
+        continue;
+      fprintf(fp, "level%u = ", l + 1);
+      print_ints(fp, "", band_config->sizes[l], band_config->nsizes[l]);
+      fprintf(fp, "\n");
+    }
+    if (band_config->ufactor > 0)
+      fprintf(fp, "unroll-jam = %u\n", band_config->ufactor);
+    if (band_config->vector_length > 0)
+      fprintf(fp, "vector-length = %u\n", band_config->vector_length);
+    if (band_config->parallel_level > 0)
+      fprintf(fp, "parallel-level = %u\n", band_config->parallel_level);
+    if (band_config->split >= 0)
+      fprintf(fp, "shape = %s\n",
+              band_config->split ? "split" : "rectangular");
+  }
+}
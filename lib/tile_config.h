@@ -0,0 +1,116 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE
+ * in the top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ */
+#ifndef _TILE_CONFIG_H
+#define _TILE_CONFIG_H
+
+#include <stdio.h>
+
+typedef struct band Band;
+typedef struct plutoContext PlutoContext;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Tile configuration of one permutable band. A tile configuration file
+ * (--tile-config) is made of sections of this form:
+ *
+ *   [band]
+ *   statements = S1, S2
+ *   depth = 0
+ *   level1 = 64, 64, 32
+ *   level2 = 4, 4, 8
+ *   unroll-jam = 8
+ *   vector-length = 4
+ *   parallel-level = 2
+ *   shape = split
+ *
+ * A band matches a section if its statements are exactly the ones listed
+ * (all statements if the key is absent or '*') and its outermost loop is at
+ * the given depth (any depth if absent). level1 lists the tile sizes of the
+ * loops of the band (scalar dimensions are skipped); level<n> lists the size
+ * of level n tiles as multiples of level n-1 tiles, for as many levels as
+ * there are levels of tiling (--tile-levels). shape is split (see
+ * --split-tile) or rectangular. Blank lines and text after '#' are
+ * ignored. */
+struct plutoTileBandConfig {
+  /* Ids of the statements of the band, sorted; NULL to match any band */
+  int *stmts;
+  unsigned nstmts;
+
+  /* Depth of the outermost loop of the band; -1 to match any depth */
+  int depth;
+
+  /* sizes[l] has the nsizes[l] tile sizes of level l + 1; levels that are
+   * not given have nsizes[l] = 0 */
+  int **sizes;
+  unsigned *nsizes;
+  unsigned nlevels;
+
+  /* Unroll-jam factor of the loops of the band; 0 if not given */
+  unsigned ufactor;
+
+  /* Vector length; the first level tile size of the innermost loop of the
+   * band, whether given, found by the tile size selection model or the
+   * default, is rounded up to a multiple of it. 0 if not given */
+  unsigned vector_length;
+
+  /* Level of tiling whose tile space loops are parallelized (see
+   * --parallel-tile-level); 0 if not given */
+  unsigned parallel_level;
+
+  /* 1 to split-tile the band, 0 to tile it with rectangular tiles; -1 if not
+   * given */
+  int split;
+};
+typedef struct plutoTileBandConfig PlutoTileBandConfig;
+
+struct plutoTileConfig {
+  PlutoTileBandConfig *bands;
+  unsigned nbands;
+};
+typedef struct plutoTileConfig PlutoTileConfig;
+
+PlutoTileConfig *pluto_tile_config_alloc();
+void pluto_tile_config_free(PlutoTileConfig *config);
+
+/// Reads a tile configuration from the file at `path'. Returns NULL (after
+/// printing the reason) if the file can't be read or has a syntax error.
+PlutoTileConfig *pluto_tile_config_read(const char *path,
+                                        PlutoContext *context);
+
+/// Writes `config' to `fp' in the format read by pluto_tile_config_read.
+void pluto_tile_config_print(FILE *fp, const PlutoTileConfig *config);
+
+/// Adds a section to `config' that matches any band and gives nothing.
+PlutoTileBandConfig *pluto_tile_config_add_band(PlutoTileConfig *config);
+
+/// Returns the section of `config' for `band': among the matching ones, a
+/// section that lists the statements of the band is preferred to one that
+/// doesn't, then one that gives the depth to one that doesn't. Returns NULL
+/// if none matches.
+const PlutoTileBandConfig *
+pluto_tile_config_lookup(const PlutoTileConfig *config, const Band *band);
+
+/// Returns the section of `config' that names exactly the statements and the
+/// depth of `band', adding an empty one if there is none.
+PlutoTileBandConfig *pluto_tile_config_get_band(PlutoTileConfig *config,
+                                                const Band *band);
+
+/// Sets the tile sizes of `level' (1 for the first level) of `band_config'.
+void pluto_tile_band_config_set_sizes(PlutoTileBandConfig *band_config,
+                                      unsigned level, const int *sizes,
+                                      unsigned nsizes);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _TILE_CONFIG_H
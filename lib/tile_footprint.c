@@ -0,0 +1,319 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE in the
+ * top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ * Exact tile footprints: the number of distinct data elements a tile of a
+ * permutable band accesses, found by counting the integer points in the
+ * images of the tile under the access relations.
+ *
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constraints.h"
+#include "math_support.h"
+#include "pluto.h"
+#include "pluto/matrix.h"
+#include "pluto/pluto.h"
+#include "tile_footprint.h"
+
+#include "isl/ctx.h"
+#include "isl/point.h"
+#include "isl/set.h"
+#include "isl/space.h"
+#include "isl/val.h"
+
+/* Bands with more loops than this are not handled: the corners of a tile are
+ * enumerated to find a full tile. */
+#define MAX_FOOTPRINT_BAND_LOOPS 8
+
+/// Appends a zero constraint (an equality if `is_eq') to `cst' and returns it.
+static int64_t *add_row(PlutoConstraints *cst, int is_eq) {
+  pluto_constraints_add_constraint(cst, is_eq);
+  return cst->val[cst->nrows - 1];
+}
+
+/// Returns `set' intersected with the constraints `cst', which are over the
+/// same dimensions. `cst' is freed.
+static isl_set *intersect_constraints(isl_set *set, PlutoConstraints *cst,
+                                      isl_ctx *ctx) {
+  isl_basic_set *bset = isl_basic_set_from_pluto_constraints(ctx, cst);
+  pluto_constraints_free(cst);
+  return isl_set_intersect(set, isl_set_from_basic_set(bset));
+}
+
+/// Returns the domain of `stmt' with all parameters set to `param_val', as a
+/// set of `nlead' leading dimensions followed by the iterators and the
+/// parameters of the statement.
+static isl_set *get_stmt_domain(const Stmt *stmt, const PlutoProg *prog,
+                                unsigned nlead, int64_t param_val,
+                                isl_ctx *ctx) {
+  unsigned npar = prog->npar;
+  isl_set *dom = isl_set_from_pluto_constraints(stmt->domain, ctx);
+  PlutoConstraints *params =
+      pluto_constraints_alloc(npar, stmt->dim + npar + 1, prog->context);
+  for (unsigned p = 0; p < npar; p++) {
+    int64_t *row = add_row(params, 1);
+    row[stmt->dim + p] = 1;
+    row[stmt->dim + npar] = -param_val;
+  }
+  dom = intersect_constraints(dom, params, ctx);
+  return isl_set_insert_dims(dom, isl_dim_set, 0, nlead);
+}
+
+/// Copies the affine function `func' of the iterators and parameters of
+/// `stmt' into `row' after `nlead' leading columns, scaled by `scale'.
+static void copy_func(int64_t *row, const int64_t *func, const Stmt *stmt,
+                      const PlutoProg *prog, unsigned nlead, int64_t scale) {
+  for (unsigned c = 0; c < stmt->dim + prog->npar + 1; c++) {
+    row[nlead + c] += scale * func[c];
+  }
+}
+
+/// Returns the first point of `set' in lexicographic order in `vals' (of
+/// size the number of dimensions of `set'). `set' is freed. Returns false if
+/// `set' is empty or unbounded.
+static bool get_lexmin_point(isl_set *set, int64_t *vals) {
+  int n = isl_set_dim(set, isl_dim_set);
+  isl_point *pnt = isl_set_sample_point(isl_set_lexmin(set));
+  if (!pnt || isl_point_is_void(pnt)) {
+    isl_point_free(pnt);
+    return false;
+  }
+  for (int d = 0; d < n; d++) {
+    isl_val *val = isl_point_get_coordinate_val(pnt, isl_dim_set, d);
+    vals[d] = isl_val_get_num_si(val);
+    isl_val_free(val);
+  }
+  isl_point_free(pnt);
+  return true;
+}
+
+/// Finds the origin of a full tile of `band', i.e., a point `origin' (one
+/// value per band dimension) such that, for every statement of the band, each
+/// corner of the box at `origin' with sizes `tile_sizes' is the image of an
+/// iteration of the statement under the band hyperplanes. Returns false if
+/// there is none.
+static bool get_full_tile_origin(const Band *band, const unsigned *tile_sizes,
+                                 const PlutoProg *prog, int64_t param_val,
+                                 isl_ctx *ctx, int64_t *origin) {
+  unsigned depth = band->loop->depth;
+  unsigned width = band->width;
+  unsigned npar = prog->npar;
+
+  /* Dimensions that are scalar for all statements are left at zero. */
+  PlutoConstraints *scalar_dims =
+      pluto_constraints_alloc(width, width + 1, prog->context);
+  for (unsigned d = 0; d < width; d++) {
+    unsigned s;
+    for (s = 0; s < band->loop->nstmts; s++) {
+      if (pluto_is_hyperplane_loop(band->loop->stmts[s], depth + d))
+        break;
+    }
+    if (s == band->loop->nstmts)
+      add_row(scalar_dims, 1)[d] = 1;
+  }
+  isl_set *origins = isl_set_universe(isl_space_set_alloc(ctx, 0, width));
+  origins = intersect_constraints(origins, scalar_dims, ctx);
+
+  for (unsigned s = 0; s < band->loop->nstmts; s++) {
+    const Stmt *stmt = band->loop->stmts[s];
+    unsigned loops[width];
+    unsigned nloops = 0;
+    for (unsigned d = 0; d < width; d++) {
+      if (pluto_is_hyperplane_loop(stmt, depth + d))
+        loops[nloops++] = d;
+    }
+    if (nloops > MAX_FOOTPRINT_BAND_LOOPS) {
+      isl_set_free(origins);
+      return false;
+    }
+
+    unsigned ncols = width + stmt->dim + npar + 1;
+    for (unsigned corner = 0; corner < (1u << nloops); corner++) {
+      PlutoConstraints *cst =
+          pluto_constraints_alloc(nloops, ncols, prog->context);
+      for (unsigned k = 0; k < nloops; k++) {
+        unsigned d = loops[k];
+        int64_t *row = add_row(cst, 1);
+        copy_func(row, stmt->trans->val[depth + d], stmt, prog, width, 1);
+        row[d] = -1;
+        if (corner & (1u << k))
+          row[ncols - 1] -= tile_sizes[d] - 1;
+      }
+      isl_set *set = get_stmt_domain(stmt, prog, width, param_val, ctx);
+      set = intersect_constraints(set, cst, ctx);
+      set = isl_set_project_out(set, isl_dim_set, width, stmt->dim + npar);
+      origins = isl_set_intersect(origins, set);
+    }
+  }
+
+  return get_lexmin_point(origins, origin);
+}
+
+/// Returns the iterations of `stmt' in the tile of `band' at `origin', as a
+/// set over the iterators and parameters of the statement. Loops outside the
+/// band are fixed to their values at the first iteration of the tile.
+static isl_set *get_stmt_tile(const Stmt *stmt, const Band *band,
+                              const unsigned *tile_sizes,
+                              const int64_t *origin, const PlutoProg *prog,
+                              int64_t param_val, isl_ctx *ctx) {
+  unsigned depth = band->loop->depth;
+  unsigned ncols = stmt->dim + prog->npar + 1;
+
+  PlutoConstraints *box =
+      pluto_constraints_alloc(2 * band->width, ncols, prog->context);
+  for (unsigned d = 0; d < band->width; d++) {
+    if (!pluto_is_hyperplane_loop(stmt, depth + d))
+      continue;
+    int64_t *lb = add_row(box, 0);
+    copy_func(lb, stmt->trans->val[depth + d], stmt, prog, 0, 1);
+    lb[ncols - 1] -= origin[d];
+    int64_t *ub = add_row(box, 0);
+    copy_func(ub, stmt->trans->val[depth + d], stmt, prog, 0, -1);
+    ub[ncols - 1] += origin[d] + tile_sizes[d] - 1;
+  }
+  isl_set *tile = get_stmt_domain(stmt, prog, 0, param_val, ctx);
+  tile = intersect_constraints(tile, box, ctx);
+
+  if (depth == 0)
+    return tile;
+
+  int64_t first[ncols];
+  if (!get_lexmin_point(isl_set_copy(tile), first))
+    return tile;
+  first[ncols - 1] = 1;
+
+  PlutoConstraints *outer =
+      pluto_constraints_alloc(depth, ncols, prog->context);
+  for (unsigned h = 0; h < depth; h++) {
+    if (!pluto_is_hyperplane_loop(stmt, h))
+      continue;
+    int64_t *row = add_row(outer, 1);
+    copy_func(row, stmt->trans->val[h], stmt, prog, 0, 1);
+    for (unsigned c = 0; c < ncols; c++) {
+      row[ncols - 1] -= stmt->trans->val[h][c] * first[c];
+    }
+  }
+  return intersect_constraints(tile, outer, ctx);
+}
+
+/// Returns the data elements `acc' accesses in `tile' (a set over the
+/// iterators and parameters of `stmt').
+static isl_set *get_access_image(const Stmt *stmt, const PlutoAccess *acc,
+                                 __isl_keep isl_set *tile,
+                                 const PlutoProg *prog, isl_ctx *ctx) {
+  unsigned ndims = acc->mat->nrows;
+  assert(acc->mat->ncols == stmt->dim + prog->npar + 1);
+
+  PlutoConstraints *cst = pluto_constraints_alloc(
+      ndims, ndims + stmt->dim + prog->npar + 1, prog->context);
+  for (unsigned k = 0; k < ndims; k++) {
+    int64_t *row = add_row(cst, 1);
+    row[k] = -1;
+    copy_func(row, acc->mat->val[k], stmt, prog, ndims, 1);
+  }
+  isl_set *image =
+      isl_set_insert_dims(isl_set_copy(tile), isl_dim_set, 0, ndims);
+  image = intersect_constraints(image, cst, ctx);
+  return isl_set_project_out(image, isl_dim_set, ndims,
+                             stmt->dim + prog->npar);
+}
+
+/// Adds the elements of `image' to those of the array `name' in `images'.
+/// Returns false if the array was seen before with a different number of
+/// dimensions.
+static bool add_array_image(const char *name, isl_set *image, char **names,
+                            isl_set **images, unsigned *nimages) {
+  for (unsigned a = 0; a < *nimages; a++) {
+    if (strcmp(names[a], name))
+      continue;
+    if (isl_set_dim(images[a], isl_dim_set) !=
+        isl_set_dim(image, isl_dim_set)) {
+      isl_set_free(image);
+      return false;
+    }
+    images[a] = isl_set_union(images[a], image);
+    return true;
+  }
+  names[*nimages] = strdup(name);
+  images[(*nimages)++] = image;
+  return true;
+}
+
+/// Returns the footprint of the tile of `band' at `origin'; a negative value
+/// if it can't be computed.
+static double count_tile_footprint(const Band *band, const unsigned *tile_sizes,
+                                   const int64_t *origin, const PlutoProg *prog,
+                                   int64_t param_val, isl_ctx *ctx) {
+  unsigned naccs = 0;
+  for (unsigned s = 0; s < band->loop->nstmts; s++) {
+    naccs += band->loop->stmts[s]->nreads + band->loop->stmts[s]->nwrites;
+  }
+
+  char **names = (char **)malloc(naccs * sizeof(char *));
+  isl_set **images = (isl_set **)malloc(naccs * sizeof(isl_set *));
+  unsigned narrays = 0;
+  bool ok = true;
+  for (unsigned s = 0; s < band->loop->nstmts && ok; s++) {
+    const Stmt *stmt = band->loop->stmts[s];
+    isl_set *tile = get_stmt_tile(stmt, band, tile_sizes, origin, prog,
+                                  param_val, ctx);
+    for (int a = 0; a < stmt->nreads + stmt->nwrites && ok; a++) {
+      const PlutoAccess *acc = a < stmt->nreads
+                                   ? stmt->reads[a]
+                                   : stmt->writes[a - stmt->nreads];
+      /* Scalars */
+      if (acc->mat->nrows == 0)
+        continue;
+      isl_set *image = get_access_image(stmt, acc, tile, prog, ctx);
+      ok = add_array_image(acc->name, image, names, images, &narrays);
+    }
+    isl_set_free(tile);
+  }
+
+  double footprint = 0.0;
+  for (unsigned a = 0; a < narrays; a++) {
+    isl_val *count = ok ? isl_set_count_val(images[a]) : NULL;
+    if (count && isl_val_is_int(count))
+      footprint += isl_val_get_d(count);
+    else
+      ok = false;
+    isl_val_free(count);
+    isl_set_free(images[a]);
+    free(names[a]);
+  }
+  free(images);
+  free(names);
+  return ok ? footprint : -1.0;
+}
+
+double pluto_get_tile_footprint(const Band *band, const unsigned *tile_sizes,
+                                const PlutoProg *prog) {
+  unsigned max_tile_size = 1;
+  for (unsigned d = 0; d < band->width; d++) {
+    max_tile_size = PLMAX(max_tile_size, tile_sizes[d]);
+  }
+
+  /* The parameters are set to values that leave room for a full tile along
+   * every dimension; larger ones are tried if that wasn't enough (with
+   * skewed or triangular domains for instance). */
+  double footprint = -1.0;
+  for (unsigned attempt = 0; attempt < 2 && footprint < 0.0; attempt++) {
+    int64_t param_val = ((int64_t)4 << (2 * attempt)) * max_tile_size + 64;
+    isl_ctx *ctx = isl_ctx_alloc();
+    int64_t origin[band->width];
+    if (get_full_tile_origin(band, tile_sizes, prog, param_val, ctx, origin))
+      footprint = count_tile_footprint(band, tile_sizes, origin, prog,
+                                       param_val, ctx);
+    isl_ctx_free(ctx);
+  }
+  return footprint;
+}
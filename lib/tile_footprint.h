@@ -0,0 +1,33 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE
+ * in the top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ */
+#ifndef _TILE_FOOTPRINT_H
+#define _TILE_FOOTPRINT_H
+
+typedef struct band Band;
+typedef struct plutoProg PlutoProg;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/// Returns the number of distinct data elements accessed by one full tile of
+/// `band' whose sizes along the band dimensions are `tile_sizes', computed by
+/// counting the integer points of the images of the tile under the access
+/// relations (accesses to the same array are united first). The parameters
+/// are set to values large enough for a full tile to exist. Returns a
+/// negative value if the footprint can't be computed.
+double pluto_get_tile_footprint(const Band *band, const unsigned *tile_sizes,
+                                const PlutoProg *prog);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _TILE_FOOTPRINT_H
@@ -1,25 +1,72 @@
 #include "tile_size_selection_model.h"
+#include "constraints.h"
 #include "math_support.h"
 #include "pluto/matrix.h"
 #include "pluto/pluto.h"
 #include "post_transform.h"
 #include "program.h"
+#include "tile_footprint.h"
 #include <algorithm>
 #include <cassert>
 #include <math.h>
 #include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <vector>
 
+/// Returns the cache hierarchy described by the options, innermost level
+/// first. A single level of options->cache_size bytes is used when no
+/// hierarchy has been provided.
+static std::vector<PlutoCacheLevel>
+get_cache_levels(const PlutoOptions *options) {
+  std::vector<PlutoCacheLevel> levels(
+      options->cache_levels, options->cache_levels + options->num_cache_levels);
+  if (levels.empty()) {
+    PlutoCacheLevel level;
+    level.size = options->cache_size;
+    level.line_size = 64;
+    level.associativity = 0;
+    level.shared_by = 1;
+    levels.push_back(level);
+  }
+  return levels;
+}
+
+/// Returns the number of data elements of a tile that can be kept in the
+/// per-core share of the input cache level. With limited associativity, one
+/// way is left for conflict misses.
+static double get_num_data_elements_in_cache(const PlutoCacheLevel &level,
+                                             unsigned data_element_size) {
+  double size = (double)level.size / std::max(level.shared_by, 1u);
+  if (level.associativity == 1)
+    size /= 2;
+  else if (level.associativity > 1)
+    size = size * (level.associativity - 1) / level.associativity;
+  return size / data_element_size;
+}
+
+/// Returns the cache level that tiles of the input tiling level (0 for the
+/// first level of tiling) are sized for. With more than one cache level, L1 is
+/// left to the intra-tile (vector) dimension and the first level of tiles
+/// targets L2, the second L3, and so on.
+static unsigned get_cache_level_for_tiling_level(unsigned tiling_level,
+                                                 unsigned num_cache_levels) {
+  unsigned level = (num_cache_levels >= 2) ? tiling_level + 1 : tiling_level;
+  return std::min(level, num_cache_levels - 1);
+}
+
 class TileSizeSelectionModel {
 private:
   std::vector<float> dimReuse;
   std::vector<bool> vectorizableLoops;
   unsigned vectorDim;
-  unsigned cache_size_per_core;
-  unsigned available_cache_size_per_core;
-  unsigned num_data_elements_in_cache;
+  std::vector<PlutoCacheLevel> cache_levels;
+  unsigned data_element_size;
+  /// Tile footprint polynomial f(\tau) in number of data elements.
   std::vector<double> reuse_polynomial;
+  void set_vector_tile_size_for_l1(unsigned num_accesses);
   void add_tile_size_constraints_for_diamond_tiling();
   unsigned compute_tile_footprint_coefficient_for_access(PlutoAccess *access,
                                                          Band *band,
@@ -30,21 +77,25 @@ private:
   unsigned tile_size_for_parallel_dimension;
   unsigned par_loop_depth;
   bool has_pipeline_parallelism;
+  bool has_fixed_tile_size(unsigned dim) const;
+  std::vector<unsigned> get_tile_sizes_for_root(double root) const;
 
 public:
   void construct_expression_for_tile_volume(Band *band, PlutoProg *prog);
+  bool construct_exact_expression_for_tile_volume(Band *band, PlutoProg *prog);
   TileSizeSelectionModel(const std::vector<float> &_dimReuse,
                          const std::vector<bool> &_vectorizableLoops,
-                         unsigned cache_size, unsigned data_element_size,
-                         unsigned ufactor, unsigned _par_loop_depth,
-                         bool _has_pipeline_parallelism)
+                         const std::vector<PlutoCacheLevel> &_cache_levels,
+                         unsigned _data_element_size, unsigned ufactor,
+                         unsigned _par_loop_depth,
+                         bool _has_pipeline_parallelism,
+                         unsigned par_tile_size)
       : dimReuse(_dimReuse), vectorizableLoops(_vectorizableLoops),
-        cache_size_per_core(cache_size), unroll_jam_factor(ufactor),
-        par_loop_depth(_par_loop_depth),
+        cache_levels(_cache_levels), data_element_size(_data_element_size),
+        unroll_jam_factor(ufactor), par_loop_depth(_par_loop_depth),
         has_pipeline_parallelism(_has_pipeline_parallelism) {
-    num_data_elements_in_cache = cache_size_per_core / data_element_size;
     tile_size_for_vector_dimension = 512;
-    tile_size_for_parallel_dimension = 32;
+    tile_size_for_parallel_dimension = par_tile_size;
     vectorDim = _vectorizableLoops.size();
     for (unsigned i = 0; i < _vectorizableLoops.size(); i++) {
       if (!_vectorizableLoops[i])
@@ -58,7 +109,7 @@ public:
         vectorDim = i;
     }
   }
-  unsigned solve_reuse_expression();
+  unsigned solve_reuse_expression(unsigned cache_level);
   std::vector<unsigned> infer_tile_sizes(unsigned root);
 };
 
@@ -104,29 +155,73 @@ static unsigned approximate_to_nearest_multiple(unsigned num, unsigned factor) {
   return num - r + factor;
 }
 
-/// Solves the reuse polynomial and returns the maximum positive root. The
-/// current implementation gives precise results when the degree of the reuse
-/// polynomial is less than 3. When degree > 3, the reuse polynomaial is
-/// approximated to the highest power. This can be very imprecise, but we did
-/// not see any cases where the degree was larger than 2. Integrate with an
-/// external library to solve higher degee polynomials.
-unsigned TileSizeSelectionModel::solve_reuse_expression() {
+/// Evaluates the polynomial whose coefficient of i^th degree is at the i^th
+/// location of 'poly' at 'x'. 'derivative' is set to the value of its
+/// derivative at 'x'.
+static double evaluate_polynomial(const std::vector<double> &poly, double x,
+                                  double &derivative) {
+  double value = 0.0;
+  derivative = 0.0;
+  for (unsigned i = poly.size(); i-- > 0;) {
+    derivative = derivative * x + value;
+    value = value * x + poly[i];
+  }
+  return value;
+}
+
+/// Returns the largest x > 0 (up to a relative tolerance) for which the input
+/// polynomial, negative at zero, stays negative on [0, x]: a sign change is
+/// bracketed between successive powers of two and then narrowed down with
+/// Newton steps, falling back to bisection whenever a step leaves the
+/// bracket.
+static double find_positive_root(const std::vector<double> &equation) {
+  const double max_root = 1 << 24;
+  double derivative;
+  double lo = 0.0, hi = 1.0;
+  while (evaluate_polynomial(equation, hi, derivative) < 0.0) {
+    lo = hi;
+    hi *= 2;
+    if (hi > max_root)
+      return max_root;
+  }
+
+  double x = (lo + hi) / 2;
+  for (unsigned iter = 0; iter < 100 && hi - lo > 1e-6 * hi; iter++) {
+    double value = evaluate_polynomial(equation, x, derivative);
+    if (value < 0.0)
+      lo = x;
+    else
+      hi = x;
+    double next = derivative > 0.0 ? x - value / derivative : lo;
+    x = (next > lo && next < hi) ? next : (lo + hi) / 2;
+  }
+  return lo;
+}
+
+/// Solves f(\tau) - C = 0, where f is the reuse polynomial and C the number of
+/// data elements that fit in the input cache level, and returns the positive
+/// root. Quadratics are solved in closed form, other polynomials (which can
+/// come out of construct_exact_expression_for_tile_volume) numerically.
+/// Returns 0 when even the constant part of the footprint exceeds the cache.
+unsigned TileSizeSelectionModel::solve_reuse_expression(unsigned cache_level) {
 
   // Just a constant. return anything
   if (reuse_polynomial.size() < 2)
     return 0;
-  assert(reuse_polynomial.size() >= 2 and reuse_polynomial[0] < 0.0f);
 
-  // If quadratic, find the exact roots. Else approximate.
-  if (reuse_polynomial.size() == 3) {
-    double max_root = solve_quadratic_equation(reuse_polynomial);
+  std::vector<double> equation = reuse_polynomial;
+  equation[0] -= get_num_data_elements_in_cache(cache_levels[cache_level],
+                                                data_element_size);
+  if (equation[0] >= 0.0)
+    return 0;
+
+  // If quadratic, find the exact roots. Else solve numerically.
+  if (equation.size() == 3 && equation[2] > 0.0) {
+    double max_root = solve_quadratic_equation(equation);
     assert(max_root >= 0 && "Negative root for reuse polynomial");
     return (unsigned)max_root;
   }
-  double base = (-reuse_polynomial[0]) / reuse_polynomial.back();
-  double exponent = (double)1 / (double)(reuse_polynomial.size() - 1);
-  double root = pow(base, exponent);
-  return (unsigned)root;
+  return (unsigned)find_positive_root(equation);
 }
 
 /// Rounds up the tile size to the nearest multiple of unroll factor.
@@ -175,7 +270,7 @@ std::vector<unsigned> TileSizeSelectionModel::infer_tile_sizes(unsigned root) {
   // Compute tile size for the dimension with the smallest dimensional reuse.
   for (unsigned i = 0; i < dimReuse.size(); i++) {
     if (has_pipeline_parallelism && (i == 0 || i == 1)) {
-      tile_sizes[i] = 32;
+      tile_sizes[i] = tile_size_for_parallel_dimension;
       continue;
     }
     if (i == vectorDim) {
@@ -329,6 +424,24 @@ unsigned TileSizeSelectionModel::compute_tile_footprint_coefficient_for_access(
   return degree;
 }
 
+/// With a cache hierarchy, sizes the tile along the vector dimension so that the
+/// rows of all accesses touched by an unroll-jammed block stay in L1. The size
+/// is kept a multiple of the number of elements in a cache line.
+void TileSizeSelectionModel::set_vector_tile_size_for_l1(
+    unsigned num_accesses) {
+  if (cache_levels.size() < 2 || num_accesses == 0)
+    return;
+  double l1_elements =
+      get_num_data_elements_in_cache(cache_levels[0], data_element_size);
+  unsigned line_elements =
+      std::max(cache_levels[0].line_size / data_element_size, 1u);
+  unsigned size =
+      l1_elements / (num_accesses * std::max(unroll_jam_factor, 1u));
+  size = std::max(size - size % line_elements, line_elements);
+  tile_size_for_vector_dimension =
+      std::min(tile_size_for_vector_dimension, size);
+}
+
 /// Constructs a single variable n-degree polynomial for tile volume based on
 /// dimensional reuse. The degree of the polynomial is bounded by the number of
 /// loops in the permutable band.
@@ -358,6 +471,8 @@ void TileSizeSelectionModel::construct_expression_for_tile_volume(
       get_distinct_accesses_in_band(band, prog);
   unsigned max_degree = 0;
 
+  set_vector_tile_size_for_l1(distinctAccesses.size());
+
   // Compute the tile footprint access-wise. Tile footprint is computed
   // according to dimensional reuse.
   for (auto acc : distinctAccesses) {
@@ -395,9 +510,6 @@ void TileSizeSelectionModel::construct_expression_for_tile_volume(
     pluto_access_free(acc);
   }
 
-  // f(\tau) - Cache_size = 0;
-  reuse_polynomial[0] -= num_data_elements_in_cache;
-
   if (options->debug || options->moredebug) {
     printf("[tile-size-selection] Reuse Polynomial \n");
     for (unsigned i = 0; i < reuse_polynomial.size(); i++) {
@@ -406,6 +518,152 @@ void TileSizeSelectionModel::construct_expression_for_tile_volume(
   }
 }
 
+/// Returns true if the tile size along 'dim' doesn't depend on the root of the
+/// reuse polynomial (see infer_tile_sizes).
+bool TileSizeSelectionModel::has_fixed_tile_size(unsigned dim) const {
+  return (has_pipeline_parallelism && (dim == 0 || dim == 1)) ||
+         dim == vectorDim || dim == par_loop_depth || dimReuse[dim] <= 0.0f;
+}
+
+/// Returns the tile sizes infer_tile_sizes would pick for 'root', without the
+/// rounding to multiples of the unroll-jam factor.
+std::vector<unsigned>
+TileSizeSelectionModel::get_tile_sizes_for_root(double root) const {
+  std::vector<unsigned> tile_sizes(dimReuse.size());
+  for (unsigned i = 0; i < dimReuse.size(); i++) {
+    if (has_pipeline_parallelism && (i == 0 || i == 1))
+      tile_sizes[i] = tile_size_for_parallel_dimension;
+    else if (i == vectorDim)
+      tile_sizes[i] = tile_size_for_vector_dimension;
+    else if (i == par_loop_depth)
+      tile_sizes[i] = tile_size_for_parallel_dimension;
+    else if (dimReuse[i] <= 0.0f)
+      tile_sizes[i] = std::max(unroll_jam_factor, 1u);
+    else
+      tile_sizes[i] = std::max((unsigned)lround(dimReuse[i] * root), 1u);
+  }
+  return tile_sizes;
+}
+
+/// Returns the polynomial of degree 'degree' (coefficient of i^th degree at
+/// the i^th location) that fits the points ('xs', 'ys') best in the least
+/// squares sense. The x values are scaled down to [0, 1] while solving the
+/// normal equations to keep them well-conditioned.
+static std::vector<double> fit_polynomial(const std::vector<double> &xs,
+                                          const std::vector<double> &ys,
+                                          unsigned degree) {
+  unsigned n = degree + 1;
+  double scale = *std::max_element(xs.begin(), xs.end());
+  std::vector<std::vector<double>> mat(n, std::vector<double>(n + 1, 0.0));
+  for (unsigned k = 0; k < xs.size(); k++) {
+    std::vector<double> powers(2 * n - 1, 1.0);
+    for (unsigned i = 1; i < powers.size(); i++)
+      powers[i] = powers[i - 1] * xs[k] / scale;
+    for (unsigned i = 0; i < n; i++) {
+      for (unsigned j = 0; j < n; j++)
+        mat[i][j] += powers[i + j];
+      mat[i][n] += powers[i] * ys[k];
+    }
+  }
+
+  // Gaussian elimination with partial pivoting.
+  for (unsigned c = 0; c < n; c++) {
+    unsigned pivot = c;
+    for (unsigned r = c + 1; r < n; r++)
+      if (fabs(mat[r][c]) > fabs(mat[pivot][c]))
+        pivot = r;
+    std::swap(mat[c], mat[pivot]);
+    for (unsigned r = c + 1; r < n; r++) {
+      double factor = mat[r][c] / mat[c][c];
+      for (unsigned j = c; j <= n; j++)
+        mat[r][j] -= factor * mat[c][j];
+    }
+  }
+  std::vector<double> poly(n);
+  for (unsigned i = n; i-- > 0;) {
+    double sum = mat[i][n];
+    for (unsigned j = i + 1; j < n; j++)
+      sum -= mat[i][j] * poly[j];
+    poly[i] = sum / mat[i][i];
+  }
+  for (unsigned i = 0; i < n; i++)
+    poly[i] /= pow(scale, i);
+  return poly;
+}
+
+/// Constructs the tile footprint polynomial from exact footprints instead of
+/// the dimensional reuse approximation: the footprint of a full tile is
+/// counted (see pluto_get_tile_footprint) for tile sizes sampled along the
+/// direction infer_tile_sizes picks them in, and a polynomial of degree the
+/// number of dimensions whose tile size varies is fitted to the counts.
+/// Returns false, leaving the polynomial empty, if a footprint couldn't be
+/// counted or the tiles to count would be too large.
+bool TileSizeSelectionModel::construct_exact_expression_for_tile_volume(
+    Band *band, PlutoProg *prog) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+
+  set_vector_tile_size_for_l1(get_num_unique_accesses_in_stmts(
+      band->loop->stmts, band->loop->nstmts, prog));
+
+  unsigned num_vars = 0;
+  float min_dim_reuse = 0.0f;
+  for (unsigned i = 0; i < dimReuse.size(); i++) {
+    if (has_fixed_tile_size(i))
+      continue;
+    if (num_vars++ == 0 || dimReuse[i] < min_dim_reuse)
+      min_dim_reuse = dimReuse[i];
+  }
+  if (num_vars == 0)
+    return false;
+
+  // Sample so that the smallest varying tile size goes 2, 4, 6, ... (1, 2, 3,
+  // ... if the tiles would be too large to count).
+  const double max_tile_volume = 1 << 22;
+  unsigned num_samples = num_vars + 3;
+  double step = 0.0;
+  for (double smallest_size : {2.0, 1.0}) {
+    auto tile_sizes = get_tile_sizes_for_root(num_samples * smallest_size /
+                                              min_dim_reuse);
+    double volume = 1.0;
+    for (auto size : tile_sizes)
+      volume *= size;
+    if (volume <= max_tile_volume) {
+      step = smallest_size / min_dim_reuse;
+      break;
+    }
+  }
+  if (step == 0.0) {
+    IF_DEBUG(printf("[tile-size-selection] Tiles too large to count their "
+                    "footprint\n"););
+    return false;
+  }
+
+  std::vector<double> roots, footprints;
+  for (unsigned k = 1; k <= num_samples; k++) {
+    auto tile_sizes = get_tile_sizes_for_root(k * step);
+    double footprint = pluto_get_tile_footprint(band, tile_sizes.data(), prog);
+    if (footprint < 0.0) {
+      IF_DEBUG(printf("[tile-size-selection] Could not count the tile "
+                      "footprint\n"););
+      return false;
+    }
+    IF_DEBUG2(printf("Footprint for root %0.2f: %0.0f\n", k * step,
+                     footprint););
+    roots.push_back(k * step);
+    footprints.push_back(footprint);
+  }
+  reuse_polynomial = fit_polynomial(roots, footprints, num_vars);
+
+  if (options->debug || options->moredebug) {
+    printf("[tile-size-selection] Exact tile footprint polynomial\n");
+    for (unsigned i = 0; i < reuse_polynomial.size(); i++) {
+      printf("\t Coefficient of degree %d: %0.5f\n", i, reuse_polynomial[i]);
+    }
+  }
+  return true;
+}
+
 /// For the input band, the routine returns a boolean vector whose values
 /// corresponding to the dimensions that will be moved to the innermost level
 /// are set to true.
@@ -499,18 +757,20 @@ static std::vector<float> get_dimensional_reuse(Band *band, PlutoProg *prog) {
 }
 
 /// Assign tile sizes for bands that have zero dimensional reuse for all
-/// dimensions.
+/// dimensions. 'par_tile_size' is the tile size for the parallel dimension (or
+/// the two outer dimensions with wavefront parallelism).
 static std::vector<unsigned> get_tile_sizes_for_band_with_zero_dim_reuse(
     Band *band, const std::vector<float> &dimReuse,
-    const std::vector<bool> &vectorizableDims, unsigned par_loop_depth) {
+    const std::vector<bool> &vectorizableDims, unsigned par_loop_depth,
+    bool is_wavefront_parallel, unsigned par_tile_size) {
   std::vector<unsigned> tile_sizes(dimReuse.size());
   for (unsigned i = 0; i < dimReuse.size(); i++) {
     if (vectorizableDims[i]) {
       tile_sizes[i] = 512;
       continue;
     }
-    if (i == par_loop_depth) {
-      tile_sizes[i] = 32;
+    if (i == par_loop_depth || (is_wavefront_parallel && i <= 1)) {
+      tile_sizes[i] = par_tile_size;
       continue;
     }
     tile_sizes[i] = 32;
@@ -518,6 +778,112 @@ static std::vector<unsigned> get_tile_sizes_for_band_with_zero_dim_reuse(
   return tile_sizes;
 }
 
+/// Returns the number of threads the generated code is expected to run with:
+/// options->num_threads, else OMP_NUM_THREADS; 0 if not known.
+static unsigned get_num_threads(const PlutoOptions *options) {
+  if (options->num_threads > 0)
+    return options->num_threads;
+  const char *env = getenv("OMP_NUM_THREADS");
+  if (env != NULL && atoi(env) > 0)
+    return atoi(env);
+  return 0;
+}
+
+/// Returns the number of iterations along dimension 'dim' of the input band
+/// (maximum across its statements). Parameters are taken to be equal to
+/// options->codegen_context (their assumed lower bound). Returns 0 if the
+/// extent cannot be determined.
+static uint64_t get_band_dim_extent(Band *band, unsigned dim,
+                                    PlutoProg *prog) {
+  const PlutoOptions *options = prog->context->options;
+  unsigned depth = band->loop->depth + dim;
+  uint64_t extent = 0;
+
+  for (unsigned s = 0; s < band->loop->nstmts; s++) {
+    Stmt *stmt = band->loop->stmts[s];
+    if (!pluto_is_hyperplane_loop(stmt, depth))
+      continue;
+    PlutoConstraints *newdom = pluto_get_new_domain(stmt);
+    if (prog->npar > 0) {
+      if (options->codegen_context == -1) {
+        pluto_constraints_free(newdom);
+        return 0;
+      }
+      for (int p = 0; p < prog->npar; p++)
+        pluto_constraints_set_var(newdom, stmt->trans->nrows + p,
+                                  options->codegen_context);
+    }
+    int64_t lb, ub;
+    bool bounded = pluto_constraints_get_const_lb(newdom, depth, &lb) &&
+                   pluto_constraints_get_const_ub(newdom, depth, &ub);
+    pluto_constraints_free(newdom);
+    if (!bounded)
+      return 0;
+    if (ub >= lb)
+      extent = std::max(extent, (uint64_t)(ub - lb + 1));
+  }
+  return extent;
+}
+
+/// Returns the largest tile size, up to 'tile_size', along the parallel
+/// dimension 'dim' of the input band that still leaves
+/// options->parallel_slack tiles per thread.
+static unsigned get_tile_size_with_parallel_slack(Band *band, unsigned dim,
+                                                  PlutoProg *prog,
+                                                  unsigned tile_size) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+  unsigned num_threads = get_num_threads(options);
+  if (num_threads == 0)
+    return tile_size;
+  uint64_t extent = get_band_dim_extent(band, dim, prog);
+  if (extent == 0)
+    return tile_size;
+
+  uint64_t min_num_tiles = (uint64_t)num_threads * options->parallel_slack;
+  uint64_t max_tile_size = std::max(extent / min_num_tiles, (uint64_t)1);
+  if (max_tile_size >= tile_size)
+    return tile_size;
+  IF_DEBUG(printf("[tile-size-selection] Tile size along parallel dimension %d "
+                  "reduced to %lu for %lu tiles per thread (extent %lu)\n",
+                  dim, (unsigned long)max_tile_size,
+                  (unsigned long)options->parallel_slack,
+                  (unsigned long)extent););
+  return max_tile_size;
+}
+
+/// Returns the tile size, up to 'tile_size', for the two outer dimensions of a
+/// band with wavefront (pipelined) parallelism. A wavefront over an n0 x n1
+/// space of tiles starts up and drains over n0 + n1 - 1 steps; the tile size is
+/// halved until the average width of a wavefront, n0 * n1 / (n0 + n1 - 1), has
+/// options->parallel_slack tiles per thread.
+static unsigned get_wavefront_tile_size(Band *band, PlutoProg *prog,
+                                        unsigned tile_size) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+  unsigned num_threads = get_num_threads(options);
+  if (num_threads == 0)
+    return tile_size;
+  uint64_t extent0 = get_band_dim_extent(band, 0, prog);
+  uint64_t extent1 = get_band_dim_extent(band, 1, prog);
+  if (extent0 == 0 || extent1 == 0)
+    return tile_size;
+
+  double min_width = (double)num_threads * options->parallel_slack;
+  unsigned size = tile_size;
+  for (; size > 1; size /= 2) {
+    double n0 = ceil((double)extent0 / size);
+    double n1 = ceil((double)extent1 / size);
+    if (n0 * n1 / (n0 + n1 - 1) >= min_width)
+      break;
+  }
+  if (size < tile_size)
+    IF_DEBUG(printf("[tile-size-selection] Wavefront tile size reduced to %u "
+                    "for %u tiles per thread\n",
+                    size, options->parallel_slack););
+  return size;
+}
+
 /// Returns true if the input band has wavefront parallelism, return false
 /// otherwise.
 // TODO: Check if this is sufficient for wavefront parallelism.
@@ -548,15 +914,64 @@ static bool pluto_band_has_wavefront_parallelism(PlutoProg *prog, Band *band) {
   return true;
 }
 
-/// Returns a vector of tile sizes. The tile sizes are proportional to the
-/// dimensional reuse of each loop in the input band.
-static std::vector<unsigned> find_tile_sizes(Band *band, PlutoProg *prog) {
-  // Trivial band.
-  if (band->width == 1)
-    return std::vector<unsigned>(1, 32);
+/// Returns the size of the data elements to size tiles for: the one provided
+/// with the options, else the one found in the input program, else
+/// sizeof(double).
+static unsigned get_data_element_size(const PlutoProg *prog) {
+  const PlutoOptions *options = prog->context->options;
+  if (options->data_element_size > 0)
+    return options->data_element_size;
+  if (prog->data_element_size > 0)
+    return prog->data_element_size;
+  return sizeof(double);
+}
 
+/// Returns the ratios of the tile sizes of tiling level 'tiling_level' + 1 to
+/// those of 'tiling_level' (0 for the first level of tiling) used when the
+/// model cannot relate them through the reuse polynomial: tiles of the next
+/// cache level are assumed to grow uniformly along all 'width' dimensions.
+static std::vector<unsigned>
+get_default_tile_size_ratios(unsigned width, unsigned tiling_level,
+                             const std::vector<PlutoCacheLevel> &levels,
+                             unsigned data_element_size) {
+  unsigned first =
+      get_cache_level_for_tiling_level(tiling_level, levels.size());
+  unsigned second =
+      get_cache_level_for_tiling_level(tiling_level + 1, levels.size());
+  if (first == second)
+    return std::vector<unsigned>(width, DEFAULT_SECOND_LEVEL_TILE_SIZE_RATIO);
+
+  double capacity_ratio =
+      get_num_data_elements_in_cache(levels[second], data_element_size) /
+      get_num_data_elements_in_cache(levels[first], data_element_size);
+  unsigned ratio = (unsigned)round(pow(capacity_ratio, 1.0 / width));
+  return std::vector<unsigned>(width, std::max(ratio, 1u));
+}
+
+/// Returns a vector of tile sizes. The tile sizes are proportional to the
+/// dimensional reuse of each loop in the input band. For each of the
+/// 'num_levels' - 1 further levels of tiling, 'ratios' gets the ratios of the
+/// tile sizes of that level to those of the previous one, the tiles of each
+/// level being sized for the next level of the cache hierarchy.
+static std::vector<unsigned>
+find_tile_sizes(Band *band, PlutoProg *prog, unsigned num_levels,
+                std::vector<std::vector<unsigned>> &ratios) {
   PlutoContext *context = prog->context;
   PlutoOptions *options = prog->context->options;
+  std::vector<PlutoCacheLevel> cache_levels = get_cache_levels(options);
+  unsigned data_element_size = get_data_element_size(prog);
+  ratios.clear();
+  for (unsigned l = 0; l + 1 < num_levels; l++)
+    ratios.push_back(get_default_tile_size_ratios(
+        band->width, l, cache_levels, data_element_size));
+
+  // Trivial band.
+  if (band->width == 1) {
+    unsigned tile_size = 32;
+    if (pluto_loop_is_parallel(prog, band->loop))
+      tile_size = get_tile_size_with_parallel_slack(band, 0, prog, tile_size);
+    return std::vector<unsigned>(1, tile_size);
+  }
 
   std::vector<bool> vectorizableDims = get_vectorizable_dimensions(band, prog);
 
@@ -595,8 +1010,17 @@ static std::vector<unsigned> find_tile_sizes(Band *band, PlutoProg *prog) {
     vectorizableDims[1] = false;
     IF_DEBUG(printf("Band has wavefront parallelism\n"););
   }
+
+  // Leave enough tiles for all threads along the parallel dimension(s).
+  unsigned par_tile_size = 32;
+  if (is_band_wavefront_parallel)
+    par_tile_size = get_wavefront_tile_size(band, prog, par_tile_size);
+  else if (par_loop_depth < band->width)
+    par_tile_size = get_tile_size_with_parallel_slack(band, par_loop_depth,
+                                                      prog, par_tile_size);
+
   if (is_band_wavefront_parallel && band->width == 2) {
-    std::vector<unsigned> tile_sizes(2, 32);
+    std::vector<unsigned> tile_sizes(2, par_tile_size);
     return tile_sizes;
   }
 
@@ -612,7 +1036,8 @@ static std::vector<unsigned> find_tile_sizes(Band *band, PlutoProg *prog) {
   // Early bailout when dimReuse of all dimensions is zero.
   if (has_zero_dim_reuse(dimReuse)) {
     auto tile_sizes = get_tile_sizes_for_band_with_zero_dim_reuse(
-        band, dimReuse, vectorizableDims, par_loop_depth);
+        band, dimReuse, vectorizableDims, par_loop_depth,
+        is_band_wavefront_parallel, par_tile_size);
     return tile_sizes;
   }
 
@@ -626,15 +1051,49 @@ static std::vector<unsigned> find_tile_sizes(Band *band, PlutoProg *prog) {
         printf("Dimensional reuse of dimension %d: %0.5f \n", i, dimReuse[i]););
   }
   TileSizeSelectionModel *tss = new TileSizeSelectionModel(
-      dimReuse, vectorizableDims, options->cache_size,
-      options->data_element_size, options->ufactor, par_loop_depth,
-      is_band_wavefront_parallel);
-  tss->construct_expression_for_tile_volume(band, prog);
-
-  unsigned root = tss->solve_reuse_expression();
-  IF_DEBUG(printf("Solution of the reuse polynomial: %d\n", root););
+      dimReuse, vectorizableDims, cache_levels, data_element_size,
+      options->ufactor, par_loop_depth, is_band_wavefront_parallel,
+      par_tile_size);
+  if (!options->exact_tile_footprint ||
+      !tss->construct_exact_expression_for_tile_volume(band, prog))
+    tss->construct_expression_for_tile_volume(band, prog);
+
+  unsigned first_level =
+      get_cache_level_for_tiling_level(0, cache_levels.size());
+  unsigned root = tss->solve_reuse_expression(first_level);
+  IF_DEBUG(printf("Solution of the reuse polynomial for cache level %d: %d\n",
+                  first_level + 1, root););
   auto tile_sizes = tss->infer_tile_sizes(root);
 
+  // Size the tiles of each further level for the next cache level with the
+  // same polynomial. Levels beyond the cache hierarchy keep the default
+  // ratios.
+  std::vector<unsigned> inner_tile_sizes = tile_sizes;
+  unsigned inner_root = root;
+  unsigned inner_cache_level = first_level;
+  for (unsigned l = 1; l < num_levels; l++) {
+    unsigned cache_level =
+        get_cache_level_for_tiling_level(l, cache_levels.size());
+    if (cache_level != inner_cache_level) {
+      unsigned outer_root = tss->solve_reuse_expression(cache_level);
+      IF_DEBUG(
+          printf("Solution of the reuse polynomial for cache level %d: %d\n",
+                 cache_level + 1, outer_root););
+      if (outer_root > inner_root) {
+        auto outer_tile_sizes = tss->infer_tile_sizes(outer_root);
+        for (unsigned i = 0; i < tile_sizes.size(); i++) {
+          unsigned inner = std::max(inner_tile_sizes[i], 1u);
+          ratios[l - 1][i] =
+              std::max((outer_tile_sizes[i] + inner / 2) / inner, 1u);
+        }
+        inner_root = outer_root;
+      }
+      inner_cache_level = cache_level;
+    }
+    for (unsigned i = 0; i < tile_sizes.size(); i++)
+      inner_tile_sizes[i] *= ratios[l - 1][i];
+  }
+
   delete tss;
   IF_DEBUG(printf("Tile sizes\n"););
   for (auto i : tile_sizes)
@@ -643,14 +1102,17 @@ static std::vector<unsigned> find_tile_sizes(Band *band, PlutoProg *prog) {
   return tile_sizes;
 }
 
-void find_tile_sizes(Band *band, PlutoProg *prog, int *tile_sizes) {
+void find_tile_sizes(Band *band, PlutoProg *prog, int *tile_sizes,
+                     int **tile_size_ratios, unsigned num_levels) {
   unsigned firstLoop = band->loop->depth;
   unsigned num_tile_dims = band->width;
   unsigned nstmts = band->loop->nstmts;
   Stmt **stmts = band->loop->stmts;
 
   double t_start = rtclock();
-  std::vector<unsigned> tileSizeVec = find_tile_sizes(band, prog);
+  std::vector<std::vector<unsigned>> ratioVecs;
+  std::vector<unsigned> tileSizeVec =
+      find_tile_sizes(band, prog, num_levels, ratioVecs);
   double t_end = rtclock();
   prog->tss_time += t_end - t_start;
   assert(tileSizeVec.size() == num_tile_dims);
@@ -665,6 +1127,8 @@ void find_tile_sizes(Band *band, PlutoProg *prog, int *tile_sizes) {
       tile_sizes[i] = tileSizeVec[i];
     else
       tile_sizes[i] = 42;
+    for (unsigned l = 0; tile_size_ratios && l + 1 < num_levels; l++)
+      tile_size_ratios[l][i] = (j < nstmts) ? ratioVecs[l][i] : 1;
   }
 
   PlutoOptions *options = prog->context->options;
@@ -673,8 +1137,116 @@ void find_tile_sizes(Band *band, PlutoProg *prog, int *tile_sizes) {
     pluto_band_print(band);
     for (unsigned i = 0; i < num_tile_dims; i++) {
       printf("TileSize for dimension %d: %d\n", i, tile_sizes[i]);
+      for (unsigned l = 0; tile_size_ratios && l + 1 < num_levels; l++)
+        printf("Level %d tile size ratio for dimension %d: %d\n", l + 2, i,
+               tile_size_ratios[l][i]);
     }
   }
 
   return;
 }
+
+/// Reads the first line of the sysfs cache attribute file 'dir/name' into
+/// 'buf' (without the newline). Returns false if it cannot be read.
+static bool read_sysfs_cache_attribute(const char *dir, const char *name,
+                                       char *buf, int len) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return false;
+  bool ret = fgets(buf, len, fp) != NULL;
+  fclose(fp);
+  if (ret)
+    buf[strcspn(buf, "\n")] = '\0';
+  return ret;
+}
+
+/// Parses a cache size as reported by sysfs, e.g., "48K" or "32M".
+static uint64_t parse_sysfs_cache_size(const char *str) {
+  char *end;
+  uint64_t size = strtoull(str, &end, 10);
+  if (*end == 'K')
+    size <<= 10;
+  else if (*end == 'M')
+    size <<= 20;
+  else if (*end == 'G')
+    size <<= 30;
+  return size;
+}
+
+/// Returns the number of CPUs in a sysfs CPU list, e.g., 4 for "0-1,8-9".
+static unsigned count_cpus_in_list(const char *list) {
+  unsigned count = 0;
+  const char *p = list;
+  while (*p != '\0') {
+    char *end;
+    unsigned long first = strtoul(p, &end, 10);
+    if (end == p)
+      break;
+    unsigned long last = first;
+    if (*end == '-')
+      last = strtoul(end + 1, &end, 10);
+    if (last >= first)
+      count += last - first + 1;
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return count;
+}
+
+unsigned pluto_detect_cache_levels(PlutoOptions *options) {
+  PlutoCacheLevel levels[PLUTO_MAX_CACHE_LEVELS];
+  bool found[PLUTO_MAX_CACHE_LEVELS] = {false};
+
+  for (unsigned index = 0;; index++) {
+    char dir[128], buf[256];
+    snprintf(dir, sizeof(dir), "/sys/devices/system/cpu/cpu0/cache/index%u",
+             index);
+    if (!read_sysfs_cache_attribute(dir, "level", buf, sizeof(buf)))
+      break;
+    int level = atoi(buf) - 1;
+    if (level < 0 || level >= PLUTO_MAX_CACHE_LEVELS)
+      continue;
+    // Only data and unified caches hold array data.
+    if (read_sysfs_cache_attribute(dir, "type", buf, sizeof(buf)) &&
+        strcmp(buf, "Instruction") == 0)
+      continue;
+    if (!read_sysfs_cache_attribute(dir, "size", buf, sizeof(buf)))
+      continue;
+    PlutoCacheLevel cache;
+    cache.size = parse_sysfs_cache_size(buf);
+    if (cache.size == 0)
+      continue;
+    cache.line_size = 64;
+    if (read_sysfs_cache_attribute(dir, "coherency_line_size", buf,
+                                   sizeof(buf)) &&
+        atoi(buf) > 0)
+      cache.line_size = atoi(buf);
+    cache.associativity = 0;
+    if (read_sysfs_cache_attribute(dir, "ways_of_associativity", buf,
+                                   sizeof(buf)))
+      cache.associativity = atoi(buf);
+    cache.shared_by = 1;
+    if (read_sysfs_cache_attribute(dir, "shared_cpu_list", buf, sizeof(buf)))
+      cache.shared_by = std::max(count_cpus_in_list(buf), 1u);
+    levels[level] = cache;
+    found[level] = true;
+  }
+
+  // Only a hierarchy starting at L1 without holes is usable.
+  unsigned num_levels = 0;
+  while (num_levels < PLUTO_MAX_CACHE_LEVELS && found[num_levels])
+    num_levels++;
+  if (num_levels == 0)
+    return 0;
+
+  for (unsigned i = 0; i < num_levels; i++)
+    options->cache_levels[i] = levels[i];
+  options->num_cache_levels = num_levels;
+
+  // Keep cache_size in line with the level that first level tiles target.
+  const PlutoCacheLevel &first =
+      levels[get_cache_level_for_tiling_level(0, num_levels)];
+  options->cache_size = first.size / first.shared_by;
+  return num_levels;
+}
@@ -1,4 +1,5 @@
 #include "pluto.h"
+#include "pluto/pluto.h"
 #ifndef TILESIZESELECTIONMODEL_H
 #define TILESIZESELECTIONMODEL_H
 
@@ -8,8 +9,19 @@ extern "C" {
 
 /// C wrapper around tile size selection model. Tile sizes for SCALAR dimensions
 /// in the input band are set to 42, rest are inferred from the tile size
-/// selection model.
-void find_tile_sizes(Band *band, PlutoProg *prog, int *tile_sizes);
+/// selection model. If tile_size_ratios is not NULL, tile_size_ratios[l] is set
+/// to the ratios of the tile sizes of level l + 2 (sized for the next cache
+/// level) to those of level l + 1, for each of the num_levels levels of tiling
+/// beyond the first.
+void find_tile_sizes(Band *band, PlutoProg *prog, int *tile_sizes,
+                     int **tile_size_ratios, unsigned num_levels);
+
+/// Detects the cache hierarchy of the host (as seen by cpu0) from sysfs and
+/// stores it into options->cache_levels; options->cache_size is set to the
+/// per-core share of the level targeted by the first level of tiling. Returns
+/// the number of cache levels detected; the options are left untouched if none
+/// could be.
+unsigned pluto_detect_cache_levels(PlutoOptions *options);
 
 #if defined(__cplusplus)
 }
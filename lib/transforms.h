@@ -18,12 +18,17 @@ typedef struct band Band;
 typedef struct plutoProg PlutoProg;
 typedef struct statement Stmt;
 typedef struct pLoop Ploop;
+typedef struct plutoTileConfig PlutoTileConfig;
 
 void pluto_sink_statement(Stmt *stmt, int depth, int val, PlutoProg *prog);
 void pluto_stripmine(Stmt *stmt, int dim, int factor, char *supernode,
                      PlutoProg *prog);
 void pluto_tile_scattering_dims(PlutoProg *prog, Band **bands, int nbands,
-                                bool l2);
+                                unsigned level, unsigned num_levels,
+                                int ***tile_size_ratios,
+                                const PlutoTileConfig *config,
+                                PlutoTileConfig *found,
+                                const int *split_slopes);
 void pluto_reschedule_tile(PlutoProg *prog);
 void pluto_interchange(PlutoProg *prog, int level1, int level2);
 void pluto_sink_transformation(Stmt *stmt, unsigned pos);
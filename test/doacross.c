@@ -0,0 +1,19 @@
+// The outer two tile loops run as doacross loops: the second one gets
+// bounds that don't depend on the first, and each tile waits for its
+// neighbours with ordered depend(sink). Rows of tiles are dealt to threads
+// cyclically so that neighbouring rows run concurrently.
+// DOACROSS: [pluto] Tiles of t1 to t2 run as doacross loops
+// DOACROSS: lb2 = 0;
+// DOACROSS-NEXT: ub2 = -1;
+// DOACROSS: #pragma omp parallel for {{.*}} schedule(static,1) ordered(2)
+// DOACROSS-NEXT: for (t1=lbp;t1<=ubp;t1++) {
+// DOACROSS-NEXT: for (t2=lb2;t2<=ub2;t2++) {
+// DOACROSS-NEXT: #pragma omp ordered depend(sink:{{.*}})
+// DOACROSS-NEXT: if ((t2 >= {{.*}}) && (t2 <= {{.*}})) {
+// DOACROSS: #pragma omp ordered depend(source)
+// DOACROSS-NOT: #pragma omp task
+#pragma scop
+for (t = 0; t < T; t++)
+  for (i = 1; i < N - 1; i++)
+    a[i] = (a[i - 1] + a[i] + a[i + 1]) / 3;
+#pragma endscop
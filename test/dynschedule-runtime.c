@@ -0,0 +1,77 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE
+ * in the top-level directory for details.
+ *
+ * Runs a graph of tiles with the --dynschedule runtime and checks that each
+ * tile runs once and after the tiles it depends on. Tiles have coordinates
+ * (i, j, k) in a triangle along i and j, with a dependence distance of one
+ * tile along each of them.
+ */
+// DYN-RUNTIME: 900 tiles run in order
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "pluto/dynschedule.h"
+
+#define NI 24
+#define NJ NI
+#define NK 3
+
+static atomic_int done[NI][NJ][NK];
+static atomic_int nerrors;
+
+static int is_done(int i, int j, int k) {
+  return i < 0 || j < 0 || atomic_load(&done[i][j][k]);
+}
+
+int main(void) {
+  const unsigned max_dists[] = {1, 1};
+  PlutoDynGraph *g = pluto_dyn_alloc(3, 2, max_dists);
+
+  long ntiles = 0;
+  for (int i = 0; i < NI; i++) {
+    for (int j = 0; j < NJ - i; j++) {
+      for (int k = 0; k < NK; k++) {
+        pluto_dyn_add_tile(g, (unsigned)(i + j) % 2, (const int[]){i, j, k});
+        ntiles++;
+      }
+    }
+  }
+  pluto_dyn_schedule(g);
+
+#pragma omp parallel
+  {
+    long tile;
+    while ((tile = pluto_dyn_next(g)) >= 0) {
+      const int *c = pluto_dyn_get_coords(g, tile);
+      int i = c[0], j = c[1], k = c[2];
+      if (pluto_dyn_get_copy(g, tile) != (unsigned)(i + j) % 2)
+        atomic_fetch_add(&nerrors, 1);
+      /* Previous tile with the same (i, j), and the last tiles of the
+       * neighbours at distance one */
+      if ((k > 0 && !is_done(i, j, k - 1)) || !is_done(i - 1, j, NK - 1) ||
+          !is_done(i, j - 1, NK - 1) || !is_done(i - 1, j - 1, NK - 1))
+        atomic_fetch_add(&nerrors, 1);
+      if (atomic_exchange(&done[i][j][k], 1))
+        atomic_fetch_add(&nerrors, 1);
+      pluto_dyn_done(g, tile);
+    }
+  }
+  pluto_dyn_free(g);
+
+  long nrun = 0;
+  for (int i = 0; i < NI; i++)
+    for (int j = 0; j < NJ; j++)
+      for (int k = 0; k < NK; k++)
+        nrun += atomic_load(&done[i][j][k]);
+
+  if (nrun != ntiles || atomic_load(&nerrors) > 0) {
+    printf("%ld of %ld tiles run, %d out of order\n", nrun, ntiles,
+           atomic_load(&nerrors));
+    return 1;
+  }
+  printf("%ld tiles run in order\n", nrun);
+  return 0;
+}
@@ -0,0 +1,20 @@
+// The tiles of the band are added to a task graph and then run by the
+// threads of a parallel region as their predecessors complete.
+// DYNSCHEDULE: [pluto] Tiles of t1 to t2 scheduled dynamically
+// DYNSCHEDULE: #include <pluto/dynschedule.h>
+// DYNSCHEDULE-NOT: pluto_task_deps
+// DYNSCHEDULE: PlutoDynGraph *pluto_dyn = pluto_dyn_alloc(2, 2, (const unsigned[]){{[{][0-9, ]+[}]}});
+// DYNSCHEDULE: pluto_dyn_add_tile(pluto_dyn, 0, (const int[]){t1, t2});
+// DYNSCHEDULE: pluto_dyn_schedule(pluto_dyn);
+// DYNSCHEDULE-NEXT: #pragma omp parallel private(t1,t2,{{.*}}lbv,ubv)
+// DYNSCHEDULE: while ((pluto_dyn_tile = pluto_dyn_next(pluto_dyn)) >= 0) {
+// DYNSCHEDULE: t1 = pluto_dyn_coords[0];
+// DYNSCHEDULE-NEXT: t2 = pluto_dyn_coords[1];
+// DYNSCHEDULE: case 0: {
+// DYNSCHEDULE: pluto_dyn_done(pluto_dyn, pluto_dyn_tile);
+// DYNSCHEDULE: pluto_dyn_free(pluto_dyn);
+#pragma scop
+for (t = 0; t < T; t++)
+  for (i = 1; i < N - 1; i++)
+    a[i] = (a[i - 1] + a[i] + a[i + 1]) / 3;
+#pragma endscop
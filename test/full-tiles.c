@@ -0,0 +1,15 @@
+// Full tiles are separated from partial ones: their point loops run the
+// whole tile, and the bounds of the partial tiles are computed once per
+// tile. Divisions by the tile size are shifts.
+// FULL-TILES: [pluto] Full tiles separated from partial ones in 1 tile(s)
+// FULL-TILES: for (t1=0;t1<={{.*}}>>5);t1++) {
+// FULL-TILES: int full0 = {{.*}};
+// FULL-TILES-NEXT: if (full0 == 1) {
+// FULL-TILES-NEXT: for (t3=32*t1;t3<=32*t1+31;t3++) {
+// FULL-TILES: if (full0 == 0) {
+// FULL-TILES-NEXT: int ub0_0 = min({{.*}});
+#pragma scop
+for (i = 0; i < N; i++)
+  for (j = 0; j < N; j++)
+    a[i][j] = b[j][i];
+#pragma endscop
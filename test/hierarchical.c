@@ -0,0 +1,26 @@
+// HIER-CHECK: Hierarchical scheduling: 3 cluster(s) of at most 2 statement(s) in 2 fusion group(s)
+// HIER-CHECK: 1 dependence(s) distributed across fusion groups; loss vs. flat ILP: 0 unchecked group boundaries, dependence distance bound +0 at most, 0 failed fusion(s)
+// HIER-CHECK: T(S1): (0, i
+// HIER-CHECK: T(S2): (0, i
+// HIER-CHECK: T(S3): (0, i
+// HIER-CHECK: T(S4): (1, i
+// HIER-CHECK: Output written
+
+/* With clusters of at most two statements, S3 gets its own cluster but is
+ * still fused with S1 and S2, since it is solved right after them with their
+ * solution fixed. S4 reads C in reverse and can't be fused with S3: it starts
+ * a new fusion group. */
+#pragma scop
+for (i = 0; i < N; i++) {
+  A[i] = 0;
+}
+for (i = 0; i < N; i++) {
+  B[i] = A[i];
+}
+for (i = 0; i < N; i++) {
+  C[i] = B[i] + A[i];
+}
+for (i = 0; i < N; i++) {
+  D[i] = C[N - 1 - i];
+}
+#pragma endscop
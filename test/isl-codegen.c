@@ -0,0 +1,18 @@
+// Code generation with isl: the loops of full tiles have no min/max in their
+// bounds; those of partial tiles keep them. The outermost tile loop is marked
+// parallel and the innermost point loop vectorizable.
+// ISL-CODEGEN: /* Start of isl code */
+// ISL-CODEGEN: #pragma omp parallel for
+// ISL-CODEGEN-NEXT: for (int t1 = 0;
+// ISL-CODEGEN: for (int t4 = 32 * t1; t4 <= 32 * t1 + 31; t4 += 1)
+// ISL-CODEGEN: #pragma omp simd
+// ISL-CODEGEN: min(
+// ISL-CODEGEN: /* End of isl code */
+// Unroll-jam is done on CLooG's AST: CLooG is used instead.
+// ISL-UNROLL-JAM: [pluto] WARNING: unroll-jam isn't supported with --codegen=isl; using CLooG
+#pragma scop
+for (i = 0; i < M; i++)
+  for (j = 0; j < N; j++)
+    for (k = 0; k < K; k++)
+      C[i][j] = C[i][j] + A[i][k] * B[k][j];
+#pragma endscop
@@ -1,5 +1,8 @@
 // CHECK: T(S1): (i, j, k)
 // TILE-PARALLEL: T(S1): (i/32, j/32, k/32, i, j, k)
+// TIME-BUDGET: Compile time budget of 0.00s exhausted; falling back to
+// TIME-BUDGET: falling back to original schedule
+// TIME-BUDGET: T(S1): (i/32, j/32, k/32, i, j, k)
 
 #define M 2048
 #define N 2048
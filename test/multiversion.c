@@ -0,0 +1,15 @@
+// The tiled, parallel code runs when the estimated iteration count (N*N
+// here) reaches the threshold, and the untiled, sequential code otherwise.
+// MULTIVERSION: [pluto] Multiversioned code: {{.*}} 4096.0 iterations
+// MULTIVERSION: if ({{.*}}(double)(N - 1){{.*}} >= 4096.0) {
+// MULTIVERSION: #pragma omp parallel for
+// MULTIVERSION: } else {
+// MULTIVERSION-NEXT: #undef S1
+// MULTIVERSION-NEXT: #define S1(i,j)
+// MULTIVERSION-NOT: #pragma omp parallel for
+// MULTIVERSION: for (t1=0;t1<=N-1;t1++) {
+#pragma scop
+for (i = 0; i < N; i++)
+  for (j = 0; j < N; j++)
+    a[i][j] = a[i][j] + b[j][i];
+#pragma endscop
@@ -0,0 +1,12 @@
+// The outer two loops are parallel with bounds that don't depend on each
+// other and are collapsed; the trip count of the innermost loop grows with
+// the outermost one, which is scheduled guided.
+// OMP-SCHEDULE: #pragma omp parallel for {{.*}}collapse(2) schedule(guided)
+// OMP-SCHEDULE-NEXT: for (t1=lbp;t1<=ubp;t1++) {
+// OMP-SCHEDULE-NEXT: for (t2=0;t2<=N-1;t2++) {
+#pragma scop
+for (i = 0; i < N; i++)
+  for (j = 0; j < N; j++)
+    for (k = 0; k <= i; k++)
+      a[i][j][k] = 2 * b[i][j][k];
+#pragma endscop
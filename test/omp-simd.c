@@ -0,0 +1,10 @@
+// The loop carries a dependence of distance 4: it is vectorized with chunks
+// of at most 4 iterations, which is also the number of doubles in an AVX2
+// register. All accesses start at multiples of 32 bytes from the (aligned)
+// array bases.
+// OMP-SIMD: #pragma omp simd simdlen(4) safelen(4) aligned(a,b:32)
+// OMP-SIMD-NEXT: for (t1=lbv;t1<=ubv;t1++) {
+#pragma scop
+for (i = 4; i < N; i++)
+  a[i] = a[i - 4] + b[i];
+#pragma endscop
@@ -0,0 +1,12 @@
+// The tiles of the band run as OpenMP tasks that depend on their
+// neighbours instead of a wavefront of tiles.
+// OMP-TASKS: [pluto] Tiles of t1 to t2 run as OpenMP tasks
+// OMP-TASKS: static char pluto_task_deps[4096];
+// OMP-TASKS: #pragma omp parallel
+// OMP-TASKS-NEXT: #pragma omp single
+// OMP-TASKS: #pragma omp task firstprivate(t1,t2) private({{.*}}lbv,ubv) depend(out:pluto_task_deps[(((t1)&63))*64+((t2)&63)]) depend(in:pluto_task_deps[{{.*}}])
+#pragma scop
+for (t = 0; t < T; t++)
+  for (i = 1; i < N - 1; i++)
+    a[i] = (a[i - 1] + a[i] + a[i + 1]) / 3;
+#pragma endscop
@@ -0,0 +1,31 @@
+// Tile sizes kept symbolic: tile loops step over multiples of tsK, whose
+// default is the tile size Pluto would have used otherwise.
+// PARAM-TILES: int ts1 = 32, ts2 = 32, ts3 = 32;
+// PARAM-TILES: getenv("PLUTO_TILE_SIZES")
+// PARAM-TILES: for (t1tile=ceild({{.*}},ts1);t1tile<=floord({{.*}},ts1);t1tile++) {
+// PARAM-TILES-NEXT: t1 = ts1*t1tile;
+
+// With more than one level of tiling, the tile sizes stay constants.
+// PARAM-TILES-LEVELS: [pluto] WARNING: --parametric-tiles can't be used with more than one level of tiling
+// PARAM-TILES-LEVELS-NOT: int ts1
+
+#define M 2048
+#define N 2048
+#define K 2048
+
+double A[M][K + 13];
+double B[K][N + 13];
+double C[M][N + 13];
+
+int main() {
+  int i, j, k;
+
+#pragma scop
+  for (i = 0; i < M; i++)
+    for (j = 0; j < N; j++)
+      for (k = 0; k < K; k++)
+        C[i][j] = C[i][j] + A[i][k] * B[k][j];
+#pragma endscop
+
+  return 0;
+}
@@ -0,0 +1,17 @@
+// S1 and S3 are connected by a dependence and S2 is connected to neither,
+// so S3 is in the CC of S1. The DFS from S1 reaches S3 before S2 is
+// visited; S3 must keep the id it got then.
+// CC-IDS: [pluto] ddg_compute_cc: S1 in CC 0
+// CC-IDS-NEXT: [pluto] ddg_compute_cc: S2 in CC 1
+// CC-IDS-NEXT: [pluto] ddg_compute_cc: S3 in CC 0
+#pragma scop
+for (i = 0; i < N; i++) {
+  a[i] = i;
+}
+for (i = 0; i < N; i++) {
+  b[i] = 2 * i;
+}
+for (i = 0; i < N; i++) {
+  c[i] = a[i];
+}
+#pragma endscop
@@ -0,0 +1,17 @@
+// A reduction on an array element: x[i - 1] is updated by all iterations of
+// j, and the next iteration of i reads what S2 writes, so that only the j
+// loop is parallel. Its reduction clause names the element as a one-element
+// array section, in terms of t1; the scalar dimension between the j loop and
+// S2 doesn't appear in it.
+// REDUCTION-ARRAY: [pluto] Number of reduction deps relaxed: {{[1-9][0-9]*}}
+// REDUCTION-ARRAY: for (t1=
+// REDUCTION-ARRAY-NOT: #pragma omp parallel for
+// REDUCTION-ARRAY: #pragma omp parallel for private({{.*}}) reduction(+:x[t1-1:1])
+// REDUCTION-ARRAY-NEXT: for (t3=
+#pragma scop
+for (i = 1; i < N; i++) {
+  for (j = 0; j < M; j++)
+    x[i - 1] = x[i - 1] + A[i][j];
+  A[i + 1][0] = x[i - 1];
+}
+#pragma endscop
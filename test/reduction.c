@@ -0,0 +1,11 @@
+// With --reductions, the dependences between the updates of s and p are
+// relaxed and the loop is run in parallel with a reduction clause per
+// operator.
+// REDUCTION: [pluto] Number of reduction deps relaxed: {{[1-9][0-9]*}}
+// REDUCTION: #pragma omp parallel for private({{.*}}) reduction(+:s) reduction(*:p)
+#pragma scop
+for (i = 0; i < N; i++) {
+  s = s + a[i] * b[i];
+  p = p * a[i];
+}
+#pragma endscop
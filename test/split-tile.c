@@ -0,0 +1,31 @@
+// Split tiling of heat-2d: time and the skewed space dimension t+i (along
+// which dependences move by up to two points per time step) are split-tiled,
+// with the time tile size reduced so that tiles of the first phase don't
+// vanish, and all tiles of a phase are run in parallel.
+// SPLIT-TILE: [pluto] Time tile size of split-tiled band at depth 0 reduced to 17
+// SPLIT-TILE: [pluto] Split tiling band at depth 0 (slopes 2, 0)
+// SPLIT-TILE: #pragma omp parallel for
+#define N 4000L
+#define T 1000L
+
+/* Define our arrays */
+double A[2][N + 2][N + 2];
+
+int main(int argc, char *argv[]) {
+#pragma scop
+  for (int t = 0; t < T; t++) {
+    for (int i = 1; i < N + 1; i++) {
+      for (int j = 1; j < N + 1; j++) {
+        A[(t + 1) % 2][i][j] =
+            0.125 * (A[t % 2][i + 1][j] - 2.0 * A[t % 2][i][j] +
+                     A[t % 2][i - 1][j]) +
+            0.125 * (A[t % 2][i][j + 1] - 2.0 * A[t % 2][i][j] +
+                     A[t % 2][i][j - 1]) +
+            A[t % 2][i][j];
+      }
+    }
+  }
+#pragma endscop
+
+  return 0;
+}
@@ -0,0 +1,31 @@
+// Tile sizes read from test/tile-config.tiles, and written out in the same
+// format by the tile size selection model.
+// TILE-CONFIG: T(S1): (i/64, j/16, k/8, {{.*}})
+// A section with only a vector length rounds the default size of the
+// innermost loop up to a multiple of it (test/tile-config-vlen.tiles).
+// VECTOR-LENGTH: T(S1): (i/32, j/32, k/36, {{.*}})
+// SAVE-CONFIG: [band]
+// SAVE-CONFIG-NEXT: statements = S1
+// SAVE-CONFIG-NEXT: depth = 0
+// SAVE-CONFIG-NEXT: level1 = {{[0-9]+}}, {{[0-9]+}}, {{[0-9]+}}
+
+#define M 2048
+#define N 2048
+#define K 2048
+
+double A[M][K + 13];
+double B[K][N + 13];
+double C[M][N + 13];
+
+int main() {
+  int i, j, k;
+
+#pragma scop
+  for (i = 0; i < M; i++)
+    for (j = 0; j < N; j++)
+      for (k = 0; k < K; k++)
+        C[i][j] = C[i][j] + A[i][k] * B[k][j];
+#pragma endscop
+
+  return 0;
+}
@@ -0,0 +1,25 @@
+// Three levels of tiling with sizes read from test/tile-levels.tiles: the
+// tile space loops of the outer levels come first, followed by those of the
+// first level.
+// TILE-LEVELS: T(S1): ({{[^,]+}}, {{[^,]+}}, {{[^,]+}}, {{[^,]+}}, {{[^,]+}}, {{[^,]+}}, i/64, j/16, k/8, {{.*}})
+
+#define M 2048
+#define N 2048
+#define K 2048
+
+double A[M][K + 13];
+double B[K][N + 13];
+double C[M][N + 13];
+
+int main() {
+  int i, j, k;
+
+#pragma scop
+  for (i = 0; i < M; i++)
+    for (j = 0; j < N; j++)
+      for (k = 0; k < K; k++)
+        C[i][j] = C[i][j] + A[i][k] * B[k][j];
+#pragma endscop
+
+  return 0;
+}
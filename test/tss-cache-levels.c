@@ -0,0 +1,29 @@
+// Automatic tile size selection for two levels of tiling with a three-level
+// cache hierarchy: first level tiles for L2, second level tiles for a shared
+// L3.
+// CACHE-LEVELS: [Pluto] After tiling:
+// CACHE-LEVELS: T(S1): (0, {{.*}})
+// CACHE-LEVELS: T(S2): (1, {{.*}})
+
+#define M 2048
+#define N 2048
+#define K 2048
+
+double A[M][K + 13];
+double B[K][N + 13];
+double C[M][N + 13];
+
+int main() {
+  int i, j, k;
+
+#pragma scop
+  for (i = 0; i < M; i++)
+    for (j = 0; j < N; j++) {
+      C[i][j] = 0.0f;
+      for (k = 0; k < K; k++)
+        C[i][j] = C[i][j] + A[i][k] * B[k][j];
+    }
+#pragma endscop
+
+  return 0;
+}
@@ -0,0 +1,35 @@
+// Tile size selection from exact tile footprints. j is the parallel dimension
+// (tile size 32); i and k have dimensional reuses 1 (B) and 2 (C, read and
+// written). Tiles of sizes (r, 32, 2r) access 32r elements of C, 2r^2 of A and
+// 64r of B: the read and the write of C are counted once. The fitted
+// polynomial 2r^2 + 96r reaches the 131072 doubles of a 1 MiB cache at
+// r = 233; k gets 2 * 233 rounded to a multiple of the unroll-jam factor (8),
+// 464, and i half of that.
+// EXACT-FOOTPRINT: [tile-size-selection] Exact tile footprint polynomial
+// EXACT-FOOTPRINT: Solution of the reuse polynomial for cache level 1: 233
+// EXACT-FOOTPRINT: TileSize for dimension 0: 232
+// EXACT-FOOTPRINT-NEXT: TileSize for dimension 1: 32
+// EXACT-FOOTPRINT-NEXT: TileSize for dimension 2: 464
+// EXACT-FOOTPRINT: [Pluto] After tiling:
+// EXACT-FOOTPRINT: T(S1): (i/232, j/32, k/464, {{.*}})
+
+#define M 2048
+#define N 2048
+#define K 2048
+
+double A[M][K];
+double B[K][N];
+double C[M][N];
+
+int main() {
+  int i, j, k;
+
+#pragma scop
+  for (i = 0; i < M; i++)
+    for (j = 0; j < N; j++)
+      for (k = 0; k < K; k++)
+        C[i][j] = C[i][j] + A[i][k] * B[k][j];
+#pragma endscop
+
+  return 0;
+}
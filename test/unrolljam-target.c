@@ -0,0 +1,12 @@
+// With the 16 registers of SSE, unroll-jamming the i and k loops by 8 would
+// need more registers than there are; they are unroll-jammed by 4 instead.
+// UJ-TARGET-DAG: [pluto-unroll-jam] Unroll-jam factor of t4: 4
+// UJ-TARGET-DAG: [pluto-unroll-jam] Unroll-jam factor of t5: 4
+// UJ-TARGET: for (t4=32*t1;t4<=(min(M-1,32*t1+31))-3;t4+=4) {
+// UJ-TARGET:   for (t5=32*t3;t5<=(min(K-1,32*t3+31))-3;t5+=4) {
+#pragma scop
+for (i = 0; i < M; i++)
+  for (j = 0; j < N; j++)
+    for (k = 0; k < K; k++)
+      C[i][j] = C[i][j] + A[i][k] * B[k][j];
+#pragma endscop
@@ -2,8 +2,7 @@
 // CHECK:   for (t5=32*t3;t5<=(min(K-1,32*t3+31))-1;t5+=2) {
 // CHECK:     lbv=32*t2;
 // CHECK:     ubv=min(N-1,32*t2+31);
-// CHECK:     #pragma ivdep
-// CHECK:     #pragma vector always
+// CHECK:     #pragma omp simd
 // CHECK:     for (t6=lbv;t6<=ubv;t6++) {
 // CHECK:       S1(t1,t2,t3,t4,t6,t5);
 // CHECK:       S1(t1,t2,t3,(t4+1),t6,t5);
@@ -14,8 +13,7 @@
 // CHECK:   for (;t5<=min(K-1,32*t3+31);t5++) {
 // CHECK:     lbv=32*t2;
 // CHECK:     ubv=min(N-1,32*t2+31);
-// CHECK:     #pragma ivdep
-// CHECK:     #pragma vector always
+// CHECK:     #pragma omp simd
 // CHECK:     for (t6=lbv;t6<=ubv;t6++) {
 // CHECK:       S1(t1,t2,t3,t4,t6,t5);
 // CHECK:       S1(t1,t2,t3,(t4+1),t6,t5);
@@ -26,8 +24,7 @@
 // CHECK:   for (t5=32*t3;t5<=min(K-1,32*t3+31);t5++) {
 // CHECK:     lbv=32*t2;
 // CHECK:     ubv=min(N-1,32*t2+31);
-// CHECK:     #pragma ivdep
-// CHECK:     #pragma vector always
+// CHECK:     #pragma omp simd
 // CHECK:     for (t6=lbv;t6<=ubv;t6++) {
 // CHECK:       S1(t1,t2,t3,t4,t6,t5);
 // CHECK:     }
@@ -9,26 +9,72 @@
  * This file is part of libpluto.
  *
  */
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ast_transform.h"
+#include "math_support.h"
 #include "pluto/matrix.h"
 #include "pluto/pluto.h"
+#include "pluto_codegen_if.h"
 #include "program.h"
+#include "reduction.h"
 
 #include "cloog/cloog.h"
 
-/// Clast-based parallel loop marking.
+/// Marks the outermost loops of the task bands (see pluto_create_task_band)
+/// parallel; the tasks are created when printing the code.
+static void mark_task_bands(struct clast_stmt *root, const PlutoProg *prog) {
+  for (unsigned i = 0; i < prog->ntask_bands; i++) {
+    const Ploop *loop = prog->task_bands[i]->band->loop;
+    char iter[13];
+    sprintf(iter, "t%d", loop->depth + 1);
+    int *stmtids = (int *)malloc(loop->nstmts * sizeof(int));
+    for (unsigned j = 0; j < loop->nstmts; j++) {
+      stmtids[j] = loop->stmts[j]->id + 1;
+    }
+
+    unsigned nloops, nstmts;
+    int *stmts;
+    struct clast_for **loops;
+    ClastFilter filter = {iter, stmtids, (int)loop->nstmts, subset};
+    clast_filter(root, filter, &loops, (int *)&nloops, &stmts,
+                 (int *)&nstmts);
+    if (nloops == 0) {
+      printf("[pluto] WARNING: task band loop not found in AST\n");
+    }
+    for (unsigned j = 0; j < nloops; j++) {
+      loops[j]->parallel = CLAST_PARALLEL_OMP;
+    }
+    free(stmtids);
+    free(loops);
+    free(stmts);
+  }
+}
+
+/// Clast-based parallel loop marking. Loops run by the tasks of task bands
+/// aren't parallelized.
 void pluto_mark_parallel(struct clast_stmt *root, const PlutoProg *prog,
                          CloogOptions *cloogOptions) {
   assert(root != NULL);
   unsigned nploops;
   Ploop **ploops = pluto_get_dom_parallel_loops(prog, &nploops);
-  Band **pbands = (Band **)malloc(nploops * sizeof(Band *));
   PlutoContext *context = prog->context;
   PlutoOptions *options = prog->context->options;
 
+  unsigned num = 0;
+  for (unsigned i = 0; i < nploops; i++) {
+    if (pluto_loop_get_task_band(ploops[i], prog)) {
+      pluto_loop_free(ploops[i]);
+      continue;
+    }
+    ploops[num++] = ploops[i];
+  }
+  nploops = num;
+  Band **pbands = (Band **)malloc(nploops * sizeof(Band *));
+
   IF_DEBUG(printf("[pluto_mark_parallel] parallel loops\n"););
   IF_DEBUG(pluto_loops_print(ploops, nploops););
 
@@ -124,10 +170,15 @@ void pluto_mark_parallel(struct clast_stmt *root, const PlutoProg *prog,
 
   pluto_loops_free(ploops, nploops);
   pluto_bands_free(pbands, npbands);
+
+  mark_task_bands(root, prog);
 }
 
 /// Marks loops in the cloog clast for unroll jam. Currently it marks all
-/// possible candidates. A way to restrict it must be implemented.
+/// possible candidates. A way to restrict it must be implemented. Loops whose
+/// statements were given an unroll-jam factor by the tile configuration use
+/// it; the others are unroll-jammed by the factor the register model picks
+/// for the target (at most `ufactor').
 void pluto_mark_unroll_jam(struct clast_stmt *root, const PlutoProg *prog,
                            CloogOptions *cloogOptions, unsigned ufactor) {
 
@@ -175,9 +226,21 @@ void pluto_mark_unroll_jam(struct clast_stmt *root, const PlutoProg *prog,
       free(stmts);
       continue;
     }
+    unsigned loop_ufactor = 0;
+    for (unsigned j = 0; j < ujloops[i]->nstmts; j++) {
+      loop_ufactor = PLMAX(loop_ufactor, ujloops[i]->stmts[j]->ufactor);
+    }
+    if (loop_ufactor == 0) {
+      loop_ufactor = pluto_get_unroll_jam_factor(ujloops[i], prog);
+      assert(loop_ufactor <= ufactor);
+    }
+    if (!options->silent) {
+      printf("[pluto-unroll-jam] Unroll-jam factor of t%d: %u\n",
+             ujloops[i]->depth + 1, loop_ufactor);
+    }
     for (unsigned j = 0; j < nloops; j++) {
       loops[j]->unroll_type += clast_unroll_and_jam;
-      loops[j]->ufactor = ufactor;
+      loops[j]->ufactor = loop_ufactor;
     }
     free(stmtids);
     free(loops);
@@ -197,16 +260,12 @@ void pluto_mark_vector(struct clast_stmt *root, const PlutoProg *prog,
   assert(root != NULL);
   PlutoContext *context = prog->context;
 
-  Ploop **ploops = pluto_get_parallel_loops(prog, &nploops);
+  Ploop **ploops = pluto_get_vector_loops(prog, &nploops);
 
-  IF_DEBUG(printf("[pluto_mark_vector] parallel loops\n"););
+  IF_DEBUG(printf("[pluto_mark_vector] vector loops\n"););
   IF_DEBUG(pluto_loops_print(ploops, nploops););
 
   for (i = 0; i < nploops; i++) {
-    /* Only the innermost ones */
-    if (!pluto_loop_is_innermost(ploops[i], prog))
-      continue;
-
     IF_DEBUG(printf("[pluto_mark_vector] marking loop vectorizable\n"););
     IF_DEBUG(pluto_loop_print(ploops[i]););
     char iter[13];
@@ -241,3 +300,811 @@ void pluto_mark_vector(struct clast_stmt *root, const PlutoProg *prog,
 
   pluto_loops_free(ploops, nploops);
 }
+
+/* Names created while parametrizing tile loops; clast doesn't free the names
+ * it refers to */
+typedef struct clastNames {
+  char **names;
+  unsigned num;
+} ClastNames;
+
+static char *clast_names_add(ClastNames *names, char *name) {
+  names->names =
+      (char **)realloc(names->names, (names->num + 1) * sizeof(char *));
+  names->names[names->num++] = name;
+  return name;
+}
+
+static char *clast_expr_sprint(struct clast_expr *e,
+                               CloogOptions *cloogOptions) {
+  char *buf = NULL;
+  size_t size = 0;
+  FILE *fp = open_memstream(&buf, &size);
+  clast_pprint_expr(cloogOptions, fp, e);
+  fclose(fp);
+  return buf;
+}
+
+static void append_private_var(struct clast_for *loop, const char *var) {
+  if (!(loop->parallel & CLAST_PARALLEL_OMP) || !loop->private_vars)
+    return;
+  loop->private_vars = (char *)realloc(
+      loop->private_vars, strlen(loop->private_vars) + strlen(var) + 2);
+  strcat(loop->private_vars, ",");
+  strcat(loop->private_vars, var);
+}
+
+/// Rewrites a tile loop `for (tK = LB; tK <= UB; tK++)' whose tile size is
+/// the parameter tsK into:
+///   for (tKtile = ceild(LB, tsK); tKtile <= floord(UB, tsK); tKtile++) {
+///     tK = tsK*tKtile;
+///     ...
+/// so that tK, the origin of the tile, only takes multiples of tsK.
+static void parametrize_tile_loop(struct clast_for *loop, int depth,
+                                  struct clast_for **enclosing,
+                                  unsigned nenclosing, ClastNames *names,
+                                  CloogOptions *cloogOptions) {
+  assert(cloog_int_is_one(loop->stride));
+
+  char ts[16], tile_iter[24];
+  sprintf(ts, "ts%d", depth);
+  sprintf(tile_iter, "t%dtile", depth);
+
+  char *lb = clast_expr_sprint(loop->LB, cloogOptions);
+  char *ub = clast_expr_sprint(loop->UB, cloogOptions);
+  char *new_lb = (char *)malloc(strlen(lb) + strlen(ts) + 16);
+  char *new_ub = (char *)malloc(strlen(ub) + strlen(ts) + 16);
+  sprintf(new_lb, "ceild(%s,%s)", lb, ts);
+  sprintf(new_ub, "floord(%s,%s)", ub, ts);
+  free(lb);
+  free(ub);
+
+  free_clast_expr(loop->LB);
+  free_clast_expr(loop->UB);
+  loop->LB = &new_clast_name(clast_names_add(names, new_lb))->expr;
+  loop->UB = &new_clast_name(clast_names_add(names, new_ub))->expr;
+
+  char *origin = (char *)malloc(strlen(ts) + strlen(tile_iter) + 2);
+  sprintf(origin, "%s*%s", ts, tile_iter);
+  struct clast_assignment *assign = new_clast_assignment(
+      loop->iterator, &new_clast_name(clast_names_add(names, origin))->expr);
+  assign->stmt.next = loop->body;
+  loop->body = &assign->stmt;
+
+  /* The tile origin is assigned in the loop body and the tile index is a new
+   * loop iterator */
+  append_private_var(loop, loop->iterator);
+  for (unsigned i = 0; i < nenclosing; i++) {
+    append_private_var(enclosing[i], tile_iter);
+  }
+  loop->iterator = clast_names_add(names, strdup(tile_iter));
+}
+
+static void parametrize_tile_loops(struct clast_stmt *s, const int *tile_sizes,
+                                   unsigned num_hyperplanes,
+                                   struct clast_for **enclosing,
+                                   unsigned nenclosing, ClastNames *names,
+                                   CloogOptions *cloogOptions) {
+  for (; s; s = s->next) {
+    if (CLAST_STMT_IS_A(s, stmt_for)) {
+      struct clast_for *loop = (struct clast_for *)s;
+      int depth, len;
+      if (sscanf(loop->iterator, "t%d%n", &depth, &len) == 1 &&
+          loop->iterator[len] == '\0' && depth >= 1 &&
+          depth <= (int)num_hyperplanes && tile_sizes[depth - 1] > 0) {
+        parametrize_tile_loop(loop, depth, enclosing, nenclosing, names,
+                              cloogOptions);
+      }
+      assert(nenclosing < num_hyperplanes);
+      enclosing[nenclosing] = loop;
+      parametrize_tile_loops(loop->body, tile_sizes, num_hyperplanes,
+                             enclosing, nenclosing + 1, names, cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_guard)) {
+      parametrize_tile_loops(((struct clast_guard *)s)->then, tile_sizes,
+                             num_hyperplanes, enclosing, nenclosing, names,
+                             cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_block)) {
+      parametrize_tile_loops(((struct clast_block *)s)->body, tile_sizes,
+                             num_hyperplanes, enclosing, nenclosing, names,
+                             cloogOptions);
+    }
+  }
+}
+
+/// Makes the tile loops whose tile sizes are parameters (--parametric-tiles)
+/// step over multiples of their tile sizes. The names the rewritten AST
+/// refers to are returned in `names' (to be freed by the caller once the AST
+/// is freed); returns their number.
+unsigned pluto_parametrize_tile_loops(struct clast_stmt *root,
+                                      const PlutoProg *prog,
+                                      CloogOptions *cloogOptions,
+                                      char ***names) {
+  assert(root != NULL);
+  ClastNames clast_names = {NULL, 0};
+  int tile_sizes[prog->num_hyperplanes];
+
+  if (pluto_get_parametric_tile_sizes(prog, tile_sizes) > 0) {
+    struct clast_for *enclosing[prog->num_hyperplanes];
+    parametrize_tile_loops(root, tile_sizes, prog->num_hyperplanes, enclosing,
+                           0, &clast_names, cloogOptions);
+  }
+  *names = clast_names.names;
+  return clast_names.num;
+}
+
+/// Adds the statements run under `s' (and the statements following it) to
+/// `loop'.
+static void add_clast_stmts(struct clast_stmt *s, Ploop *loop,
+                            const PlutoProg *prog) {
+  for (; s; s = s->next) {
+    if (CLAST_STMT_IS_A(s, stmt_user)) {
+      Stmt *stmt =
+          prog->stmts[((struct clast_user_stmt *)s)->statement->number - 1];
+      if (!pluto_stmt_is_member_of(stmt->id, loop->stmts, loop->nstmts)) {
+        loop->stmts = (Stmt **)realloc(loop->stmts,
+                                       (loop->nstmts + 1) * sizeof(Stmt *));
+        loop->stmts[loop->nstmts++] = stmt;
+      }
+    } else if (CLAST_STMT_IS_A(s, stmt_for)) {
+      add_clast_stmts(((struct clast_for *)s)->body, loop, prog);
+    } else if (CLAST_STMT_IS_A(s, stmt_guard)) {
+      add_clast_stmts(((struct clast_guard *)s)->then, loop, prog);
+    } else if (CLAST_STMT_IS_A(s, stmt_block)) {
+      add_clast_stmts(((struct clast_block *)s)->body, loop, prog);
+    }
+  }
+}
+
+/// Returns the poly loop over the statements `for_loop' runs, or NULL if its
+/// iterator isn't a schedule dimension.
+static Ploop *get_clast_poly_loop(const struct clast_for *for_loop,
+                                  const PlutoProg *prog) {
+  int depth;
+  if (sscanf(for_loop->iterator, "t%d", &depth) != 1)
+    return NULL;
+  Ploop *loop = pluto_loop_alloc();
+  loop->depth = depth - 1;
+  add_clast_stmts(for_loop->body, loop, prog);
+  return loop;
+}
+
+/// Appends the loops under `s' marked with `flag' to `loops' (as poly loops)
+/// and to `for_loops' (as they are in the AST), where not NULL.
+static void get_clast_marked_loops(struct clast_stmt *s, const PlutoProg *prog,
+                                   int flag, Ploop ***loops,
+                                   struct clast_for ***for_loops,
+                                   unsigned *num) {
+  for (; s; s = s->next) {
+    if (CLAST_STMT_IS_A(s, stmt_for)) {
+      struct clast_for *for_loop = (struct clast_for *)s;
+      Ploop *loop;
+      if ((for_loop->parallel & flag) &&
+          (loop = get_clast_poly_loop(for_loop, prog))) {
+        if (loops) {
+          *loops = (Ploop **)realloc(*loops, (*num + 1) * sizeof(Ploop *));
+          (*loops)[*num] = loop;
+        } else {
+          pluto_loop_free(loop);
+        }
+        if (for_loops) {
+          *for_loops = (struct clast_for **)realloc(
+              *for_loops, (*num + 1) * sizeof(struct clast_for *));
+          (*for_loops)[*num] = for_loop;
+        }
+        (*num)++;
+      }
+      get_clast_marked_loops(for_loop->body, prog, flag, loops, for_loops,
+                             num);
+    } else if (CLAST_STMT_IS_A(s, stmt_guard)) {
+      get_clast_marked_loops(((struct clast_guard *)s)->then, prog, flag,
+                             loops, for_loops, num);
+    } else if (CLAST_STMT_IS_A(s, stmt_block)) {
+      get_clast_marked_loops(((struct clast_block *)s)->body, prog, flag,
+                             loops, for_loops, num);
+    }
+  }
+}
+
+/// Returns the loops of the AST marked with `flag' (CLAST_PARALLEL_VEC or
+/// CLAST_PARALLEL_OMP; after unroll-jamming, the copies of a loop included),
+/// in the order CLooG prints them, as poly loops over the statements they
+/// run.
+Ploop **pluto_get_clast_marked_loops(struct clast_stmt *root,
+                                     const PlutoProg *prog, int flag,
+                                     unsigned *num) {
+  Ploop **loops = NULL;
+  *num = 0;
+  get_clast_marked_loops(root, prog, flag, &loops, NULL, num);
+  return loops;
+}
+
+/// Checks if `text' has the identifier `name' in it. The names created by
+/// the rewrites in this file hold whole expressions.
+static bool text_uses_name(const char *text, const char *name) {
+  size_t len = strlen(name);
+  for (const char *p = strstr(text, name); p; p = strstr(p + 1, name)) {
+    if ((p == text || !(isalnum(p[-1]) || p[-1] == '_')) &&
+        !(isalnum(p[len]) || p[len] == '_'))
+      return true;
+  }
+  return false;
+}
+
+/// Checks if the expression `e' refers to `name'.
+static bool clast_expr_uses_name(const struct clast_expr *e,
+                                 const char *name) {
+  switch (e->type) {
+  case clast_expr_name:
+    return text_uses_name(((const struct clast_name *)e)->name, name);
+  case clast_expr_term: {
+    const struct clast_term *term = (const struct clast_term *)e;
+    return term->var && clast_expr_uses_name(term->var, name);
+  }
+  case clast_expr_bin:
+    return clast_expr_uses_name(((const struct clast_binary *)e)->LHS, name);
+  case clast_expr_red: {
+    const struct clast_reduction *red = (const struct clast_reduction *)e;
+    for (int i = 0; i < red->n; i++) {
+      if (clast_expr_uses_name(red->elts[i], name))
+        return true;
+    }
+    return false;
+  }
+  }
+  return false;
+}
+
+/// Returns the number of loops, starting with the parallel loop `for_loop',
+/// that can be collapsed into one (OpenMP's collapse): each loop after the
+/// first is all the body of the one before, is parallel with no reduction,
+/// has a unit stride and isn't marked otherwise, and its bounds don't refer
+/// to the iterators of the loops before, since collapsed loops must be
+/// rectangular.
+static unsigned get_clast_collapse_count(const struct clast_for *for_loop,
+                                         const PlutoProg *prog) {
+  const struct clast_for *loops[prog->num_hyperplanes + 1];
+  unsigned count = 1;
+  loops[0] = for_loop;
+  while (count <= prog->num_hyperplanes) {
+    const struct clast_stmt *body = loops[count - 1]->body;
+    if (!body || body->next || !CLAST_STMT_IS_A(body, stmt_for))
+      break;
+    const struct clast_for *inner = (const struct clast_for *)body;
+    if (inner->parallel != CLAST_PARALLEL_NOT || !inner->LB || !inner->UB ||
+        !cloog_int_is_one(inner->stride))
+      break;
+    unsigned k;
+    for (k = 0; k < count; k++) {
+      if (clast_expr_uses_name(inner->LB, loops[k]->iterator) ||
+          clast_expr_uses_name(inner->UB, loops[k]->iterator))
+        break;
+    }
+    if (k < count)
+      break;
+    Ploop *loop = get_clast_poly_loop(inner, prog);
+    if (!loop)
+      break;
+    char *clause = NULL;
+    bool parallel = pluto_loop_is_parallel(prog, loop) &&
+                    pluto_loop_get_reduction_clause(loop, prog, &clause) &&
+                    !clause;
+    free(clause);
+    pluto_loop_free(loop);
+    if (!parallel)
+      break;
+    loops[count++] = inner;
+  }
+  return count;
+}
+
+/// Returns, for each loop of the AST marked CLAST_PARALLEL_OMP (in the order
+/// of pluto_get_clast_marked_loops), the number of loops it can be collapsed
+/// with (see get_clast_collapse_count), 1 if none.
+unsigned *pluto_get_clast_collapse_counts(struct clast_stmt *root,
+                                          const PlutoProg *prog,
+                                          unsigned *num) {
+  struct clast_for **for_loops = NULL;
+  *num = 0;
+  get_clast_marked_loops(root, prog, CLAST_PARALLEL_OMP, NULL, &for_loops,
+                         num);
+  unsigned *counts = (unsigned *)malloc(*num * sizeof(unsigned));
+  for (unsigned i = 0; i < *num; i++) {
+    counts[i] = get_clast_collapse_count(for_loops[i], prog);
+  }
+  free(for_loops);
+  return counts;
+}
+
+/// Returns k if `d' is 2^k with k >= 1, -1 otherwise.
+static int get_pow2_exponent(long d) {
+  if (d < 2 || (d & (d - 1)))
+    return -1;
+  int k = 0;
+  while (d > 1) {
+    d >>= 1;
+    k++;
+  }
+  return k;
+}
+
+/// Rewrites the floord, ceild and exact divisions in `e' by powers of two
+/// into arithmetic right shifts: floord(x,2^k) is x>>k and ceild(x,2^k) is
+/// (x+2^k-1)>>k, negative x included. Returns the rewritten expression.
+static struct clast_expr *shift_divisions(struct clast_expr *e,
+                                          ClastNames *names,
+                                          CloogOptions *cloogOptions) {
+  switch (e->type) {
+  case clast_expr_term: {
+    struct clast_term *term = (struct clast_term *)e;
+    if (term->var)
+      term->var = shift_divisions(term->var, names, cloogOptions);
+    return e;
+  }
+  case clast_expr_red: {
+    struct clast_reduction *red = (struct clast_reduction *)e;
+    for (int i = 0; i < red->n; i++) {
+      red->elts[i] = shift_divisions(red->elts[i], names, cloogOptions);
+    }
+    return e;
+  }
+  case clast_expr_bin: {
+    struct clast_binary *bin = (struct clast_binary *)e;
+    bin->LHS = shift_divisions(bin->LHS, names, cloogOptions);
+    int k = bin->type == clast_bin_mod
+                ? -1
+                : get_pow2_exponent(cloog_int_get_si(bin->RHS));
+    if (k < 0)
+      return e;
+    char *lhs = clast_expr_sprint(bin->LHS, cloogOptions);
+    char *shift = (char *)malloc(strlen(lhs) + 32);
+    if (bin->type == clast_bin_cdiv) {
+      sprintf(shift, "(((%s)+%ld)>>%d)", lhs, (1L << k) - 1, k);
+    } else {
+      sprintf(shift, "((%s)>>%d)", lhs, k);
+    }
+    free(lhs);
+    free_clast_expr(e);
+    return &new_clast_name(clast_names_add(names, shift))->expr;
+  }
+  default:
+    return e;
+  }
+}
+
+/// Applies shift_divisions to all the expressions of the AST under `s'.
+static void shift_stmt_divisions(struct clast_stmt *s, ClastNames *names,
+                                 CloogOptions *cloogOptions) {
+  for (; s; s = s->next) {
+    if (CLAST_STMT_IS_A(s, stmt_for)) {
+      struct clast_for *loop = (struct clast_for *)s;
+      if (loop->LB)
+        loop->LB = shift_divisions(loop->LB, names, cloogOptions);
+      if (loop->UB)
+        loop->UB = shift_divisions(loop->UB, names, cloogOptions);
+      shift_stmt_divisions(loop->body, names, cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_guard)) {
+      struct clast_guard *guard = (struct clast_guard *)s;
+      for (int i = 0; i < guard->n; i++) {
+        guard->eq[i].LHS = shift_divisions(guard->eq[i].LHS, names,
+                                           cloogOptions);
+        guard->eq[i].RHS = shift_divisions(guard->eq[i].RHS, names,
+                                           cloogOptions);
+      }
+      shift_stmt_divisions(guard->then, names, cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_block)) {
+      shift_stmt_divisions(((struct clast_block *)s)->body, names,
+                           cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_ass)) {
+      struct clast_assignment *assign = (struct clast_assignment *)s;
+      assign->RHS = shift_divisions(assign->RHS, names, cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_user)) {
+      shift_stmt_divisions(((struct clast_user_stmt *)s)->substitutions,
+                           names, cloogOptions);
+    }
+  }
+}
+
+/// Full tiles separated from partial ones: the names created, the number of
+/// tiles (which numbers the variables declared), and the innermost loops of
+/// the full tiles, whose bodies are shared with the partial tiles.
+typedef struct clastTileSplits {
+  ClastNames names;
+  unsigned max_depth;
+  unsigned ntiles;
+  struct clast_for **full_tiles;
+  unsigned nfull_tiles;
+} ClastTileSplits;
+
+/// Returns the bounds `*bound' is made of: the elements of the reduction
+/// `type' if it is one (max for lower bounds, min for upper bounds),
+/// `*bound' itself otherwise.
+static struct clast_expr *const *get_bound_elts(struct clast_expr *const *bound,
+                                                int type, int *n) {
+  if ((*bound)->type == clast_expr_red &&
+      ((const struct clast_reduction *)*bound)->type == type) {
+    const struct clast_reduction *red =
+        (const struct clast_reduction *)*bound;
+    *n = red->n;
+    return red->elts;
+  }
+  *n = 1;
+  return bound;
+}
+
+/// Checks if `e' is affine (no min, max, division or modulo), i.e., cheap
+/// enough to leave in a loop bound.
+static bool clast_expr_is_affine(const struct clast_expr *e) {
+  switch (e->type) {
+  case clast_expr_name: {
+    const char *name = ((const struct clast_name *)e)->name;
+    for (; *name; name++) {
+      if (!isalnum(*name) && *name != '_')
+        return false;
+    }
+    return true;
+  }
+  case clast_expr_term: {
+    const struct clast_term *term = (const struct clast_term *)e;
+    return !term->var || clast_expr_is_affine(term->var);
+  }
+  case clast_expr_red: {
+    const struct clast_reduction *red = (const struct clast_reduction *)e;
+    if (red->type != clast_red_sum)
+      return false;
+    for (int i = 0; i < red->n; i++) {
+      if (!clast_expr_is_affine(red->elts[i]))
+        return false;
+    }
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+/// Finds the tile box among the bounds of the point loop `loop': a lower
+/// bound T*tK and an upper bound T*tK+T-1 with T > 1, tK being the iterator
+/// of one of the `nenclosing' loops enclosing the tile. The conditions under
+/// which the other bounds are redundant (the tile is full along `loop') are
+/// appended to `conds'; they must not refer to the iterators of the `nchain'
+/// point loops of the tile enclosing `loop'. Returns false if there is no
+/// such box.
+static bool get_tile_box(const struct clast_for *loop,
+                         struct clast_for **enclosing, unsigned nenclosing,
+                         struct clast_for **chain, unsigned nchain,
+                         char **box_lb, char **box_ub, char ***conds,
+                         unsigned *nconds, CloogOptions *cloogOptions) {
+  if (!loop->LB || !loop->UB || !cloog_int_is_one(loop->stride))
+    return false;
+
+  int nlbs, nubs;
+  struct clast_expr *const *lbs =
+      get_bound_elts(&loop->LB, clast_red_max, &nlbs);
+  struct clast_expr *const *ubs =
+      get_bound_elts(&loop->UB, clast_red_min, &nubs);
+  char *lb_strs[nlbs], *ub_strs[nubs];
+  for (int i = 0; i < nlbs; i++) {
+    lb_strs[i] = clast_expr_sprint(lbs[i], cloogOptions);
+  }
+  for (int i = 0; i < nubs; i++) {
+    ub_strs[i] = clast_expr_sprint(ubs[i], cloogOptions);
+  }
+
+  int lb = -1, ub = -1;
+  for (int i = 0; i < nlbs && ub < 0; i++) {
+    int tile_size, len;
+    char iter[32];
+    if (sscanf(lb_strs[i], "%d*%31[A-Za-z0-9_]%n", &tile_size, iter, &len) !=
+            2 ||
+        lb_strs[i][len] != '\0' || tile_size < 2)
+      continue;
+    unsigned k;
+    for (k = 0; k < nenclosing; k++) {
+      if (!strcmp(enclosing[k]->iterator, iter))
+        break;
+    }
+    if (k == nenclosing)
+      continue;
+    char box[64];
+    snprintf(box, sizeof(box), "%d*%s+%d", tile_size, iter, tile_size - 1);
+    for (int j = 0; j < nubs; j++) {
+      if (!strcmp(ub_strs[j], box)) {
+        lb = i;
+        ub = j;
+        break;
+      }
+    }
+  }
+
+  bool found = ub >= 0;
+  for (int i = 0; i < nlbs + nubs && found; i++) {
+    struct clast_expr *e = i < nlbs ? lbs[i] : ubs[i - nlbs];
+    for (unsigned k = 0; k < nchain; k++) {
+      if (clast_expr_uses_name(e, chain[k]->iterator))
+        found = false;
+    }
+  }
+  if (found) {
+    *box_lb = strdup(lb_strs[lb]);
+    *box_ub = strdup(ub_strs[ub]);
+    for (int i = 0; i < nlbs + nubs; i++) {
+      if (i == lb || i == nlbs + ub)
+        continue;
+      const char *box = i < nlbs ? lb_strs[lb] : ub_strs[ub];
+      const char *bound = i < nlbs ? lb_strs[i] : ub_strs[i - nlbs];
+      char *cond = (char *)malloc(strlen(box) + strlen(bound) + 8);
+      sprintf(cond, "(%s %s %s)", box, i < nlbs ? ">=" : "<=", bound);
+      unsigned c;
+      for (c = 0; c < *nconds; c++) {
+        if (!strcmp((*conds)[c], cond))
+          break;
+      }
+      if (c < *nconds) {
+        free(cond);
+        continue;
+      }
+      *conds = (char **)realloc(*conds, (*nconds + 1) * sizeof(char *));
+      (*conds)[(*nconds)++] = cond;
+    }
+  }
+
+  for (int i = 0; i < nlbs; i++) {
+    free(lb_strs[i]);
+  }
+  for (int i = 0; i < nubs; i++) {
+    free(ub_strs[i]);
+  }
+  return found;
+}
+
+/// Returns a new clast_name for `text' (kept in `names').
+static struct clast_expr *new_name_expr(ClastNames *names, char *text) {
+  return &new_clast_name(clast_names_add(names, text))->expr;
+}
+
+/// Replaces the bound `*bound' of a point loop of a partial tile, if it
+/// isn't affine, by a variable assigned before the tile; the assignment is
+/// appended to `*hoisted'.
+static void hoist_bound(struct clast_expr **bound, const char *prefix,
+                        unsigned tile, ClastTileSplits *splits,
+                        struct clast_assignment ***hoisted,
+                        unsigned *nhoisted) {
+  if (clast_expr_is_affine(*bound))
+    return;
+  char var[32], decl[40];
+  snprintf(var, sizeof(var), "%s%u_%u", prefix, tile, *nhoisted);
+  snprintf(decl, sizeof(decl), "int %s", var);
+  struct clast_assignment *assign =
+      new_clast_assignment(clast_names_add(&splits->names, strdup(decl)),
+                           *bound);
+  *bound = new_name_expr(&splits->names, strdup(var));
+  *hoisted = (struct clast_assignment **)realloc(
+      *hoisted, (*nhoisted + 1) * sizeof(struct clast_assignment *));
+  (*hoisted)[(*nhoisted)++] = assign;
+}
+
+static bool separate_full_tiles(struct clast_stmt **link,
+                                struct clast_for **enclosing,
+                                unsigned nenclosing, ClastTileSplits *splits,
+                                CloogOptions *cloogOptions);
+
+/// Separates the full tiles of the tile whose outermost point loop is
+/// `*link' (nested in the loops `enclosing') from its partial ones, if its
+/// point loops have a tile box (see get_tile_box) and there are no tiles
+/// inside. The point loops that are perfectly nested in it and have a box
+/// too are rewritten into:
+///   int fullN = <the other bounds are redundant>;
+///   if (fullN == 1) {
+///     for (tP = T*tK; tP <= T*tK+T-1; tP++) ... <body>
+///   }
+///   if (fullN == 0) {
+///     int lbN_0 = ..., ubN_0 = ...;
+///     for (tP = <original bounds>) ... <body>
+///   }
+/// where the non-affine bounds of the inner point loops of the partial tile
+/// are computed once per tile before them, since they only depend on the
+/// tile. The loops of the full tile are new; <body> is shared. `*link' is
+/// advanced to the link of the partial tile. Returns false if `*link' isn't
+/// the outermost point loop of a tile.
+static bool separate_full_tile(struct clast_stmt ***link,
+                               struct clast_for **enclosing,
+                               unsigned nenclosing, ClastTileSplits *splits,
+                               CloogOptions *cloogOptions) {
+  struct clast_for *loop = (struct clast_for *)**link;
+  struct clast_for **chain = NULL;
+  char **box_lbs = NULL, **box_ubs = NULL, **conds = NULL;
+  unsigned nchain = 0, nconds = 0;
+
+  while (loop) {
+    char *box_lb, *box_ub;
+    if (!get_tile_box(loop, enclosing, nenclosing, chain, nchain, &box_lb,
+                      &box_ub, &conds, &nconds, cloogOptions))
+      break;
+    chain = (struct clast_for **)realloc(
+        chain, (nchain + 1) * sizeof(struct clast_for *));
+    box_lbs = (char **)realloc(box_lbs, (nchain + 1) * sizeof(char *));
+    box_ubs = (char **)realloc(box_ubs, (nchain + 1) * sizeof(char *));
+    chain[nchain] = loop;
+    box_lbs[nchain] = box_lb;
+    box_ubs[nchain++] = box_ub;
+    struct clast_stmt *body = loop->body;
+    loop = (body && !body->next && CLAST_STMT_IS_A(body, stmt_for))
+               ? (struct clast_for *)body
+               : NULL;
+  }
+
+  /* Only the innermost tiles are separated */
+  bool inner_tiles = false;
+  if (nchain > 0) {
+    for (unsigned i = 0; i < nchain; i++) {
+      assert(nenclosing + i <= splits->max_depth);
+      enclosing[nenclosing + i] = chain[i];
+    }
+    inner_tiles = separate_full_tiles(&chain[nchain - 1]->body, enclosing,
+                                      nenclosing + nchain, splits,
+                                      cloogOptions);
+  }
+
+  if (nchain == 0 || nconds == 0 || inner_tiles) {
+    /* Not a tile, a tile that is always full, or one with tiles inside */
+    for (unsigned c = 0; c < nconds; c++) {
+      free(conds[c]);
+    }
+    free(conds);
+    for (unsigned i = 0; i < nchain; i++) {
+      free(box_lbs[i]);
+      free(box_ubs[i]);
+    }
+    free(box_lbs);
+    free(box_ubs);
+    free(chain);
+    return nchain > 0;
+  }
+
+  unsigned tile = splits->ntiles++;
+  size_t len = 1;
+  for (unsigned c = 0; c < nconds; c++) {
+    len += strlen(conds[c]) + 4;
+  }
+  char *cond = (char *)malloc(len);
+  cond[0] = '\0';
+  for (unsigned c = 0; c < nconds; c++) {
+    if (c > 0)
+      strcat(cond, " && ");
+    strcat(cond, conds[c]);
+    free(conds[c]);
+  }
+  free(conds);
+
+  char flag[32], decl[40];
+  snprintf(flag, sizeof(flag), "full%u", tile);
+  snprintf(decl, sizeof(decl), "int %s", flag);
+  struct clast_assignment *assign =
+      new_clast_assignment(clast_names_add(&splits->names, strdup(decl)),
+                           new_name_expr(&splits->names, cond));
+
+  /* The full tile */
+  struct clast_for *full = NULL;
+  for (int i = nchain - 1; i >= 0; i--) {
+    struct clast_for *point = chain[i];
+    struct clast_for *full_point = new_clast_for(
+        point->domain, point->iterator,
+        new_name_expr(&splits->names, box_lbs[i]),
+        new_name_expr(&splits->names, box_ubs[i]), NULL);
+    full_point->parallel = point->parallel;
+    full_point->private_vars =
+        point->private_vars ? strdup(point->private_vars) : NULL;
+    full_point->unroll_type = point->unroll_type;
+    full_point->ufactor = point->ufactor;
+    if (full) {
+      full_point->body = &full->stmt;
+    } else {
+      full_point->body = point->body;
+      splits->full_tiles = (struct clast_for **)realloc(
+          splits->full_tiles,
+          (splits->nfull_tiles + 1) * sizeof(struct clast_for *));
+      splits->full_tiles[splits->nfull_tiles++] = full_point;
+    }
+    full = full_point;
+  }
+  free(box_lbs);
+  free(box_ubs);
+
+  /* The partial tile */
+  struct clast_assignment **hoisted = NULL;
+  unsigned nhoisted = 0;
+  for (unsigned i = 1; i < nchain; i++) {
+    hoist_bound(&chain[i]->LB, "lb", tile, splits, &hoisted, &nhoisted);
+    hoist_bound(&chain[i]->UB, "ub", tile, splits, &hoisted, &nhoisted);
+  }
+  struct clast_stmt *partial = &chain[0]->stmt;
+  for (int i = nhoisted - 1; i >= 0; i--) {
+    hoisted[i]->stmt.next = partial;
+    partial = &hoisted[i]->stmt;
+  }
+  free(hoisted);
+
+  struct clast_guard *full_guard = new_clast_guard(&full->stmt, 1);
+  full_guard->eq[0].LHS = new_name_expr(&splits->names, strdup(flag));
+  full_guard->eq[0].RHS = new_name_expr(&splits->names, strdup("1"));
+  full_guard->eq[0].sign = 0;
+  struct clast_guard *partial_guard = new_clast_guard(partial, 1);
+  partial_guard->eq[0].LHS = new_name_expr(&splits->names, strdup(flag));
+  partial_guard->eq[0].RHS = new_name_expr(&splits->names, strdup("0"));
+  partial_guard->eq[0].sign = 0;
+
+  partial_guard->stmt.next = chain[0]->stmt.next;
+  chain[0]->stmt.next = NULL;
+  full_guard->stmt.next = &partial_guard->stmt;
+  assign->stmt.next = &full_guard->stmt;
+  **link = &assign->stmt;
+  *link = &full_guard->stmt.next;
+  free(chain);
+  return true;
+}
+
+/// Separates the full tiles of the innermost tiles under `*link' from their
+/// partial ones (see separate_full_tile). Returns true if there are tiles.
+static bool separate_full_tiles(struct clast_stmt **link,
+                                struct clast_for **enclosing,
+                                unsigned nenclosing, ClastTileSplits *splits,
+                                CloogOptions *cloogOptions) {
+  bool found = false;
+  for (; *link; link = &(*link)->next) {
+    struct clast_stmt *s = *link;
+    if (CLAST_STMT_IS_A(s, stmt_for)) {
+      struct clast_for *loop = (struct clast_for *)s;
+      if (separate_full_tile(&link, enclosing, nenclosing, splits,
+                             cloogOptions)) {
+        found = true;
+        continue;
+      }
+      assert(nenclosing <= splits->max_depth);
+      enclosing[nenclosing] = loop;
+      found |= separate_full_tiles(&loop->body, enclosing, nenclosing + 1,
+                                   splits, cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_guard)) {
+      found |= separate_full_tiles(&((struct clast_guard *)s)->then,
+                                   enclosing, nenclosing, splits,
+                                   cloogOptions);
+    } else if (CLAST_STMT_IS_A(s, stmt_block)) {
+      found |= separate_full_tiles(&((struct clast_block *)s)->body,
+                                   enclosing, nenclosing, splits,
+                                   cloogOptions);
+    }
+  }
+  return found;
+}
+
+/// Cuts down the bound arithmetic of tiled code (--full-tiles): divisions by
+/// powers of two become shifts, and the innermost tiles are separated into
+/// full tiles, whose point loops have constant trip counts, and partial
+/// ones, whose non-affine point loop bounds are computed once per tile (see
+/// separate_full_tile). The names the rewritten AST refers to are appended
+/// to the `num_names' names of `names' (to be freed by the caller once the
+/// AST is freed); returns their new number. The innermost loops of the full
+/// tiles are returned in `full_tiles': their bodies are shared with the
+/// partial tiles, and must be set to NULL before the AST is freed.
+unsigned pluto_separate_full_tiles(struct clast_stmt *root,
+                                   const PlutoProg *prog,
+                                   CloogOptions *cloogOptions, char ***names,
+                                   unsigned num_names,
+                                   struct clast_for ***full_tiles,
+                                   unsigned *num_full_tiles) {
+  assert(root != NULL);
+  ClastTileSplits splits = {{*names, num_names}, prog->num_hyperplanes, 0,
+                            NULL, 0};
+  struct clast_for *enclosing[prog->num_hyperplanes + 1];
+
+  shift_stmt_divisions(root, &splits.names, cloogOptions);
+  separate_full_tiles(&root, enclosing, 0, &splits, cloogOptions);
+
+  if (!prog->context->options->silent) {
+    printf("[pluto] Full tiles separated from partial ones in %u tile(s)\n",
+           splits.ntiles);
+  }
+  *names = splits.names.names;
+  *full_tiles = splits.full_tiles;
+  *num_full_tiles = splits.nfull_tiles;
+  return splits.names.num;
+}
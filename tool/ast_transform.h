@@ -4,6 +4,7 @@
 #include "cloog/cloog.h"
 
 typedef struct plutoProg PlutoProg;
+typedef struct pLoop Ploop;
 
 void pluto_mark_parallel(struct clast_stmt *root, const PlutoProg *prog,
                          CloogOptions *options);
@@ -11,4 +12,19 @@ void pluto_mark_vector(struct clast_stmt *root, const PlutoProg *prog,
                        CloogOptions *options);
 void pluto_mark_unroll_jam(struct clast_stmt *root, const PlutoProg *prog,
                            CloogOptions *options, unsigned ufactor);
+unsigned pluto_parametrize_tile_loops(struct clast_stmt *root,
+                                      const PlutoProg *prog,
+                                      CloogOptions *options, char ***names);
+unsigned pluto_separate_full_tiles(struct clast_stmt *root,
+                                   const PlutoProg *prog,
+                                   CloogOptions *cloogOptions, char ***names,
+                                   unsigned num_names,
+                                   struct clast_for ***full_tiles,
+                                   unsigned *num_full_tiles);
+Ploop **pluto_get_clast_marked_loops(struct clast_stmt *root,
+                                     const PlutoProg *prog, int flag,
+                                     unsigned *num);
+unsigned *pluto_get_clast_collapse_counts(struct clast_stmt *root,
+                                          const PlutoProg *prog,
+                                          unsigned *num);
 #endif // AST_TRANSFORM_H
@@ -29,7 +29,11 @@
 #include "pluto.h"
 #include "pluto/pluto.h"
 #include "post_transform.h"
+#include "pluto_tune.h"
 #include "program.h"
+#include "reduction.h"
+#include "target.h"
+#include "tile_size_selection_model.h"
 #include "transforms.h"
 #include "version.h"
 
@@ -89,13 +93,76 @@ void usage_message(void) {
                   "execution order for locality [enabled by default]\n");
   fprintf(stdout, "       --second-level-tile       Tile a second time "
                   "(typically for L2 cache) [disabled by default] \n");
+  fprintf(stdout, "       --tile-levels=<n>       Tile n times, each level "
+                  "tiling the tile space loops of the previous one\n"
+                  "                                 (e.g., L1, L2, L3, "
+                  "socket) [default 1]\n");
+  fprintf(stdout, "       --parallel-tile-level=<n>  Parallelize the tile "
+                  "loops of level n (1 for the innermost tiles), with a\n"
+                  "                                 wavefront if needed; "
+                  "outer levels run sequentially [default: outermost]\n");
+  fprintf(stdout, "       --parametric-tiles        Keep tile sizes as "
+                  "variables (tsK for loop tK) in the generated code;\n"
+                  "                                 settable at run time with "
+                  "PLUTO_TILE_SIZES=<s1>,<s2>,... Disables diamond\n"
+                  "                                 tiling and wavefronts of "
+                  "tiles; one level of tiling only\n");
+  fprintf(stdout, "       --full-tiles              Separate full tiles "
+                  "from partial ones in the CLooG\n"
+                  "                                 output, with bounds "
+                  "computed once per partial tile and\n"
+                  "                                 shifts for power-of-two "
+                  "tile sizes\n");
   fprintf(stdout, "       --determine-tile-size    Choose tile sizes using a "
-                  "tile size selection model\n");
+                  "tile size selection model; with -o, the sizes chosen\n"
+                  "                                 are written next to the "
+                  "output (<output without .c>.tiles) for --tile-config\n");
+  fprintf(stdout, "       --exact-tile-footprint  With --determine-tile-size, "
+                  "count the data elements accessed by a tile\n"
+                  "                                 exactly instead of "
+                  "estimating them from dimensional reuse\n");
+  fprintf(stdout, "       --tile-config=<file>    Tile sizes, unroll-jam "
+                  "factors and vector lengths per band (instead of\n"
+                  "                                 tile.sizes); see "
+                  "lib/tile_config.h for the format\n");
+  fprintf(stdout, "       --save-tile-config=<file>  File the tile sizes "
+                  "found by --determine-tile-size or --tune are\n"
+                  "                                 written to (default "
+                  "<output without .c>.tiles with -o)\n");
   fprintf(stdout,
           "       --cache-size=<value>    Cache size per core in "
-          "bytes for first level of tiling. Default 1MB (L2 cache size))\n");
+          "bytes for first level of tiling. Default: detected from sysfs, "
+          "else 1MB (L2 cache size))\n");
   fprintf(stdout, "       --data-element-size=<value>  Size of each data "
-                  "element in bytes. Default sizeof(double)\n");
+                  "element in bytes. Default: largest array element type "
+                  "with --pet, else sizeof(double)\n");
+  fprintf(stdout, "       --cache-levels=<size>[:<line>[:<assoc>[:<shared>]]]"
+                  ",...\n"
+                  "                                 Cache hierarchy (L1 first) "
+                  "for tile size selection: size and line size in bytes,\n"
+                  "                                 ways (0 for fully "
+                  "associative), cores sharing it. Overrides --cache-size. "
+                  "Default: detected from sysfs\n");
+  fprintf(stdout, "       --num-threads=<n>       Number of threads to select "
+                  "tile sizes for. Default: OMP_NUM_THREADS if set\n");
+  fprintf(stdout, "       --parallel-slack=<n>    Minimum number of tiles per "
+                  "thread along parallel dimensions with --determine-tile-size "
+                  "(default 2)\n");
+  fprintf(stdout, "       --tune                    Empirically tune tile "
+                  "sizes: variants are compiled with $CC $CFLAGS $LDFLAGS and "
+                  "run;\n"
+                  "                                 the best sizes are written "
+                  "as with --determine-tile-size (use pluto-tune)\n");
+  fprintf(stdout, "       --tune-strategy=<s>     Search strategy: random, "
+                  "coordinate (default) or nelder-mead\n");
+  fprintf(stdout, "       --tune-evals=<n>        Maximum number of variants "
+                  "to run (default 50)\n");
+  fprintf(stdout, "       --tune-jobs=<n>         Number of variants built "
+                  "in parallel (default 4)\n");
+  fprintf(stdout, "       --tune-reps=<n>         Runs per variant; the "
+                  "fastest is kept (default 3)\n");
+  fprintf(stdout, "       --tune-db=<file>        Tuning database (default "
+                  "<source>.tune.db)\n");
   fprintf(stdout, "       --parallel                Automatically parallelize "
                   "(generate OpenMP pragmas) [disabled by default]\n");
   fprintf(stdout, "    or --parallelize\n");
@@ -103,12 +170,24 @@ void usage_message(void) {
                   "(enabled by default)\n");
   fprintf(stdout, "       --full-diamond-tile       Enables full-dimensional "
                   "concurrent start\n");
+  fprintf(stdout, "       --split-tile              Split-tile time and space "
+                  "of bands (iterative stencils) for concurrent\n"
+                  "                                 start without a wavefront "
+                  "or redundant computation; disables diamond tiling\n");
   fprintf(
       stdout,
       "       --per-cc-obj              Enables separate dependence distance "
       "upper bounds for dependences from different connected components\n");
   fprintf(stdout, "       --[no]prevector           Mark loops for (icc/gcc) "
                   "vectorization (enabled by default)\n");
+  fprintf(stdout, "       --[no]omp-simd            Mark vector loops with "
+                  "'#pragma omp simd' instead of\n"
+                  "                                 ivdep (enabled by "
+                  "default)\n");
+  fprintf(stdout, "       --array-alignment=<bytes> Arrays (and their rows) "
+                  "are aligned to <bytes> bytes;\n"
+                  "                                 adds aligned clauses to "
+                  "SIMD loops\n");
   fprintf(stdout, "       --multipar                Extract all degrees of "
                   "parallelism [disabled by default];\n");
   fprintf(stdout, "                                    by default one degree "
@@ -116,6 +195,43 @@ void usage_message(void) {
   fprintf(stdout, "       --innerpar                Choose pure inner "
                   "parallelism over pipelined/wavefront parallelism [disabled "
                   "by default]\n");
+  fprintf(stdout, "       --reductions              Parallelize and vectorize "
+                  "reductions (+, *) with OpenMP\n"
+                  "                                 reduction clauses; "
+                  "reassociates floating-point updates [disabled by "
+                  "default]\n");
+  fprintf(stdout, "       --omp-tasks               Run the tiles of bands "
+                  "with pipelined parallelism as OpenMP\n"
+                  "                                 tasks with depend "
+                  "clauses instead of a wavefront (with --tile)\n");
+  fprintf(stdout, "       --dynschedule             Schedule the tiles of "
+                  "bands with pipelined parallelism\n"
+                  "                                 dynamically with Pluto's "
+                  "runtime (pluto/dynschedule.h)\n"
+                  "                                 instead of a wavefront "
+                  "(implies --tile, --parallel)\n");
+  fprintf(stdout, "       --doacross                Run the outer two tile "
+                  "loops of bands with pipelined\n"
+                  "                                 parallelism as doacross "
+                  "loops (omp ordered depend) instead\n"
+                  "                                 of a wavefront (with "
+                  "--tile)\n");
+  fprintf(stdout, "       --[no]omp-collapse        Collapse parallel loops "
+                  "with the rectangular parallel\n"
+                  "                                 loops nested in them "
+                  "(enabled by default)\n");
+  fprintf(stdout, "       --[no]omp-schedule        Schedule parallel loops "
+                  "with triangular inner loops\n"
+                  "                                 dynamic or guided "
+                  "(enabled by default)\n");
+  fprintf(stdout, "       --multiversion            Also emit a --notile "
+                  "--noparallel version, run\n"
+                  "                                 when the estimated "
+                  "iteration count is small\n");
+  fprintf(stdout, "       --multiversion-threshold=<iterations>  Estimated "
+                  "iteration count at and above\n"
+                  "                                 which the optimized "
+                  "version runs (default 100000)\n");
   fprintf(stdout,
           "\n   Fusion                Options to control fusion heuristic\n");
   fprintf(stdout, "       --nofuse                  Do not fuse across SCCs of "
@@ -132,6 +248,18 @@ void usage_message(void) {
   fprintf(stdout, "       --delayedcut              Delays the cut between "
                   "SCCs of different dimensionalities in dfp approach [uses "
                   "glpk or gurobi for solving LPs]\n");
+  fprintf(stdout, "       --incremental-scc         Maintain SCCs/connected "
+                  "components of the DDG incrementally as dependences get "
+                  "satisfied [disabled by default]\n");
+  fprintf(stdout, "       --hierarchical            Hierarchical scheduling "
+                  "for large SCoPs: cluster SCCs and solve one small ILP per "
+                  "cluster [disabled by default]\n");
+  fprintf(stdout, "       --hier-cluster-size=<n>   Maximum number of "
+                  "statements in a cluster with --hierarchical (default 16)\n");
+  fprintf(stdout, "       --time-budget=<seconds>   Compile time budget; "
+                  "when the scheduling ILPs run out of it, fall back to LP, "
+                  "then per-SCC scheduling, then the original schedule; the "
+                  "strategies share the budget [no budget by default]\n");
   fprintf(stdout, "\n   Index Set Splitting        \n");
   fprintf(stdout, "       --iss                  \n");
   fprintf(
@@ -143,13 +271,25 @@ void usage_message(void) {
                   "convex hull (default - off)\n");
   fprintf(stdout, "       --codegen-context=<value> Parameters are at least as "
                   "much as <value>\n");
+  fprintf(stdout, "       --codegen=<generator>     cloog [default] or isl; "
+                  "isl separates full tiles from\n"
+                  "                                 partial ones\n");
+  fprintf(stdout, "       --isl-ast-options=<list>  AST generation option of "
+                  "each of t1, t2, ... with\n"
+                  "                                 --codegen=isl: atomic, "
+                  "separate, unroll or empty\n");
   fprintf(stdout, "\n   Miscellaneous\n");
   fprintf(stdout, "       --rar                     Consider RAR dependences "
                   "too (disabled by default)\n");
   fprintf(stdout, "       --[no]unrolljam           Unroll and jam (enabled "
                   "by default)\n");
-  fprintf(stdout, "       --ufactor=<factor>        Unroll and jam factor "
-                  "(default is 8)\n");
+  fprintf(stdout, "       --ufactor=<factor>        Maximum unroll and jam "
+                  "factor (default is 8)\n");
+  fprintf(stdout, "       --target=<isa>            Instruction set whose "
+                  "registers unroll-jam factors are\n"
+                  "                                 chosen for: generic "
+                  "[default], native, sse, avx2,\n"
+                  "                                 avx512 or neon\n");
   fprintf(stdout, "       --forceparallel=<bitvec>  6 bit-vector of depths "
                   "(1-indexed) to force parallel (0th bit represents depth "
                   "1)\n");
@@ -179,6 +319,60 @@ static double rtclock() {
   return (Tp.tv_sec + Tp.tv_usec * 1.0e-6);
 }
 
+/* Context of the version of multiversioned code that runs for small
+ * iteration counts: that of --notile --noparallel with the other options */
+static PlutoContext *multiversion_context_alloc(const PlutoOptions *options) {
+  PlutoContext *context = pluto_context_alloc();
+  PlutoOptions *simple = context->options;
+
+  *simple = *options;
+  simple->out_file = NULL;
+  simple->tile_config = NULL;
+  simple->tile_config_out = NULL;
+  simple->isl_ast_options =
+      options->isl_ast_options ? strdup(options->isl_ast_options) : NULL;
+
+  simple->tile = 0;
+  simple->parallel = 0;
+  simple->multipar = 0;
+  simple->innerpar = 0;
+  simple->reductions = 0;
+  simple->omp_tasks = 0;
+  simple->dynschedule = 0;
+  simple->doacross = 0;
+  simple->parametric_tiles = 0;
+  simple->full_tiles = 0;
+  simple->split_tile = 0;
+  simple->find_tile_sizes = 0;
+  simple->second_level_tile = 0;
+  simple->diamondtile = 0;
+  simple->fulldiamondtile = 0;
+  simple->multiversion = 0;
+  /* Statistics are those of the optimized version */
+  simple->silent = 1;
+  simple->time = 0;
+
+  return context;
+}
+
+/* Transform the version of multiversioned code that runs for small iteration
+ * counts as Pluto does with --notile --noparallel */
+static void multiversion_transform(PlutoProg *prog) {
+  PlutoOptions *options = prog->context->options;
+
+  if (options->iss) {
+    pluto_iss_dep(prog);
+  }
+  if (!options->identity) {
+    pluto_auto_transform(prog);
+  }
+  pluto_compute_dep_directions(prog);
+  pluto_compute_dep_satisfaction(prog);
+  if (options->intratileopt) {
+    pluto_intra_tile_optimize(prog, 0);
+  }
+}
+
 int main(int argc, char *argv[]) {
   if (argc <= 1) {
     usage_message();
@@ -189,6 +383,10 @@ int main(int argc, char *argv[]) {
 
   int option_index = 0;
   int nolastwriter = 0;
+  bool cache_size_given = false;
+  int tune = 0;
+  PlutoTuneOptions tune_options;
+  pluto_tune_options_init(&tune_options);
 
   PlutoContext *context = pluto_context_alloc();
   PlutoOptions *options = context->options;
@@ -219,28 +417,65 @@ int main(int argc, char *argv[]) {
     {"parallel", no_argument, &options->parallel, 1},
     {"parallelize", no_argument, &options->parallel, 1},
     {"innerpar", no_argument, &options->innerpar, 1},
+    {"reductions", no_argument, &options->reductions, 1},
+    {"omp-tasks", no_argument, &options->omp_tasks, 1},
+    {"dynschedule", no_argument, &options->dynschedule, 1},
+    {"doacross", no_argument, &options->doacross, 1},
+    {"omp-collapse", no_argument, &options->omp_collapse, 1},
+    {"noomp-collapse", no_argument, &options->omp_collapse, 0},
+    {"omp-schedule", no_argument, &options->omp_schedule, 1},
+    {"noomp-schedule", no_argument, &options->omp_schedule, 0},
+    {"multiversion", no_argument, &options->multiversion, 1},
+    {"multiversion-threshold", required_argument, 0, 'M'},
     {"iss", no_argument, &options->iss, 1},
+    {"incremental-scc", no_argument, &options->incremental_scc, 1},
+    {"hierarchical", no_argument, &options->hierarchical, 1},
+    {"hier-cluster-size", required_argument, 0, 'H'},
+    {"time-budget", required_argument, 0, 'T'},
     {"unrolljam", no_argument, &options->unrolljam, 1},
     {"nounrolljam", no_argument, &options->unrolljam, 0},
     {"bee", no_argument, &options->bee, 1},
     {"ufactor", required_argument, 0, 'u'},
+    {"target", required_argument, 0, 't'},
     {"prevector", no_argument, &options->prevector, 1},
     {"noprevector", no_argument, &options->prevector, 0},
+    {"omp-simd", no_argument, &options->omp_simd, 1},
+    {"noomp-simd", no_argument, &options->omp_simd, 0},
+    {"array-alignment", required_argument, 0, 'A'},
     {"codegen-context", required_argument, 0, 'c'},
     {"coeff-bound", required_argument, 0, 'C'},
     {"cloogf", required_argument, 0, 'F'},
     {"cloogl", required_argument, 0, 'L'},
     {"cloogsh", no_argument, &options->cloogsh, 1},
     {"nocloogbacktrack", no_argument, &options->cloogbacktrack, 0},
+    {"codegen", required_argument, 0, 'x'},
+    {"isl-ast-options", required_argument, 0, 'a'},
     {"forceparallel", required_argument, 0, 'p'},
     {"ft", required_argument, 0, 'f'},
     {"lt", required_argument, 0, 'l'},
     {"multipar", no_argument, &options->multipar, 1},
     {"second-level-tile", no_argument, &options->second_level_tile, 1},
+    {"tile-levels", required_argument, 0, 'z'},
+    {"parallel-tile-level", required_argument, 0, 'w'},
+    {"parametric-tiles", no_argument, &options->parametric_tiles, 1},
+    {"full-tiles", no_argument, &options->full_tiles, 1},
+    {"split-tile", no_argument, &options->split_tile, 1},
     {"determine-tile-size", no_argument, (int *)&options->find_tile_sizes,
      true},
+    {"exact-tile-footprint", no_argument, &options->exact_tile_footprint, 1},
+    {"tile-config", required_argument, 0, 'k'},
+    {"save-tile-config", required_argument, 0, 'G'},
     {"data-element-size", required_argument, 0, 'D'},
     {"cache-size", required_argument, 0, 'S'},
+    {"cache-levels", required_argument, 0, 'K'},
+    {"num-threads", required_argument, 0, 'N'},
+    {"parallel-slack", required_argument, 0, 'P'},
+    {"tune", no_argument, &tune, 1},
+    {"tune-strategy", required_argument, 0, 'y'},
+    {"tune-evals", required_argument, 0, 'e'},
+    {"tune-jobs", required_argument, 0, 'j'},
+    {"tune-reps", required_argument, 0, 'r'},
+    {"tune-db", required_argument, 0, 'B'},
     {"version", no_argument, 0, 'v'},
     {"help", no_argument, 0, 'h'},
     {"indent", no_argument, 0, 'i'},
@@ -293,6 +528,14 @@ int main(int argc, char *argv[]) {
         return 2;
       }
       break;
+    case 'A':
+      options->array_alignment = atoi(optarg);
+      if (options->array_alignment == 0 ||
+          (options->array_alignment & (options->array_alignment - 1))) {
+        printf("ERROR: Array alignment should be a power of two\n");
+        return 2;
+      }
+      break;
     case 'F':
       options->cloogf = atoi(optarg);
       break;
@@ -305,6 +548,114 @@ int main(int argc, char *argv[]) {
         printf("ERROR: Cache size should be at least 1 byte\n");
         return 2;
       }
+      cache_size_given = true;
+      break;
+    case 'K': {
+      char *levels = strdup(optarg);
+      char *saveptr = NULL;
+      options->num_cache_levels = 0;
+      for (char *level = strtok_r(levels, ",", &saveptr); level != NULL;
+           level = strtok_r(NULL, ",", &saveptr)) {
+        if (options->num_cache_levels == PLUTO_MAX_CACHE_LEVELS) {
+          printf("ERROR: at most %d cache levels are supported\n",
+                 PLUTO_MAX_CACHE_LEVELS);
+          free(levels);
+          return 2;
+        }
+        PlutoCacheLevel *cache =
+            &options->cache_levels[options->num_cache_levels++];
+        unsigned long long size = 0;
+        cache->line_size = 64;
+        cache->associativity = 0;
+        cache->shared_by = 1;
+        if (sscanf(level, "%llu:%u:%u:%u", &size, &cache->line_size,
+                   &cache->associativity, &cache->shared_by) < 1 ||
+            size == 0 || cache->line_size == 0 || cache->shared_by == 0) {
+          printf("ERROR: invalid cache level '%s'\n", level);
+          free(levels);
+          return 2;
+        }
+        cache->size = size;
+      }
+      free(levels);
+      break;
+    }
+    case 'z':
+      if (atoi(optarg) <= 0 || atoi(optarg) > MAX_TILING_LEVELS) {
+        printf("ERROR: tile-levels should be between 1 and %d\n",
+               MAX_TILING_LEVELS);
+        return 2;
+      }
+      options->tile_levels = atoi(optarg);
+      break;
+    case 'w':
+      if (atoi(optarg) <= 0) {
+        printf("ERROR: parallel-tile-level should be at least 1\n");
+        return 2;
+      }
+      options->parallel_tile_level = atoi(optarg);
+      break;
+    case 'N':
+      if (atoi(optarg) <= 0) {
+        printf("ERROR: num-threads should be at least 1\n");
+        return 2;
+      }
+      options->num_threads = atoi(optarg);
+      break;
+    case 'P':
+      if (atoi(optarg) <= 0) {
+        printf("ERROR: parallel-slack should be at least 1\n");
+        return 2;
+      }
+      options->parallel_slack = atoi(optarg);
+      break;
+    case 'y':
+      if (!strcmp(optarg, "random")) {
+        tune_options.strategy = kTuneRandom;
+      } else if (!strcmp(optarg, "coordinate")) {
+        tune_options.strategy = kTuneCoordinateDescent;
+      } else if (!strcmp(optarg, "nelder-mead")) {
+        tune_options.strategy = kTuneNelderMead;
+      } else {
+        printf("ERROR: unknown tune-strategy '%s'\n", optarg);
+        return 2;
+      }
+      break;
+    case 'e':
+      tune_options.max_evals = atoi(optarg);
+      if (tune_options.max_evals <= 0) {
+        printf("ERROR: tune-evals should be at least 1\n");
+        return 2;
+      }
+      break;
+    case 'j':
+      tune_options.jobs = atoi(optarg);
+      if (tune_options.jobs <= 0) {
+        printf("ERROR: tune-jobs should be at least 1\n");
+        return 2;
+      }
+      break;
+    case 'r':
+      tune_options.reps = atoi(optarg);
+      if (tune_options.reps <= 0) {
+        printf("ERROR: tune-reps should be at least 1\n");
+        return 2;
+      }
+      break;
+    case 'B':
+      tune_options.db = optarg;
+      break;
+    case 'k':
+      if (access(optarg, R_OK) != 0) {
+        printf("ERROR: can't read tile configuration '%s'\n", optarg);
+        return 2;
+      }
+      free(options->tile_config);
+      options->tile_config = strdup(optarg);
+      break;
+    case 'G':
+      free(options->tile_config_out);
+      options->tile_config_out = strdup(optarg);
       break;
     case 'b':
       options->bee = 1;
@@ -329,6 +680,28 @@ int main(int argc, char *argv[]) {
     case 'h':
       usage_message();
       return 2;
+    case 'H':
+      options->hier_cluster_size = atoi(optarg);
+      if (options->hier_cluster_size <= 0) {
+        printf("ERROR: hier-cluster-size should be at least 1\n");
+        return 2;
+      }
+      break;
+    case 'T':
+      options->time_budget = atof(optarg);
+      if (options->time_budget <= 0.0) {
+        printf("ERROR: time-budget should be a positive number of seconds\n");
+        return 2;
+      }
+      break;
+    case 'M':
+      options->multiversion_threshold = atof(optarg);
+      if (options->multiversion_threshold <= 0.0) {
+        printf("ERROR: multiversion-threshold should be a positive iteration "
+               "count\n");
+        return 2;
+      }
+      break;
     case 'i':
       /* Handled in polycc */
       break;
@@ -353,6 +726,28 @@ int main(int argc, char *argv[]) {
     case 'u':
       options->ufactor = atoi(optarg);
       break;
+    case 't':
+      if (!pluto_parse_target(optarg, &options->target)) {
+        printf("ERROR: unknown target '%s' (generic, native, sse, avx2, "
+               "avx512 or neon)\n",
+               optarg);
+        return 2;
+      }
+      break;
+    case 'x':
+      if (!strcmp(optarg, "cloog")) {
+        options->codegen = kCodegenCloog;
+      } else if (!strcmp(optarg, "isl")) {
+        options->codegen = kCodegenIsl;
+      } else {
+        printf("ERROR: unknown code generator '%s' (cloog or isl)\n", optarg);
+        return 2;
+      }
+      break;
+    case 'a':
+      free(options->isl_ast_options);
+      options->isl_ast_options = strdup(optarg);
+      break;
     case 'v':
       printf(
           "PLUTO version %s - An automatic parallelizer and locality optimizer\n\
@@ -401,20 +796,155 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
     return 1;
   }
 
-  if (options->second_level_tile && options->find_tile_sizes) {
-    printf("[pluto] ERROR: Automatic tile size selection is supported only for "
-           "one level of tiling\n");
+  if (tune && !options->tile) {
+    printf("[pluto] WARNING: --tune needs --tile; turning on tiling\n");
+    options->tile = 1;
+  }
+
+  if (tune && !strcmp(srcFileName, "stdin")) {
+    printf("[pluto] ERROR: --tune needs a source file\n");
     pluto_options_free(options);
-    usage_message();
     return 1;
   }
 
+  /* Tile sizes found by the model or the tuner are saved to the file given
+   * with --save-tile-config, else next to the output file given with -o
+   * (<output without .c>.tiles); the tuner hands its sizes over through a
+   * temporary file if neither is given */
+  bool tile_config_tmp = false;
+  if ((options->find_tile_sizes || tune) && !options->tile_config_out) {
+    if (options->out_file) {
+      size_t len = strlen(options->out_file);
+      if (len > 2 && !strcmp(options->out_file + len - 2, ".c"))
+        len -= 2;
+      options->tile_config_out = (char *)malloc(len + strlen(".tiles") + 1);
+      memcpy(options->tile_config_out, options->out_file, len);
+      strcpy(options->tile_config_out + len, ".tiles");
+    } else if (tune) {
+      char tmpl[] = "/tmp/pluto-tiles.XXXXXX";
+      int fd = mkstemp(tmpl);
+      if (fd < 0) {
+        printf("[pluto] ERROR: can't create a temporary tile size file\n");
+        pluto_options_free(options);
+        return 1;
+      }
+      close(fd);
+      options->tile_config_out = strdup(tmpl);
+      tile_config_tmp = true;
+    }
+  }
+
+  /* Detect the cache hierarchy unless it was provided; the tuner is seeded
+   * with the tile size selection model */
+  if ((options->find_tile_sizes || tune) && !cache_size_given &&
+      options->num_cache_levels == 0) {
+    unsigned num_levels = pluto_detect_cache_levels(options);
+    if (options->debug) {
+      printf("[pluto] %u cache level(s) detected from sysfs\n", num_levels);
+      for (unsigned i = 0; i < num_levels; i++) {
+        PlutoCacheLevel *cache = &options->cache_levels[i];
+        printf("[pluto] \tL%u: %lu bytes, %u-byte lines, %u-way, shared by "
+               "%u core(s)\n",
+               i + 1, (unsigned long)cache->size, cache->line_size,
+               cache->associativity, cache->shared_by);
+      }
+    }
+  }
+
   if (options->lastwriter && nolastwriter) {
     printf("[pluto] WARNING: both --lastwriter, --nolastwriter are on\n");
     printf("[pluto] disabling --lastwriter\n");
     options->lastwriter = 0;
   }
 
+  if (options->parametric_tiles && !options->tile) {
+    printf("[pluto] WARNING: --parametric-tiles needs --tile; turning on "
+           "tiling\n");
+    options->tile = 1;
+  }
+
+  if (options->split_tile && !options->tile) {
+    printf("[pluto] WARNING: --split-tile needs --tile; turning on tiling\n");
+    options->tile = 1;
+  }
+
+  if (options->dynschedule && (!options->tile || !options->parallel)) {
+    printf("[pluto] WARNING: --dynschedule needs --tile and --parallel; "
+           "turning them on\n");
+    options->tile = 1;
+    options->parallel = 1;
+  }
+
+  if (options->dynschedule && options->omp_tasks) {
+    printf("[pluto] WARNING: --omp-tasks is ignored with --dynschedule\n");
+    options->omp_tasks = 0;
+  }
+
+  if (options->doacross && (options->dynschedule || options->omp_tasks)) {
+    printf("[pluto] WARNING: --doacross is ignored with --dynschedule and "
+           "--omp-tasks\n");
+    options->doacross = 0;
+  }
+
+  if (options->full_tiles && !options->tile) {
+    printf("[pluto] WARNING: --full-tiles needs --tile; turning on tiling\n");
+    options->tile = 1;
+  }
+
+  if (options->full_tiles && options->parametric_tiles) {
+    printf("[pluto] WARNING: --full-tiles is ignored with "
+           "--parametric-tiles\n");
+    options->full_tiles = 0;
+  }
+
+  if (options->full_tiles && options->codegen == kCodegenIsl) {
+    printf("[pluto] WARNING: --full-tiles is ignored with --codegen=isl, "
+           "which separates full tiles already\n");
+    options->full_tiles = 0;
+  }
+
+  if (options->multiversion && !options->pet &&
+      !strcmp(srcFileName, "stdin")) {
+    printf("[pluto] WARNING: --multiversion is ignored when reading a scop "
+           "from stdin\n");
+    options->multiversion = 0;
+  }
+
+  if (options->split_tile && options->parametric_tiles) {
+    printf("[pluto] WARNING: --split-tile can't be used with "
+           "--parametric-tiles; turning off split tiling\n");
+    options->split_tile = 0;
+  }
+
+  /* Only the tile size of the outermost level could be kept as a variable:
+   * the supernodes of the inner levels are also bounded by the tile loops of
+   * the levels outside them. */
+  if (options->parametric_tiles &&
+      (options->tile_levels > 1 || options->second_level_tile)) {
+    printf("[pluto] WARNING: --parametric-tiles can't be used with more than "
+           "one level of tiling; using constant tile sizes\n");
+    options->parametric_tiles = 0;
+  }
+
+  if (options->codegen == kCodegenIsl && options->parametric_tiles) {
+    printf("[pluto] WARNING: --parametric-tiles is only supported with "
+           "--codegen=cloog; using CLooG\n");
+    options->codegen = kCodegenCloog;
+  }
+
+  if (options->isl_ast_options && options->codegen != kCodegenIsl) {
+    printf("[pluto] WARNING: --isl-ast-options is ignored without "
+           "--codegen=isl\n");
+  }
+
+  /* Diamond tiling skews tile space dimensions, which needs the tile sizes to
+   * be known. Split tiling needs the time dimension of a band to be
+   * outermost, which diamond tiling changes. */
+  if (options->parametric_tiles || options->split_tile) {
+    options->diamondtile = 0;
+    options->fulldiamondtile = 0;
+  }
+
   if (options->diamondtile == 1 && options->tile == 0) {
     options->diamondtile = 0;
   }
@@ -487,6 +1017,13 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
   if (options->pipsolve)
     options->islsolve = 0;
 
+  if (options->hierarchical &&
+      (options->dfp || options->per_cc_obj || options->lp)) {
+    printf("[pluto] WARNING: --hierarchical is not supported with dfp, "
+           "--per-cc-obj or --lp; disabling it\n");
+    options->hierarchical = 0;
+  }
+
   if (options->dfp && !(options->glpk || options->gurobi)) {
     printf("[pluto] ERROR: DFP framework is currently supported with GLPK or "
            "GUROBI solvers only. Run ./configure --help to for more "
@@ -540,6 +1077,9 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
 
   /* Extract polyhedral representation from osl scop */
   PlutoProg *prog = NULL;
+  /* The version of multiversioned code run for small iteration counts */
+  PlutoContext *simple_context = NULL;
+  PlutoProg *simple_prog = NULL;
 
   osl_scop_p scop = NULL;
   char *irroption = NULL;
@@ -565,6 +1105,11 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
     prog = pet_to_pluto_prog(pscop, pctx, context);
     t_d = rtclock() - t_start;
 
+    if (options->multiversion) {
+      simple_context = multiversion_context_alloc(options);
+      simple_prog = pet_to_pluto_prog(pscop, pctx, simple_context);
+    }
+
     pet_scop_free(pscop);
     isl_ctx_free(pctx);
 
@@ -625,6 +1170,10 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
 
     /* Convert clan scop to Pluto program */
     prog = osl_scop_to_pluto_prog(scop, context);
+    if (options->multiversion) {
+      simple_context = multiversion_context_alloc(options);
+      simple_prog = osl_scop_to_pluto_prog(scop, simple_context);
+    }
 
     /* Backup irregular program portion in .scop. */
     osl_irregular_p irreg_ext = NULL;
@@ -654,6 +1203,14 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
     pluto_iss_dep(prog);
   }
 
+  if (options->reductions) {
+    unsigned num_relaxed = pluto_relax_reduction_deps(prog);
+    if (!options->silent) {
+      fprintf(stdout, "[pluto] Number of reduction deps relaxed: %u\n",
+              num_relaxed);
+    }
+  }
+
   double t_start = rtclock();
   /* Auto transformation */
   if (!options->identity) {
@@ -672,13 +1229,43 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
     pluto_transformations_pretty_print(prog);
   }
 
+  double t_tune = 0.0;
+  if (tune) {
+    t_start = rtclock();
+    if (pluto_tune(prog, srcFileName, irroption, &tune_options) == 0) {
+      /* Tile with the best tile sizes found */
+      options->find_tile_sizes = 0;
+      free(options->tile_config);
+      options->tile_config = strdup(options->tile_config_out);
+    } else {
+      printf("[pluto] WARNING: tuning failed; tiling with default sizes\n");
+    }
+    t_tune = rtclock() - t_start;
+  }
+
   if (options->tile) {
-    pluto_tile(prog);
+    if (pluto_tile(prog)) {
+      /* The tile configuration couldn't be read */
+      if (tile_config_tmp)
+        unlink(options->tile_config_out);
+      pluto_prog_free(prog);
+      pluto_context_free(context);
+      if (simple_prog) {
+        pluto_prog_free(simple_prog);
+        pluto_context_free(simple_context);
+      }
+      return 1;
+    }
   } else {
     if (options->intratileopt) {
       pluto_intra_tile_optimize(prog, 0);
     }
   }
+  if (tile_config_tmp) {
+    unlink(options->tile_config_out);
+    PLUTO_MESSAGE(printf("[pluto] Tuned tile sizes not saved; use -o or "
+                         "--save-tile-config to keep them\n"););
+  }
 
   if (options->parallel && !options->tile && !options->identity) {
     /* Obtain wavefront/pipelined parallelization by skewing if
@@ -701,6 +1288,10 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
     }
   }
 
+  if (simple_prog) {
+    multiversion_transform(simple_prog);
+  }
+
   double t_c = 0.0;
 
   if (!options->pet && !strcmp(srcFileName, "stdin")) {
@@ -742,30 +1333,72 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
       strcpy(outFileName, options->out_file);
     }
 
-    char *cloogFileName;
-    if (strlen(bname) >= 2 && !strcmp(bname + strlen(bname) - 2, ".c")) {
-      cloogFileName =
-          (char *)malloc(strlen(bname) - 2 + strlen(".pluto.cloog") + 1);
-      strcpy(cloogFileName, bname);
-      cloogFileName[strlen(bname) - 2] = '\0';
-    } else {
-      cloogFileName =
-          (char *)malloc(strlen(bname) + strlen(".pluto.cloog") + 1);
-      strcpy(cloogFileName, bname);
+    /* The input of CLooG is built in memory; a .cloog file is only written
+     * when debugging, or to pass on the <irregular> extension from clan,
+     * which CLooG only reads from a file */
+    bool irregular = !options->pet && irroption;
+    if (irregular && options->codegen == kCodegenIsl) {
+      printf("[pluto] WARNING: irregular control isn't supported with "
+             "--codegen=isl; using CLooG\n");
+      options->codegen = kCodegenCloog;
     }
-    strcat(cloogFileName, ".pluto.cloog");
-    free(basec);
-
-    FILE *cloogfp = fopen(cloogFileName, "w+");
-    if (!cloogfp) {
-      fprintf(stderr, "[Pluto] Can't open .cloog file: '%s'\n", cloogFileName);
+    if (prog->ntask_bands > 0 && options->codegen == kCodegenIsl) {
+      printf("[pluto] WARNING: --omp-tasks, --dynschedule and --doacross "
+             "aren't supported with --codegen=isl; using CLooG\n");
+      options->codegen = kCodegenCloog;
+    }
+    if (options->unrolljam && options->codegen == kCodegenIsl) {
+      /* Unroll-jam is done on CLooG's clast */
+      unsigned num_ujloops;
+      Ploop **ujloops = pluto_get_unroll_jam_loops(prog, &num_ujloops);
+      if (num_ujloops > 0) {
+        printf("[pluto] WARNING: unroll-jam isn't supported with "
+               "--codegen=isl; using CLooG (--nounrolljam keeps isl)\n");
+        options->codegen = kCodegenCloog;
+      }
+      pluto_loops_free(ujloops, num_ujloops);
+    }
+    if (irregular && simple_prog) {
+      printf("[pluto] WARNING: --multiversion isn't supported with irregular "
+             "control; emitting the optimized version only\n");
+      pluto_prog_free(simple_prog);
+      pluto_context_free(simple_context);
+      simple_prog = NULL;
+      simple_context = NULL;
+    }
+    FILE *cloogfp = NULL;
+    if (options->debug || options->moredebug || irregular) {
+      char *cloogFileName;
+      if (strlen(bname) >= 2 && !strcmp(bname + strlen(bname) - 2, ".c")) {
+        cloogFileName =
+            (char *)malloc(strlen(bname) - 2 + strlen(".pluto.cloog") + 1);
+        strcpy(cloogFileName, bname);
+        cloogFileName[strlen(bname) - 2] = '\0';
+      } else {
+        cloogFileName =
+            (char *)malloc(strlen(bname) + strlen(".pluto.cloog") + 1);
+        strcpy(cloogFileName, bname);
+      }
+      strcat(cloogFileName, ".pluto.cloog");
+
+      cloogfp = fopen(cloogFileName, "w+");
+      if (!cloogfp) {
+        fprintf(stderr, "[Pluto] Can't open .cloog file: '%s'\n",
+                cloogFileName);
+        free(cloogFileName);
+        free(basec);
+        pluto_options_free(options);
+        pluto_prog_free(prog);
+        pluto_context_free(context);
+        if (simple_prog) {
+          pluto_prog_free(simple_prog);
+          pluto_context_free(simple_context);
+        }
+        return 9;
+      }
       free(cloogFileName);
-      pluto_options_free(options);
-      pluto_prog_free(prog);
-      pluto_context_free(context);
-      return 9;
     }
-    free(cloogFileName);
+    free(basec);
 
     FILE *outfp = fopen(outFileName, "w");
     if (!outfp) {
@@ -775,24 +1408,32 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
       pluto_options_free(options);
       pluto_prog_free(prog);
       pluto_context_free(context);
-      fclose(cloogfp);
+      if (simple_prog) {
+        pluto_prog_free(simple_prog);
+        pluto_context_free(simple_context);
+      }
+      if (cloogfp)
+        fclose(cloogfp);
       return 10;
     }
 
-    /* Generate .cloog file */
-    pluto_gen_cloog_file(cloogfp, prog);
-    /* Add the <irregular> tag from clan, if any */
-    if (!options->pet) {
-      if (irroption) {
+    if (cloogfp) {
+      /* Generate .cloog file */
+      pluto_gen_cloog_file(cloogfp, prog);
+      /* Add the <irregular> tag from clan, if any */
+      if (irregular)
         fprintf(cloogfp, "<irregular>\n%s\n</irregular>\n\n", irroption);
-        free(irroption);
-      }
+      rewind(cloogfp);
     }
-    rewind(cloogfp);
+    free(irroption);
 
     /* Generate code using Cloog and add necessary stuff before/after code */
     t_start = rtclock();
-    pluto_multicore_codegen(cloogfp, outfp, prog);
+    if (simple_prog) {
+      pluto_multiversion_codegen(cloogfp, outfp, prog, simple_prog);
+    } else {
+      pluto_multicore_codegen(cloogfp, outfp, prog);
+    }
     t_c = rtclock() - t_start;
 
     FILE *tmpfp = fopen(".outfilename", "w");
@@ -803,7 +1444,8 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
     }
     free(outFileName);
 
-    fclose(cloogfp);
+    if (cloogfp)
+      fclose(cloogfp);
     fclose(outfp);
   }
   osl_scop_free(scop);
@@ -816,14 +1458,39 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
            t_d);
     printf("[pluto] Auto-transformation time: %0.6lfs\n", t_t);
     printf("[pluto] Tile size selection time: %0.6lfs\n", prog->tss_time);
+    if (tune) {
+      printf("[pluto] Empirical tuning time: %0.6lfs\n", t_tune);
+    }
     if (options->dfp) {
       printf("[pluto] \tFCG construction time: %0.6lfs\n",
              prog->fcg_const_time);
+      printf("[pluto] \t\tFCG LPs solved: %ld, pairwise outcomes reused: "
+             "%ld\n",
+             prog->num_lp_calls, prog->num_fcg_lp_reused);
       printf("[pluto] \tFCG colouring time: %0.6lfs\n", prog->fcg_colour_time);
       printf("[pluto] \tscaling + shifting time: %0.6lfs\n",
              prog->fcg_dims_scale_time);
       printf("[pluto] \tskew determination time: %0.6lfs\n", prog->skew_time);
     }
+    if (options->incremental_scc) {
+      printf("[pluto] \tDDG SCC/CC computation time: %0.6lfs (%ld full), "
+             "%0.6lfs (%ld incremental)\n",
+             prog->ddg_scc_full_time, prog->num_ddg_scc_full,
+             prog->ddg_scc_incr_time, prog->num_ddg_scc_incr);
+      printf("[pluto] \tEstimated time saved by incremental SCC/CC updates: "
+             "%0.6lfs\n",
+             prog->ddg_scc_time_saved);
+    }
+    if (options->hierarchical) {
+      printf("[pluto] \tHierarchical scheduling time: %0.6lfs (%d "
+             "clusters)\n",
+             prog->hier_time, prog->hier_num_clusters);
+    }
+    if (options->time_budget > 0.0) {
+      printf("[pluto] \tCompile time budget: %0.6lfs, fallback used: %s\n",
+             options->time_budget,
+             pluto_budget_fallback_str(prog->budget_fallback));
+    }
     printf("[pluto] \t\tTotal constraint solving time (LP/MIP/ILP) time: "
            "%0.6lfs\n",
            prog->mipTime);
@@ -836,6 +1503,10 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
 
   pluto_prog_free(prog);
   pluto_context_free(context);
+  if (simple_prog) {
+    pluto_prog_free(simple_prog);
+    pluto_context_free(simple_context);
+  }
 
   return 0;
 }
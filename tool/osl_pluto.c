@@ -20,6 +20,7 @@
 #include "pluto/pluto.h"
 #include "pluto_codegen_if.h"
 #include "program.h"
+#include "reduction.h"
 
 #include "candl/candl.h"
 
@@ -828,6 +829,7 @@ static Stmt **osl_to_pluto_stmts(const osl_scop_p scop, PlutoContext *context) {
     /* Statement text */
     stmt->text = osl_strings_sprint(stmt_body->expression); // appends \n
     stmt->text[strlen(stmt->text) - 1] = '\0'; // remove the \n from end
+    stmt->reduction_op = pluto_get_reduction_op_from_text(stmt->text);
 
     /* Read/write accesses */
     osl_relation_list_p wlist = osl_access_list_filter_write(scop_stmt->access);
@@ -28,6 +28,7 @@
 #include "pluto/pluto.h"
 #include "program.h"
 
+#include "isl/aff.h"
 #include "isl/flow.h"
 #include "isl/id.h"
 #include "isl/map.h"
@@ -221,6 +222,68 @@ static void mark_trivial_dead_code(struct pet_scop *pscop,
   }
 }
 
+/// Returns true if `expr1' and `expr2' access the same element.
+static bool is_same_access(pet_expr *expr1, pet_expr *expr2) {
+  if (pet_expr_get_type(expr1) != pet_expr_access ||
+      pet_expr_get_type(expr2) != pet_expr_access)
+    return false;
+  isl_multi_pw_aff *index1 = pet_expr_access_get_index(expr1);
+  isl_multi_pw_aff *index2 = pet_expr_access_get_index(expr2);
+  bool equal =
+      isl_multi_pw_aff_plain_is_equal(index1, index2) == isl_bool_true;
+  isl_multi_pw_aff_free(index1);
+  isl_multi_pw_aff_free(index2);
+  return equal;
+}
+
+/// Returns the reduction operator of a statement of the form x += e, x -= e,
+/// x *= e, x = x + e, x = x - e or x = x * e; kReductionNone otherwise.
+static PlutoReductionOp get_reduction_op(struct pet_stmt *pstmt) {
+  if (pet_tree_get_type(pstmt->body) != pet_tree_expr)
+    return kReductionNone;
+
+  PlutoReductionOp op = kReductionNone;
+  pet_expr *expr = pet_tree_expr_get_expr(pstmt->body);
+  if (pet_expr_get_type(expr) != pet_expr_op) {
+    pet_expr_free(expr);
+    return kReductionNone;
+  }
+
+  switch (pet_expr_op_get_type(expr)) {
+  case pet_op_add_assign:
+  case pet_op_sub_assign:
+    op = kReductionAdd;
+    break;
+  case pet_op_mul_assign:
+    op = kReductionMul;
+    break;
+  case pet_op_assign: {
+    pet_expr *lhs = pet_expr_get_arg(expr, 0);
+    pet_expr *rhs = pet_expr_get_arg(expr, 1);
+    if (pet_expr_get_type(rhs) == pet_expr_op &&
+        pet_expr_get_n_arg(rhs) == 2) {
+      enum pet_op_type type = pet_expr_op_get_type(rhs);
+      pet_expr *arg = pet_expr_get_arg(rhs, 0);
+      if (is_same_access(arg, lhs)) {
+        if (type == pet_op_add || type == pet_op_sub)
+          op = kReductionAdd;
+        else if (type == pet_op_mul)
+          op = kReductionMul;
+      }
+      pet_expr_free(arg);
+    }
+    pet_expr_free(lhs);
+    pet_expr_free(rhs);
+    break;
+  }
+  default:
+    break;
+  }
+
+  pet_expr_free(expr);
+  return op;
+}
+
 /* Read statement info from pet structures (nvar: max domain dim) */
 static Stmt **pet_to_pluto_stmts(
     struct pet_scop *pscop, isl_map **stmt_wise_schedules,
@@ -333,6 +396,7 @@ static Stmt **pet_to_pluto_stmts(
     } else {
       stmt->text = strdup("/* kill statement */");
     }
+    stmt->reduction_op = get_reduction_op(pstmt);
 
     isl_space *space = isl_set_get_space(pscop->context);
     isl_union_map *reads = pet_stmt_collect_accesses(
@@ -681,6 +745,16 @@ PlutoProg *pet_to_pluto_prog(struct pet_scop *pscop, isl_ctx *ctx,
     free(entry.second);
   }
 
+  /* Element size for tile size selection: the largest one among the arrays
+   * (scalars are left out) */
+  for (int i = 0; i < pscop->n_array; i++) {
+    struct pet_array *array = pscop->arrays[i];
+    if (isl_set_dim(array->extent, isl_dim_set) == 0)
+      continue;
+    prog->data_element_size =
+        PLMAX(prog->data_element_size, (unsigned)array->element_size);
+  }
+
   /* Compute dependences */
   compute_deps_pet(pscop, prog, options);
 
@@ -10,6 +10,7 @@
  *
  */
 #include <assert.h>
+#include <ctype.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -24,9 +25,13 @@
 #include "pluto/matrix.h"
 #include "pluto/pluto.h"
 #include "program.h"
+#include "reduction.h"
+#include "target.h"
 #include "version.h"
 
-#include "cloog/cloog.h"
+#include "cloog/isl/cloog.h"
+#include "isl/map.h"
+#include "isl/set.h"
 #include "osl/extensions/loop.h"
 
 static int get_first_point_loop(Stmt *stmt, const PlutoProg *prog) {
@@ -58,6 +63,174 @@ static int get_first_point_loop(Stmt *stmt, const PlutoProg *prog) {
   return first_point_loop;
 }
 
+/// Checks if the hyperplane at `depth' of `stmt' scans a tile: a supernode
+/// added by tiling (zT*) that appears only in the two constraints
+/// T*zT <= f(i) <= T*zT + T - 1. Returns the tile size T, with the supernode
+/// and the rows of the two constraints in `col', `lb_row' and `ub_row', or 0
+/// if the hyperplane is not of that form.
+static int get_tile_constraints(const Stmt *stmt, unsigned depth, int *col,
+                                int *lb_row, int *ub_row) {
+  const PlutoMatrix *trans = stmt->trans;
+  const PlutoConstraints *dom = stmt->domain;
+
+  if (dom->next != NULL)
+    return 0;
+
+  int c = -1;
+  for (unsigned j = 0; j < trans->ncols; j++) {
+    if (trans->val[depth][j] == 0)
+      continue;
+    if (c != -1 || j >= stmt->dim || trans->val[depth][j] != 1)
+      return 0;
+    c = j;
+  }
+  if (c == -1 || strncmp(stmt->iterators[c], "zT", 2))
+    return 0;
+
+  int lb = -1, ub = -1;
+  for (unsigned r = 0; r < dom->nrows; r++) {
+    if (dom->val[r][c] == 0)
+      continue;
+    if (dom->is_eq[r])
+      return 0;
+    if (dom->val[r][c] < 0 && lb == -1) {
+      lb = r;
+    } else if (dom->val[r][c] > 0 && ub == -1) {
+      ub = r;
+    } else {
+      return 0;
+    }
+  }
+  if (lb == -1 || ub == -1)
+    return 0;
+
+  int64_t tile_size = dom->val[ub][c];
+  if (dom->val[lb][c] != -tile_size)
+    return 0;
+  for (unsigned j = 0; j < dom->ncols - 1; j++) {
+    if (j != (unsigned)c && dom->val[lb][j] != -dom->val[ub][j])
+      return 0;
+  }
+  if (dom->val[lb][dom->ncols - 1] + dom->val[ub][dom->ncols - 1] !=
+      tile_size - 1)
+    return 0;
+
+  *col = c;
+  *lb_row = lb;
+  *ub_row = ub;
+  return tile_size;
+}
+
+/// Returns the size of the tiles scanned by the hyperplane at `depth' of
+/// `stmt' if it is a tile space loop (see get_tile_constraints), 0 otherwise.
+int pluto_get_tile_size(const Stmt *stmt, unsigned depth) {
+  int col, lb, ub;
+  return get_tile_constraints(stmt, depth, &col, &lb, &ub);
+}
+
+/// With --parametric-tiles, finds the hyperplanes that are tile space loops
+/// for all statements they are loops for. tile_sizes[d] is set to the tile
+/// size used at depth d (the default value of its tile size variable), or 0
+/// if the tile size at that depth stays a constant. Returns the number of
+/// parametric tile sizes.
+unsigned pluto_get_parametric_tile_sizes(const PlutoProg *prog,
+                                         int *tile_sizes) {
+  unsigned num_tile_sizes = 0;
+  PlutoOptions *options = prog->context->options;
+
+  for (unsigned d = 0; d < prog->num_hyperplanes; d++) {
+    tile_sizes[d] = 0;
+    if (!options->parametric_tiles)
+      continue;
+    int tile_size = 0;
+    unsigned i;
+    for (i = 0; i < prog->nstmts; i++) {
+      Stmt *stmt = prog->stmts[i];
+      if (pluto_is_hyperplane_scalar(stmt, d))
+        continue;
+      int col, lb, ub;
+      int size = get_tile_constraints(stmt, d, &col, &lb, &ub);
+      if (size == 0)
+        break;
+      if (tile_size == 0)
+        tile_size = size;
+    }
+    if (i == prog->nstmts && tile_size > 0) {
+      tile_sizes[d] = tile_size;
+      num_tile_sizes++;
+    }
+  }
+  return num_tile_sizes;
+}
+
+/// Rewrites the tile constraints of the domain `dom' of `stmt' (a copy of its
+/// domain with the tile size parameters appended) from T*c <= f(i) <= T*c +
+/// T - 1 to c <= f(i) <= c + tsK - 1: the supernode c becomes the origin of
+/// the tile. The tile loops are made to step over multiples of the tile sizes
+/// in the AST (see pluto_parametrize_tile_loops).
+static void parametrize_tile_constraints(const Stmt *stmt,
+                                         PlutoConstraints *dom,
+                                         const int *tile_sizes,
+                                         const PlutoProg *prog) {
+  unsigned k = 0;
+  for (unsigned d = 0; d < prog->num_hyperplanes; d++) {
+    if (tile_sizes[d] == 0)
+      continue;
+    int col, lb, ub;
+    int size = get_tile_constraints(stmt, d, &col, &lb, &ub);
+    if (size > 0) {
+      dom->val[lb][col] = -1;
+      dom->val[ub][col] = 1;
+      dom->val[ub][stmt->dim + prog->npar + k] = 1;
+      dom->val[ub][dom->ncols - 1] -= size;
+    }
+    k++;
+  }
+}
+
+/// Returns the context of the generated code: the parameter context and the
+/// codegen context, followed by tsK >= 1 for each of the `num_tile_params'
+/// tile size parameters.
+static PlutoConstraints *get_cloog_context(const PlutoProg *prog,
+                                           unsigned num_tile_params) {
+  PlutoConstraints *param_ctx = pluto_constraints_dup(prog->param_context);
+  pluto_constraints_intersect_isl(param_ctx, prog->codegen_context);
+  for (unsigned k = 0; k < num_tile_params; k++) {
+    /* tsK >= 1 */
+    pluto_constraints_add_dim(param_ctx, param_ctx->ncols - 1, NULL);
+    pluto_constraints_add_inequality(param_ctx);
+    param_ctx->val[param_ctx->nrows - 1][param_ctx->ncols - 2] = 1;
+    param_ctx->val[param_ctx->nrows - 1][param_ctx->ncols - 1] = -1;
+  }
+  return param_ctx;
+}
+
+/// Returns the domain of `stmt' as given to CLooG: with tile size parameters
+/// appended and the tile constraints rewritten for them if there are any.
+static PlutoConstraints *get_cloog_domain(const Stmt *stmt,
+                                          const int *tile_sizes,
+                                          unsigned num_tile_params,
+                                          const PlutoProg *prog) {
+  PlutoConstraints *dom = pluto_constraints_dup(stmt->domain);
+  if (num_tile_params > 0) {
+    for (unsigned k = 0; k < num_tile_params; k++) {
+      pluto_constraints_add_dim(dom, dom->ncols - 1, NULL);
+    }
+    parametrize_tile_constraints(stmt, dom, tile_sizes, prog);
+  }
+  return dom;
+}
+
+/// Returns the scattering function of `stmt' as given to CLooG.
+static PlutoConstraints *get_cloog_scattering(const Stmt *stmt,
+                                              unsigned num_tile_params) {
+  PlutoConstraints *sched = pluto_stmt_get_schedule(stmt);
+  for (unsigned k = 0; k < num_tile_params; k++) {
+    pluto_constraints_add_dim(sched, sched->ncols - 1, NULL);
+  }
+  return sched;
+}
+
 /* Generate and print .cloog file from the transformations computed */
 void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog) {
   int i;
@@ -73,9 +246,13 @@ void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog) {
   fprintf(fp, "# language: C\n");
   fprintf(fp, "c\n\n");
 
+  /* Tile sizes that are parameters (--parametric-tiles); they come after the
+   * program parameters */
+  int tile_sizes[prog->num_hyperplanes];
+  unsigned num_tile_params = pluto_get_parametric_tile_sizes(prog, tile_sizes);
+
   /* Context: setting conditions on parameters */
-  PlutoConstraints *param_ctx = pluto_constraints_dup(prog->param_context);
-  pluto_constraints_intersect_isl(param_ctx, prog->codegen_context);
+  PlutoConstraints *param_ctx = get_cloog_context(prog, num_tile_params);
   pluto_constraints_print_polylib(fp, param_ctx);
   pluto_constraints_free(param_ctx);
 
@@ -84,6 +261,10 @@ void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog) {
   for (i = 0; i < npar; i++) {
     fprintf(fp, "%s ", prog->params[i]);
   }
+  for (i = 0; i < prog->num_hyperplanes; i++) {
+    if (tile_sizes[i] > 0)
+      fprintf(fp, "ts%d ", i + 1);
+  }
   fprintf(fp, "\n\n");
 
   fprintf(fp, "# Number of statements\n");
@@ -92,7 +273,10 @@ void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog) {
   /* Print statement domains */
   for (i = 0; i < nstmts; i++) {
     fprintf(fp, "# S%d (%s)\n", stmts[i]->id + 1, stmts[i]->text);
-    pluto_constraints_print_polylib(fp, stmts[i]->domain);
+    PlutoConstraints *dom =
+        get_cloog_domain(stmts[i], tile_sizes, num_tile_params, prog);
+    pluto_constraints_print_polylib(fp, dom);
+    pluto_constraints_free(dom);
     fprintf(fp, "0 0 0\n\n");
   }
 
@@ -106,7 +290,7 @@ void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog) {
     /* Print scattering functions */
     for (i = 0; i < nstmts; i++) {
       fprintf(fp, "# T(S%d)\n", i + 1);
-      PlutoConstraints *sched = pluto_stmt_get_schedule(stmts[i]);
+      PlutoConstraints *sched = get_cloog_scattering(stmts[i], num_tile_params);
       pluto_constraints_print_polylib(fp, sched);
       fprintf(fp, "\n");
       pluto_constraints_free(sched);
@@ -124,6 +308,66 @@ void pluto_gen_cloog_file(FILE *fp, const PlutoProg *prog) {
   }
 }
 
+/// Builds the input of CLooG for `prog' in `ctx': the same context, domains,
+/// scattering functions and names as written out by pluto_gen_cloog_file, but
+/// without going through the text format. Iterator names are left for CLooG
+/// to set.
+static CloogInput *pluto_gen_cloog_input(const PlutoProg *prog, isl_ctx *ctx) {
+  Stmt **stmts = prog->stmts;
+  unsigned nstmts = prog->nstmts;
+  PlutoContext *context = prog->context;
+  char name[16];
+
+  IF_DEBUG(printf("[pluto] generating Cloog input...\n"));
+
+  int tile_sizes[prog->num_hyperplanes];
+  unsigned num_tile_params = pluto_get_parametric_tile_sizes(prog, tile_sizes);
+  int npar = prog->npar + num_tile_params;
+
+  PlutoConstraints *param_ctx = get_cloog_context(prog, num_tile_params);
+  CloogDomain *cloog_ctx = cloog_domain_from_isl_set(
+      isl_set_from_pluto_constraints_params(param_ctx, npar, ctx));
+  pluto_constraints_free(param_ctx);
+
+  CloogUnionDomain *ud = cloog_union_domain_alloc(npar);
+  for (unsigned i = 0; i < nstmts; i++) {
+    PlutoConstraints *dom =
+        get_cloog_domain(stmts[i], tile_sizes, num_tile_params, prog);
+    CloogDomain *domain = cloog_domain_from_isl_set(
+        isl_set_from_pluto_constraints_params(dom, npar, ctx));
+    pluto_constraints_free(dom);
+
+    CloogScattering *scattering = NULL;
+    if (stmts[0]->trans != NULL) {
+      PlutoConstraints *sched = get_cloog_scattering(stmts[i], num_tile_params);
+      isl_basic_map *bmap = isl_basic_map_from_pluto_constraints(
+          ctx, sched, stmts[i]->dim, stmts[i]->trans->nrows, npar);
+      scattering =
+          cloog_scattering_from_isl_map(isl_map_from_basic_map(bmap));
+      pluto_constraints_free(sched);
+    }
+    ud = cloog_union_domain_add_domain(ud, NULL, domain, scattering, NULL);
+  }
+
+  for (int i = 0; i < prog->npar; i++) {
+    ud = cloog_union_domain_set_name(ud, CLOOG_PARAM, i, prog->params[i]);
+  }
+  for (unsigned i = 0, k = prog->npar; i < prog->num_hyperplanes; i++) {
+    if (tile_sizes[i] == 0)
+      continue;
+    snprintf(name, sizeof(name), "ts%u", i + 1);
+    ud = cloog_union_domain_set_name(ud, CLOOG_PARAM, k++, name);
+  }
+  if (nstmts >= 1 && stmts[0]->trans != NULL) {
+    for (unsigned i = 0; i < stmts[0]->trans->nrows; i++) {
+      snprintf(name, sizeof(name), "t%u", i + 1);
+      ud = cloog_union_domain_set_name(ud, CLOOG_SCAT, i, name);
+    }
+  }
+
+  return cloog_input_alloc(cloog_ctx, ud);
+}
+
 static void gen_stmt_macro(const Stmt *stmt, PlutoOptions *options,
                            FILE *outfp) {
   int j;
@@ -172,6 +416,9 @@ int generate_declarations(const PlutoProg *prog, FILE *outfp) {
   }
   fprintf(outfp, "\n");
 
+  int tile_sizes[prog->num_hyperplanes];
+  unsigned num_tile_params = pluto_get_parametric_tile_sizes(prog, tile_sizes);
+
   /* Scattering iterators. */
   if (prog->num_hyperplanes >= 1) {
     fprintf(outfp, "\t\tint ");
@@ -182,13 +429,55 @@ int generate_declarations(const PlutoProg *prog, FILE *outfp) {
       if (prog->hProps[i].unroll) {
         fprintf(outfp, ", t%dt, newlb_t%d, newub_t%d", i + 1, i + 1, i + 1);
       }
+      if (tile_sizes[i] > 0) {
+        fprintf(outfp, ", t%dtile", i + 1);
+      }
     }
     fprintf(outfp, ";\n\n");
   }
 
+  /* Tile sizes (--parametric-tiles) */
+  if (num_tile_params > 0) {
+    fprintf(outfp, "\t/* Tile sizes; can be set at run time through "
+                   "PLUTO_TILE_SIZES=<s1>,<s2>,... */\n");
+    const char *sep = "";
+    fprintf(outfp, "\tint ");
+    for (i = 0; i < prog->num_hyperplanes; i++) {
+      if (tile_sizes[i] == 0)
+        continue;
+      fprintf(outfp, "%sts%d = %d", sep, i + 1, tile_sizes[i]);
+      sep = ", ";
+    }
+    fprintf(outfp, ";\n");
+    fprintf(outfp, "\t{\n");
+    fprintf(outfp, "\t\tchar *tsenv = getenv(\"PLUTO_TILE_SIZES\");\n");
+    fprintf(outfp, "\t\tint *tsvars[] = {");
+    sep = "";
+    for (i = 0; i < prog->num_hyperplanes; i++) {
+      if (tile_sizes[i] == 0)
+        continue;
+      fprintf(outfp, "%s&ts%d", sep, i + 1);
+      sep = ", ";
+    }
+    fprintf(outfp, "};\n");
+    fprintf(outfp, "\t\tfor (int tsi = 0; tsenv && tsi < %u; tsi++) {\n",
+            num_tile_params);
+    fprintf(outfp, "\t\t\tlong ts = strtol(tsenv, &tsenv, 10);\n");
+    fprintf(outfp, "\t\t\tif (ts >= 1)\n");
+    fprintf(outfp, "\t\t\t\t*tsvars[tsi] = ts;\n");
+    fprintf(outfp, "\t\t\ttsenv = (*tsenv == ',') ? tsenv + 1 : NULL;\n");
+    fprintf(outfp, "\t\t}\n");
+    fprintf(outfp, "\t}\n\n");
+  }
+
   if (prog->context->options->parallel) {
     fprintf(outfp, "\tint lb, ub, lbp, ubp, lb2, ub2;\n");
   }
+  if (prog->ntask_bands > 0 && !prog->context->options->dynschedule) {
+    /* Elements whose addresses stand for tiles in depend clauses */
+    fprintf(outfp, "\tstatic char pluto_task_deps[%u];\n",
+            1u << TASK_DEP_SLOT_BITS);
+  }
   /* For vectorizable loop bound replacement */
   fprintf(outfp, "\tregister int lbv, ubv;\n\n");
 
@@ -201,12 +490,731 @@ int generate_declarations(const PlutoProg *prog, FILE *outfp) {
  *
  * --cloogf, --cloogl overrides everything; next cloogf, cloogl if != -1,
  *  then the function takes care of the rest
+ *
+ * cloogfp: .cloog file to read the input of CLooG from; if NULL, the input is
+ * built in memory from prog (see pluto_gen_cloog_input)
  */
+/// Returns true if `acc' of `stmt', once transformed, accesses consecutive
+/// elements along the loop at `depth' starting from a multiple of
+/// `align_elems' elements: its last subscript has a coefficient of one for
+/// the loop and multiples of `align_elems' elsewhere, and the other
+/// subscripts don't vary with the loop.
+static bool is_aligned_access(const PlutoAccess *acc, const Stmt *stmt,
+                              unsigned depth, unsigned align_elems) {
+  if (acc->mat->nrows == 0)
+    return false;
+  int *divs;
+  PlutoMatrix *newacc = pluto_get_new_access_func(acc->mat, stmt, &divs);
+  unsigned last = newacc->nrows - 1;
+  bool aligned = newacc->val[last][depth] == divs[last];
+  for (unsigned c = 0; c < newacc->ncols && aligned; c++) {
+    if (c != depth && newacc->val[last][c] % (divs[last] * align_elems) != 0)
+      aligned = false;
+  }
+  for (unsigned r = 0; r < last && aligned; r++) {
+    if (newacc->val[r][depth] != 0)
+      aligned = false;
+  }
+  pluto_matrix_free(newacc);
+  free(divs);
+  return aligned;
+}
+
+/// Returns true if all the accesses to the array `name' under `loop' are
+/// aligned (see is_aligned_access).
+static bool is_aligned_array(const char *name, const Ploop *loop,
+                             unsigned align_elems) {
+  for (unsigned i = 0; i < loop->nstmts; i++) {
+    const Stmt *stmt = loop->stmts[i];
+    for (int j = 0; j < stmt->nreads + stmt->nwrites; j++) {
+      const PlutoAccess *acc = j < stmt->nreads
+                                   ? stmt->reads[j]
+                                   : stmt->writes[j - stmt->nreads];
+      if (!strcmp(acc->name, name) &&
+          !is_aligned_access(acc, stmt, loop->depth, align_elems))
+        return false;
+    }
+  }
+  return true;
+}
+
+/// Returns the OpenMP SIMD pragma for `loop' (to be freed by the caller). Its
+/// clauses are:
+///   simdlen: the vector length of the tile configuration of its statements,
+///     or the number of elements in a vector register of --target;
+///   safelen: the minimum dependence distance along the loop if it isn't
+///     parallel (see pluto_loop_get_safelen);
+///   aligned: with --array-alignment, the arrays that are only accessed at
+///     consecutive elements starting at aligned offsets;
+///   reduction: the reductions the loop carries (see
+///     pluto_loop_get_reduction_clause).
+char *pluto_get_simd_pragma(const Ploop *loop, const PlutoProg *prog) {
+  PlutoOptions *options = prog->context->options;
+  unsigned elem_size = options->data_element_size
+                           ? options->data_element_size
+                           : prog->data_element_size ? prog->data_element_size
+                                                     : sizeof(double);
+
+  unsigned safelen = pluto_loop_get_safelen(loop, prog);
+
+  unsigned simdlen = loop->nstmts > 0 ? loop->stmts[0]->vector_length : 0;
+  for (unsigned i = 1; i < loop->nstmts; i++) {
+    if (loop->stmts[i]->vector_length != simdlen)
+      simdlen = 0;
+  }
+  const PlutoTarget *target = pluto_get_target(options->target);
+  if (simdlen == 0 && target != pluto_get_target(kTargetGeneric)) {
+    simdlen = target->vector_width / elem_size;
+  }
+  if (safelen >= 2 && simdlen > safelen) {
+    simdlen = safelen;
+  }
+
+  /* Arrays for the aligned clause */
+  const char **arrays = NULL;
+  unsigned narrays = 0;
+  size_t len = 64;
+  unsigned align = options->array_alignment;
+  if (align > 0 && align % elem_size == 0) {
+    for (unsigned i = 0; i < loop->nstmts; i++) {
+      const Stmt *stmt = loop->stmts[i];
+      for (int j = 0; j < stmt->nreads + stmt->nwrites; j++) {
+        const PlutoAccess *acc = j < stmt->nreads
+                                     ? stmt->reads[j]
+                                     : stmt->writes[j - stmt->nreads];
+        unsigned k;
+        for (k = 0; k < narrays; k++) {
+          if (!strcmp(arrays[k], acc->name))
+            break;
+        }
+        if (k < narrays || !is_aligned_array(acc->name, loop,
+                                             align / elem_size))
+          continue;
+        arrays = (const char **)realloc(arrays,
+                                        (narrays + 1) * sizeof(const char *));
+        arrays[narrays++] = acc->name;
+        len += strlen(acc->name) + 1;
+      }
+    }
+  }
+
+  char *clause;
+  pluto_loop_get_reduction_clause(loop, prog, &clause);
+  if (clause) {
+    len += strlen(clause) + 1;
+  }
+
+  char *pragma = (char *)malloc(len);
+  strcpy(pragma, "#pragma omp simd");
+  if (simdlen >= 2) {
+    sprintf(pragma + strlen(pragma), " simdlen(%u)", simdlen);
+  }
+  if (safelen >= 2) {
+    sprintf(pragma + strlen(pragma), " safelen(%u)", safelen);
+  }
+  for (unsigned i = 0; i < narrays; i++) {
+    sprintf(pragma + strlen(pragma), "%s%s", i == 0 ? " aligned(" : ",",
+            arrays[i]);
+  }
+  if (narrays > 0) {
+    sprintf(pragma + strlen(pragma), ":%u)", align);
+  }
+  if (clause) {
+    sprintf(pragma + strlen(pragma), " %s", clause);
+  }
+  free(arrays);
+  free(clause);
+
+  return pragma;
+}
+
+/// Returns the clauses to append to the parallel for pragma of `loop', run
+/// collapsed with the `collapse' - 1 loops inside (see
+/// pluto_get_clast_collapse_counts): the reduction clauses of the reductions
+/// it carries, collapse(<n>) with --omp-collapse, and the schedule of its
+/// iterations with --omp-schedule (see pluto_loop_get_omp_schedule). Returns
+/// NULL if there are none.
+char *pluto_get_omp_loop_clauses(const Ploop *loop, unsigned collapse,
+                                 const PlutoProg *prog) {
+  PlutoOptions *options = prog->context->options;
+  char *reduction, *schedule = NULL;
+  pluto_loop_get_reduction_clause(loop, prog, &reduction);
+  if (options->omp_schedule)
+    schedule = pluto_loop_get_omp_schedule(loop, prog);
+  if (!options->omp_collapse)
+    collapse = 1;
+  if (!reduction && !schedule && collapse <= 1)
+    return NULL;
+
+  char *clauses = (char *)malloc((reduction ? strlen(reduction) : 0) +
+                                 (schedule ? strlen(schedule) : 0) + 32);
+  clauses[0] = '\0';
+  if (reduction)
+    strcat(clauses, reduction);
+  if (collapse > 1)
+    sprintf(clauses + strlen(clauses), "%scollapse(%u)",
+            clauses[0] ? " " : "", collapse);
+  if (schedule)
+    sprintf(clauses + strlen(clauses), "%s%s", clauses[0] ? " " : "",
+            schedule);
+  free(reduction);
+  free(schedule);
+  return clauses;
+}
+
+/// Returns the number of lines of `code' that start with `marker' (after
+/// indentation).
+static unsigned count_marker_lines(const char *code, const char *marker) {
+  unsigned num = 0;
+  for (const char *line = code; *line;) {
+    if (!strncmp(line + strspn(line, " \t"), marker, strlen(marker)))
+      num++;
+    const char *end = strchr(line, '\n');
+    if (!end)
+      break;
+    line = end + 1;
+  }
+  return num;
+}
+
+/// Returns the number of loops of the deepest statement of `tband'.
+static unsigned get_task_band_max_depth(const PlutoTaskBand *tband) {
+  const Ploop *loop = tband->band->loop;
+  unsigned max_depth = 0;
+  for (unsigned i = 0; i < loop->nstmts; i++) {
+    max_depth = PLMAX(max_depth, loop->stmts[i]->trans->nrows);
+  }
+  return max_depth;
+}
+
+/// Returns the index in pluto_task_deps of the tile at `offsets' before the
+/// current one of `tband'; e.g., ((t1-1)&63)*64+((t2)&63).
+static void print_task_dep_slot(char *str, const PlutoTaskBand *tband,
+                                const unsigned *offsets) {
+  unsigned h = tband->ndep_dims;
+  unsigned slots = 1u << (TASK_DEP_SLOT_BITS / h);
+  unsigned depth = tband->band->loop->depth;
+  str[0] = '\0';
+  for (unsigned k = 0; k < h; k++) {
+    if (k > 0) {
+      /* Wrap what precedes so that it is scaled as a whole */
+      memmove(str + 1, str, strlen(str) + 1);
+      str[0] = '(';
+      sprintf(str + strlen(str), ")*%u+", slots);
+    }
+    if (offsets[k] > 0)
+      sprintf(str + strlen(str), "((t%u-%u)&%u)", depth + k + 1, offsets[k],
+              slots - 1);
+    else
+      sprintf(str + strlen(str), "((t%u)&%u)", depth + k + 1, slots - 1);
+  }
+}
+
+/// Returns the pragma of the task running a tile of `tband': the iterators
+/// of the tile space loops are firstprivate and those of the loops inside
+/// private, and the task depends on the tiles at the distances the
+/// dependences between tiles have (see pluto_create_task_band), whose
+/// addresses in pluto_task_deps stand for them.
+static char *get_task_pragma(const PlutoTaskBand *tband,
+                             const PlutoProg *prog) {
+  const Ploop *loop = tband->band->loop;
+  unsigned last = loop->depth + tband->band->width;
+  unsigned max_depth = get_task_band_max_depth(tband);
+
+  unsigned ndeps = 1;
+  for (unsigned k = 0; k < tband->ndep_dims; k++) {
+    ndeps *= tband->max_dists[k] + 1;
+  }
+  size_t slot_len = 40 * tband->ndep_dims + 8;
+  char *pragma =
+      (char *)malloc(128 + 16 * max_depth + (ndeps + 1) * (slot_len + 24));
+  char *slot = (char *)malloc(slot_len);
+
+  strcpy(pragma, "#pragma omp task firstprivate(");
+  for (unsigned d = 1; d <= last; d++) {
+    sprintf(pragma + strlen(pragma), "%st%u", d > 1 ? "," : "", d);
+  }
+  strcat(pragma, ") private(");
+  for (unsigned d = last + 1; d <= max_depth; d++) {
+    sprintf(pragma + strlen(pragma), "t%u,", d);
+  }
+  strcat(pragma, "lbv,ubv)");
+
+  unsigned offsets[3] = {0, 0, 0};
+  print_task_dep_slot(slot, tband, offsets);
+  sprintf(pragma + strlen(pragma), " depend(out:pluto_task_deps[%s])", slot);
+
+  /* All the offsets up to the maximum distances but the tile itself */
+  bool first = true;
+  for (unsigned n = 1; n < ndeps; n++) {
+    unsigned rem = n;
+    for (int k = tband->ndep_dims - 1; k >= 0; k--) {
+      offsets[k] = rem % (tband->max_dists[k] + 1);
+      rem /= tband->max_dists[k] + 1;
+    }
+    print_task_dep_slot(slot, tband, offsets);
+    sprintf(pragma + strlen(pragma), "%spluto_task_deps[%s]",
+            first ? " depend(in:" : ",", slot);
+    first = false;
+  }
+  if (!first)
+    strcat(pragma, ")");
+
+  free(slot);
+  return pragma;
+}
+
+/// Checks if the outer two tile space loops of `tband', whose code starts at
+/// `code' (the line after the parallel for pragma), are perfectly nested, so
+/// that they can run as doacross loops. If so, sets `lb' and `ub' to the
+/// bounds of the second loop (to be freed).
+static bool get_doacross_bounds(const char *code, const PlutoTaskBand *tband,
+                                char **lb, char **ub) {
+  unsigned depth = tband->band->loop->depth;
+  char prefix[16], cond[16], incr[24];
+  sprintf(prefix, "for (t%u=", depth + 1);
+  if (strncmp(code + strspn(code, " \t"), prefix, strlen(prefix)))
+    return false;
+  const char *line = strchr(code, '\n');
+  if (!line)
+    return false;
+  line++;
+  const char *header = line + strspn(line, " \t");
+  sprintf(prefix, "for (t%u=", depth + 2);
+  sprintf(cond, ";t%u<=", depth + 2);
+  sprintf(incr, ";t%u++) {\n", depth + 2);
+  const char *eol = strchr(header, '\n');
+  const char *lb_end = strstr(header, cond);
+  if (strncmp(header, prefix, strlen(prefix)) || !eol || !lb_end ||
+      lb_end > eol)
+    return false;
+  const char *ub_start = lb_end + strlen(cond);
+  const char *ub_end = strstr(ub_start, incr);
+  if (!ub_end || ub_end + strlen(incr) != eol + 1)
+    return false;
+
+  /* The second loop must be all the body of the first */
+  int depth_diff = 0;
+  do {
+    const char *end = strchr(line, '\n');
+    if (!end)
+      return false;
+    for (const char *c = line; c < end; c++) {
+      if (*c == '{')
+        depth_diff++;
+      else if (*c == '}')
+        depth_diff--;
+    }
+    line = end + 1;
+  } while (depth_diff > 0);
+  if (line[strspn(line, " \t")] != '}')
+    return false;
+
+  *lb = strndup(header + strlen(prefix), lb_end - header - strlen(prefix));
+  *ub = strndup(ub_start, ub_end - ub_start);
+  return true;
+}
+
+/// Prints, at `indent', code that sets lb2 and ub2 to the smallest lower
+/// bound `lb' and largest upper bound `ub' the second loop of a doacross
+/// loop nest has over the iterations of the first one, whose header is
+/// `header': loops associated with ordered(2) need bounds that don't depend
+/// on outer iterators.
+static void print_doacross_bounds(FILE *outfp, int indent, const char *header,
+                                  const char *lb, const char *ub) {
+  fprintf(outfp, "%*slb2 = 0;\n", indent, "");
+  fprintf(outfp, "%*sub2 = -1;\n", indent, "");
+  fwrite(header, 1, strcspn(header, "\n") + 1, outfp);
+  fprintf(outfp, "%*s  if (ub2 < lb2) {\n", indent, "");
+  fprintf(outfp, "%*s    lb2 = %s;\n", indent, "", lb);
+  fprintf(outfp, "%*s    ub2 = %s;\n", indent, "", ub);
+  fprintf(outfp, "%*s  } else {\n", indent, "");
+  fprintf(outfp, "%*s    lb2 = min(lb2, %s);\n", indent, "", lb);
+  fprintf(outfp, "%*s    ub2 = max(ub2, %s);\n", indent, "", ub);
+  fprintf(outfp, "%*s  }\n", indent, "");
+  fprintf(outfp, "%*s}\n", indent, "");
+}
+
+/// Prints the parallel for pragma `line' (ending at `end') of the first
+/// doacross loop with ordered(2) and a cyclic schedule: each thread then runs
+/// every nth iteration, so that an iteration only waits on its neighbours
+/// being run concurrently, while with blocks of iterations, the first one of
+/// a thread would wait on the last one of the previous thread. Drops the
+/// schedule clause the pragma might have had (see pluto_get_omp_loop_clauses).
+static void print_doacross_pragma(FILE *outfp, const char *line,
+                                  const char *end) {
+  const char *sched = strstr(line, " schedule(");
+  if (sched && sched < end) {
+    const char *sched_end = strchr(sched, ')');
+    fwrite(line, 1, sched - line, outfp);
+    line = sched_end + 1;
+  }
+  fprintf(outfp, "%.*s schedule(static,1) ordered(2)\n", (int)(end - line),
+          line);
+}
+
+/// Returns the ordered pragma with which an iteration of the doacross loops
+/// of `tband' waits for the tiles it depends on (along the outer two
+/// dimensions of the band, see pluto_create_task_band), e.g.,
+/// "#pragma omp ordered depend(sink:t1-1,t2) depend(sink:t1,t2-1)".
+static char *get_doacross_sink_pragma(const PlutoTaskBand *tband) {
+  unsigned depth = tband->band->loop->depth;
+  unsigned dists[2] = {tband->max_dists[0], tband->max_dists[1]};
+  unsigned ndeps = (dists[0] + 1) * (dists[1] + 1);
+  char *pragma = (char *)malloc(32 + ndeps * 48);
+
+  strcpy(pragma, "#pragma omp ordered");
+  for (unsigned n = 1; n < ndeps; n++) {
+    unsigned offsets[2] = {n / (dists[1] + 1), n % (dists[1] + 1)};
+    strcat(pragma, " depend(sink:");
+    for (unsigned k = 0; k < 2; k++) {
+      sprintf(pragma + strlen(pragma), k > 0 ? ",t%u" : "t%u", depth + k + 1);
+      if (offsets[k] > 0)
+        sprintf(pragma + strlen(pragma), "-%u", offsets[k]);
+    }
+    strcat(pragma, ")");
+  }
+  return pragma;
+}
+
+/// Prints the code of the parallel region of `tband' for the dynamic
+/// scheduling runtime (--dynschedule, see include/pluto/dynschedule.h), at
+/// `indent': `enum_code', the tile space loops of the band with the tiles
+/// added to the graph instead of run, is followed by a parallel region whose
+/// threads run the tiles as they get ready, each with the body of the
+/// innermost tile space loop that added it (one of `bodies'). If
+/// `sequential', some statements run outside the tiles, and the bodies are
+/// put back in the loops instead.
+static void print_dyn_region(FILE *outfp, int indent,
+                             const PlutoTaskBand *tband, const char *enum_code,
+                             char **bodies, unsigned nbodies,
+                             bool sequential) {
+  if (sequential) {
+    for (const char *line = enum_code; *line;) {
+      const char *end = strchr(line, '\n');
+      size_t line_len = end ? (size_t)(end - line + 1) : strlen(line);
+      unsigned copy;
+      if (sscanf(line, " pluto_dyn_add_tile(pluto_dyn, %u,", &copy) == 1 &&
+          copy < nbodies) {
+        fputs(bodies[copy], outfp);
+      } else {
+        fwrite(line, 1, line_len, outfp);
+      }
+      line += line_len;
+    }
+    return;
+  }
+
+  unsigned depth = tband->band->loop->depth;
+  unsigned width = tband->band->width;
+  fprintf(outfp, "%*s{\n", indent, "");
+  fprintf(outfp,
+          "%*s  PlutoDynGraph *pluto_dyn = pluto_dyn_alloc(%u, %u, "
+          "(const unsigned[]){",
+          indent, "", width, tband->ndep_dims);
+  for (unsigned k = 0; k < tband->ndep_dims; k++) {
+    fprintf(outfp, "%s%u", k > 0 ? ", " : "", tband->max_dists[k]);
+  }
+  fprintf(outfp, "});\n");
+  fputs(enum_code, outfp);
+  fprintf(outfp, "%*s  pluto_dyn_schedule(pluto_dyn);\n", indent, "");
+  fprintf(outfp, "%*s#pragma omp parallel private(", indent, "");
+  for (unsigned d = depth + 1; d <= get_task_band_max_depth(tband); d++) {
+    fprintf(outfp, "t%u,", d);
+  }
+  fprintf(outfp, "lbv,ubv)\n");
+  fprintf(outfp, "%*s  {\n", indent, "");
+  fprintf(outfp, "%*s    long pluto_dyn_tile;\n", indent, "");
+  fprintf(outfp,
+          "%*s    while ((pluto_dyn_tile = pluto_dyn_next(pluto_dyn)) >= 0) "
+          "{\n",
+          indent, "");
+  fprintf(outfp,
+          "%*s      const int *pluto_dyn_coords = "
+          "pluto_dyn_get_coords(pluto_dyn, pluto_dyn_tile);\n",
+          indent, "");
+  for (unsigned k = 0; k < width; k++) {
+    fprintf(outfp, "%*s      t%u = pluto_dyn_coords[%u];\n", indent, "",
+            depth + k + 1, k);
+  }
+  fprintf(outfp,
+          "%*s      switch (pluto_dyn_get_copy(pluto_dyn, pluto_dyn_tile)) "
+          "{\n",
+          indent, "");
+  for (unsigned copy = 0; copy < nbodies; copy++) {
+    fprintf(outfp, "%*s      case %u: {\n", indent, "", copy);
+    fputs(bodies[copy], outfp);
+    fprintf(outfp, "%*s        break;\n", indent, "");
+    fprintf(outfp, "%*s      }\n", indent, "");
+  }
+  fprintf(outfp, "%*s      }\n", indent, "");
+  fprintf(outfp, "%*s      pluto_dyn_done(pluto_dyn, pluto_dyn_tile);\n",
+          indent, "");
+  fprintf(outfp, "%*s    }\n", indent, "");
+  fprintf(outfp, "%*s  }\n", indent, "");
+  fprintf(outfp, "%*s  pluto_dyn_free(pluto_dyn);\n", indent, "");
+  fprintf(outfp, "%*s}\n", indent, "");
+}
+
+/// Prints the clast `root' to `outfp' with the OpenMP pragmas CLooG can't
+/// emit:
+///   - the ivdep and vector always pragmas of vectorizable loops are
+///     replaced by OpenMP SIMD ones (see pluto_get_simd_pragma) if
+///     `omp_simd' is set;
+///   - the reduction, collapse and schedule clauses of the parallel loops
+///     (see pluto_get_omp_loop_clauses) are appended to their parallel for
+///     pragmas;
+///   - the outermost loops of task bands (marked parallel) are run by a
+///     single thread of a parallel region, and the bodies of their innermost
+///     tile space loops become tasks (see get_task_pragma). Statements run
+///     outside the tasks (when CLooG doesn't print a loop for the innermost
+///     dimension) first wait for the tasks created before. With
+///     --dynschedule, the tiles are run by the dynamic scheduling runtime
+///     instead (see print_dyn_region). With --doacross, the outer two tile
+///     space loops are instead run as doacross loops if they are perfectly
+///     nested, with a cyclic schedule (see print_doacross_pragma): the
+///     bounds of the second one are widened to those over all iterations of
+///     the first (see print_doacross_bounds) and its body is
+///     guarded by the original ones, and each iteration waits for the tiles
+///     it depends on (see get_doacross_sink_pragma) before running its tile
+///     and signals its completion after.
+static void print_clast_openmp(FILE *outfp, struct clast_stmt *root,
+                               CloogOptions *cloogOptions,
+                               const PlutoProg *prog, bool omp_simd) {
+  char *code = NULL;
+  size_t size = 0;
+  FILE *fp = open_memstream(&code, &size);
+  clast_pprint(fp, root, 0, cloogOptions);
+  fclose(fp);
+
+  unsigned nvloops = 0, nploops;
+  Ploop **vloops = NULL;
+  if (omp_simd) {
+    vloops = pluto_get_clast_marked_loops(root, prog, CLAST_PARALLEL_VEC,
+                                          &nvloops);
+  }
+  Ploop **ploops =
+      pluto_get_clast_marked_loops(root, prog, CLAST_PARALLEL_OMP, &nploops);
+  unsigned ncollapse;
+  unsigned *collapse = pluto_get_clast_collapse_counts(root, prog, &ncollapse);
+  assert(ncollapse == nploops);
+
+  /* Check that CLooG printed one marker per loop before rewriting them */
+  if (omp_simd && count_marker_lines(code, "#pragma ivdep\n") != nvloops) {
+    printf("[pluto] WARNING: vector loops not found in the CLooG output; "
+           "keeping ivdep pragmas\n");
+    omp_simd = false;
+  }
+  bool omp_loops = true;
+  if (count_marker_lines(code, "#pragma omp parallel for") != nploops) {
+    omp_loops = false;
+    if (prog->ntask_bands > 0) {
+      /* The loops of task bands aren't parallel */
+      printf("[pluto] WARNING: parallel loops not found in the CLooG output; "
+             "generating sequential code\n");
+    } else {
+      printf("[pluto] WARNING: parallel loops not found in the CLooG output; "
+             "OpenMP clauses not added\n");
+    }
+  }
+
+  char *line = code;
+  unsigned kv = 0, kp = 0;
+  /* Brace depth at the start of the line */
+  int depth = 0;
+  /* The task band whose parallel region is being printed, the depth of its
+   * outermost loop (-1 until its header), the header of its innermost loop,
+   * and the depth of the innermost loop whose body is being printed as a
+   * task */
+  const PlutoTaskBand *tband = NULL;
+  int region_depth = -1;
+  char task_loop[16];
+  int task_depth = -1;
+  /* With --dynschedule, the code of the region printed so far without the
+   * bodies of the innermost tile space loops, which are printed in
+   * `bodies' */
+  bool dyn = prog->context->options->dynschedule;
+  int region_indent = 0;
+  char *enum_code = NULL, **bodies = NULL;
+  size_t enum_size = 0, body_size = 0;
+  FILE *enum_fp = NULL, *body_fp = NULL;
+  unsigned nbodies = 0;
+  bool sequential = false;
+  /* With --doacross, whether the region is run as doacross loops, the depth
+   * of the second loop of the band (-1 until its header, -2 after its end),
+   * and the bounds it had */
+  bool doacross = false;
+  int doacross_depth = -1;
+  char *doacross_lb = NULL, *doacross_ub = NULL;
+  while (*line) {
+    char *end = strchr(line, '\n');
+    size_t line_len = end ? (size_t)(end - line + 1) : strlen(line);
+    size_t indent = strspn(line, " \t");
+    int next_depth = depth;
+    for (size_t i = 0; i < line_len; i++) {
+      if (line[i] == '{')
+        next_depth++;
+      else if (line[i] == '}')
+        next_depth--;
+    }
+
+    if (task_depth >= 0 && next_depth == task_depth) {
+      /* End of the task's block */
+      if (dyn) {
+        fclose(body_fp);
+      } else {
+        fprintf(outfp, "%.*s  }\n", (int)indent, line);
+      }
+      task_depth = -1;
+    }
+    if (doacross && next_depth == doacross_depth) {
+      /* End of the second loop of the doacross loops */
+      fprintf(outfp, "%.*s  }\n", (int)indent, line);
+      fprintf(outfp, "%.*s#pragma omp ordered depend(source)\n", (int)indent,
+              line);
+      doacross_depth = -2;
+    }
+    FILE *out = outfp;
+    if (dyn && tband) {
+      out = task_depth >= 0 ? body_fp : enum_fp;
+    }
+
+    if (omp_simd && !strncmp(line + indent, "#pragma ivdep\n", 14)) {
+      char *pragma = pluto_get_simd_pragma(vloops[kv++], prog);
+      fprintf(out, "%.*s%s\n", (int)indent, line, pragma);
+      free(pragma);
+    } else if (omp_simd &&
+               !strncmp(line + indent, "#pragma vector always\n", 22)) {
+      /* Subsumed by the SIMD pragma */
+    } else if (!strncmp(line + indent, "#pragma omp parallel for", 24)) {
+      unsigned loop_collapse = omp_loops ? collapse[kp] : 1;
+      const Ploop *loop = omp_loops ? ploops[kp++] : NULL;
+      const PlutoTaskBand *loop_tband =
+          loop ? pluto_loop_get_task_band(loop, prog) : NULL;
+      if (loop_tband && loop->depth == loop_tband->band->loop->depth) {
+        doacross = prog->context->options->doacross && !dyn && end &&
+                   get_doacross_bounds(end + 1, loop_tband, &doacross_lb,
+                                       &doacross_ub);
+        doacross_depth = -1;
+        if (doacross) {
+          print_doacross_bounds(outfp, indent, end + 1, doacross_lb,
+                                doacross_ub);
+          print_doacross_pragma(outfp, line, end);
+        } else if (dyn) {
+          region_indent = indent;
+          enum_fp = open_memstream(&enum_code, &enum_size);
+          nbodies = 0;
+          sequential = false;
+        } else {
+          if (prog->context->options->doacross) {
+            printf("[pluto] WARNING: tile loops t%u and t%u aren't perfectly "
+                   "nested; running their tiles as OpenMP tasks\n",
+                   loop->depth + 1, loop->depth + 2);
+          }
+          fprintf(outfp, "%.*s#pragma omp parallel\n", (int)indent, line);
+          fprintf(outfp, "%.*s#pragma omp single\n", (int)indent, line);
+        }
+        tband = loop_tband;
+        region_depth = -1;
+        sprintf(task_loop, "for (t%u=",
+                tband->band->loop->depth + tband->band->width);
+      } else if (loop) {
+        char *clauses = pluto_get_omp_loop_clauses(loop, loop_collapse, prog);
+        if (clauses && end) {
+          fprintf(out, "%.*s %s\n", (int)(end - line), line, clauses);
+        } else {
+          fwrite(line, 1, line_len, out);
+        }
+        free(clauses);
+      } else if (prog->ntask_bands == 0) {
+        fwrite(line, 1, line_len, out);
+      }
+    } else if (tband && region_depth < 0 &&
+               !strncmp(line + indent, "for (", 5)) {
+      /* Outermost loop of the task band */
+      region_depth = depth;
+      fwrite(line, 1, line_len, out);
+    } else if (doacross && region_depth >= 0 && doacross_depth == -1) {
+      /* Second loop of the doacross loops */
+      unsigned d = tband->band->loop->depth + 2;
+      char *pragma = get_doacross_sink_pragma(tband);
+      fprintf(out, "%.*sfor (t%u=lb2;t%u<=ub2;t%u++) {\n", (int)indent, line,
+              d, d, d);
+      fprintf(out, "%.*s%s\n", (int)indent, line, pragma);
+      fprintf(out, "%.*s  if ((t%u >= %s) && (t%u <= %s)) {\n", (int)indent,
+              line, d, doacross_lb, d, doacross_ub);
+      free(pragma);
+      doacross_depth = depth;
+    } else if (tband && !doacross && task_depth < 0 && end &&
+               !strncmp(line + indent, task_loop, strlen(task_loop))) {
+      /* Innermost tile space loop: its body is a task */
+      fwrite(line, 1, line_len, out);
+      if (dyn) {
+        unsigned first = tband->band->loop->depth + 1;
+        fprintf(out, "%.*s  pluto_dyn_add_tile(pluto_dyn, %u, (const int[]){",
+                (int)indent, line, nbodies);
+        for (unsigned d = first; d < first + tband->band->width; d++) {
+          fprintf(out, "%st%u", d > first ? ", " : "", d);
+        }
+        fprintf(out, "});\n");
+        bodies = (char **)realloc(bodies, (nbodies + 1) * sizeof(char *));
+        bodies[nbodies] = NULL;
+        body_fp = open_memstream(&bodies[nbodies++], &body_size);
+      } else {
+        char *pragma = get_task_pragma(tband, prog);
+        fprintf(out, "%.*s  %s\n", (int)indent, line, pragma);
+        fprintf(out, "%.*s  {\n", (int)indent, line);
+        free(pragma);
+      }
+      task_depth = depth;
+    } else if (tband && !doacross && task_depth < 0 && line[indent] == 'S' &&
+               isdigit(line[indent + 1])) {
+      if (dyn) {
+        sequential = true;
+      } else {
+        fprintf(out, "%.*s#pragma omp taskwait\n", (int)indent, line);
+      }
+      fwrite(line, 1, line_len, out);
+    } else {
+      fwrite(line, 1, line_len, out);
+    }
+
+    if (tband && region_depth >= 0 && next_depth == region_depth) {
+      /* End of the parallel region */
+      if (dyn) {
+        fclose(enum_fp);
+        print_dyn_region(outfp, region_indent, tband, enum_code, bodies,
+                         nbodies, sequential);
+        for (unsigned k = 0; k < nbodies; k++) {
+          free(bodies[k]);
+        }
+        free(enum_code);
+        enum_code = NULL;
+      }
+      free(doacross_lb);
+      free(doacross_ub);
+      doacross_lb = doacross_ub = NULL;
+      doacross = false;
+      tband = NULL;
+      region_depth = -1;
+    }
+    depth = next_depth;
+    line += line_len;
+  }
+
+  pluto_loops_free(vloops, nvloops);
+  pluto_loops_free(ploops, nploops);
+  free(collapse);
+  free(bodies);
+  free(code);
+}
+
 int pluto_gen_cloog_code(const PlutoProg *prog, int cloogf, int cloogl,
                          FILE *cloogfp, FILE *outfp) {
   CloogInput *input;
   CloogOptions *cloogOptions;
   CloogState *state;
+  isl_ctx *ctx = NULL;
   PlutoContext *context = prog->context;
   PlutoOptions *options = context->options;
   int i;
@@ -216,7 +1224,12 @@ int pluto_gen_cloog_code(const PlutoProg *prog, int cloogf, int cloogl,
   Stmt **stmts = prog->stmts;
   int nstmts = prog->nstmts;
 
-  state = cloog_state_malloc();
+  if (cloogfp) {
+    state = cloog_state_malloc();
+  } else {
+    ctx = isl_ctx_alloc();
+    state = cloog_isl_state_malloc(ctx);
+  }
   cloogOptions = cloog_options_malloc(state);
 
   cloogOptions->fs = (int *)malloc(nstmts * sizeof(int));
@@ -278,8 +1291,12 @@ int pluto_gen_cloog_code(const PlutoProg *prog, int cloogf, int cloogl,
 
   fprintf(outfp, "/* Start of CLooG code */\n");
   /* Get the code from CLooG */
-  IF_DEBUG(printf("[pluto] cloog_input_read\n"));
-  input = cloog_input_read(cloogfp, cloogOptions);
+  if (cloogfp) {
+    IF_DEBUG(printf("[pluto] cloog_input_read\n"));
+    input = cloog_input_read(cloogfp, cloogOptions);
+  } else {
+    input = pluto_gen_cloog_input(prog, ctx);
+  }
   IF_DEBUG(printf("[pluto] cloog_clast_create\n"));
   root = cloog_clast_create_from_input(input, cloogOptions);
   if (options->prevector) {
@@ -296,31 +1313,219 @@ int pluto_gen_cloog_code(const PlutoProg *prog, int cloogf, int cloogl,
     pluto_mark_unroll_jam(root, prog, cloogOptions, options->ufactor);
     clast_unroll_jam(root);
   }
-  clast_pprint(outfp, root, 0, cloogOptions);
+  /* Tile loops with tile sizes that are parameters */
+  char **clast_names = NULL;
+  unsigned num_clast_names = 0;
+  if (options->parametric_tiles) {
+    num_clast_names =
+        pluto_parametrize_tile_loops(root, prog, cloogOptions, &clast_names);
+  }
+  /* Separate full tiles from partial ones */
+  struct clast_for **full_tiles = NULL;
+  unsigned num_full_tiles = 0;
+  if (options->full_tiles) {
+    num_clast_names = pluto_separate_full_tiles(
+        root, prog, cloogOptions, &clast_names, num_clast_names, &full_tiles,
+        &num_full_tiles);
+  }
+  if ((options->prevector && options->omp_simd) ||
+      (options->parallel &&
+       (prog->nreduction_deps > 0 || prog->ntask_bands > 0 ||
+        options->omp_collapse || options->omp_schedule))) {
+    print_clast_openmp(outfp, root, cloogOptions, prog,
+                       options->prevector && options->omp_simd);
+  } else {
+    clast_pprint(outfp, root, 0, cloogOptions);
+  }
+  /* The bodies of full tiles are those of partial tiles */
+  for (unsigned k = 0; k < num_full_tiles; k++) {
+    full_tiles[k]->body = NULL;
+  }
+  free(full_tiles);
   cloog_clast_free(root);
+  for (i = 0; i < (int)num_clast_names; i++) {
+    free(clast_names[i]);
+  }
+  free(clast_names);
 
   fprintf(outfp, "/* End of CLooG code */\n");
 
   cloog_options_free(cloogOptions);
   cloog_state_free(state);
+  if (ctx)
+    isl_ctx_free(ctx);
 
   return 0;
 }
 
-/* Generate code for a single multicore; the ploog script will insert openmp
- * pragmas later */
-int pluto_multicore_codegen(FILE *cloogfp, FILE *outfp, const PlutoProg *prog) {
+/* Print the #include lines the code generated for 'prog' needs */
+static void print_includes(const PlutoProg *prog, FILE *outfp) {
   if (prog->context->options->parallel) {
     fprintf(outfp, "#include <omp.h>\n\n");
   }
+  if (prog->context->options->parametric_tiles) {
+    /* For getenv and strtol */
+    fprintf(outfp, "#include <stdlib.h>\n\n");
+  }
+  if (prog->ntask_bands > 0 && prog->context->options->dynschedule) {
+    fprintf(outfp, "#include <pluto/dynschedule.h>\n\n");
+  }
+}
+
+static void gen_code(FILE *cloogfp, FILE *outfp, const PlutoProg *prog) {
+  if (prog->context->options->codegen == kCodegenIsl) {
+    pluto_gen_isl_code(prog, outfp);
+  } else {
+    pluto_gen_cloog_code(prog, -1, -1, cloogfp, outfp);
+  }
+}
+
+/* Generate code for a single multicore; the ploog script will insert openmp
+ * pragmas later. cloogfp is the .cloog file to read the input of CLooG from,
+ * or NULL to build it in memory; it is not used with --codegen=isl */
+int pluto_multicore_codegen(FILE *cloogfp, FILE *outfp, const PlutoProg *prog) {
+  print_includes(prog, outfp);
+  generate_declarations(prog, outfp);
+  gen_code(cloogfp, outfp, prog);
+
+  return 0;
+}
+
+/* Print the affine function of the parameters in the iterator row 'row' of
+ * a domain projected on one iterator, negated if 'negate' is set */
+static void print_param_function(const int64_t *row, bool negate,
+                                 const PlutoProg *prog, FILE *outfp) {
+  bool first = true;
+  for (int j = 0; j <= prog->npar; j++) {
+    int64_t coeff = negate ? -row[1 + j] : row[1 + j];
+    if (coeff == 0)
+      continue;
+    if (coeff < 0 || !first)
+      fprintf(outfp, coeff < 0 ? (first ? "-" : " - ") : " + ");
+    int64_t abs_coeff = coeff < 0 ? -coeff : coeff;
+    if (j == prog->npar) {
+      fprintf(outfp, "%lld", (long long)abs_coeff);
+    } else if (abs_coeff == 1) {
+      fprintf(outfp, "%s", prog->params[j]);
+    } else {
+      fprintf(outfp, "%lld*%s", (long long)abs_coeff, prog->params[j]);
+    }
+    first = false;
+  }
+  if (first)
+    fprintf(outfp, "0");
+}
+
+/* Number of lower (is_lb true) or upper bounds of the iterator of 'dom', a
+ * domain projected on one iterator */
+static unsigned get_num_bounds(const PlutoConstraints *dom, bool is_lb) {
+  unsigned num_bounds = 0;
+  for (unsigned r = 0; r < dom->nrows; r++) {
+    int64_t a = dom->val[r][0];
+    if (a != 0 && (dom->is_eq[r] || (a > 0) == is_lb))
+      num_bounds++;
+  }
+  return num_bounds;
+}
+
+/* Print the max of the lower bounds (is_lb true) or the min of the upper
+ * bounds of the iterator of 'dom', a domain projected on one iterator */
+static void print_bounds(const PlutoConstraints *dom, bool is_lb,
+                         const PlutoProg *prog, FILE *outfp) {
+  unsigned num_bounds = get_num_bounds(dom, is_lb);
+  for (unsigned k = 1; k < num_bounds; k++)
+    fprintf(outfp, is_lb ? "max(" : "min(");
+  unsigned k = 0;
+  for (unsigned r = 0; r < dom->nrows; r++) {
+    int64_t a = dom->val[r][0];
+    if (a == 0 || !(dom->is_eq[r] || (a > 0) == is_lb))
+      continue;
+    if (k > 0)
+      fprintf(outfp, ", ");
+    /* a*i + f >= 0 bounds i by -f/a */
+    fprintf(outfp, "(double)(");
+    print_param_function(dom->val[r], a > 0, prog, outfp);
+    fprintf(outfp, ")");
+    if (a != 1 && a != -1)
+      fprintf(outfp, " / %lld", (long long)(a > 0 ? a : -a));
+    if (k > 0)
+      fprintf(outfp, ")");
+    k++;
+  }
+}
+
+/* Print an estimate of the number of iterations of all statements of 'prog'
+ * as a C expression of the parameters: the sum over statements of the
+ * volume of the bounding box of their domains. Pluto can't count the
+ * integer points of a parametric domain exactly; the bounding box is exact
+ * for rectangular domains and within a small constant factor of the count
+ * for the triangular ones of common kernels. */
+static void print_iteration_count_estimate(const PlutoProg *prog,
+                                           FILE *outfp) {
+  for (unsigned i = 0; i < prog->nstmts; i++) {
+    const Stmt *stmt = prog->stmts[i];
+    if (i > 0)
+      fprintf(outfp, "\n\t    + ");
+    if (stmt->dim == 0) {
+      fprintf(outfp, "1.0");
+      continue;
+    }
+    for (int d = 0; d < stmt->dim; d++) {
+      PlutoConstraints *dom = pluto_constraints_dup_single(stmt->domain);
+      pluto_constraints_project_out(dom, d + 1, stmt->dim - d - 1);
+      pluto_constraints_project_out(dom, 0, d);
+      if (d > 0)
+        fprintf(outfp, " * ");
+      /* An unbounded iterator doesn't add to the estimate */
+      if (get_num_bounds(dom, true) == 0 || get_num_bounds(dom, false) == 0) {
+        fprintf(outfp, "1.0");
+      } else {
+        fprintf(outfp, "max(0.0, ");
+        print_bounds(dom, false, prog, outfp);
+        fprintf(outfp, " - ");
+        print_bounds(dom, true, prog, outfp);
+        fprintf(outfp, " + 1)");
+      }
+      pluto_constraints_free(dom);
+    }
+  }
+}
+
+/* Generate multiversioned code: the code of 'prog' runs when the estimated
+ * iteration count of the SCoP is at least the multiversion threshold, and
+ * that of 'simple_prog', its --notile --noparallel version, runs otherwise.
+ * cloogfp is as for pluto_multicore_codegen and only used for 'prog' */
+int pluto_multiversion_codegen(FILE *cloogfp, FILE *outfp,
+                               const PlutoProg *prog,
+                               const PlutoProg *simple_prog) {
+  PlutoOptions *options = prog->context->options;
+
+  print_includes(prog, outfp);
   generate_declarations(prog, outfp);
 
-  if (prog->context->options->multipar) {
-    fprintf(outfp, "\tomp_set_nested(1);\n");
-    fprintf(outfp, "\tomp_set_num_threads(2);\n");
+  fprintf(outfp, "\t/* Estimated iteration count of the SCoP; the "
+                 "optimized version runs\n\t * at and above %.1f "
+                 "iterations (--multiversion-threshold) */\n",
+          options->multiversion_threshold);
+  fprintf(outfp, "\tif (");
+  print_iteration_count_estimate(simple_prog, outfp);
+  fprintf(outfp, " >= %.1f) {\n", options->multiversion_threshold);
+  gen_code(cloogfp, outfp, prog);
+  fprintf(outfp, "\t} else {\n");
+
+  /* Statement macros of the simple version */
+  for (unsigned i = 0; i < prog->nstmts; i++) {
+    fprintf(outfp, "#undef S%d\n", prog->stmts[i]->id + 1);
   }
+  generate_declarations(simple_prog, outfp);
+  gen_code(NULL, outfp, simple_prog);
+  fprintf(outfp, "\t}\n");
 
-  pluto_gen_cloog_code(prog, -1, -1, cloogfp, outfp);
+  if (!options->silent) {
+    printf("[pluto] Multiversioned code: optimized version at and above an "
+           "estimated %.1f iterations\n",
+           options->multiversion_threshold);
+  }
 
   return 0;
 }
@@ -423,6 +1628,14 @@ osl_loop_p pluto_get_parallel_loop_list(const PlutoProg *prog,
   IF_DEBUG(pluto_loops_print(ploops, nploops););
 
   for (i = 0; i < nploops; i++) {
+    /* The loop extension has no reduction clauses */
+    char *clause;
+    pluto_loop_get_reduction_clause(ploops[i], prog, &clause);
+    if (clause) {
+      free(clause);
+      continue;
+    }
+
     osl_loop_p newloop = osl_loop_malloc();
 
     char iter[13];
@@ -475,6 +1688,12 @@ osl_loop_p pluto_get_vector_loop_list(const PlutoProg *prog) {
     /* Only the innermost ones */
     if (!pluto_loop_is_innermost(ploops[i], prog))
       continue;
+    char *clause;
+    pluto_loop_get_reduction_clause(ploops[i], prog, &clause);
+    if (clause) {
+      free(clause);
+      continue;
+    }
 
     IF_DEBUG(printf("[pluto_get_vector_loop_list] marking loop\n"););
     IF_DEBUG(pluto_loop_print(ploops[i]););
@@ -1,11 +1,28 @@
 #ifndef _PLUTO_CODEGEN_IF_H_
 #define _PLUTO_CODEGEN_IF_H_
 
+#include <stdio.h>
+
 #include "osl/extensions/loop.h"
 
 typedef struct plutoProg PlutoProg;
+typedef struct statement Stmt;
+typedef struct pLoop Ploop;
+
+int pluto_get_tile_size(const Stmt *stmt, unsigned depth);
+char *pluto_get_simd_pragma(const Ploop *loop, const PlutoProg *prog);
+char *pluto_get_omp_loop_clauses(const Ploop *loop, unsigned collapse,
+                                 const PlutoProg *prog);
 
+unsigned pluto_get_parametric_tile_sizes(const PlutoProg *prog,
+                                         int *tile_sizes);
 osl_loop_p pluto_get_vector_loop_list(const PlutoProg *prog);
 osl_loop_p pluto_get_parallel_loop_list(const PlutoProg *prog,
                                         int vloopsfound);
+
+/// Generates code for `prog' with isl's AST generator (--codegen=isl) and
+/// writes it to `outfp'. Full tiles are separated from partial ones so that
+/// their loops have no min/max bounds; the loops are marked parallel and
+/// vectorizable as with CLooG.
+int pluto_gen_isl_code(const PlutoProg *prog, FILE *outfp);
 #endif
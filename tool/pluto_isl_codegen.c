@@ -0,0 +1,617 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * This software is available under the MIT license. Please see LICENSE in the
+ * top-level directory for details.
+ *
+ * This file is part of libpluto.
+ *
+ * Code generation with isl's AST generator (--codegen=isl).
+ *
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pluto_codegen_if.h"
+
+#include "constraints.h"
+#include "pluto/matrix.h"
+#include "pluto/pluto.h"
+#include "program.h"
+#include "reduction.h"
+
+#include "isl/aff.h"
+#include "isl/ast.h"
+#include "isl/ast_build.h"
+#include "isl/constraint.h"
+#include "isl/ctx.h"
+#include "isl/id.h"
+#include "isl/local_space.h"
+#include "isl/map.h"
+#include "isl/printer.h"
+#include "isl/schedule.h"
+#include "isl/schedule_node.h"
+#include "isl/set.h"
+#include "isl/space.h"
+#include "isl/union_map.h"
+#include "isl/union_set.h"
+#include "isl/val.h"
+
+/// A for loop of the generated AST: the schedule dimension (t<depth + 1>) it
+/// iterates over, the ids of the statements it runs, and how it is marked.
+/// Attached to its AST node as annotation.
+typedef struct islLoop {
+  unsigned depth;
+  int *stmts;
+  unsigned nstmts;
+  bool parallel;
+  bool vector;
+} IslLoop;
+
+typedef struct islLoops {
+  IslLoop **loops;
+  unsigned num;
+} IslLoops;
+
+static isl_set *set_param_names(isl_set *set, const PlutoProg *prog) {
+  for (int i = 0; i < prog->npar; i++) {
+    set = isl_set_set_dim_name(set, isl_dim_param, i, prog->params[i]);
+  }
+  return set;
+}
+
+/// Returns the domain of `stmt' as a set named S<id + 1> (the name of its
+/// statement macro).
+static isl_set *get_stmt_domain(const Stmt *stmt, const PlutoProg *prog,
+                                isl_ctx *ctx) {
+  char name[16];
+  snprintf(name, sizeof(name), "S%d", stmt->id + 1);
+  isl_set *set =
+      isl_set_from_pluto_constraints_params(stmt->domain, prog->npar, ctx);
+  set = set_param_names(set, prog);
+  return isl_set_set_tuple_name(set, name);
+}
+
+/// Returns the schedule of `stmt': its domain mapped to t1, t2, ...
+static isl_map *get_stmt_schedule(const Stmt *stmt, const PlutoProg *prog,
+                                  isl_ctx *ctx) {
+  char name[16];
+  snprintf(name, sizeof(name), "S%d", stmt->id + 1);
+  PlutoConstraints *sched = pluto_stmt_get_schedule(stmt);
+  isl_basic_map *bmap = isl_basic_map_from_pluto_constraints(
+      ctx, sched, stmt->dim, stmt->trans->nrows, prog->npar);
+  pluto_constraints_free(sched);
+  isl_map *map = isl_map_from_basic_map(bmap);
+  for (int i = 0; i < prog->npar; i++) {
+    map = isl_map_set_dim_name(map, isl_dim_param, i, prog->params[i]);
+  }
+  return isl_map_set_tuple_name(map, isl_dim_in, name);
+}
+
+/// Returns the set of the points of the schedule space with
+/// T*t<d> <= t<p> <= T*t<d> + T - 1 (t<p> in the tile of size T t<d> scans).
+static isl_set *get_tile_strip(__isl_take isl_space *space, unsigned d,
+                               unsigned p, int tile_size) {
+  isl_local_space *ls = isl_local_space_from_space(isl_space_copy(space));
+  isl_set *strip = isl_set_universe(space);
+
+  isl_constraint *c = isl_constraint_alloc_inequality(isl_local_space_copy(ls));
+  c = isl_constraint_set_coefficient_si(c, isl_dim_set, p, 1);
+  c = isl_constraint_set_coefficient_si(c, isl_dim_set, d, -tile_size);
+  strip = isl_set_add_constraint(strip, c);
+
+  c = isl_constraint_alloc_inequality(ls);
+  c = isl_constraint_set_coefficient_si(c, isl_dim_set, p, -1);
+  c = isl_constraint_set_coefficient_si(c, isl_dim_set, d, tile_size);
+  c = isl_constraint_set_constant_si(c, tile_size - 1);
+  return isl_set_add_constraint(strip, c);
+}
+
+/// Removes all the constraints on the dimensions of `set' that are not
+/// marked in `keep' (first `n' dimensions).
+static isl_set *eliminate_dims(isl_set *set, const bool *keep, unsigned n) {
+  for (unsigned i = 0; i < n; i++) {
+    if (!keep[i])
+      set = isl_set_eliminate(set, isl_dim_set, i, 1);
+  }
+  return set;
+}
+
+/// Returns the set of schedule points (t1, t2, ...) that lie in full tiles:
+/// tiles in which, for every statement, all the points of the tile box are
+/// in the statement's (scheduled) domain. A tile space loop t<d> of size T is
+/// paired with the loop t<p> it tiles by checking that T*t<d> <= t<p> <=
+/// T*t<d> + T - 1 on the domain. Returns NULL if nothing is tiled.
+static isl_set *get_full_tiles(const PlutoProg *prog, isl_ctx *ctx) {
+  unsigned n = prog->num_hyperplanes;
+  isl_set *full = NULL, *partial = NULL;
+
+  for (int s = 0; s < prog->nstmts; s++) {
+    Stmt *stmt = prog->stmts[s];
+    isl_set *sched_dom = isl_set_apply(get_stmt_domain(stmt, prog, ctx),
+                                       get_stmt_schedule(stmt, prog, ctx));
+
+    bool keep[n];
+    int last_tile_dim = -1;
+    isl_set *box = isl_set_universe(isl_set_get_space(sched_dom));
+    for (unsigned d = 0; d < n; d++) {
+      keep[d] = false;
+    }
+    for (unsigned d = 0; d < n; d++) {
+      int tile_size = pluto_get_tile_size(stmt, d);
+      if (tile_size <= 0)
+        continue;
+      for (unsigned p = d + 1; p < n; p++) {
+        isl_set *strip =
+            get_tile_strip(isl_set_get_space(sched_dom), d, p, tile_size);
+        isl_bool in_strip = isl_set_is_subset(sched_dom, strip);
+        if (in_strip == isl_bool_true) {
+          box = isl_set_intersect(box, strip);
+          keep[d] = keep[p] = true;
+          last_tile_dim = d;
+          break;
+        }
+        isl_set_free(strip);
+      }
+    }
+    if (last_tile_dim < 0) {
+      isl_set_free(box);
+      isl_set_free(sched_dom);
+      continue;
+    }
+    for (int d = 0; d <= last_tile_dim; d++) {
+      keep[d] = true;
+    }
+    bool keep_prefix[n];
+    for (unsigned d = 0; d < n; d++) {
+      keep_prefix[d] = (int)d <= last_tile_dim;
+    }
+
+    /* The tiles of the statement, and the points of the tile boxes (along
+     * the tiled dimensions) that are not in the domain */
+    isl_set *tiles = eliminate_dims(isl_set_copy(sched_dom), keep_prefix, n);
+    isl_set *points = eliminate_dims(sched_dom, keep, n);
+    box = isl_set_intersect(box, isl_set_copy(tiles));
+    isl_set *missing = isl_set_subtract(box, points);
+    isl_set *stmt_partial = eliminate_dims(missing, keep_prefix, n);
+    isl_set *stmt_full = isl_set_subtract(tiles, isl_set_copy(stmt_partial));
+
+    full = full ? isl_set_union(full, stmt_full) : stmt_full;
+    partial = partial ? isl_set_union(partial, stmt_partial) : stmt_partial;
+  }
+
+  if (!full)
+    return NULL;
+
+  /* A tile that is full for one statement but partial for another one it is
+   * fused with is not isolated */
+  return isl_set_coalesce(isl_set_subtract(full, partial));
+}
+
+/// Returns the AST generation options of the band of all the schedule
+/// dimensions: full tiles are isolated, and the options given with
+/// --isl-ast-options apply to each dimension (unrolling only to full tiles
+/// when there are some).
+static isl_union_set *get_ast_options(const PlutoProg *prog, isl_ctx *ctx) {
+  PlutoOptions *options = prog->context->options;
+  isl_union_set *ast_options =
+      isl_union_set_empty(isl_space_params_alloc(ctx, 0));
+
+  isl_set *full = get_full_tiles(prog, ctx);
+  bool isolated = full != NULL;
+  if (isolated) {
+    isl_set *isolate = isl_map_wrap(isl_map_from_range(full));
+    isolate = isl_set_set_tuple_name(isolate, "isolate");
+    ast_options =
+        isl_union_set_union(ast_options, isl_union_set_from_set(isolate));
+  }
+
+  if (!options->isl_ast_options)
+    return ast_options;
+
+  char *list = strdup(options->isl_ast_options);
+  char *save = NULL;
+  unsigned d = 0;
+  for (char *type = strtok_r(list, ",", &save); type != NULL;
+       type = strtok_r(NULL, ",", &save), d++) {
+    while (*type == ' ')
+      type++;
+    if (*type == '\0')
+      continue;
+    if (d >= (unsigned)prog->num_hyperplanes) {
+      printf("[pluto] WARNING: --isl-ast-options has more entries than "
+             "there are schedule dimensions (%d)\n",
+             prog->num_hyperplanes);
+      break;
+    }
+    if (strcmp(type, "atomic") && strcmp(type, "separate") &&
+        strcmp(type, "unroll")) {
+      printf("[pluto] WARNING: unknown AST generation option '%s' for t%u "
+             "(atomic, separate or unroll)\n",
+             type, d + 1);
+      continue;
+    }
+    char str[128];
+    if (!isolated) {
+      snprintf(str, sizeof(str), "{ %s[%u] }", type, d);
+    } else if (!strcmp(type, "unroll")) {
+      snprintf(str, sizeof(str), "{ [isolate[] -> unroll[%u]] }", d);
+    } else {
+      snprintf(str, sizeof(str), "{ %s[%u]; [isolate[] -> %s[%u]] }", type, d,
+               type, d);
+    }
+    ast_options = isl_union_set_union(ast_options,
+                                      isl_union_set_read_from_str(ctx, str));
+  }
+  free(list);
+
+  return ast_options;
+}
+
+static isl_stat add_loop_stmt(__isl_take isl_map *map, void *user) {
+  IslLoop *loop = (IslLoop *)user;
+  const char *name = isl_map_get_tuple_name(map, isl_dim_in);
+  loop->stmts =
+      (int *)realloc(loop->stmts, (loop->nstmts + 1) * sizeof(int));
+  loop->stmts[loop->nstmts++] = atoi(name + 1) - 1;
+  isl_map_free(map);
+  return isl_stat_ok;
+}
+
+/// Records the statements run by the loop about to be generated and
+/// attaches the record to the loop.
+static __isl_give isl_id *before_each_for(__isl_keep isl_ast_build *build,
+                                          void *user) {
+  IslLoops *loops = (IslLoops *)user;
+  IslLoop *loop = (IslLoop *)calloc(1, sizeof(IslLoop));
+
+  isl_union_map *sched = isl_ast_build_get_schedule(build);
+  isl_union_map_foreach_map(sched, &add_loop_stmt, loop);
+  isl_union_map_free(sched);
+
+  loops->loops = (IslLoop **)realloc(loops->loops,
+                                     (loops->num + 1) * sizeof(IslLoop *));
+  loops->loops[loops->num++] = loop;
+
+  return isl_id_alloc(isl_ast_build_get_ctx(build), "loop", loop);
+}
+
+/// Sets the depth of the loop records from the iterators of their loops.
+static isl_bool set_loop_depth(__isl_keep isl_ast_node *node, void *user) {
+  if (isl_ast_node_get_type(node) != isl_ast_node_for)
+    return isl_bool_true;
+
+  isl_id *id = isl_ast_node_get_annotation(node);
+  if (!id)
+    return isl_bool_true;
+  IslLoop *loop = (IslLoop *)isl_id_get_user(id);
+  isl_id_free(id);
+
+  isl_ast_expr *iter = isl_ast_node_for_get_iterator(node);
+  isl_id *iter_id = isl_ast_expr_get_id(iter);
+  loop->depth = atoi(isl_id_get_name(iter_id) + 1) - 1;
+  isl_id_free(iter_id);
+  isl_ast_expr_free(iter);
+
+  return isl_bool_true;
+}
+
+/// Marks the AST loops that scan `ploop' (the loops at its depth that only
+/// run statements of `ploop') parallel or vectorizable. Returns the number of
+/// loops marked.
+static unsigned mark_loops(IslLoops *loops, const Ploop *ploop,
+                           bool vector) {
+  unsigned num_marked = 0;
+  for (unsigned i = 0; i < loops->num; i++) {
+    IslLoop *loop = loops->loops[i];
+    if (loop->depth != ploop->depth || loop->nstmts == 0)
+      continue;
+    unsigned j;
+    for (j = 0; j < loop->nstmts; j++) {
+      unsigned k;
+      for (k = 0; k < ploop->nstmts; k++) {
+        if (ploop->stmts[k]->id == loop->stmts[j])
+          break;
+      }
+      if (k == ploop->nstmts)
+        break;
+    }
+    if (j < loop->nstmts)
+      continue;
+    if (vector)
+      loop->vector = true;
+    else
+      loop->parallel = true;
+    num_marked++;
+  }
+  return num_marked;
+}
+
+/// Marks the outermost parallel loops like pluto_mark_parallel does on the
+/// clast: if a loop doesn't appear in the AST, the next inner loop of its
+/// band is marked instead.
+static void mark_parallel_loops(IslLoops *loops, const PlutoProg *prog) {
+  unsigned nploops;
+  Ploop **ploops = pluto_get_dom_parallel_loops(prog, &nploops);
+
+  for (unsigned i = 0; i < nploops; i++) {
+    int innermost_split_level;
+    Band *band =
+        pluto_get_parallel_band(ploops[i], prog, &innermost_split_level);
+    Ploop *loop = pluto_loop_dup(band->loop);
+    while (loop != NULL && mark_loops(loops, loop, false) == 0) {
+      unsigned ninloops;
+      Ploop **inloops = pluto_get_loops_immediately_inner(loop, prog,
+                                                          &ninloops);
+      pluto_loop_free(loop);
+      loop = NULL;
+      if (ninloops == 0 ||
+          inloops[0]->depth > band->loop->depth + band->width) {
+        printf("Warning: parallel poly loop not found in AST\n");
+      } else {
+        loop = pluto_loop_dup(inloops[0]);
+      }
+      pluto_loops_free(inloops, ninloops);
+    }
+    if (loop)
+      pluto_loop_free(loop);
+    pluto_band_free(band);
+  }
+
+  pluto_loops_free(ploops, nploops);
+}
+
+/// Marks the loops to vectorize (see pluto_get_vector_loops).
+static void mark_vector_loops(IslLoops *loops, const PlutoProg *prog) {
+  unsigned nploops;
+  Ploop **ploops = pluto_get_vector_loops(prog, &nploops);
+
+  for (unsigned i = 0; i < nploops; i++) {
+    if (mark_loops(loops, ploops[i], true) == 0) {
+      printf("[pluto] WARNING: vectorizable poly loop not found in AST\n");
+    }
+  }
+
+  pluto_loops_free(ploops, nploops);
+}
+
+/// Returns the poly loop over the statements `loop' runs.
+static Ploop *get_poly_loop(const IslLoop *loop, const PlutoProg *prog) {
+  Ploop *ploop = pluto_loop_alloc();
+  ploop->depth = loop->depth;
+  ploop->nstmts = loop->nstmts;
+  ploop->stmts = (Stmt **)malloc(loop->nstmts * sizeof(Stmt *));
+  for (unsigned i = 0; i < loop->nstmts; i++) {
+    ploop->stmts[i] = prog->stmts[loop->stmts[i]];
+  }
+  return ploop;
+}
+
+/// Returns true if `expr' uses the iterator `id'.
+static bool expr_uses_id(__isl_keep isl_ast_expr *expr, __isl_keep isl_id *id) {
+  if (isl_ast_expr_get_type(expr) == isl_ast_expr_id) {
+    isl_id *expr_id = isl_ast_expr_get_id(expr);
+    bool uses = expr_id == id;
+    isl_id_free(expr_id);
+    return uses;
+  }
+  if (isl_ast_expr_get_type(expr) != isl_ast_expr_op)
+    return false;
+  int nargs = isl_ast_expr_get_op_n_arg(expr);
+  bool uses = false;
+  for (int i = 0; i < nargs && !uses; i++) {
+    isl_ast_expr *arg = isl_ast_expr_get_op_arg(expr, i);
+    uses = expr_uses_id(arg, id);
+    isl_ast_expr_free(arg);
+  }
+  return uses;
+}
+
+/// Returns true if the init or the condition of the for node `node' use
+/// one of the iterators `ids'.
+static bool for_bounds_use_ids(__isl_keep isl_ast_node *node, isl_id **ids,
+                               unsigned nids) {
+  isl_ast_expr *init = isl_ast_node_for_get_init(node);
+  isl_ast_expr *cond = isl_ast_node_for_get_cond(node);
+  bool uses = false;
+  for (unsigned i = 0; i < nids && !uses; i++) {
+    uses = expr_uses_id(init, ids[i]) || expr_uses_id(cond, ids[i]);
+  }
+  isl_ast_expr_free(init);
+  isl_ast_expr_free(cond);
+  return uses;
+}
+
+/// Returns the number of loops the parallel loop `node' can be collapsed
+/// with (itself included) like get_clast_collapse_count does on the clast:
+/// the loops perfectly nested in it whose bounds don't depend on the
+/// collapsed iterators and that are parallel without reductions.
+static unsigned get_collapse_count(__isl_keep isl_ast_node *node,
+                                   const PlutoProg *prog) {
+  isl_id *ids[prog->num_hyperplanes + 1];
+  unsigned count = 1;
+  isl_ast_expr *iter = isl_ast_node_for_get_iterator(node);
+  ids[0] = isl_ast_expr_get_id(iter);
+  isl_ast_expr_free(iter);
+
+  isl_ast_node *outer = isl_ast_node_copy(node);
+  while (count <= prog->num_hyperplanes) {
+    isl_ast_node *body = isl_ast_node_for_get_body(outer);
+    if (isl_ast_node_get_type(body) != isl_ast_node_for ||
+        isl_ast_node_for_is_degenerate(body) != isl_bool_false ||
+        for_bounds_use_ids(body, ids, count)) {
+      isl_ast_node_free(body);
+      break;
+    }
+    isl_ast_node_free(outer);
+    outer = body;
+
+    isl_ast_expr *inc = isl_ast_node_for_get_inc(outer);
+    isl_val *step = isl_ast_expr_get_val(inc);
+    bool unit = isl_val_is_one(step) == isl_bool_true;
+    isl_val_free(step);
+    isl_ast_expr_free(inc);
+    isl_id *id = isl_ast_node_get_annotation(outer);
+    IslLoop *loop = id ? (IslLoop *)isl_id_get_user(id) : NULL;
+    isl_id_free(id);
+    if (!unit || !loop || loop->parallel || loop->vector)
+      break;
+
+    Ploop *ploop = get_poly_loop(loop, prog);
+    char *clause = NULL;
+    bool parallel = pluto_loop_is_parallel(prog, ploop) &&
+                    pluto_loop_get_reduction_clause(ploop, prog, &clause) &&
+                    !clause;
+    free(clause);
+    pluto_loop_free(ploop);
+    if (!parallel)
+      break;
+    iter = isl_ast_node_for_get_iterator(outer);
+    ids[count++] = isl_ast_expr_get_id(iter);
+    isl_ast_expr_free(iter);
+  }
+  isl_ast_node_free(outer);
+
+  for (unsigned i = 0; i < count; i++) {
+    isl_id_free(ids[i]);
+  }
+  return count;
+}
+
+/// Prints the pragmas of a marked loop before the loop, with its OpenMP
+/// clauses (see pluto_get_omp_loop_clauses). The loop iterators are declared
+/// in the loops, which makes them private to the threads.
+static __isl_give isl_printer *
+print_for(__isl_take isl_printer *p,
+          __isl_take isl_ast_print_options *print_options,
+          __isl_keep isl_ast_node *node, void *user) {
+  const PlutoProg *prog = (const PlutoProg *)user;
+  isl_id *id = isl_ast_node_get_annotation(node);
+  IslLoop *loop = id ? (IslLoop *)isl_id_get_user(id) : NULL;
+  isl_id_free(id);
+
+  if (loop && loop->parallel) {
+    Ploop *ploop = get_poly_loop(loop, prog);
+    char *clauses = pluto_get_omp_loop_clauses(
+        ploop, get_collapse_count(node, prog), prog);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "#pragma omp parallel for");
+    if (clauses) {
+      p = isl_printer_print_str(p, " ");
+      p = isl_printer_print_str(p, clauses);
+    }
+    p = isl_printer_end_line(p);
+    free(clauses);
+    pluto_loop_free(ploop);
+  }
+  if (loop && loop->vector && prog->context->options->omp_simd) {
+    Ploop *ploop = get_poly_loop(loop, prog);
+    char *pragma = pluto_get_simd_pragma(ploop, prog);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, pragma);
+    p = isl_printer_end_line(p);
+    free(pragma);
+    pluto_loop_free(ploop);
+  } else if (loop && loop->vector) {
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "#pragma ivdep");
+    p = isl_printer_end_line(p);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "#pragma vector always");
+    p = isl_printer_end_line(p);
+  }
+  return isl_ast_node_for_print(node, p, print_options);
+}
+
+int pluto_gen_isl_code(const PlutoProg *prog, FILE *outfp) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+  unsigned n = prog->num_hyperplanes;
+
+  isl_ctx *ctx = isl_ctx_alloc();
+
+  IF_DEBUG(printf("[pluto] generating code with isl\n"));
+
+  isl_union_set *domains = NULL;
+  isl_union_map *schedules = NULL;
+  for (int i = 0; i < prog->nstmts; i++) {
+    Stmt *stmt = prog->stmts[i];
+    isl_union_set *dom =
+        isl_union_set_from_set(get_stmt_domain(stmt, prog, ctx));
+    isl_union_map *sched =
+        isl_union_map_from_map(get_stmt_schedule(stmt, prog, ctx));
+    domains = domains ? isl_union_set_union(domains, dom) : dom;
+    schedules = schedules ? isl_union_map_union(schedules, sched) : sched;
+  }
+
+  PlutoConstraints *param_ctx = pluto_constraints_dup(prog->param_context);
+  pluto_constraints_intersect_isl(param_ctx, prog->codegen_context);
+  isl_set *ast_context =
+      isl_set_from_pluto_constraints_params(param_ctx, prog->npar, ctx);
+  ast_context = isl_set_params(set_param_names(ast_context, prog));
+  pluto_constraints_free(param_ctx);
+
+  /* All the schedule dimensions form a single band, whose AST generation
+   * options isolate the full tiles */
+  isl_schedule *schedule = isl_schedule_from_domain(domains);
+  if (n > 0) {
+    schedule = isl_schedule_insert_partial_schedule(
+        schedule, isl_multi_union_pw_aff_from_union_map(schedules));
+    isl_schedule_node *node = isl_schedule_get_root(schedule);
+    isl_schedule_free(schedule);
+    node = isl_schedule_node_child(node, 0);
+    node = isl_schedule_node_band_set_ast_build_options(
+        node, get_ast_options(prog, ctx));
+    schedule = isl_schedule_node_get_schedule(node);
+    isl_schedule_node_free(node);
+  } else {
+    isl_union_map_free(schedules);
+  }
+
+  isl_id_list *iterators = isl_id_list_alloc(ctx, n);
+  for (unsigned i = 0; i < n; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "t%u", i + 1);
+    iterators = isl_id_list_add(iterators, isl_id_alloc(ctx, name, NULL));
+  }
+
+  IslLoops loops = {NULL, 0};
+  isl_ast_build *build = isl_ast_build_from_context(ast_context);
+  build = isl_ast_build_set_iterators(build, iterators);
+  build = isl_ast_build_set_before_each_for(build, &before_each_for, &loops);
+  isl_ast_node *tree = isl_ast_build_node_from_schedule(build, schedule);
+  isl_ast_build_free(build);
+
+  isl_ast_node_foreach_descendant_top_down(tree, &set_loop_depth, NULL);
+  if (options->parallel) {
+    mark_parallel_loops(&loops, prog);
+  }
+  if (options->prevector) {
+    mark_vector_loops(&loops, prog);
+  }
+
+  fprintf(outfp, "/* Start of isl code */\n");
+  fflush(outfp);
+  isl_printer *p = isl_printer_to_file(ctx, outfp);
+  p = isl_printer_set_output_format(p, ISL_FORMAT_C);
+  isl_ast_print_options *print_options = isl_ast_print_options_alloc(ctx);
+  print_options = isl_ast_print_options_set_print_for(
+      print_options, &print_for, (void *)prog);
+  p = isl_ast_node_print(tree, p, print_options);
+  isl_printer_flush(p);
+  isl_printer_free(p);
+  fprintf(outfp, "/* End of isl code */\n");
+
+  isl_ast_node_free(tree);
+  for (unsigned i = 0; i < loops.num; i++) {
+    free(loops.loops[i]->stmts);
+    free(loops.loops[i]);
+  }
+  free(loops.loops);
+  isl_ctx_free(ctx);
+
+  return 0;
+}
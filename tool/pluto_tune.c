@@ -0,0 +1,920 @@
+/*
+ * Pluto: An automatic parallelizer and locality optimizer
+ *
+ * Copyright (C) 2007-2015 Uday Bondhugula
+ *
+ * This software is available under the MIT license, a copy of which can be
+ * found in the file `LICENSE' in the top-level directory.
+ *
+ * Empirical tile size tuning. The polyhedral analysis and transformation are
+ * done once; each variant is then tiled in a forked copy of the program,
+ * generated, compiled and run, and a search strategy decides which tile sizes
+ * to try next. Results are kept in a tuning database so that a kernel is not
+ * re-measured across runs.
+ */
+#include <assert.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pluto_tune.h"
+
+#include "pluto.h"
+#include "pluto/matrix.h"
+#include "pluto/pluto.h"
+#include "post_transform.h"
+#include "program.h"
+#include "tile_config.h"
+#include "tile_size_selection_model.h"
+
+/* Range of tile sizes searched */
+#define TUNE_MIN_TILE_SIZE 2
+#define TUNE_MAX_TILE_SIZE 2048
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+typedef struct tuneState {
+  PlutoProg *prog;
+  const PlutoTuneOptions *topts;
+  const char *irroption;
+
+  /* Number of tile sizes searched: the number of loops in the widest
+   * outermost permutable band (the same sizes are used for every band) */
+  unsigned ndims;
+
+  /* Absolute path of the source file, its directory and its basename */
+  char *src;
+  char *srcdir;
+  char *kernel;
+
+  /* Private directory the variants are generated in */
+  char *workdir;
+
+  /* Compiler used for the variants, and the inscop script */
+  const char *cc;
+  const char *cflags;
+  const char *ldflags;
+  const char *inscop;
+
+  /* Tuning database, and the keys its entries are matched against: the
+   * source, the compiler command, the transformation and the options that
+   * shape the code of a variant (see hash_variant_code), and the number of
+   * threads */
+  char *db;
+  uint64_t src_hash;
+  uint64_t flags_hash;
+  unsigned threads;
+
+  /* Tile sizes evaluated so far (ndims each) and their execution times */
+  int *points;
+  double *times;
+  unsigned npoints;
+  unsigned max_points;
+
+  /* Index of the fastest point, -1 if none */
+  int best;
+
+  /* Number of variants run (points taken from the database not included) */
+  int nevals;
+
+  /* With --parametric-tiles, a single variant is built, in parametric_dir,
+   * and the tile sizes are passed to it at run time; parametric_built is -1
+   * until it has been built, then 1 if that succeeded and 0 otherwise */
+  bool parametric;
+  int parametric_built;
+  char parametric_dir[PATH_MAX];
+} TuneState;
+
+static double rtclock() {
+  struct timeval Tp;
+  int stat = gettimeofday(&Tp, NULL);
+  if (stat != 0)
+    printf("Error return from gettimeofday: %d", stat);
+  return (Tp.tv_sec + Tp.tv_usec * 1.0e-6);
+}
+
+void pluto_tune_options_init(PlutoTuneOptions *topts) {
+  topts->strategy = kTuneCoordinateDescent;
+  topts->max_evals = 50;
+  topts->jobs = 4;
+  topts->reps = 3;
+  topts->db = NULL;
+}
+
+static uint64_t fnv1a_hash(uint64_t hash, const char *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    hash ^= (unsigned char)buf[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+static uint64_t hash_file(const char *path) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return hash;
+  char buf[4096];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+    hash = fnv1a_hash(hash, buf, len);
+  }
+  fclose(fp);
+  return hash;
+}
+
+/// Adds to `hash' what, besides the source and the tile sizes, shapes the code
+/// of a variant: the transformation found for each statement and the options
+/// that tiling, parallelization and code generation depend on. Timings
+/// measured on other code are then never reused.
+static uint64_t hash_variant_code(uint64_t hash, const PlutoProg *prog) {
+  const PlutoOptions *options = prog->context->options;
+
+  for (int i = 0; i < prog->nstmts; i++) {
+    const PlutoMatrix *trans = prog->stmts[i]->trans;
+    for (unsigned r = 0; r < trans->nrows; r++) {
+      hash = fnv1a_hash(hash, (const char *)trans->val[r],
+                        trans->ncols * sizeof(int64_t));
+    }
+  }
+
+  int opts[] = {options->parallel, options->innerpar, options->forceparallel,
+                options->multipar, options->tile_levels,
+                options->second_level_tile, options->parallel_tile_level,
+                options->split_tile, options->parametric_tiles,
+                options->full_tiles, options->diamondtile,
+                options->fulldiamondtile, options->intratileopt,
+                options->unrolljam, options->ufactor, (int)options->target,
+                options->prevector, options->omp_simd,
+                (int)options->array_alignment, options->reductions,
+                options->omp_tasks, options->doacross, options->dynschedule,
+                options->omp_collapse, options->omp_schedule,
+                options->multiversion, options->ft, options->lt,
+                (int)options->codegen, options->codegen_context,
+                options->cloogf, options->cloogl, options->cloogsh,
+                options->cloogbacktrack};
+  hash = fnv1a_hash(hash, (const char *)opts, sizeof(opts));
+  hash = fnv1a_hash(hash, (const char *)&options->multiversion_threshold,
+                    sizeof(options->multiversion_threshold));
+  if (options->isl_ast_options) {
+    hash = fnv1a_hash(hash, options->isl_ast_options,
+                      strlen(options->isl_ast_options));
+  }
+  return hash;
+}
+
+static int clamp_tile_size(long size) {
+  if (size < TUNE_MIN_TILE_SIZE)
+    return TUNE_MIN_TILE_SIZE;
+  if (size > TUNE_MAX_TILE_SIZE)
+    return TUNE_MAX_TILE_SIZE;
+  return size;
+}
+
+/// Prints tile sizes as "s1<sep>s2<sep>...".
+static void sprint_tile_sizes(char *buf, size_t len, const int *sizes,
+                              unsigned n, char sep) {
+  size_t pos = 0;
+  buf[0] = '\0';
+  for (unsigned i = 0; i < n && pos < len; i++) {
+    if (i > 0)
+      pos += snprintf(buf + pos, len - pos, "%c", sep);
+    if (pos < len)
+      pos += snprintf(buf + pos, len - pos, "%d", sizes[i]);
+  }
+}
+
+static int tune_find(const TuneState *st, const int *sizes) {
+  for (unsigned i = 0; i < st->npoints; i++) {
+    if (!memcmp(&st->points[i * st->ndims], sizes, st->ndims * sizeof(int)))
+      return i;
+  }
+  return -1;
+}
+
+/// Execution time of the variant with these tile sizes; infinity if it has
+/// not been evaluated or failed to build or run.
+static double tune_time(const TuneState *st, const int *sizes) {
+  int idx = tune_find(st, sizes);
+  return idx >= 0 ? st->times[idx] : INFINITY;
+}
+
+static void tune_record(TuneState *st, const int *sizes, double time) {
+  if (st->npoints == st->max_points) {
+    st->max_points = st->max_points ? 2 * st->max_points : 64;
+    st->points = (int *)realloc(st->points,
+                                st->max_points * st->ndims * sizeof(int));
+    st->times = (double *)realloc(st->times, st->max_points * sizeof(double));
+  }
+  memcpy(&st->points[st->npoints * st->ndims], sizes, st->ndims * sizeof(int));
+  st->times[st->npoints] = time;
+  if (st->best < 0 || time < st->times[st->best]) {
+    st->best = st->npoints;
+  }
+  st->npoints++;
+}
+
+static bool tune_budget_left(const TuneState *st) {
+  return st->nevals < st->topts->max_evals;
+}
+
+/// Loads the entries of the tuning database for the same source, compiler
+/// command, code options (see hash_variant_code) and number of threads. Each
+/// entry is a line of the form:
+/// kernel=<name> source=<hash> flags=<hash> threads=<n> sizes=<s1,s2,..>
+/// time=<seconds>
+static void tune_db_load(TuneState *st) {
+  FILE *fp = fopen(st->db, "r");
+  if (!fp)
+    return;
+
+  char line[1024];
+  int sizes[st->ndims];
+  while (fgets(line, sizeof(line), fp)) {
+    char kernel[256], sizes_str[512];
+    unsigned long long src_hash, flags_hash;
+    unsigned threads;
+    double time;
+    if (sscanf(line,
+               "kernel=%255s source=%llx flags=%llx threads=%u sizes=%511s "
+               "time=%lf",
+               kernel, &src_hash, &flags_hash, &threads, sizes_str,
+               &time) != 6)
+      continue;
+    if (src_hash != st->src_hash || flags_hash != st->flags_hash ||
+        threads != st->threads)
+      continue;
+
+    unsigned n = 0;
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(sizes_str, ",", &saveptr); tok;
+         tok = strtok_r(NULL, ",", &saveptr)) {
+      if (n == st->ndims)
+        break;
+      sizes[n++] = atoi(tok);
+    }
+    if (n == st->ndims && tune_find(st, sizes) < 0) {
+      tune_record(st, sizes, time);
+    }
+  }
+  fclose(fp);
+}
+
+static void tune_db_append(const TuneState *st, const int *sizes,
+                           double time) {
+  FILE *fp = fopen(st->db, "a");
+  if (!fp) {
+    printf("[pluto-tune] WARNING: can't write to tuning database %s\n",
+           st->db);
+    return;
+  }
+  char sizes_str[512];
+  sprint_tile_sizes(sizes_str, sizeof(sizes_str), sizes, st->ndims, ',');
+  fprintf(fp, "kernel=%s source=%016llx flags=%016llx threads=%u sizes=%s "
+              "time=%0.6lf\n",
+          st->kernel, (unsigned long long)st->src_hash,
+          (unsigned long long)st->flags_hash, st->threads, sizes_str, time);
+  fclose(fp);
+}
+
+/// Writes `sizes' to `path' as a tile configuration for all bands. Returns
+/// false if the file can't be written.
+static bool write_tile_config(const char *path, const int *sizes, unsigned n) {
+  FILE *fp = fopen(path, "w");
+  if (!fp)
+    return false;
+  PlutoTileConfig *config = pluto_tile_config_alloc();
+  PlutoTileBandConfig *band_config = pluto_tile_config_add_band(config);
+  pluto_tile_band_config_set_sizes(band_config, 1, sizes, n);
+  fprintf(fp, "# Tile sizes found by pluto-tune\n");
+  pluto_tile_config_print(fp, config);
+  pluto_tile_config_free(config);
+  fclose(fp);
+  return true;
+}
+
+/// Appends the white space separated words of `str' to argv, from
+/// argv[*argc] on, and advances *argc. No shell quoting is interpreted.
+static void tune_split_words(const char *str, char **argv, int *argc) {
+  const char *p = str;
+  while (*p != '\0') {
+    while (*p == ' ' || *p == '\t' || *p == '\n')
+      p++;
+    const char *start = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\n')
+      p++;
+    if (p > start) {
+      argv[(*argc)++] = strndup(start, p - start);
+    }
+  }
+}
+
+/// Runs the program argv[0] (looked up in PATH) with the arguments argv
+/// without going through a shell, so that paths and flags are passed as they
+/// are. Returns true if it exits with status 0.
+static bool tune_run_command(char *const argv[]) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    execvp(argv[0], argv);
+    _exit(127);
+  }
+  if (pid < 0)
+    return false;
+
+  int status;
+  return waitpid(pid, &status, 0) >= 0 && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+/// Tiles, generates and compiles the variant with the given tile sizes in
+/// `dir'. Runs in a child process: the program being tiled is the child's own
+/// copy. Does not return.
+static void tune_build_variant(TuneState *st, const int *sizes,
+                               const char *dir) {
+  PlutoProg *prog = st->prog;
+  PlutoOptions *options = prog->context->options;
+
+  if (chdir(dir) != 0)
+    _exit(1);
+
+  /* Keep the output of Pluto and of the compiler out of the way */
+  int fd = open("build.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0) {
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+  }
+
+  if (!write_tile_config("variant.tiles", sizes, st->ndims))
+    _exit(1);
+  free(options->tile_config);
+  options->tile_config = strdup("variant.tiles");
+
+  options->find_tile_sizes = 0;
+  if (pluto_tile(prog))
+    _exit(1);
+  gen_reg_tile_file(prog);
+
+  FILE *outfp = fopen("variant.pluto.c", "w");
+  if (!outfp)
+    _exit(1);
+  /* The <irregular> extension from clan can only be passed to CLooG through
+   * a .cloog file; the input of CLooG is built in memory otherwise */
+  FILE *cloogfp = NULL;
+  if (!options->pet && st->irroption) {
+    cloogfp = fopen("variant.pluto.cloog", "w+");
+    if (!cloogfp)
+      _exit(1);
+    pluto_gen_cloog_file(cloogfp, prog);
+    fprintf(cloogfp, "<irregular>\n%s\n</irregular>\n\n", st->irroption);
+    rewind(cloogfp);
+  }
+  pluto_multicore_codegen(cloogfp, outfp, prog);
+  if (cloogfp)
+    fclose(cloogfp);
+  fclose(outfp);
+
+  /* Put the generated code back into the source file */
+  char *inscop_argv[] = {(char *)st->inscop, st->src, (char *)"variant.pluto.c",
+                         (char *)"variant.c", NULL};
+  if (!tune_run_command(inscop_argv))
+    _exit(1);
+
+  /* $CC $CFLAGS -I<srcdir> variant.c -o variant $LDFLAGS; $CC, $CFLAGS and
+   * $LDFLAGS are split into words at white space */
+  size_t max_args = strlen(st->cc) + strlen(st->cflags) + strlen(st->ldflags);
+  char **cc_argv = (char **)malloc((max_args + 8) * sizeof(char *));
+  int cc_argc = 0;
+  tune_split_words(st->cc, cc_argv, &cc_argc);
+  if (cc_argc == 0)
+    _exit(1);
+  tune_split_words(st->cflags, cc_argv, &cc_argc);
+  char *include = (char *)malloc(strlen(st->srcdir) + 3);
+  sprintf(include, "-I%s", st->srcdir);
+  cc_argv[cc_argc++] = include;
+  cc_argv[cc_argc++] = (char *)"variant.c";
+  cc_argv[cc_argc++] = (char *)"-o";
+  cc_argv[cc_argc++] = (char *)"variant";
+  tune_split_words(st->ldflags, cc_argv, &cc_argc);
+  cc_argv[cc_argc] = NULL;
+  _exit(tune_run_command(cc_argv) ? 0 : 1);
+}
+
+/// Runs the variant built in `dir' reps times with pinned threads; returns
+/// the minimum wall clock time, or infinity if it fails. A variant built with
+/// parametric tile sizes is given `sizes' through PLUTO_TILE_SIZES; they are
+/// assigned to its tile size variables in order, which matches the loops of
+/// the widest band when it is outermost.
+static double tune_run_variant(const TuneState *st, const char *dir,
+                               const int *sizes) {
+  double best = INFINITY;
+
+  for (int r = 0; r < st->topts->reps; r++) {
+    fflush(stdout);
+    double t_start = rtclock();
+    pid_t pid = fork();
+    if (pid == 0) {
+      if (chdir(dir) != 0)
+        _exit(127);
+      int fd = open("run.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd >= 0) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+      }
+      if (st->threads > 0) {
+        char nthreads[16];
+        snprintf(nthreads, sizeof(nthreads), "%u", st->threads);
+        setenv("OMP_NUM_THREADS", nthreads, 1);
+      }
+      if (st->parametric) {
+        char sizes_str[512];
+        sprint_tile_sizes(sizes_str, sizeof(sizes_str), sizes, st->ndims, ',');
+        setenv("PLUTO_TILE_SIZES", sizes_str, 1);
+      }
+      setenv("OMP_PROC_BIND", "close", 0);
+      setenv("OMP_PLACES", "cores", 0);
+      execl("./variant", "./variant", (char *)NULL);
+      _exit(127);
+    }
+    if (pid < 0)
+      return INFINITY;
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0)
+      return INFINITY;
+    double t = rtclock() - t_start;
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+/// Builds the variants with the n tile size vectors in `sizes' in directories
+/// `dirs', topts->jobs at a time; built[k] is set to whether the k^th one
+/// could be built.
+static void tune_build_variants(TuneState *st, const int *sizes, unsigned n,
+                                char (*dirs)[PATH_MAX], bool *built) {
+  pid_t pids[n];
+  for (unsigned k = 0; k < n; k++) {
+    pids[k] = -1;
+    built[k] = false;
+  }
+
+  unsigned next = 0, running = 0;
+  while (next < n || running > 0) {
+    while (next < n && running < (unsigned)st->topts->jobs) {
+      if (mkdir(dirs[next], 0755) == 0) {
+        fflush(stdout);
+        fflush(stderr);
+        pids[next] = fork();
+        if (pids[next] == 0) {
+          tune_build_variant(st, &sizes[next * st->ndims], dirs[next]);
+        }
+        if (pids[next] > 0)
+          running++;
+      }
+      next++;
+    }
+    if (running == 0)
+      continue;
+
+    int status;
+    pid_t pid = wait(&status);
+    if (pid < 0)
+      break;
+    for (unsigned k = 0; k < n; k++) {
+      if (pids[k] == pid) {
+        built[k] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        running--;
+        break;
+      }
+    }
+  }
+}
+
+/// Evaluates the n tile size vectors in `batch' that have not been evaluated
+/// yet (as many as the budget allows): the variants are built concurrently,
+/// topts->jobs at a time (a single one is built for all of them with
+/// --parametric-tiles), and then run one after the other.
+static void tune_evaluate(TuneState *st, const int *batch, unsigned n) {
+  PlutoContext *context = st->prog->context;
+  unsigned ndims = st->ndims;
+
+  int *pending = (int *)malloc(n * ndims * sizeof(int) + 1);
+  unsigned npending = 0;
+  for (unsigned i = 0; i < n; i++) {
+    if (st->nevals + (int)npending >= st->topts->max_evals)
+      break;
+    const int *sizes = &batch[i * ndims];
+    if (tune_find(st, sizes) >= 0)
+      continue;
+    unsigned k;
+    for (k = 0; k < npending; k++) {
+      if (!memcmp(&pending[k * ndims], sizes, ndims * sizeof(int)))
+        break;
+    }
+    if (k == npending) {
+      memcpy(&pending[npending++ * ndims], sizes, ndims * sizeof(int));
+    }
+  }
+
+  if (npending == 0) {
+    free(pending);
+    return;
+  }
+
+  bool built[npending];
+  char dirs[npending][PATH_MAX];
+  if (st->parametric) {
+    /* One variant serves all tile sizes */
+    if (st->parametric_built < 0) {
+      bool ok;
+      snprintf(st->parametric_dir, PATH_MAX, "%s/parametric", st->workdir);
+      tune_build_variants(st, pending, 1, &st->parametric_dir, &ok);
+      st->parametric_built = ok;
+    }
+    for (unsigned k = 0; k < npending; k++) {
+      strcpy(dirs[k], st->parametric_dir);
+      built[k] = st->parametric_built;
+    }
+  } else {
+    for (unsigned k = 0; k < npending; k++) {
+      snprintf(dirs[k], PATH_MAX, "%s/v%d", st->workdir, st->nevals + k);
+    }
+    tune_build_variants(st, pending, npending, dirs, built);
+  }
+
+  for (unsigned k = 0; k < npending; k++) {
+    const int *sizes = &pending[k * ndims];
+    double time = built[k] ? tune_run_variant(st, dirs[k], sizes) : INFINITY;
+    st->nevals++;
+    tune_record(st, sizes, time);
+    tune_db_append(st, sizes, time);
+
+    char sizes_str[512];
+    sprint_tile_sizes(sizes_str, sizeof(sizes_str), sizes, ndims, 'x');
+    if (isinf(time)) {
+      PLUTO_MESSAGE(printf("[pluto-tune] %3d: %s: failed (see %s)\n",
+                           st->nevals, sizes_str, dirs[k]););
+    } else {
+      PLUTO_MESSAGE(printf("[pluto-tune] %3d: %s: %0.6lfs\n", st->nevals,
+                           sizes_str, time););
+    }
+  }
+  free(pending);
+}
+
+/// Log-uniform random sampling of the tile sizes.
+static void tune_random(TuneState *st, const int *seed) {
+  unsigned ndims = st->ndims;
+  unsigned rseed = 1;
+  int jobs = st->topts->jobs;
+  int *batch = (int *)malloc(jobs * ndims * sizeof(int));
+  double lmin = log2(TUNE_MIN_TILE_SIZE), lmax = log2(TUNE_MAX_TILE_SIZE);
+
+  tune_evaluate(st, seed, 1);
+  /* Bound the number of samples in case most of them are already known */
+  for (int tries = 0; tune_budget_left(st) && tries < 64 * st->topts->max_evals;
+       tries += jobs) {
+    for (int k = 0; k < jobs; k++) {
+      for (unsigned i = 0; i < ndims; i++) {
+        double l = lmin + (lmax - lmin) * rand_r(&rseed) / (double)RAND_MAX;
+        batch[k * ndims + i] = clamp_tile_size(lround(exp2(l)));
+      }
+    }
+    tune_evaluate(st, batch, jobs);
+  }
+  free(batch);
+}
+
+/// Coordinate descent: each tile size in turn is multiplied and divided by a
+/// factor (2 to start with), moving to the better neighbour if any. The factor
+/// is reduced when a sweep over all tile sizes does not improve.
+static void tune_coordinate_descent(TuneState *st, const int *seed) {
+  unsigned ndims = st->ndims;
+  int cur[ndims], batch[2 * ndims];
+
+  memcpy(cur, seed, ndims * sizeof(int));
+  tune_evaluate(st, cur, 1);
+  double tcur = tune_time(st, cur);
+
+  double factor = 2.0;
+  while (tune_budget_left(st) && factor > 1.1) {
+    bool improved = false;
+    for (unsigned i = 0; i < ndims && tune_budget_left(st); i++) {
+      memcpy(&batch[0], cur, ndims * sizeof(int));
+      memcpy(&batch[ndims], cur, ndims * sizeof(int));
+      batch[i] = clamp_tile_size(lround(cur[i] * factor));
+      batch[ndims + i] = clamp_tile_size(lround(cur[i] / factor));
+      tune_evaluate(st, batch, 2);
+      for (unsigned k = 0; k < 2; k++) {
+        double t = tune_time(st, &batch[k * ndims]);
+        if (t < tcur) {
+          tcur = t;
+          memcpy(cur, &batch[k * ndims], ndims * sizeof(int));
+          improved = true;
+        }
+      }
+    }
+    if (!improved)
+      factor = sqrt(factor);
+  }
+}
+
+static void log2_to_tile_sizes(const double *x, int *sizes, unsigned n) {
+  for (unsigned i = 0; i < n; i++) {
+    sizes[i] = clamp_tile_size(lround(exp2(x[i])));
+  }
+}
+
+static double tune_eval_log2(TuneState *st, const double *x) {
+  int sizes[st->ndims];
+  log2_to_tile_sizes(x, sizes, st->ndims);
+  tune_evaluate(st, sizes, 1);
+  return tune_time(st, sizes);
+}
+
+/// Nelder-Mead simplex search on the log2 of the tile sizes, starting from a
+/// simplex around the seed with each tile size doubled in turn.
+static void tune_nelder_mead(TuneState *st, const int *seed) {
+  unsigned n = st->ndims;
+  double x[n + 1][n], f[n + 1], c[n], xr[n], xe[n], xc[n];
+  int sizes[(n + 1) * n];
+
+  for (unsigned v = 0; v <= n; v++) {
+    for (unsigned i = 0; i < n; i++) {
+      x[v][i] = log2(seed[i]);
+    }
+    if (v > 0) {
+      x[v][v - 1] += (seed[v - 1] * 2 > TUNE_MAX_TILE_SIZE) ? -1.0 : 1.0;
+    }
+    log2_to_tile_sizes(x[v], &sizes[v * n], n);
+  }
+  tune_evaluate(st, sizes, n + 1);
+  for (unsigned v = 0; v <= n; v++) {
+    f[v] = tune_time(st, &sizes[v * n]);
+  }
+
+  for (int iter = 0; tune_budget_left(st) && iter < 4 * st->topts->max_evals;
+       iter++) {
+    /* Order the vertices from best to worst */
+    for (unsigned v = 1; v <= n; v++) {
+      for (unsigned w = v; w > 0 && f[w] < f[w - 1]; w--) {
+        double tmp = f[w];
+        f[w] = f[w - 1];
+        f[w - 1] = tmp;
+        for (unsigned i = 0; i < n; i++) {
+          tmp = x[w][i];
+          x[w][i] = x[w - 1][i];
+          x[w - 1][i] = tmp;
+        }
+      }
+    }
+
+    /* Converged once all vertices round to the same tile sizes */
+    bool converged = true;
+    log2_to_tile_sizes(x[0], &sizes[0], n);
+    for (unsigned v = 1; v <= n && converged; v++) {
+      log2_to_tile_sizes(x[v], &sizes[v * n], n);
+      converged = !memcmp(&sizes[0], &sizes[v * n], n * sizeof(int));
+    }
+    if (converged)
+      break;
+
+    for (unsigned i = 0; i < n; i++) {
+      c[i] = 0.0;
+      for (unsigned v = 0; v < n; v++) {
+        c[i] += x[v][i] / n;
+      }
+      xr[i] = c[i] + (c[i] - x[n][i]);
+    }
+    double fr = tune_eval_log2(st, xr);
+
+    if (fr < f[0]) {
+      for (unsigned i = 0; i < n; i++) {
+        xe[i] = c[i] + 2.0 * (c[i] - x[n][i]);
+      }
+      double fe = tune_eval_log2(st, xe);
+      memcpy(x[n], fe < fr ? xe : xr, n * sizeof(double));
+      f[n] = fe < fr ? fe : fr;
+    } else if (fr < f[n - 1]) {
+      memcpy(x[n], xr, n * sizeof(double));
+      f[n] = fr;
+    } else {
+      for (unsigned i = 0; i < n; i++) {
+        xc[i] = c[i] + 0.5 * (x[n][i] - c[i]);
+      }
+      double fc = tune_eval_log2(st, xc);
+      if (fc < f[n]) {
+        memcpy(x[n], xc, n * sizeof(double));
+        f[n] = fc;
+      } else {
+        /* Shrink towards the best vertex */
+        for (unsigned v = 1; v <= n; v++) {
+          for (unsigned i = 0; i < n; i++) {
+            x[v][i] = x[0][i] + 0.5 * (x[v][i] - x[0][i]);
+          }
+          log2_to_tile_sizes(x[v], &sizes[(v - 1) * n], n);
+        }
+        tune_evaluate(st, sizes, n);
+        for (unsigned v = 1; v <= n; v++) {
+          f[v] = tune_time(st, &sizes[(v - 1) * n]);
+        }
+      }
+    }
+  }
+}
+
+/// Determines the number of tile sizes to search for (loops of the widest
+/// outermost permutable band) and the starting point from the tile size
+/// selection model. Returns the number of tile sizes.
+static unsigned tune_get_seed(PlutoProg *prog, int **seed) {
+  unsigned nbands, widest = 0, ndims = 0;
+  Band **bands = pluto_get_outermost_permutable_bands(prog, &nbands);
+
+  for (unsigned b = 0; b < nbands; b++) {
+    unsigned nloops = 0;
+    for (unsigned d = 0; d < bands[b]->width; d++) {
+      for (unsigned j = 0; j < bands[b]->loop->nstmts; j++) {
+        if (pluto_is_hyperplane_loop(bands[b]->loop->stmts[j],
+                                     bands[b]->loop->depth + d)) {
+          nloops++;
+          break;
+        }
+      }
+    }
+    if (nloops > ndims) {
+      ndims = nloops;
+      widest = b;
+    }
+  }
+
+  if (ndims == 0) {
+    pluto_bands_free(bands, nbands);
+    return 0;
+  }
+
+  Band *band = bands[widest];
+  int tile_sizes[band->width];
+  find_tile_sizes(band, prog, tile_sizes, NULL, 1);
+
+  *seed = (int *)malloc(ndims * sizeof(int));
+  unsigned i = 0;
+  for (unsigned d = 0; d < band->width; d++) {
+    for (unsigned j = 0; j < band->loop->nstmts; j++) {
+      if (pluto_is_hyperplane_loop(band->loop->stmts[j],
+                                   band->loop->depth + d)) {
+        (*seed)[i++] = clamp_tile_size(tile_sizes[d]);
+        break;
+      }
+    }
+  }
+  pluto_bands_free(bands, nbands);
+  return ndims;
+}
+
+int pluto_tune(PlutoProg *prog, const char *srcFileName, const char *irroption,
+               const PlutoTuneOptions *topts) {
+  PlutoContext *context = prog->context;
+  PlutoOptions *options = context->options;
+  TuneState st;
+
+  memset(&st, 0, sizeof(st));
+  st.prog = prog;
+  st.topts = topts;
+  st.irroption = irroption;
+  st.best = -1;
+  st.parametric = options->parametric_tiles;
+  st.parametric_built = -1;
+
+  int *seed = NULL;
+  st.ndims = tune_get_seed(prog, &seed);
+  if (st.ndims == 0) {
+    printf("[pluto-tune] No tilable band; nothing to tune\n");
+    return 1;
+  }
+
+  st.src = realpath(srcFileName, NULL);
+  if (!st.src) {
+    printf("[pluto-tune] ERROR: can't find source file %s\n", srcFileName);
+    free(seed);
+    return 1;
+  }
+  char *dirc = strdup(st.src);
+  st.srcdir = strdup(dirname(dirc));
+  free(dirc);
+  char *basec = strdup(st.src);
+  st.kernel = strdup(basename(basec));
+  free(basec);
+
+  st.cc = getenv("CC") ? getenv("CC") : "cc";
+  st.cflags =
+      getenv("CFLAGS") ? getenv("CFLAGS") : "-O3 -march=native -fopenmp";
+  st.ldflags = getenv("LDFLAGS") ? getenv("LDFLAGS") : "-lm";
+  st.inscop = getenv("PLUTO_INSCOP") ? getenv("PLUTO_INSCOP") : "inscop";
+
+  if (topts->db) {
+    st.db = strdup(topts->db);
+  } else {
+    st.db = (char *)malloc(strlen(st.kernel) + strlen(".tune.db") + 1);
+    strcpy(st.db, st.kernel);
+    strcat(st.db, ".tune.db");
+  }
+  st.src_hash = hash_file(st.src);
+  st.flags_hash = FNV_OFFSET_BASIS;
+  st.flags_hash = fnv1a_hash(st.flags_hash, st.cc, strlen(st.cc) + 1);
+  st.flags_hash = fnv1a_hash(st.flags_hash, st.cflags, strlen(st.cflags) + 1);
+  st.flags_hash = fnv1a_hash(st.flags_hash, st.ldflags, strlen(st.ldflags) + 1);
+  st.flags_hash = hash_variant_code(st.flags_hash, prog);
+  st.threads = options->num_threads;
+  if (st.threads == 0 && getenv("OMP_NUM_THREADS")) {
+    st.threads = atoi(getenv("OMP_NUM_THREADS"));
+  }
+
+  char workdir[] = "/tmp/pluto-tune.XXXXXX";
+  if (!mkdtemp(workdir)) {
+    printf("[pluto-tune] ERROR: can't create a directory for the variants\n");
+    free(seed);
+    return 1;
+  }
+  st.workdir = workdir;
+
+  tune_db_load(&st);
+
+  char sizes_str[512];
+  sprint_tile_sizes(sizes_str, sizeof(sizes_str), seed, st.ndims, 'x');
+  PLUTO_MESSAGE(printf("[pluto-tune] Tuning %u tile sizes of %s, up to %d "
+                       "variants; model suggests %s\n",
+                       st.ndims, st.kernel, topts->max_evals, sizes_str););
+  if (st.npoints > 0) {
+    PLUTO_MESSAGE(printf("[pluto-tune] %u variant(s) found in %s\n",
+                         st.npoints, st.db););
+  }
+
+  double t_start = rtclock();
+  switch (topts->strategy) {
+  case kTuneRandom:
+    tune_random(&st, seed);
+    break;
+  case kTuneCoordinateDescent:
+    tune_coordinate_descent(&st, seed);
+    break;
+  case kTuneNelderMead:
+    tune_nelder_mead(&st, seed);
+    break;
+  }
+  double t_tune = rtclock() - t_start;
+
+  int retval = 0;
+  if (st.best < 0 || isinf(st.times[st.best])) {
+    printf("[pluto-tune] ERROR: no variant could be built and run; see %s\n",
+           st.workdir);
+    retval = 1;
+  } else {
+    const int *best = &st.points[st.best * st.ndims];
+    assert(options->tile_config_out != NULL);
+    if (!write_tile_config(options->tile_config_out, best, st.ndims)) {
+      printf("[pluto-tune] ERROR: can't write %s\n", options->tile_config_out);
+      retval = 1;
+    } else {
+      sprint_tile_sizes(sizes_str, sizeof(sizes_str), best, st.ndims, 'x');
+      PLUTO_MESSAGE(printf("[pluto-tune] Best tile sizes: %s (%0.6lfs); %d "
+                           "variant(s) run in %0.2lfs; written to %s\n",
+                           sizes_str, st.times[st.best], st.nevals, t_tune,
+                           options->tile_config_out););
+    }
+  }
+
+  /* Keep the variants around for inspection when debugging or on failure */
+  if (retval == 0 && !options->debug) {
+    char *rm_argv[] = {(char *)"rm", (char *)"-rf", st.workdir, NULL};
+    if (!tune_run_command(rm_argv)) {
+      printf("[pluto-tune] WARNING: couldn't remove %s\n", st.workdir);
+    }
+  }
+
+  free(seed);
+  free(st.src);
+  free(st.srcdir);
+  free(st.kernel);
+  free(st.db);
+  free(st.points);
+  free(st.times);
+  return retval;
+}
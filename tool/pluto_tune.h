@@ -0,0 +1,55 @@
+#ifndef PLUTO_TUNE_H
+#define PLUTO_TUNE_H
+
+typedef struct plutoProg PlutoProg;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Search strategies for the empirical tile size tuner */
+enum tuneStrategy {
+  /* Log-uniform random sampling of tile sizes */
+  kTuneRandom,
+
+  /* Double/halve one tile size at a time, shrinking the step on no progress */
+  kTuneCoordinateDescent,
+
+  /* Nelder-Mead simplex search on the log2 of the tile sizes */
+  kTuneNelderMead
+};
+typedef enum tuneStrategy TuneStrategy;
+
+struct plutoTuneOptions {
+  TuneStrategy strategy;
+
+  /* Maximum number of variants to compile and run */
+  int max_evals;
+
+  /* Number of variants generated and compiled concurrently */
+  int jobs;
+
+  /* Number of runs of each variant; the minimum execution time is kept */
+  int reps;
+
+  /* Tuning database; defaults to <source basename>.tune.db */
+  char *db;
+};
+typedef struct plutoTuneOptions PlutoTuneOptions;
+
+void pluto_tune_options_init(PlutoTuneOptions *topts);
+
+/// Empirically searches for the tile sizes of the outermost permutable bands
+/// of `prog' (which should be transformed but not yet tiled). Each variant is
+/// tiled in a forked copy of `prog', generated, compiled with $CC $CFLAGS
+/// $LDFLAGS and run; the search is seeded with the tile size selection model.
+/// The best tile sizes found are written as a tile configuration to
+/// options->tile_config_out. Returns 0 on success.
+int pluto_tune(PlutoProg *prog, const char *srcFileName, const char *irroption,
+               const PlutoTuneOptions *topts);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // PLUTO_TUNE_H